@@ -83,6 +83,12 @@ volatile uint32 abort_context;
 /* Pointer to the last decoded instruction */
 instr *cpu_instr;
 
+/* Cache of decoded instructions */
+dcache_entry dcache[DCACHE_SIZE];
+
+/* Direct lookup of halfword opcodes by their second byte */
+mnemonic *hword_map[256];
+
 /* The instruction to use if there is no history storage */
 instr inst;
 
@@ -756,6 +762,11 @@ t_stat cpu_reset(DEVICE *dptr)
     cpu_hist_p = 0;
     cpu_in_wait = FALSE;
 
+    memset(hword_map, 0, sizeof(hword_map));
+    for (i = 0; i < HWORD_OP_COUNT; i++) {
+        hword_map[hword_ops[i].opcode & 0xff] = &hword_ops[i];
+    }
+
     sim_brk_types = SWMASK('E');
     sim_brk_dflt = SWMASK('E');
 
@@ -861,14 +872,7 @@ t_stat fprint_sym_m(FILE *of, t_addr addr, t_value *val)
     inst = (int32) val[vp++];
 
     if (inst == 0x30) {
-        /* Scan to find opcode */
-        inst = 0x3000 | (int8) val[vp++];
-        for (i = 0; i < HWORD_OP_COUNT; i++) {
-            if (hword_ops[i].opcode == inst) {
-                mn = &hword_ops[i];
-                break;
-            }
-        }
+        mn = hword_map[(uint8) val[vp++]];
     } else {
         mn = &ops[inst];
     }
@@ -1457,6 +1461,95 @@ static uint8 decode_operand(uint32 pa, instr *instr, uint8 op_number, int8 *etyp
     return offset;
 }
 
+/*
+ * Look up a previously decoded instruction whose opcode lives at
+ * physical address pa. The cached decode is only used if the memory
+ * it was decoded from is unchanged and the rest of the instruction is
+ * still mapped directly behind the opcode. Register-mode operands are
+ * refreshed, since decode captures their current contents.
+ *
+ * returns: the length of the instruction, or 0 on a miss.
+ */
+static SIM_INLINE uint8 dcache_lookup(instr *instr, uint32 va, uint32 pa)
+{
+    dcache_entry *entry = &dcache[DCACHE_IDX(pa)];
+    operand *oper;
+    uint32 base, tail_pa;
+    uint8 i, words;
+
+    if (entry->pa != pa) {
+        return 0;
+    }
+
+    base = (pa - PHYS_MEM_BASE) >> 2;
+    words = ((pa & 3) + entry->len + 3) >> 2;
+
+    for (i = 0; i < words; i++) {
+        if (RAM[base + i] != entry->mem[i]) {
+            return 0;
+        }
+    }
+
+    if (entry->len > 1 &&
+        (mmu_decode_va(va + entry->len - 1, ACC_OF, FALSE, &tail_pa) != SCPE_OK ||
+         tail_pa != pa + entry->len - 1)) {
+        return 0;
+    }
+
+    *instr = entry->inst;
+
+    instr->psw = R[NUM_PSW];
+    instr->sp  = R[NUM_SP];
+    instr->pc  = va;
+
+    for (i = 0; i < 4; i++) {
+        oper = &instr->operands[i];
+        if ((oper->mode == 4 || oper->mode == 5) && oper->reg != 15) {
+            oper->data = R[oper->reg];
+        }
+    }
+
+    /* Operand bytes are fetched through read_b, which leaves the last
+       virtual address behind in the MMU. */
+    if (entry->len > entry->op_len) {
+        mmu_state.var = va + entry->len - 1;
+    }
+
+    return entry->len;
+}
+
+/*
+ * Remember a successfully decoded instruction. Only instructions that
+ * sit entirely in main memory, within a single page, are cached.
+ */
+static SIM_INLINE void dcache_store(instr *instr, uint32 va, uint32 pa,
+                                    uint8 len, uint8 op_len)
+{
+    dcache_entry *entry;
+    uint32 base;
+    uint8 i, words;
+
+    words = ((pa & 3) + len + 3) >> 2;
+
+    if (words > DCACHE_WORDS ||
+        POT(va + len - 1) < POT(va) ||
+        !addr_is_mem(pa) || !addr_is_mem(pa + len - 1)) {
+        return;
+    }
+
+    entry = &dcache[DCACHE_IDX(pa)];
+    base = (pa - PHYS_MEM_BASE) >> 2;
+
+    for (i = 0; i < words; i++) {
+        entry->mem[i] = RAM[base + i];
+    }
+
+    entry->pa = pa;
+    entry->len = len;
+    entry->op_len = op_len;
+    entry->inst = *instr;
+}
+
 /*
  * Decode the instruction currently being pointed at by the PC.
  * This routine does the following:
@@ -1472,45 +1565,52 @@ static uint8 decode_operand(uint32 pa, instr *instr, uint8 op_number, int8 *etyp
 uint8 decode_instruction(instr *instr)
 {
     uint8 offset = 0;
+    uint8 op_len;
     uint8 b1, b2;
-    uint16 hword_op;
-    uint32 pa;
+    uint32 pa, opcode_pa;
+    t_stat succ;
     mnemonic *mn = NULL;
     int i;
     int8 etype = -1;  /* Expanded datatype (if any) */
 
-    clear_instruction(instr);
-
     pa = R[NUM_PC];
 
+    succ = mmu_decode_va(pa, ACC_OF, TRUE, &opcode_pa);
+
+    if (succ == SCPE_OK && (offset = dcache_lookup(instr, pa, opcode_pa)) != 0) {
+        return offset;
+    }
+
+    clear_instruction(instr);
+
     /* Store off the PC and and PSW for history keeping */
     instr->psw = R[NUM_PSW];
     instr->sp  = R[NUM_SP];
     instr->pc  = pa;
 
-    if (read_operand(pa + offset++, &b1) != SCPE_OK) {
+    offset++;
+
+    if (succ != SCPE_OK) {
         /* We tried to read out of a page that doesn't exist. We
            need to let the operating system handle it.*/
         cpu_abort(NORMAL_EXCEPTION, EXTERNAL_MEMORY_FAULT);
         return offset;
     }
 
+    b1 = pread_b(opcode_pa);
+
     /* It should never, ever happen that operand fetch
        would cause a page fault. */
 
     if (b1 == 0x30) {
         read_operand(pa + offset++, &b2);
-        hword_op = (uint16) ((uint16)b1 << 8) | (uint16) b2;
-        for (i = 0; i < HWORD_OP_COUNT; i++) {
-            if (hword_ops[i].opcode == hword_op) {
-                mn = &hword_ops[i];
-                break;
-            }
-        }
+        mn = hword_map[b2];
     } else {
         mn = &ops[b1];
     }
 
+    op_len = offset;
+
     if (mn == NULL) {
         cpu_abort(NORMAL_EXCEPTION, ILLEGAL_OPCODE);
         return offset;
@@ -1525,6 +1625,7 @@ uint8 decode_instruction(instr *instr)
 
     if (mn->op_count == 0) {
         /* Nothing else to do, we're done decoding. */
+        dcache_store(instr, pa, opcode_pa, offset, op_len);
         return offset;
     }
 
@@ -1563,6 +1664,8 @@ uint8 decode_instruction(instr *instr)
         break;
     }
 
+    dcache_store(instr, pa, opcode_pa, offset, op_len);
+
     return offset;
 }
 
@@ -1713,6 +1816,9 @@ t_stat sim_instr(void)
 
     stop_reason = 0;
 
+    /* Memory may have been resized while stopped */
+    memset(dcache, 0, sizeof(dcache));
+
     abort_reason = (uint32) setjmp(save_env);
 
     /* Exception handler.
@@ -386,6 +386,23 @@ typedef struct _instr {
     operand operands[4];
 } instr;
 
+/*
+ * The decode cache holds fully decoded instructions keyed on the
+ * physical address of their opcode, along with the memory image they
+ * were decoded from so that modified code is never replayed.
+ */
+#define DCACHE_SIZE    4096
+#define DCACHE_WORDS   8
+#define DCACHE_IDX(pa) (((pa) ^ ((pa) >> 12)) & (DCACHE_SIZE - 1))
+
+typedef struct _dcache_entry {
+    uint32  pa;                 /* Physical address of opcode (0 if empty) */
+    uint8   len;                /* Length of the instruction in bytes */
+    uint8   op_len;             /* Length of the opcode in bytes */
+    uint32  mem[DCACHE_WORDS];  /* Memory words holding the instruction */
+    instr   inst;               /* The decoded instruction */
+} dcache_entry;
+
 /* Function prototypes */
 t_stat sys_boot(int32 flag, CONST char *ptr);
 t_stat cpu_svc(UNIT *uptr);
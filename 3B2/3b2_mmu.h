@@ -206,10 +206,10 @@
 /* Pluck out Virtual Address fields */
 #define SID(va)           (((va) >> 30) & 3)
 #define SSL(va)           (((va) >> 17) & 0x1fff)
-#define SOT(va)           (va & 0x1ffff)
+#define SOT(va)           ((va) & 0x1ffff)
 #define PSL(va)           (((va) >> 11) & 0x3f)
 #define PSL_C(va)         ((va) & 0x1f800)
-#define POT(va)           (va & 0x7ff)
+#define POT(va)           ((va) & 0x7ff)
 
 /* Get the maximum length of an SSL from SRAMB */
 #define SRAMB_LEN(va)     (mmu_state.sec[SID(va)].len + 1)
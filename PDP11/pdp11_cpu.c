@@ -266,6 +266,21 @@ typedef struct {
     uint16              inst[HIST_ILNT];
     } InstHistory;
 
+/* Translation lookaside buffer.  There is one entry per APR (mode, space,
+   page) for reads and another for writes.  An entry is made only after a
+   relocation that could not trap, and only when the whole part of the page
+   allowed by the PLF maps contiguously onto memory, so a hit can go
+   straight to M[] without any access, length or NXM checks.  An entry with
+   hi < 0 is empty. */
+
+typedef struct {
+    int32               lo;                             /* lowest valid va<12:0> */
+    int32               hi;                             /* highest valid va<12:0> */
+    int32               pa;                             /* pa of va<12:0> = 0 */
+    } TLBENT;
+
+#define TLB_HIT(t,va)   ((((va) & VA_DF) >= (t)->lo) && (((va) & VA_DF) <= (t)->hi))
+
 /* Global state */
 
 uint16 *M = NULL;                                       /* memory */
@@ -318,6 +333,8 @@ int16 inst_pc;                                          /* PC of current instr *
 int32 inst_psw;                                         /* PSW at instr. start */
 int16 reg_mods;                                         /* reg deltas */
 int32 last_pa;                                          /* pa from ReadMW/ReadMB */
+TLBENT tlb_rd[64];                                      /* read translations */
+TLBENT tlb_wr[64];                                      /* write translations */
 int32 saved_sim_interval;                               /* saved at inst start */
 t_stat reason;                                          /* stop reason */
 
@@ -328,6 +345,7 @@ extern CPUTAB cpu_tab[];
 
 t_stat cpu_ex (t_value *vptr, t_addr addr, UNIT *uptr, int32 sw);
 t_stat cpu_dep (t_value val, t_addr addr, UNIT *uptr, int32 sw);
+void *cpu_mem_image (UNIT *uptr, size_t *size);
 t_stat cpu_reset (DEVICE *dptr);
 t_bool cpu_is_pc_a_subroutine_call (t_addr **ret_addrs);
 t_stat cpu_set_hist (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
@@ -341,6 +359,8 @@ void relocR_test (int32 va, int32 apridx);
 void relocW_test (int32 va, int32 apridx);
 t_bool PLF_test (int32 va, int32 apr);
 void reloc_abort (int32 err, int32 apridx);
+void tlb_fill (TLBENT *tlb, int32 va, int32 pa, int32 apr);
+void tlb_flush (void);
 int32 ReadE (int32 addr);
 int32 ReadW (int32 addr);
 int32 ReadB (int32 addr);
@@ -733,6 +753,7 @@ dsenable = calc_ds (cm);
 put_PIRQ (PIRQ);                                        /* rewrite PIRQ */
 STKLIM = STKLIM & STKLIM_RW;                            /* clean up STKLIM */
 MMR0 = MMR0 | MMR0_IC;                                  /* usually on */
+tlb_flush ();                                           /* console may have changed mmgt */
 
 trap_req = calc_ints (ipl, trap_req);                   /* upd int req */
 trapea = 0;
@@ -1000,8 +1021,8 @@ while (reason == 0)  {
     saved_sim_interval = sim_interval;
     if (BPT_SUMM_PC) {                                  /* possible breakpoint */
         t_addr pa = relocR (PC | isenable);             /* relocate PC */
-        if (sim_brk_test (PC, BPT_PCVIR) ||             /* Normal PC breakpoint? */
-            sim_brk_test (pa, BPT_PCPHY))               /* Physical Address breakpoint? */
+        if (SIM_BRK_TEST (PC, BPT_PCVIR) ||             /* Normal PC breakpoint? */
+            SIM_BRK_TEST (pa, BPT_PCPHY))               /* Physical Address breakpoint? */
             ABORT (ABRT_BKPT);                          /* stop simulation */
         }
 
@@ -1107,6 +1128,7 @@ while (reason == 0)  {
                     MMR0 = 0;                           /* clear MMR0 */
                     MMR3 = 0;                           /* clear MMR3 */
                     cpu_bme = 0;                        /* (also clear bme) */
+                    tlb_flush ();                       /* mmgt now off */
                     for (i = 0; i < IPL_HLVL; i++)
                         int_req[i] = 0;
 #ifdef OPCON
@@ -2745,15 +2767,18 @@ switch (spec >> 3) {                                    /* decode spec<5:3> */
 int32 ReadE (int32 va)
 {
 int32 pa, data;
+TLBENT *tlb = &tlb_rd[(va >> VA_V_APF) & 077];
 
 if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
     setCPUERR (CPUE_ODD);
     ABORT (TRAP_ODD);
     }
+if (TLB_HIT (tlb, va) && !BPT_SUMM_RD)                  /* mapped memory, no bkpt? */
+    return RdMemW (tlb->pa + (va & VA_DF));
 pa = relocR (va);                                       /* relocate */
 if (BPT_SUMM_RD &&
-    (sim_brk_test (va & 0177777, BPT_RDVIR) ||
-     sim_brk_test (pa, BPT_RDPHY)))                     /* read breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_RDVIR) ||
+     SIM_BRK_TEST (pa, BPT_RDPHY)))                     /* read breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 if (ADDR_IS_MEM (pa))                                   /* memory address? */
 #ifdef OPCON
@@ -2781,15 +2806,18 @@ return data;
 int32 ReadW (int32 va)
 {
 int32 pa;
+TLBENT *tlb = &tlb_rd[(va >> VA_V_APF) & 077];
 
 if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
     setCPUERR (CPUE_ODD);
     ABORT (TRAP_ODD);
     }
+if (TLB_HIT (tlb, va) && !BPT_SUMM_RD)                  /* mapped memory, no bkpt? */
+    return RdMemW (tlb->pa + (va & VA_DF));
 pa = relocR (va);                                       /* relocate */
 if (BPT_SUMM_RD &&
-    (sim_brk_test (va & 0177777, BPT_RDVIR) ||
-     sim_brk_test (pa, BPT_RDPHY)))                     /* read breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_RDVIR) ||
+     SIM_BRK_TEST (pa, BPT_RDPHY)))                     /* read breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 return PReadW (pa);
 }
@@ -2797,11 +2825,14 @@ return PReadW (pa);
 int32 ReadB (int32 va)
 {
 int32 pa;
+TLBENT *tlb = &tlb_rd[(va >> VA_V_APF) & 077];
 
+if (TLB_HIT (tlb, va) && !BPT_SUMM_RD)                  /* mapped memory, no bkpt? */
+    return RdMemB (tlb->pa + (va & VA_DF));
 pa = relocR (va);                                       /* relocate */
 if (BPT_SUMM_RD &&
-    (sim_brk_test (va & 0177777, BPT_RDVIR) ||
-     sim_brk_test (pa, BPT_RDPHY)))                     /* read breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_RDVIR) ||
+     SIM_BRK_TEST (pa, BPT_RDPHY)))                     /* read breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 return PReadB (pa);
 }
@@ -2812,39 +2843,54 @@ return PReadB (pa);
 int32 ReadCW (int32 va)
 {
 int32 pa;
+TLBENT *tlb = &tlb_rd[(va >> VA_V_APF) & 077];
 
 if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
     setCPUERR (CPUE_ODD);
     ABORT (TRAP_ODD);
     }
+if (TLB_HIT (tlb, va) && !BPT_SUMM_RD)                  /* mapped memory, no bkpt? */
+    return RdMemW (tlb->pa + (va & VA_DF));
 pa = relocR (va);                                       /* relocate */
 if (BPT_SUMM_RD &&
-    (sim_brk_test (va & 0177777, BPT_RDVIR) ||
-     sim_brk_test (pa, BPT_RDPHY)))                     /* read breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_RDVIR) ||
+     SIM_BRK_TEST (pa, BPT_RDPHY)))                     /* read breakpoint? */
     reason = STOP_IBKPT;                                /* report that */
 return PReadW (pa);
 }
 
 int32 ReadMW (int32 va)
 {
+TLBENT *tlb = &tlb_wr[(va >> VA_V_APF) & 077];
+
 if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
     setCPUERR (CPUE_ODD);
     ABORT (TRAP_ODD);
     }
+if (TLB_HIT (tlb, va) && !BPT_SUMM_RW) {                /* mapped memory, no bkpt? */
+    last_pa = tlb->pa + (va & VA_DF);
+    return RdMemW (last_pa);
+    }
 last_pa = relocW (va);                                  /* reloc, wrt chk */
 if (BPT_SUMM_RW &&
-    (sim_brk_test (va & 0177777, BPT_RWVIR) ||
-     sim_brk_test (last_pa, BPT_RWPHY)))                /* read or write breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_RWVIR) ||
+     SIM_BRK_TEST (last_pa, BPT_RWPHY)))                /* read or write breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 return PReadW (last_pa);
 }
 
 int32 ReadMB (int32 va)
 {
+TLBENT *tlb = &tlb_wr[(va >> VA_V_APF) & 077];
+
+if (TLB_HIT (tlb, va) && !BPT_SUMM_RW) {                /* mapped memory, no bkpt? */
+    last_pa = tlb->pa + (va & VA_DF);
+    return RdMemB (last_pa);
+    }
 last_pa = relocW (va);                                  /* reloc, wrt chk */
 if (BPT_SUMM_RW &&
-    (sim_brk_test (va & 0177777, BPT_RWVIR) ||
-     sim_brk_test (last_pa, BPT_RWPHY)))                /* read or write breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_RWVIR) ||
+     SIM_BRK_TEST (last_pa, BPT_RWPHY)))                /* read or write breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 return PReadB (last_pa);
 }
@@ -2911,15 +2957,20 @@ return ((pa & 1)? data >> 8: data) & 0377;
 void WriteW (int32 data, int32 va)
 {
 int32 pa;
+TLBENT *tlb = &tlb_wr[(va >> VA_V_APF) & 077];
 
 if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
     setCPUERR (CPUE_ODD);
     ABORT (TRAP_ODD);
     }
+if (TLB_HIT (tlb, va) && !BPT_SUMM_WR) {                /* mapped memory, no bkpt? */
+    WrMemW (tlb->pa + (va & VA_DF), data);
+    return;
+    }
 pa = relocW (va);                                       /* relocate */
 if (BPT_SUMM_WR &&
-    (sim_brk_test (va & 0177777, BPT_WRVIR) ||
-     sim_brk_test (pa, BPT_WRPHY)))                     /* write breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_WRVIR) ||
+     SIM_BRK_TEST (pa, BPT_WRPHY)))                     /* write breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 PWriteW (data, pa);
 }
@@ -2927,11 +2978,17 @@ PWriteW (data, pa);
 void WriteB (int32 data, int32 va)
 {
 int32 pa;
+TLBENT *tlb = &tlb_wr[(va >> VA_V_APF) & 077];
 
+if (TLB_HIT (tlb, va) && !BPT_SUMM_WR) {                /* mapped memory, no bkpt? */
+    pa = tlb->pa + (va & VA_DF);
+    WrMemB (pa, data);
+    return;
+    }
 pa = relocW (va);                                       /* relocate */
 if (BPT_SUMM_WR &&
-    (sim_brk_test (va & 0177777, BPT_WRVIR) ||
-     sim_brk_test (pa, BPT_WRPHY)))                     /* write breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_WRVIR) ||
+     SIM_BRK_TEST (pa, BPT_WRPHY)))                     /* write breakpoint? */
     ABORT (ABRT_BKPT);                                  /* stop simulation */
 PWriteB (data, pa);
 }
@@ -2942,15 +2999,20 @@ PWriteB (data, pa);
 void WriteCW (int32 data, int32 va)
 {
 int32 pa;
+TLBENT *tlb = &tlb_wr[(va >> VA_V_APF) & 077];
 
 if ((va & 1) && CPUT (HAS_ODD)) {                       /* odd address? */
     setCPUERR (CPUE_ODD);
     ABORT (TRAP_ODD);
     }
+if (TLB_HIT (tlb, va) && !BPT_SUMM_WR) {                /* mapped memory, no bkpt? */
+    WrMemW (tlb->pa + (va & VA_DF), data);
+    return;
+    }
 pa = relocW (va);                                       /* relocate */
 if (BPT_SUMM_WR &&
-    (sim_brk_test (va & 0177777, BPT_WRVIR) ||
-     sim_brk_test (pa, BPT_WRPHY)))                     /* write breakpoint? */
+    (SIM_BRK_TEST (va & 0177777, BPT_WRVIR) ||
+     SIM_BRK_TEST (pa, BPT_WRPHY)))                     /* write breakpoint? */
     reason = STOP_IBKPT;                                /* report that */
 PWriteW (data, pa);
 }
@@ -3037,11 +3099,14 @@ if (MMR0 & MMR0_MME) {                                  /* if mmgt */
         if (pa >= 0760000)
             pa = 017000000 | pa;
         }
+    if ((apr & PDR_PRD) == 2)                           /* plain read access? */
+        tlb_fill (&tlb_rd[apridx], va, pa, apr);
     }
 else {
     pa = va & 0177777;                                  /* mmgt off */
     if (pa >= 0160000)
         pa = 017600000 | pa;
+    tlb_fill (&tlb_rd[(va >> VA_V_APF) & 077], va, pa, 0);
     }
 #ifdef OPCON
 if (oc_active)
@@ -3156,11 +3221,14 @@ if (MMR0 & MMR0_MME) {                                  /* if mmgt */
         if (pa >= 0760000)
             pa = 017000000 | pa;
         }
+    if ((apr & PDR_ACF) == 6)                           /* plain write access? */
+        tlb_fill (&tlb_wr[apridx], va, pa, apr | PDR_W);
     }
 else {
     pa = va & 0177777;                                  /* mmgt off */
     if (pa >= 0160000)
         pa = 017600000 | pa;
+    tlb_fill (&tlb_wr[(va >> VA_V_APF) & 077], va, pa, 0);
     }
 #ifdef OPCON
 if (oc_active)
@@ -3219,6 +3287,58 @@ reloc_abort (err, apridx);
 return;
 }
 
+/* Make a TLB entry for the page containing va, just relocated to pa
+
+   The valid range is the part of the page the PLF allows (the whole page
+   with mmgt off).  No entry is made if that range wraps, reaches the I/O
+   page, runs past the end of memory, or the operator panel is active and
+   must see every reference.
+*/
+
+void tlb_fill (TLBENT *tlb, int32 va, int32 pa, int32 apr)
+{
+int32 lo, hi, lim, base;
+
+#ifdef OPCON
+if (oc_active)
+    return;
+#endif
+if (MMR0 & MMR0_MME) {                                  /* if mmgt */
+    if (apr & PDR_ED) {                                 /* expands down? */
+        lo = (apr & PDR_PLF) >> 2;
+        hi = VA_DF;
+        }
+    else {
+        lo = 0;
+        hi = ((apr & PDR_PLF) >> 2) | (VA_DF & ~VA_BN);
+        }
+    lim = (MMR3 & MMR3_M22E)? MAXMEMSIZE: 0760000;
+    }
+else {
+    lo = 0;
+    hi = VA_DF;
+    lim = 0160000;
+    }
+base = pa - (va & VA_DF);                               /* pa of va<12:0> = 0 */
+if (((base + lo) < 0) || ((base + hi) >= lim) || !ADDR_IS_MEM (base + hi))
+    return;
+tlb->lo = lo;
+tlb->hi = hi;
+tlb->pa = base;
+}
+
+/* Empty the TLB, after any change to MMR0, MMR3 or the APRs as a whole */
+
+void tlb_flush (void)
+{
+int32 i;
+
+for (i = 0; i < 64; i++) {
+    tlb_rd[i].lo = tlb_wr[i].lo = 0;
+    tlb_rd[i].hi = tlb_wr[i].hi = -1;
+    }
+}
+
 /* Relocate virtual address, console access
 
    Inputs:
@@ -3318,6 +3438,7 @@ switch ((pa >> 1) & 3) {                                /* decode pa<2:1> */
             data = (pa & 1)? (MMR0 & 0377) | (data << 8): (MMR0 & ~0377) | data;
         data = data & cpu_tab[cpu_model].mm0;
         MMR0 = (MMR0 & ~MMR0_WR) | (data & MMR0_WR);
+        tlb_flush ();
 #ifdef OPCON
         if (oc_active) {
 	    oc_set_mmu ();
@@ -3344,6 +3465,7 @@ if (pa & 1)
 MMR3 = data & cpu_tab[cpu_model].mm3;
 cpu_bme = (MMR3 & MMR3_BME) && (cpu_opt & OPT_UBM);
 dsenable = calc_ds (cm);
+tlb_flush ();
 
 #ifdef OPCON
 if (oc_active) {
@@ -3409,6 +3531,7 @@ if (left)
         (((uint32) (data & cpu_tab[cpu_model].par)) << 16)) & ~(PDR_A|PDR_W);
 else APRFILE[idx] = ((APRFILE[idx] & ~0177777) |
     (data & cpu_tab[cpu_model].pdr)) & ~(PDR_A|PDR_W);
+tlb_rd[idx].hi = tlb_wr[idx].hi = -1;                   /* drop its translations */
 return SCPE_OK;
 }
 
@@ -3580,6 +3703,7 @@ MMR0 = 0;
 MMR1 = 0;
 MMR2 = 0;
 MMR3 = 0;
+tlb_flush ();
 trap_req = 0;
 wait_state = 0;
 
@@ -3605,6 +3729,7 @@ if (M == NULL) {                    /* First time init */
                     SWMASK ('W')|SWMASK ('X');
     sim_brk_type_desc = cpu_breakpoints;
     sim_vm_is_subroutine_call = &cpu_is_pc_a_subroutine_call;
+    sim_vm_mem_image = &cpu_mem_image;
     auto_config(NULL, 0);           /* do an initial auto configure */
     }
 pcq_r = find_reg ("PCQ", NULL, dptr);
@@ -3725,6 +3850,16 @@ if (addr < IOPAGEBASE)
 return iopageW ((int32) val, addr, WRITEC);
 }
 
+/* Memory image for SAVE -B snapshots */
+
+void *cpu_mem_image (UNIT *uptr, size_t *size)
+{
+if (uptr != &cpu_unit)
+    return NULL;
+*size = (size_t) MEMSIZE;
+return M;
+}
+
 /* Set R, SP register display addresses */
 
 void set_r_display (int32 rs, int32 cm)
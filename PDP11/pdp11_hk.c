@@ -656,6 +656,10 @@ MTAB hk_mod[] = {
         &hk_set_bad, NULL, NULL, "write bad block table on last track" },
     { MTAB_XTD|MTAB_VUN|MTAB_VALR, 0, "FORMAT", "FORMAT={SIMH|VHD|RAW}",
       &sim_disk_set_fmt, &sim_disk_show_fmt, NULL, "Display disk format" },
+    { MTAB_XTD|MTAB_VUN, 1, NULL, "COMMIT",
+      &sim_disk_set_overlay, NULL, NULL, "Write disk overlay (ATTACH -S) to the container" },
+    { MTAB_XTD|MTAB_VUN, 0, NULL, "DISCARD",
+      &sim_disk_set_overlay, NULL, NULL, "Discard disk overlay (ATTACH -S) contents" },
     { (UNIT_DTYPE+UNIT_ATT), UNIT_RK06 + UNIT_ATT,
       "RK06", NULL, NULL },
     { (UNIT_DTYPE+UNIT_ATT), UNIT_RK07 + UNIT_ATT,
@@ -234,6 +234,58 @@ else uba_last = (IOPAGEBASE + off) & PAMASK;            /* yes, use fixed */
 return uba_last;
 }
 
+/* Map a run of I/O addresses - caller checks cpu_bme
+
+   Returns the number of bytes, from ba up to lim, which map onto
+   consecutive memory addresses starting at *ma.  A run continues
+   across pages whose map registers are contiguous and stops at the
+   end of memory.  Zero means that ba itself maps to NXM.
+*/
+
+static uint32 Map_Run (uint32 ba, uint32 lim, uint32 *ma)
+{
+int32 pg = UBM_GETPN (ba);
+uint32 run = UBM_PAGSIZE - UBM_GETOFF (ba);             /* left in page */
+
+*ma = Map_Addr (ba);                                    /* map first addr */
+if (!ADDR_IS_MEM (*ma))                                 /* NXM? */
+    return 0;
+while (((ba + run) < lim) &&                            /* more to xfr and */
+       ((pg + 1) < UBM_M_PN) &&                         /* next page mapped */
+       (ub_map[pg + 1] == (ub_map[pg] + UBM_PAGSIZE))) { /* contiguously? */
+    pg = pg + 1;
+    run = run + UBM_PAGSIZE;
+    }
+if (run > (lim - ba))                                   /* limit to rem xfr */
+    run = lim - ba;
+if (!ADDR_IS_MEM (*ma + run - 1))                       /* past end of mem? */
+    run = MEMSIZE - *ma;
+uba_last = (*ma + run - 2) & PAMASK;                    /* last word mapped */
+return run;
+}
+
+/* Block word transfers between memory and a DMA buffer */
+
+static void Map_RdMemWBlk (uint32 pa, uint32 bc, uint16 *buf)
+{
+#if defined (UC15)
+for ( ; bc; pa = pa + 2, bc = bc - 2)
+    *buf++ = (uint16) RdMemW (pa);
+#else
+memcpy (buf, &M[pa >> 1], bc);
+#endif
+}
+
+static void Map_WrMemWBlk (uint32 pa, uint32 bc, const uint16 *buf)
+{
+#if defined (UC15)
+for ( ; bc; pa = pa + 2, bc = bc - 2)
+    WrMemW (pa, *buf++);
+#else
+memcpy (&M[pa >> 1], buf, bc);
+#endif
+}
+
 /* I/O buffer routines, aligned access
 
    Map_ReadB    -       fetch byte buffer from memory
@@ -327,7 +379,7 @@ else {                                                  /* physical */
 
 int32 Map_ReadW (uint32 ba, int32 bc, uint16 *buf)
 {
-uint32 alim, lim, ma;
+uint32 alim, lim, ma, run;
 
 #ifdef OPCON
 if (oc_active) oc_set_master(FALSE);
@@ -362,9 +414,9 @@ if (UNIBUS && (ba >= (uint32)(IOPAGEBASE & UNIMASK))) {
 ba = (ba & BUSMASK) & ~01;                              /* trim, align addr */
 lim = ba + (bc & ~01);
 if (cpu_bme) {                                          /* map enabled? */
-    for (; ba < lim; ba = ba + 2) {                     /* by words */
-        ma = Map_Addr (ba);                             /* map addr */
-        if (!ADDR_IS_MEM (ma))                          /* NXM? err */
+    for (; ba < lim; ba = ba + run) {                   /* by map runs */
+        run = Map_Run (ba, lim, &ma);                   /* map addr */
+        if (run == 0)                                   /* NXM? err */
 #ifdef OPCON
             {
 	    if (oc_active) oc_set_master(TRUE);
@@ -373,7 +425,8 @@ if (cpu_bme) {                                          /* map enabled? */
 #else
             return (lim - ba);
 #endif
-        *buf++ = (uint16) RdMemW (ma);
+        Map_RdMemWBlk (ma, run, buf);
+        buf = buf + (run >> 1);
         }
 #ifdef OPCON
     if (oc_active) oc_set_master(TRUE);
@@ -386,9 +439,8 @@ else {                                                  /* physical */
     else if (ADDR_IS_MEM (ba))                          /* no, strt ok? */
         alim = MEMSIZE;
     else return bc;                                     /* no, err */
-    for ( ; ba < alim; ba = ba + 2) {                   /* by words */
-        *buf++ = (uint16) RdMemW (ba);
-        }
+    if (ba < alim)                                      /* by block */
+        Map_RdMemWBlk (ba, alim - ba, buf);
 #ifdef OPCON
     if (oc_active) oc_set_master(TRUE);
 #endif
@@ -469,7 +521,7 @@ else {                                                  /* physical */
 
 int32 Map_WriteW (uint32 ba, int32 bc, const uint16 *buf)
 {
-uint32 alim, lim, ma;
+uint32 alim, lim, ma, run;
 
 #ifdef OPCON
 if (oc_active) oc_set_master(FALSE);
@@ -501,9 +553,9 @@ if (UNIBUS && (ba >= (uint32)(IOPAGEBASE & UNIMASK))) {
 ba = (ba & BUSMASK) & ~01;                              /* trim, align addr */
 lim = ba + (bc & ~01);
 if (cpu_bme) {                                          /* map enabled? */
-    for (; ba < lim; ba = ba + 2) {                     /* by words */
-        ma = Map_Addr (ba);                             /* map addr */
-        if (!ADDR_IS_MEM (ma))                          /* NXM? err */
+    for (; ba < lim; ba = ba + run) {                   /* by map runs */
+        run = Map_Run (ba, lim, &ma);                   /* map addr */
+        if (run == 0)                                   /* NXM? err */
 #ifdef OPCON
             {
 	    if (oc_active) oc_set_master(TRUE);
@@ -512,7 +564,8 @@ if (cpu_bme) {                                          /* map enabled? */
 #else
             return (lim - ba);
 #endif
-        WrMemW (ma, *buf++);
+        Map_WrMemWBlk (ma, run, buf);
+        buf = buf + (run >> 1);
         }
 #ifdef OPCON
     if (oc_active) oc_set_master(TRUE);
@@ -532,9 +585,8 @@ else {                                                  /* physical */
 #else
     else return bc;                                     /* no, err */
 #endif
-    for ( ; ba < alim; ba = ba + 2) {                   /* by words */
-        WrMemW (ba, *buf++);
-        }
+    if (ba < alim)                                      /* by block */
+        Map_WrMemWBlk (ba, alim - ba, buf);
 #ifdef OPCON
     if (oc_active) oc_set_master(TRUE);
 #endif
@@ -365,6 +365,10 @@ static const MTAB rl_mod[] = {
         &rl_set_bad, NULL, NULL, "Write bad block table on last track" },
     { MTAB_XTD|MTAB_VUN|MTAB_VALR, 0, "FORMAT", "FORMAT={SIMH|VHD|RAW}",
       &sim_disk_set_fmt, &sim_disk_show_fmt, NULL, "Display disk format" },
+    { MTAB_XTD|MTAB_VUN, 1, NULL, "COMMIT",
+      &sim_disk_set_overlay, NULL, NULL, "Write disk overlay (ATTACH -S) to the container" },
+    { MTAB_XTD|MTAB_VUN, 0, NULL, "DISCARD",
+      &sim_disk_set_overlay, NULL, NULL, "Discard disk overlay (ATTACH -S) contents" },
     { (UNIT_RL02+UNIT_ATT), UNIT_ATT, "RL01", NULL, NULL },
     { (UNIT_RL02+UNIT_ATT), (UNIT_RL02+UNIT_ATT), "RL02", NULL, NULL },
     { (UNIT_AUTO+UNIT_RL02+UNIT_ATT),         0, "RL01", NULL, 
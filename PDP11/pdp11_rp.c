@@ -653,6 +653,10 @@ MTAB rp_mod[] = {
         &rp_set_bad, NULL, NULL, "write bad block table on last track" },
     { MTAB_XTD|MTAB_VUN|MTAB_VALR, 0, "FORMAT", "FORMAT={SIMH|VHD|RAW}",
       &sim_disk_set_fmt, &sim_disk_show_fmt, NULL, "Display disk format" },
+    { MTAB_XTD|MTAB_VUN, 1, NULL, "COMMIT",
+      &sim_disk_set_overlay, NULL, NULL, "Write disk overlay (ATTACH -S) to the container" },
+    { MTAB_XTD|MTAB_VUN, 0, NULL, "DISCARD",
+      &sim_disk_set_overlay, NULL, NULL, "Discard disk overlay (ATTACH -S) contents" },
     { (UNIT_DTYPE+UNIT_ATT), (RM03_DTYPE << UNIT_V_DTYPE) + UNIT_ATT,
       "RM03", NULL, NULL },
     { (UNIT_DTYPE+UNIT_ATT), (RP04_DTYPE << UNIT_V_DTYPE) + UNIT_ATT,
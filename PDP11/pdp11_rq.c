@@ -151,6 +151,7 @@ extern int32 MMR2;
 #define RQ_NUMDR        4                               /* # drives */
 #define RQ_NUMBY        512                             /* bytes per block */
 #define RQ_MAXFR        (1 << 16)                       /* max xfer */
+#define RQ_MAXXFR       4                               /* xfer cmds in progress per unit */
 #define RQ_MAPXFER      (1u << 31)                      /* mapped xfer */
 #define RQ_M_PFN        0x1FFFFF                        /* map entry PFN */
 
@@ -171,8 +172,6 @@ extern int32 MMR2;
 #define uf              buf                             /* settable unit flags */
 #define cnum            wait                            /* controller index */
 #define unit_plug       u4                              /* drive unit plug value */
-#define io_status       u5                              /* io status from callback */
-#define io_complete     u6                              /* io completion flag */
 #define rqxb            filebuf                         /* xfer buffer */
 #define UNIT_WPRT       (UNIT_WLK | UNIT_RO)            /* write prot */
 #define RQ_RMV(u)       ((drv_tab[GET_DTYPE (u->flags)].flgs & RQDF_RMV)? \
@@ -791,6 +790,32 @@ int32 rq_itime4 = 10;                                   /* stage 4 */
 int32 rq_qtime = RQ_QTIME;                              /* queue time */
 int32 rq_xtime = RQ_XTIME;                              /* transfer time */
 
+/* Transfer commands in progress.  Each unit can have RQ_MAXXFR transfer
+   commands handed to the disk library at once, each with its own part of
+   the unit's transfer buffer.
+
+   The disk library delivers a unit's completion callbacks in the order
+   its transfers were issued (synchronously, or from the asynchronous
+   request queue in submission order), so rq_io_complete gives each
+   completion to the oldest slot with a transfer outstanding.  The unit
+   service reports completed slots in issue order too, each no sooner
+   than rq_xtime after its command started, as with a single transfer.
+
+   Only the packet of each slot is saved (XPKT); the progress of the
+   command is in the packet's working fields.  A slot with a packet and
+   no disk transfer outstanding or complete (after a RESTORE or DETACH)
+   is restarted from those fields by the unit service routine. */
+
+struct rq_xfr {
+    uint16              pkt;                            /* command packet, 0 if aborted */
+    t_bool              active;                         /* slot in use */
+    t_bool              busy;                           /* disk transfer outstanding */
+    t_bool              done;                           /* disk transfer complete */
+    t_stat              status;                         /* disk transfer status */
+    uint32              seq;                            /* disk transfer issue order */
+    uint32              start;                          /* command start time */
+    };
+
 typedef struct {
     uint32              cnum;                           /* ctrl number */
     uint32              sa;                             /* status, addr */
@@ -814,6 +839,8 @@ typedef struct {
     struct uq_ring      rq;                             /* rsp ring */
     struct rqpkt        pak[RQ_NPKTS];                  /* packet queue */
     uint16              max_plug;                       /* highest unit plug number */
+    struct rq_xfr       xfr[RQ_NUMDR][RQ_MAXXFR];      /* transfers in progress */
+    uint32              xseq;                           /* disk transfer sequence */
     } MSC;
 
 /* debugging bitmaps */
@@ -899,8 +926,8 @@ t_bool rq_rw (MSC *cp, uint16 pkt, t_bool q);
 t_bool rq_scc (MSC *cp, uint16 pkt, t_bool q);
 t_bool rq_suc (MSC *cp, uint16 pkt, t_bool q);
 t_bool rq_plf (MSC *cp, uint16 err);
-t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 err);
-t_bool rq_hbe (MSC *cp, UNIT *uptr);
+t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 tpkt, uint16 err);
+t_bool rq_hbe (MSC *cp, UNIT *uptr, uint16 tpkt);
 t_bool rq_una (MSC *cp, uint16 un);
 t_bool rq_deqf (MSC *cp, uint16 *pkt);
 uint16 rq_deqh (MSC *cp, uint16 *lh);
@@ -911,7 +938,13 @@ t_bool rq_putpkt (MSC *cp, uint16 pkt, t_bool qt);
 t_bool rq_getdesc (MSC *cp, struct uq_ring *ring, uint32 *desc);
 t_bool rq_putdesc (MSC *cp, struct uq_ring *ring, uint32 desc);
 uint16 rq_rw_valid (MSC *cp, uint16 pkt, UNIT *uptr, uint16 cmd);
-t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint16 flg, uint16 sts);
+t_bool rq_rw_end (MSC *cp, UNIT *uptr, struct rq_xfr *xfr, uint16 flg, uint16 sts);
+t_bool rq_xfr_start (MSC *cp, UNIT *uptr, struct rq_xfr *xfr);
+t_stat rq_xfr_done (MSC *cp, UNIT *uptr, struct rq_xfr *xfr);
+struct rq_xfr *rq_xfr_free (MSC *cp, UNIT *uptr);
+struct rq_xfr *rq_xfr_find (MSC *cp, UNIT *uptr, uint32 ref);
+void rq_xfr_cpkt (MSC *cp, UNIT *uptr);
+void rq_xfr_sched (MSC *cp, UNIT *uptr);
 uint32 rq_map_ba (uint32 ba, uint32 ma);
 int32 rq_readb (uint32 ba, int32 bc, uint32 ma, uint8 *buf);
 int32 rq_readw (uint32 ba, int32 bc, uint32 ma, uint16 *buf);
@@ -990,6 +1023,7 @@ REG rq_reg[] = {
     { DRDATAD (XTIME,   rq_xtime,                   24, "response time for data transfers"), PV_LEFT + REG_NZ },
     { BRDATAD (PKTS,    rq_ctx.pak,     DEV_RDX,    16, sizeof(rq_ctx.pak)/2, "packet buffers, 33W each, 32 entries") },
     { URDATAD (CPKT,    rq_unit[0].cpkt, 10, 5, 0, RQ_NUMDR, 0, "current packet, units 0 to 3") },
+    { STRDATAD (XPKT,   rq_ctx.xfr[0][0].pkt, 10, 16, 0, RQ_NUMDR * RQ_MAXXFR, sizeof (struct rq_xfr), REG_HRO, "transfer packets, 4 per unit") },
     { URDATAD (UCNUM,   rq_unit[0].cnum, 10, 5, 0, RQ_NUMDR, 0, "ctrl number, units 0 to 3") },
     { URDATAD (PKTQ,    rq_unit[0].pktq, 10, 5, 0, RQ_NUMDR, 0, "packet queue, units 0 to 3") },
     { URDATAD (UFLG,    rq_unit[0].uf,  DEV_RDX, 16, 0, RQ_NUMDR, 0, "unit flags, units 0 to 3") },
@@ -1088,6 +1122,10 @@ MTAB rq_mod[] = {
     { UNIT_NOAUTO,           0, "autosize",   "AUTOSIZE",   NULL, NULL, NULL, "Enables disk autosize on attach" },
     { MTAB_XTD|MTAB_VUN|MTAB_VALR, 0, "FORMAT", "FORMAT={SIMH|VHD|RAW}",
       &sim_disk_set_fmt, &sim_disk_show_fmt, NULL, "Set/Display disk format" },
+    { MTAB_XTD|MTAB_VUN, 1, NULL, "COMMIT",
+      &sim_disk_set_overlay, NULL, NULL, "Write disk overlay (ATTACH -S) to the container" },
+    { MTAB_XTD|MTAB_VUN, 0, NULL, "DISCARD",
+      &sim_disk_set_overlay, NULL, NULL, "Discard disk overlay (ATTACH -S) contents" },
 #if defined (VM_PDP11)
     { MTAB_XTD|MTAB_VDV|MTAB_VALR, 004, "ADDRESS", "ADDRESS",
       &set_addr, &show_addr, NULL, "Bus address" },
@@ -1169,6 +1207,7 @@ REG rqb_reg[] = {
     { FLDATA  (CTYPE,   rqb_ctx.ctype,               32), REG_HIDDEN  },
     { BRDATAD (PKTS,    rqb_ctx.pak,     DEV_RDX,    16, sizeof(rq_ctx.pak)/2, "packet buffers, 33W each, 32 entries") },
     { URDATAD (CPKT,    rqb_unit[0].cpkt, 10, 5, 0, RQ_NUMDR, 0, "current packet, units 0 to 3") },
+    { STRDATAD (XPKT,   rqb_ctx.xfr[0][0].pkt, 10, 16, 0, RQ_NUMDR * RQ_MAXXFR, sizeof (struct rq_xfr), REG_HRO, "transfer packets, 4 per unit") },
     { URDATAD (UCNUM,   rqb_unit[0].cnum, 10, 5, 0, RQ_NUMDR, 0, "ctrl number, units 0 to 3") },
     { URDATAD (PKTQ,    rqb_unit[0].pktq, 10, 5, 0, RQ_NUMDR, 0, "packet queue, units 0 to 3") },
     { URDATAD (UFLG,    rqb_unit[0].uf,  DEV_RDX, 16, 0, RQ_NUMDR, 0, "unit flags, units 0 to 3") },
@@ -1244,6 +1283,7 @@ REG rqc_reg[] = {
     { FLDATA  (CTYPE,   rqc_ctx.ctype,               32), REG_HIDDEN  },
     { BRDATAD (PKTS,    rqc_ctx.pak,     DEV_RDX,    16, sizeof(rq_ctx.pak)/2, "packet buffers, 33W each, 32 entries") },
     { URDATAD (CPKT,    rqc_unit[0].cpkt, 10, 5, 0, RQ_NUMDR, 0, "current packet, units 0 to 3") },
+    { STRDATAD (XPKT,   rqc_ctx.xfr[0][0].pkt, 10, 16, 0, RQ_NUMDR * RQ_MAXXFR, sizeof (struct rq_xfr), REG_HRO, "transfer packets, 4 per unit") },
     { URDATAD (UCNUM,   rqc_unit[0].cnum, 10, 5, 0, RQ_NUMDR, 0, "ctrl number, units 0 to 3") },
     { URDATAD (PKTQ,    rqc_unit[0].pktq, 10, 5, 0, RQ_NUMDR, 0, "packet queue, units 0 to 3") },
     { URDATAD (UFLG,    rqc_unit[0].uf,  DEV_RDX, 16, 0, RQ_NUMDR, 0, "unit flags, units 0 to 3") },
@@ -1319,6 +1359,7 @@ REG rqd_reg[] = {
     { FLDATA  (CTYPE,   rqd_ctx.ctype,               32), REG_HIDDEN  },
     { BRDATAD (PKTS,    rqd_ctx.pak,     DEV_RDX,    16, sizeof(rq_ctx.pak)/2, "packet buffers, 33W each, 32 entries") },
     { URDATAD (CPKT,    rqd_unit[0].cpkt, 10, 5, 0, RQ_NUMDR, 0, "current packet, units 0 to 3") },
+    { STRDATAD (XPKT,   rqd_ctx.xfr[0][0].pkt, 10, 16, 0, RQ_NUMDR * RQ_MAXXFR, sizeof (struct rq_xfr), REG_HRO, "transfer packets, 4 per unit") },
     { URDATAD (UCNUM,   rqd_unit[0].cnum, 10, 5, 0, RQ_NUMDR, 0, "ctrl number, units 0 to 3") },
     { URDATAD (PKTQ,    rqd_unit[0].pktq, 10, 5, 0, RQ_NUMDR, 0, "packet queue, units 0 to 3") },
     { URDATAD (UFLG,    rqd_unit[0].uf,  DEV_RDX, 16, 0, RQ_NUMDR, 0, "unit flags, units 0 to 3") },
@@ -1558,7 +1599,10 @@ if (cp->csta < CST_UP) {                                /* still init? */
 
 for (i = 0; i < RQ_NUMDR; i++) {                        /* chk unit q's */
     nuptr = dptr->units + i;                            /* ptr to unit */
-    if (nuptr->cpkt || (nuptr->pktq == 0))
+    if ((nuptr->pktq == 0) ||
+        (nuptr->cpkt &&                                 /* busy and not a xfer */
+         ((GETP (nuptr->pktq, CMD_OPC, OPC) < OP_ACC) ||/* which can start now? */
+          !rq_xfr_free (cp, nuptr))))
         continue;
     pkt = rq_deqh (cp, &nuptr->pktq);                   /* get top of q */
     if (!rq_mscp (cp, pkt, FALSE))                      /* process */
@@ -1694,17 +1738,19 @@ uint16 cmd = GETP (pkt, CMD_OPC, OPC);                  /* opcode */
 uint32 ref = GETP32 (pkt, ABO_REFL);                    /* cmd ref # */
 uint16 tpkt, prv;
 UNIT *uptr;
+struct rq_xfr *xfr;
 DEVICE *dptr = rq_devmap[cp->cnum];
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_abo\n");
 
 tpkt = 0;                                               /* set no mtch */
 if ((uptr = rq_getucb (cp, lu))) {                      /* get unit */
-    if (uptr->cpkt &&                                   /* curr pkt? */
-        (GETP32 (uptr->cpkt, CMD_REFL) == ref)) {       /* match ref? */
-        tpkt = uptr->cpkt;                              /* save match */
-        uptr->cpkt = 0;                                 /* gonzo */
-        sim_cancel (uptr);                              /* cancel unit */
+    if ((xfr = rq_xfr_find (cp, uptr, ref))) {          /* xfer in progress? */
+        tpkt = xfr->pkt;                                /* save match */
+        xfr->pkt = 0;                                   /* gonzo, slot freed */
+        if (!xfr->busy && !xfr->done)                   /*   when disk xfer done */
+            xfr->active = FALSE;
+        rq_xfr_cpkt (cp, uptr);
         sim_activate (dptr->units + RQ_QUEUE, rq_qtime);
         }
     else if (uptr->pktq &&                              /* head of q? */
@@ -1769,12 +1815,13 @@ uint16 cmd = GETP (pkt, CMD_OPC, OPC);                  /* opcode */
 uint32 ref = GETP32 (pkt, GCS_REFL);                    /* ref # */
 int32 tpkt;
 UNIT *uptr;
+struct rq_xfr *xfr;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_gcs\n");
 
 if ((uptr = rq_getucb (cp, lu)) &&                      /* valid lu? */
-    (tpkt = uptr->cpkt) &&                              /* queued pkt? */
-    (GETP32 (tpkt, CMD_REFL) == ref) &&                 /* match ref? */
+    (xfr = rq_xfr_find (cp, uptr, ref)) &&              /* xfer with ref? */
+    (tpkt = xfr->pkt) &&
     (GETP (tpkt, CMD_OPC, OPC) >= OP_ACC)) {            /* rd/wr cmd? */
     cp->pak[pkt].d[GCS_STSL] = cp->pak[tpkt].d[RW_WBCL];
     cp->pak[pkt].d[GCS_STSH] = cp->pak[tpkt].d[RW_WBCH];
@@ -1977,11 +2024,14 @@ uint16 lu = cp->pak[pkt].d[CMD_UN];                     /* unit # */
 uint16 cmd = GETP (pkt, CMD_OPC, OPC);                  /* opcode */
 uint16 sts;
 UNIT *uptr;
+struct rq_xfr *xfr;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_rw(lu=%d, pkt=%d, queue=%s)\n", lu, pkt, q?"yes" : "no");
 
 if ((uptr = rq_getucb (cp, lu))) {                      /* unit exist? */
-    if (q && uptr->cpkt) {                              /* need to queue? */
+    xfr = rq_xfr_free (cp, uptr);                       /* free xfer slot */
+    if (q && ((uptr->cpkt && uptr->pktq) ||             /* need to queue? */
+              (xfr == NULL))) {
         uint16 tpktq = uptr->pktq;
 
         sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_rw - queued\n");
@@ -1990,9 +2040,17 @@ if ((uptr = rq_getucb (cp, lu))) {                      /* unit exist? */
         uptr->pktq = tpktq;
         return OK;
         }
+    if (xfr == NULL) {                                  /* no slot? */
+        rq_enqh (cp, &uptr->pktq, pkt);                 /* retry later */
+        return OK;
+        }
     sts = rq_rw_valid (cp, pkt, uptr, cmd);             /* validity checks */
     if (sts == 0) {                                     /* ok? */
-        uptr->cpkt = pkt;                               /* op in progress */
+        xfr->active = TRUE;                             /* op in progress */
+        xfr->busy = xfr->done = FALSE;
+        xfr->pkt = pkt;
+        xfr->start = sim_grtime();
+        rq_xfr_cpkt (cp, uptr);
         cp->pak[pkt].d[RW_WBAL] = cp->pak[pkt].d[RW_BAL];
         cp->pak[pkt].d[RW_WBAH] = cp->pak[pkt].d[RW_BAH];
         cp->pak[pkt].d[RW_WBCL] = cp->pak[pkt].d[RW_BCL];
@@ -2001,10 +2059,8 @@ if ((uptr = rq_getucb (cp, lu))) {                      /* unit exist? */
         cp->pak[pkt].d[RW_WBLH] = cp->pak[pkt].d[RW_LBNH];
         cp->pak[pkt].d[RW_WMPL] = cp->pak[pkt].d[RW_MAPL];
         cp->pak[pkt].d[RW_WMPH] = cp->pak[pkt].d[RW_MAPH];
-        uptr->iostarttime = sim_grtime();
-        sim_activate (uptr, 0);                         /* activate */
         sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_rw - started\n");
-        return OK;                                      /* done */
+        return rq_xfr_start (cp, uptr, xfr);            /* start first xfer */
         }
     }
 else sts = ST_OFL;                                      /* offline */
@@ -2058,13 +2114,91 @@ return 0;                                               /* success! */
 void rq_io_complete (UNIT *uptr, t_stat status)
 {
 MSC *cp = rq_ctxmap[uptr->cnum];
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+struct rq_xfr *xfr = NULL;
+int32 i;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_io_complete(status=%d)\n", status);
 
-uptr->io_status = status;
-uptr->io_complete = 1;
-/* Reschedule for the appropriate delay */
-sim_activate_notbefore (uptr, uptr->iostarttime+rq_xtime);
+for (i = 0; i < RQ_MAXXFR; i++) {                       /* oldest outstanding */
+    if (uxfr[i].busy &&
+        ((xfr == NULL) || ((int32)(uxfr[i].seq - xfr->seq) < 0)))
+        xfr = &uxfr[i];
+    }
+if (xfr == NULL)                                        /* unit was reset */
+    return;
+xfr->busy = FALSE;
+xfr->done = TRUE;
+xfr->status = status;
+rq_xfr_sched (cp, uptr);                                /* reschedule for the appropriate delay */
+}
+
+/* Schedule the unit service for the oldest completed transfer, rq_xtime
+   after its command started.  This uses sim_activate rather than
+   sim_activate_notbefore: cancelling the unit would wait for its other
+   disk transfers.  While they are outstanding the unit counts as active
+   and nothing is scheduled; the completion of the last of them does it.
+   An earlier activation (such as the disk library's completion latency)
+   just finds the transfer not yet due and schedules the rest. */
+
+void rq_xfr_sched (MSC *cp, UNIT *uptr)
+{
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+struct rq_xfr *xfr = NULL;
+int32 i, delay;
+
+for (i = 0; i < RQ_MAXXFR; i++) {                       /* oldest completed */
+    if (uxfr[i].done &&
+        ((xfr == NULL) || ((int32)(uxfr[i].seq - xfr->seq) < 0)))
+        xfr = &uxfr[i];
+    }
+if (xfr == NULL)
+    return;
+delay = (int32)(xfr->start + rq_xtime - sim_grtime ());
+sim_activate (uptr, (delay < 0) ? 0 : delay);
+}
+
+/* Transfer slot management */
+
+struct rq_xfr *rq_xfr_free (MSC *cp, UNIT *uptr)
+{
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+int32 i;
+
+for (i = 0; i < RQ_MAXXFR; i++) {
+    if (!uxfr[i].active)
+        return &uxfr[i];
+    }
+return NULL;
+}
+
+struct rq_xfr *rq_xfr_find (MSC *cp, UNIT *uptr, uint32 ref)
+{
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+int32 i;
+
+for (i = 0; i < RQ_MAXXFR; i++) {
+    if (uxfr[i].active && uxfr[i].pkt &&
+        (GETP32 (uxfr[i].pkt, CMD_REFL) == ref))
+        return &uxfr[i];
+    }
+return NULL;
+}
+
+/* Unit's current packet is that of its oldest transfer in progress */
+
+void rq_xfr_cpkt (MSC *cp, UNIT *uptr)
+{
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+struct rq_xfr *xfr = NULL;
+int32 i;
+
+for (i = 0; i < RQ_MAXXFR; i++) {
+    if (uxfr[i].active && uxfr[i].pkt &&
+        ((xfr == NULL) || ((int32)(uxfr[i].start - xfr->start) < 0)))
+        xfr = &uxfr[i];
+    }
+uptr->cpkt = xfr ? xfr->pkt : 0;
 }
 
 /* Map buffer address */
@@ -2166,121 +2300,195 @@ return Map_WriteW (ba, bc, buf);                        /* unmapped xfer */
 t_stat rq_svc (UNIT *uptr)
 {
 MSC *cp = rq_ctxmap[uptr->cnum];
+struct rq_xfr *uxfr, *xfr;
+uint32 seq;
+int32 i;
+t_stat r, ret = SCPE_OK;
+
+if (cp == NULL)                                         /* what??? */
+    return STOP_RQ;
+uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+seq = cp->xseq;                                         /* xfers issued from here on */
+for (i = 0; i < RQ_MAXXFR; i++) {                       /* restored or orphaned xfers */
+    xfr = &uxfr[i];
+    if (xfr->busy || xfr->done)
+        continue;
+    xfr->active = (xfr->pkt != 0);
+    if (xfr->active) {                                  /* restart from pkt */
+        xfr->start = sim_grtime();
+        rq_xfr_start (cp, uptr, xfr);
+        }
+    }
+if (uptr->cpkt &&                                       /* old save file xfer */
+    (rq_xfr_find (cp, uptr, GETP32 (uptr->cpkt, CMD_REFL)) == NULL) &&
+    (xfr = rq_xfr_free (cp, uptr))) {                   /* not yet in a slot? */
+    xfr->active = TRUE;
+    xfr->busy = xfr->done = FALSE;
+    xfr->pkt = uptr->cpkt;
+    xfr->start = sim_grtime();
+    rq_xfr_start (cp, uptr, xfr);
+    return SCPE_OK;
+    }
+for (;;) {                                              /* xfers issued from here wait */
+    xfr = NULL;                                         /* for their own delay */
+    for (i = 0; i < RQ_MAXXFR; i++) {                   /* oldest completed xfer */
+        if (uxfr[i].done && ((int32)(uxfr[i].seq - seq) < 0) &&
+            ((xfr == NULL) || ((int32)(uxfr[i].seq - xfr->seq) < 0)))
+            xfr = &uxfr[i];
+        }
+    if ((xfr == NULL) ||                                /* none, or not yet due? */
+        ((int32)(sim_grtime () - (xfr->start + rq_xtime)) < 0))
+        break;
+    r = rq_xfr_done (cp, uptr, xfr);
+    if (r != SCPE_OK)
+        ret = r;
+    }
+rq_xfr_sched (cp, uptr);                                /* report the rest when due */
+return ret;
+}
+
+/* Start the disk transfer for the next part of a transfer command */
+
+t_bool rq_xfr_start (MSC *cp, UNIT *uptr, struct rq_xfr *xfr)
+{
 uint32 i, t, tbc, abc, wwc;
-uint32 err = 0;
-int32 pkt = uptr->cpkt;                                 /* get packet */
+uint16 pkt = xfr->pkt;                                  /* get packet */
+uint16 *xb = ((uint16 *)uptr->rqxb) + (xfr - cp->xfr[uptr - rq_devmap[cp->cnum]->units]) * (RQ_MAXFR >> 1);
 uint32 cmd, ba, bc, bl, ma;
 
-if ((cp == NULL) || (pkt == 0))                         /* what??? */
-    return STOP_RQ;
 cmd = GETP (pkt, CMD_OPC, OPC);                         /* get cmd */
 ba = GETP32 (pkt, RW_WBAL);                             /* buf addr */
 bc = GETP32 (pkt, RW_WBCL);                             /* byte count */
 bl = GETP32 (pkt, RW_WBLL);                             /* block addr */
 ma = GETP32 (pkt, RW_WMPL);                             /* block addr */
 
-sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_svc(%s,unit=%d, pkt=%d, cmd=%s, lbn=%0X, bc=%0x, phase=%s)\n",
-           sim_uname (uptr), uptr->unit_plug, pkt, rq_cmdname[cp->pak[pkt].d[CMD_OPC]&0x3f], bl, bc,
-           uptr->io_complete ? "bottom" : "top");
+sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_xfr_start(%s,unit=%d, pkt=%d, cmd=%s, lbn=%0X, bc=%0x)\n",
+           sim_uname (uptr), uptr->unit_plug, pkt, rq_cmdname[cp->pak[pkt].d[CMD_OPC]&0x3f], bl, bc);
 
 tbc = (bc > RQ_MAXFR)? RQ_MAXFR: bc;                    /* trim cnt to max */
 
-if ((uptr->flags & UNIT_ATT) == 0) {                    /* not attached? */
-    rq_rw_end (cp, uptr, 0, ST_OFL | SB_OFL_NV);        /* offl no vol */
-    return SCPE_OK;
+if ((uptr->flags & UNIT_ATT) == 0)                      /* not attached? */
+    return rq_rw_end (cp, uptr, xfr, 0, ST_OFL | SB_OFL_NV);/* offl no vol */
+if (bc == 0)                                            /* no xfer? */
+    return rq_rw_end (cp, uptr, xfr, 0, ST_SUC);        /* ok by me... */
+
+if ((cmd == OP_ERS) || (cmd == OP_WR)) {                /* write op? */
+    if (RQ_WPH (uptr))
+        return rq_rw_end (cp, uptr, xfr, 0, ST_WPR | SB_WPR_HW);
+    if (uptr->uf & UF_WPS)
+        return rq_rw_end (cp, uptr, xfr, 0, ST_WPR | SB_WPR_SW);
     }
-if (bc == 0) {                                          /* no xfer? */
-    rq_rw_end (cp, uptr, 0, ST_SUC);                    /* ok by me... */
-    return SCPE_OK;
+
+xfr->busy = TRUE;                                       /* the callback may */
+xfr->done = FALSE;                                      /* come before we return */
+xfr->seq = cp->xseq++;
+if (cmd == OP_ERS) {                                    /* erase? */
+    wwc = ((tbc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
+    memset (xb, 0, wwc * sizeof(uint16));               /* clr buf */
+    sim_disk_data_trace(uptr, (uint8 *)xb, bl, wwc << 1, "sim_disk_wrsect-ERS", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
+    sim_disk_wrsect_a (uptr, bl, (uint8 *)xb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
     }
 
-if ((cmd == OP_ERS) || (cmd == OP_WR)) {                /* write op? */
-    if (RQ_WPH (uptr)) {
-        rq_rw_end (cp, uptr, 0, ST_WPR | SB_WPR_HW);
-        return SCPE_OK;
+else if (cmd == OP_WR) {                                /* write? */
+    t = rq_readw (ba, tbc, ma, xb);                     /* fetch buffer */
+    if ((abc = tbc - t)) {                              /* any xfer? */
+        wwc = ((abc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
+        for (i = (abc >> 1); i < wwc; i++)
+            xb[i] = 0;
+        sim_disk_data_trace(uptr, (uint8 *)xb, bl, wwc << 1, "sim_disk_wrsect-WR", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
+        sim_disk_wrsect_a (uptr, bl, (uint8 *)xb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
         }
-    if (uptr->uf & UF_WPS) {
-        rq_rw_end (cp, uptr, 0, ST_WPR | SB_WPR_SW);
-        return SCPE_OK;
+    else {                                              /* nxm, nothing to write */
+        xfr->busy = FALSE;                              /* report it from rq_svc */
+        xfr->done = TRUE;
+        xfr->status = SCPE_OK;
+        rq_xfr_sched (cp, uptr);
         }
     }
 
-if (!uptr->io_complete) { /* Top End (I/O Initiation) Processing */
-    if (cmd == OP_ERS) {                                /* erase? */
-        wwc = ((tbc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
-        memset (uptr->rqxb, 0, wwc * sizeof(uint16));   /* clr buf */
-        sim_disk_data_trace(uptr, (uint8 *)uptr->rqxb, bl, wwc << 1, "sim_disk_wrsect-ERS", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
-        err = sim_disk_wrsect_a (uptr, bl, (uint8 *)uptr->rqxb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
-        }
+else {  /* OP_RD & OP_CMP */
+    sim_disk_rdsect_a (uptr, bl, (uint8 *)xb, NULL, (tbc + RQ_NUMBY - 1) / RQ_NUMBY, rq_io_complete);
+    }                                                   /* end else read */
+return OK;                                              /* done for now until callback */
+}
 
-    else if (cmd == OP_WR) {                            /* write? */
-        t = rq_readw (ba, tbc, ma, (uint16 *)uptr->rqxb);/* fetch buffer */
-        if ((abc = tbc - t)) {                          /* any xfer? */
-            wwc = ((abc + (RQ_NUMBY - 1)) & ~(RQ_NUMBY - 1)) >> 1;
-            for (i = (abc >> 1); i < wwc; i++)
-                ((uint16 *)(uptr->rqxb))[i] = 0;
-            sim_disk_data_trace(uptr, (uint8 *)uptr->rqxb, bl, wwc << 1, "sim_disk_wrsect-WR", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
-            err = sim_disk_wrsect_a (uptr, bl, (uint8 *)uptr->rqxb, NULL, (wwc << 1) / RQ_NUMBY, rq_io_complete);
-            }
-        }
+/* Finish a completed disk transfer */
+
+t_stat rq_xfr_done (MSC *cp, UNIT *uptr, struct rq_xfr *xfr)
+{
+uint32 i, t, tbc, abc;
+uint32 err = xfr->status;
+uint16 pkt = xfr->pkt;                                  /* get packet */
+uint16 *xb = ((uint16 *)uptr->rqxb) + (xfr - cp->xfr[uptr - rq_devmap[cp->cnum]->units]) * (RQ_MAXFR >> 1);
+uint32 cmd, ba, bc, bl, ma;
+DEVICE *dptr = rq_devmap[cp->cnum];
+
+xfr->done = FALSE;
+if (pkt == 0) {                                         /* aborted? */
+    xfr->active = FALSE;                                /* slot is free again */
+    if (uptr->pktq)                                     /* more to do? */
+        sim_activate (dptr->units + RQ_QUEUE, rq_qtime);/* activate thread */
+    return SCPE_OK;
+    }
+cmd = GETP (pkt, CMD_OPC, OPC);                         /* get cmd */
+ba = GETP32 (pkt, RW_WBAL);                             /* buf addr */
+bc = GETP32 (pkt, RW_WBCL);                             /* byte count */
+bl = GETP32 (pkt, RW_WBLL);                             /* block addr */
+ma = GETP32 (pkt, RW_WMPL);                             /* block addr */
+
+sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_xfr_done(%s,unit=%d, pkt=%d, cmd=%s, lbn=%0X, bc=%0x, status=%d)\n",
+           sim_uname (uptr), uptr->unit_plug, pkt, rq_cmdname[cp->pak[pkt].d[CMD_OPC]&0x3f], bl, bc, err);
+
+tbc = (bc > RQ_MAXFR)? RQ_MAXFR: bc;                    /* trim cnt to max */
 
-    else {  /* OP_RD & OP_CMP */
-        err = sim_disk_rdsect_a (uptr, bl, (uint8 *)uptr->rqxb, NULL, (tbc + RQ_NUMBY - 1) / RQ_NUMBY, rq_io_complete);
-        }                                               /* end else read */
-    return SCPE_OK;                                     /* done for now until callback */    
+if (cmd == OP_ERS) {                                    /* erase? */
     }
-else { /* Bottom End (After I/O processing) */
-    uptr->io_complete = 0;
-    err = uptr->io_status;
-    if (cmd == OP_ERS) {                                /* erase? */
+
+else if (cmd == OP_WR) {                                /* write? */
+    t = rq_readw (ba, tbc, ma, xb);                     /* fetch buffer */
+    abc = tbc - t;                                      /* any xfer? */
+    if (t) {                                            /* nxm? */
+        PUTP32 (pkt, RW_WBCL, bc - abc);                /* adj bc */
+        PUTP32 (pkt, RW_WBAL, ba + abc);                /* adj ba */
+        if (rq_hbe (cp, uptr, pkt))                     /* post err log */
+            rq_rw_end (cp, uptr, xfr, EF_LOG, ST_HST | SB_HST_NXM);
+        return SCPE_OK;                                 /* end else wr */
         }
+    }
 
-    else if (cmd == OP_WR) {                            /* write? */
-        t = rq_readw (ba, tbc, ma, (uint16 *)uptr->rqxb);/* fetch buffer */
-        abc = tbc - t;                                  /* any xfer? */
-        if (t) {                                        /* nxm? */
-            PUTP32 (pkt, RW_WBCL, bc - abc);            /* adj bc */
-            PUTP32 (pkt, RW_WBAL, ba + abc);            /* adj ba */
-            if (rq_hbe (cp, uptr))                      /* post err log */
-                rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);  
-            return SCPE_OK;                             /* end else wr */
+else {
+    sim_disk_data_trace(uptr, (uint8 *)xb, bl, tbc, "sim_disk_rdsect", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
+    if ((cmd == OP_RD) && !err) {                       /* read? */
+        if ((t = rq_writew (ba, tbc, ma, xb))) {        /* store, nxm? */
+            PUTP32 (pkt, RW_WBCL, bc - (tbc - t));      /* adj bc */
+            PUTP32 (pkt, RW_WBAL, ba + (tbc - t));      /* adj ba */
+            if (rq_hbe (cp, uptr, pkt))                 /* post err log */
+                rq_rw_end (cp, uptr, xfr, EF_LOG, ST_HST | SB_HST_NXM);
+            return SCPE_OK;
             }
         }
-
-    else {
-        sim_disk_data_trace(uptr, (uint8 *)uptr->rqxb, bl, tbc, "sim_disk_rdsect", DBG_DAT & rq_devmap[cp->cnum]->dctrl, DBG_REQ);
-        if ((cmd == OP_RD) && !err) {                   /* read? */
-            if ((t = rq_writew (ba, tbc, ma, (uint16 *)uptr->rqxb))) {/* store, nxm? */
-                PUTP32 (pkt, RW_WBCL, bc - (tbc - t));  /* adj bc */
-                PUTP32 (pkt, RW_WBAL, ba + (tbc - t));  /* adj ba */
-                if (rq_hbe (cp, uptr))                  /* post err log */
-                    rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);      
+    else if ((cmd == OP_CMP) && !err) {                 /* compare? */
+        uint8 dby, mby;
+        for (i = 0; i < tbc; i++) {                     /* loop */
+            if (rq_readb (ba + i, 1, ma, &mby)) {       /* fetch, nxm? */
+                PUTP32 (pkt, RW_WBCL, bc - i);          /* adj bc */
+                PUTP32 (pkt, RW_WBAL, bc - i);          /* adj ba */
+                if (rq_hbe (cp, uptr, pkt))             /* post err log */
+                    rq_rw_end (cp, uptr, xfr, EF_LOG, ST_HST | SB_HST_NXM);
                 return SCPE_OK;
                 }
-            }
-        else if ((cmd == OP_CMP) && !err) {             /* compare? */
-            uint8 dby, mby;
-            for (i = 0; i < tbc; i++) {                 /* loop */
-                if (rq_readb (ba + i, 1, ma, &mby)) {   /* fetch, nxm? */
-                    PUTP32 (pkt, RW_WBCL, bc - i);      /* adj bc */
-                    PUTP32 (pkt, RW_WBAL, bc - i);      /* adj ba */
-                    if (rq_hbe (cp, uptr))              /* post err log */
-                        rq_rw_end (cp, uptr, EF_LOG, ST_HST | SB_HST_NXM);
-                    return SCPE_OK;
-                    }
-                dby = (((uint16 *)(uptr->rqxb))[i >> 1] >> ((i & 1)? 8: 0)) & 0xFF;
-                if (mby != dby) {                       /* cmp err? */
-                    PUTP32 (pkt, RW_WBCL, bc - i);      /* adj bc */
-                    rq_rw_end (cp, uptr, 0, ST_CMP);    /* done */
-                    return SCPE_OK;                     /* exit */
-                    }                                   /* end if */
-                }                                       /* end for */
-            }                                           /* end else if */
-        }                                               /* end else read */
-    }                                                   /* end else bottom end */
+            dby = (xb[i >> 1] >> ((i & 1)? 8: 0)) & 0xFF;
+            if (mby != dby) {                           /* cmp err? */
+                PUTP32 (pkt, RW_WBCL, bc - i);          /* adj bc */
+                rq_rw_end (cp, uptr, xfr, 0, ST_CMP);   /* done */
+                return SCPE_OK;                         /* exit */
+                }                                       /* end if */
+            }                                           /* end for */
+        }                                               /* end else if */
+    }                                                   /* end else read */
 if (err != 0) {                                         /* error? */
-    if (rq_dte (cp, uptr, ST_DRV))                      /* post err log */
-        rq_rw_end (cp, uptr, EF_LOG, ST_DRV);           /* if ok, report err */
+    if (rq_dte (cp, uptr, pkt, ST_DRV))                 /* post err log */
+        rq_rw_end (cp, uptr, xfr, EF_LOG, ST_DRV);      /* if ok, report err */
     sim_disk_perror (uptr, "RQ I/O error");
     sim_disk_clearerr (uptr);
     return SCPE_IOERR;
@@ -2291,17 +2499,17 @@ bl = bl + ((tbc + (RQ_NUMBY - 1)) / RQ_NUMBY);          /* incr blk # */
 PUTP32 (pkt, RW_WBAL, ba);                              /* update pkt */
 PUTP32 (pkt, RW_WBCL, bc);
 PUTP32 (pkt, RW_WBLL, bl);
-if (bc)                                                 /* more? resched */
-    sim_activate (uptr, 0);
-else rq_rw_end (cp, uptr, 0, ST_SUC);                   /* done! */
+if (bc)                                                 /* more? */
+    rq_xfr_start (cp, uptr, xfr);
+else rq_rw_end (cp, uptr, xfr, 0, ST_SUC);              /* done! */
 return SCPE_OK;
 }
 
 /* Transfer command complete */
 
-t_bool rq_rw_end (MSC *cp, UNIT *uptr, uint16 flg, uint16 sts)
+t_bool rq_rw_end (MSC *cp, UNIT *uptr, struct rq_xfr *xfr, uint16 flg, uint16 sts)
 {
-uint16 pkt = uptr->cpkt;                                /* packet */
+uint16 pkt = xfr->pkt;                                  /* packet */
 uint16 cmd = GETP (pkt, CMD_OPC, OPC);                  /* get cmd */
 uint32 bc = GETP32 (pkt, RW_BCL);                       /* init bc */
 uint32 wbc = GETP32 (pkt, RW_WBCL);                     /* work bc */
@@ -2309,7 +2517,9 @@ DEVICE *dptr = rq_devmap[uptr->cnum];
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_rw_end\n");
 
-uptr->cpkt = 0;                                         /* done */
+xfr->active = FALSE;                                    /* done */
+xfr->pkt = 0;
+rq_xfr_cpkt (cp, uptr);
 PUTP32 (pkt, RW_BCL, bc - wbc);                         /* bytes processed */
 cp->pak[pkt].d[RW_WBAL] = 0;                            /* clear temps */
 cp->pak[pkt].d[RW_WBAH] = 0;
@@ -2329,9 +2539,9 @@ return OK;
 
 /* Data transfer error log packet */
 
-t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 err)
+t_bool rq_dte (MSC *cp, UNIT *uptr, uint16 tpkt, uint16 err)
 {
-uint16 pkt, tpkt;
+uint16 pkt;
 uint16 lu, ccyl, csurf, csect;
 uint32 dtyp, lbn, t;
 
@@ -2341,7 +2551,6 @@ if ((cp->cflgs & CF_THS) == 0)                          /* logging? */
     return OK;
 if (!rq_deqf (cp, &pkt))                                /* get log pkt */
     return ERR;
-tpkt = uptr->cpkt;                                      /* rw pkt */
 lu = cp->pak[tpkt].d[CMD_UN];                           /* unit # */
 lbn = GETP32 (tpkt, RW_WBLL);                           /* recent LBN */
 dtyp = GET_DTYPE (uptr->flags);                         /* drv type */
@@ -2385,9 +2594,9 @@ return rq_putpkt (cp, pkt, TRUE);
 
 /* Host bus error log packet */
 
-t_bool rq_hbe (MSC *cp, UNIT *uptr)
+t_bool rq_hbe (MSC *cp, UNIT *uptr, uint16 tpkt)
 {
-uint16 pkt, tpkt;
+uint16 pkt;
 
 sim_debug (DBG_TRC, rq_devmap[cp->cnum], "rq_hbe\n");
 
@@ -2395,7 +2604,6 @@ if ((cp->cflgs & CF_THS) == 0)                          /* logging? */
     return OK;
 if (!rq_deqf (cp, &pkt))                                /* get log pkt */
     return ERR;
-tpkt = uptr->cpkt;                                      /* rw pkt */
 cp->pak[pkt].d[ELP_REFL] = cp->pak[tpkt].d[CMD_REFL];   /* copy cmd ref */
 cp->pak[pkt].d[ELP_REFH] = cp->pak[tpkt].d[CMD_REFH];
 cp->pak[pkt].d[ELP_UN] = cp->pak[tpkt].d[CMD_UN];       /* copy unit */
@@ -2900,6 +3108,8 @@ return SCPE_OK;
 t_stat rq_attach (UNIT *uptr, CONST char *cptr)
 {
 MSC *cp = rq_ctxmap[uptr->cnum];
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+int32 i;
 t_stat r;
 
 r = sim_disk_attach (uptr, cptr, RQ_NUMBY, sizeof (uint16), (uptr->flags & UNIT_NOAUTO), DBG_DSK, drv_tab[GET_DTYPE (uptr->flags)].name, 0, 0);
@@ -2908,6 +3118,11 @@ if (r != SCPE_OK)
 
 if ((cp->csta == CST_UP) && sim_disk_isavailable (uptr))
     uptr->flags = uptr->flags | UNIT_ATP;
+for (i = 0; i < RQ_MAXXFR; i++) {                       /* xfers restored? */
+    if (uxfr[i].pkt && !uxfr[i].busy && !uxfr[i].done &&
+        !sim_is_active (uptr))
+        sim_activate (uptr, rq_xtime);                  /* restart them */
+    }
 return SCPE_OK;
 }
 
@@ -2915,6 +3130,10 @@ return SCPE_OK;
 
 t_stat rq_detach (UNIT *uptr)
 {
+MSC *cp = rq_ctxmap[uptr->cnum];
+struct rq_xfr *uxfr = cp->xfr[uptr - rq_devmap[cp->cnum]->units];
+t_bool restart = FALSE;
+int32 i;
 t_stat r;
 
 r = sim_disk_detach (uptr);                             /* detach unit */
@@ -2922,6 +3141,13 @@ if (r != SCPE_OK)
     return r;
 uptr->flags = uptr->flags & ~(UNIT_ONL | UNIT_ATP);     /* clr onl, atn pend */
 uptr->uf = 0;                                           /* clr unit flgs */
+for (i = 0; i < RQ_MAXXFR; i++) {                       /* disk xfers are gone */
+    uxfr[i].busy = uxfr[i].done = FALSE;
+    uxfr[i].active = (uxfr[i].pkt != 0);
+    restart |= uxfr[i].active;
+    }
+if (restart)                                            /* let rq_svc end them */
+    sim_activate (uptr, rq_xtime);
 return SCPE_OK;
 } 
 
@@ -3003,10 +3229,12 @@ for (i = 0; i < (RQ_NUMDR + 2); i++) {                  /* init units */
     uptr->flags = uptr->flags & ~(UNIT_ONL | UNIT_ATP);
     uptr->uf = 0;                                       /* clr unit flags */
     uptr->cpkt = uptr->pktq = 0;                        /* clr pkt q's */
-    uptr->rqxb = (uint16 *) realloc (uptr->rqxb, (RQ_MAXFR >> 1) * sizeof (uint16));
+    uptr->rqxb = (uint16 *) realloc (uptr->rqxb, (RQ_MAXFR >> 1) * sizeof (uint16) *
+                                                 ((i < RQ_NUMDR) ? RQ_MAXXFR : 1));
     if (uptr->rqxb == NULL)
         return SCPE_MEM;
     }
+memset (cp->xfr, 0, sizeof (cp->xfr));                  /* no xfers in progress */
 for (i=cp->max_plug=0; i<RQ_NUMDR; i++)
     if (dptr->units[i].unit_plug > cp->max_plug)
         cp->max_plug = (uint16)dptr->units[i].unit_plug;
@@ -3166,7 +3394,7 @@ t_stat rq_show_unitq (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
 {
 MSC *cp = rq_ctxmap[uptr->cnum];
 DEVICE *dptr = rq_devmap[uptr->cnum];
-int32 pkt, u;
+int32 i, pkt, u;
 
 u = (int32) (uptr - dptr->units);
 if (cp->csta != CST_UP) {
@@ -3180,8 +3408,12 @@ if ((uptr->flags & UNIT_ONL) == 0) {
     return SCPE_OK;
     }
 if (uptr->cpkt) {
-    fprintf (st, "Unit %d current ", u);
-    rq_show_pkt (st, cp, uptr->cpkt);
+    for (i = 0; i < RQ_MAXXFR; i++) {
+        if ((pkt = cp->xfr[u][i].pkt)) {
+            fprintf (st, "Unit %d current ", u);
+            rq_show_pkt (st, cp, pkt);
+            }
+        }
     if ((pkt = uptr->pktq)) {
         do {
             fprintf (st, "Unit %d queued ", u);
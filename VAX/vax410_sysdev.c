@@ -926,7 +926,7 @@ if ((cptr == NULL) || (!*cptr))
 cptr = get_glyph (cptr, gbuf, 0);
 if (MATCH_CMD(gbuf, "MICROVAX") == 0) {
     sys_model = 0;
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     va_dev.flags = vc_dev.flags | DEV_DIS;               /* disable GPX */
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     lk_dev.flags = lk_dev.flags | DEV_DIS;               /* disable keyboard */
@@ -936,7 +936,7 @@ if (MATCH_CMD(gbuf, "MICROVAX") == 0) {
     reset_all (0);                                       /* reset everything */
     }
 else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     va_dev.flags = va_dev.flags | DEV_DIS;               /* disable GPX */
     vc_dev.flags = vc_dev.flags & ~DEV_DIS;              /* enable MVO */
@@ -949,7 +949,7 @@ else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
 #endif
     }
 else if (MATCH_CMD(gbuf, "VAXSTATIONGPX") == 0) {
-#if defined (USE_SIM_VIDEO) && defined (HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     va_dev.flags = va_dev.flags & ~DEV_DIS;              /* enable GPX */
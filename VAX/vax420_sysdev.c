@@ -1130,7 +1130,7 @@ else
 if ((MATCH_CMD(gbuf, "VAXSERVER") == 0) ||
     (MATCH_CMD(gbuf, "MICROVAX") == 0)) {                /* needed by VA,VC,VE */
     sys_model = 0;
-#if defined (USE_SIM_VIDEO) && defined (HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     va_dev.flags = vc_dev.flags | DEV_DIS;               /* disable GPX */
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     ve_dev.flags = vc_dev.flags | DEV_DIS;               /* disable SPX */
@@ -1145,7 +1145,7 @@ if ((MATCH_CMD(gbuf, "VAXSERVER") == 0) ||
     reset_all (0);                                       /* reset everything */
     }
 else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
-#if defined (USE_SIM_VIDEO) && defined (HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     va_dev.flags = va_dev.flags | DEV_DIS;               /* disable GPX */
     ve_dev.flags = ve_dev.flags | DEV_DIS;               /* disable SPX */
@@ -1163,7 +1163,7 @@ else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
 #endif
     }
 else if (MATCH_CMD(gbuf, "VAXSTATIONGPX") == 0) {
-#if defined (USE_SIM_VIDEO) && defined (HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     ve_dev.flags = ve_dev.flags | DEV_DIS;               /* disable SPX */
@@ -1181,7 +1181,7 @@ else if (MATCH_CMD(gbuf, "VAXSTATIONGPX") == 0) {
 #endif
     }
 else if (MATCH_CMD(gbuf, "VAXSTATIONSPX") == 0) {
-#if defined (USE_SIM_VIDEO) && defined (HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     va_dev.flags = va_dev.flags | DEV_DIS;               /* disable GPX */
@@ -1054,7 +1054,7 @@ cptr = get_glyph (cptr, gbuf, 0);
 if ((MATCH_CMD(gbuf, "VAXSERVER") == 0) ||
     (MATCH_CMD(gbuf, "MICROVAX") == 0)) {                /* needed by VC,VE */
     sys_model = 0;
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     ve_dev.flags = vc_dev.flags | DEV_DIS;               /* disable SPX */
     lk_dev.flags = lk_dev.flags | DEV_DIS;               /* disable keyboard */
@@ -1064,7 +1064,7 @@ if ((MATCH_CMD(gbuf, "VAXSERVER") == 0) ||
     reset_all (0);                                       /* reset everything */
     }
 else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     ve_dev.flags = ve_dev.flags | DEV_DIS;               /* disable SPX */
     vc_dev.flags = vc_dev.flags & ~DEV_DIS;              /* enable MVO */
@@ -1077,7 +1077,7 @@ else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
 #endif
     }
 else if (MATCH_CMD(gbuf, "VAXSTATIONSPX") == 0) {
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable MVO */
     ve_dev.flags = ve_dev.flags & ~DEV_DIS;              /* enable SPX */
@@ -1047,7 +1047,7 @@ if ((cptr == NULL) || (!*cptr))
 cptr = get_glyph (cptr, gbuf, 0);
 if (MATCH_CMD(gbuf, "MICROVAX") == 0) {
     sys_model = 0;
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     lk_dev.flags = lk_dev.flags | DEV_DIS;               /* disable keyboard */
     vs_dev.flags = vs_dev.flags | DEV_DIS;               /* disable mouse */
 #endif
@@ -1056,7 +1056,7 @@ if (MATCH_CMD(gbuf, "MICROVAX") == 0) {
     }
 #if defined (VAX_46) || defined (VAX_48)
 else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     lk_dev.flags = lk_dev.flags & ~DEV_DIS;              /* enable keyboard */
     vs_dev.flags = vs_dev.flags & ~DEV_DIS;              /* enable mouse */
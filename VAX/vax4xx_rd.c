@@ -372,6 +372,10 @@ MTAB rd_mod[] = {
       NULL, &rd_show_type, NULL, "Display device type" },
     { MTAB_XTD|MTAB_VUN | MTAB_VALR, 0, "FORMAT", "FORMAT={SIMH|VHD|RAW}",
       &sim_disk_set_fmt, &sim_disk_show_fmt, NULL, "Display disk format" },
+    { MTAB_XTD|MTAB_VUN, 1, NULL, "COMMIT",
+      &sim_disk_set_overlay, NULL, NULL, "Write disk overlay (ATTACH -S) to the container" },
+    { MTAB_XTD|MTAB_VUN, 0, NULL, "DISCARD",
+      &sim_disk_set_overlay, NULL, NULL, "Discard disk overlay (ATTACH -S) contents" },
     { 0 }
     };
 
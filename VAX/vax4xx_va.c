@@ -976,14 +976,10 @@ lines = 0;
 for (ln = 0; ln < VA_YSIZE; ln++) {
     if (va_updated[ln + va_yoff]) {                     /* line updated? */
         off = (ln + va_yoff) * VA_XSIZE;                /* get video buf offet */
-        if (va_dpln > 0) {
-            for (col = 0; col < VA_XSIZE; col++)
-                va_lines[ln*VA_XSIZE + col] = (va_buf[off + col] & va_dpln) ? va_white : va_black;
-            }
-        else {
-            for (col = 0; col < VA_XSIZE; col++)
-                va_lines[ln*VA_XSIZE + col] = va_palette[va_buf[off + col] & VA_PLANE_MASK];
-            }
+        if (va_dpln > 0)
+            vid_expand_plane (&va_lines[ln*VA_XSIZE], &va_buf[off], VA_XSIZE, va_dpln, va_white, va_black);
+        else
+            vid_expand_index (&va_lines[ln*VA_XSIZE], &va_buf[off], VA_XSIZE, VA_PLANE_MASK, va_palette);
 
         if (CUR_V &&                                    /* cursor visible && need to draw cursor? */
             (va_input_captured || (va_dev.dctrl & DBG_CURSOR))) {
@@ -413,8 +413,7 @@ lines = 0;
 for (ln = 0; ln < VC_YSIZE; ln++) {
     if (vc_updated[ln]) {                               /* line invalid? */
         off = ((ln + (vc_org << VC_ORSC)) << 5) & VC_BUFMASK; /* get video buf offet */
-        for (col = 0; col < VC_XSIZE; col++)  
-            vc_lines[ln*VC_XSIZE + col] = vc_palette[(vc_buf[off + (col >> 5)] >> (col & 0x1F)) & 1];
+        vid_expand_1bpp (&vc_lines[ln*VC_XSIZE], &vc_buf[off], VC_XSIZE, vc_palette);
                                                         /* 1bpp to 32bpp */
         if (CUR_V &&                                    /* cursor visible && need to draw cursor? */
             (vc_input_captured || (vc_dev.dctrl & DBG_CURSOR))) {
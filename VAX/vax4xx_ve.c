@@ -1279,7 +1279,7 @@ SIM_MOUSE_EVENT mev;
 SIM_KEY_EVENT kev;
 t_bool updated = FALSE;                                 /* flag for refresh */
 uint32 lines;
-uint32 ln, col, off;
+uint32 ln, off;
 uint32 i, c;
 uint32 rg, val;
 
@@ -1341,8 +1341,7 @@ lines = 0;
 for (ln = 0; ln < VE_YSIZE; ln++) {
     if (ve_updated[ln]) {                               /* line invalid? */
         off = ((ln + (vc_org << VE_ORSC)) * VE_BXSIZE); /* get video buf offet */
-        for (col = 0; col < VE_XSIZE; col++)
-            ve_lines[ln*VE_XSIZE + col] = ve_palette[ve_buf[off + col]];
+        vid_expand_8bpp (&ve_lines[ln*VE_XSIZE], &ve_buf[off], VE_XSIZE, ve_palette);
                                                         /* 8bpp to 32bpp */
 #if 0
         if (CUR_V) {                                    /* cursor visible? */
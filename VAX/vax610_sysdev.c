@@ -548,7 +548,7 @@ if ((cptr == NULL) || (!*cptr))
 cptr = get_glyph (cptr, gbuf, 0);
 if (MATCH_CMD(gbuf, "MICROVAX") == 0) {
     sys_model = 0;
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     vc_dev.flags = vc_dev.flags | DEV_DIS;               /* disable QVSS */
     lk_dev.flags = lk_dev.flags | DEV_DIS;               /* disable keyboard */
     vs_dev.flags = vs_dev.flags | DEV_DIS;               /* disable mouse */
@@ -557,7 +557,7 @@ if (MATCH_CMD(gbuf, "MICROVAX") == 0) {
     reset_all (0);                                       /* reset everything */
     }
 else if (MATCH_CMD(gbuf, "VAXSTATION") == 0) {
-#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+#if defined(USE_SIM_VIDEO)
     sys_model = 1;
     vc_dev.flags = vc_dev.flags & ~DEV_DIS;              /* enable QVSS */
     lk_dev.flags = lk_dev.flags & ~DEV_DIS;              /* enable keyboard */
@@ -197,6 +197,7 @@ void uba_adap_clr_int ();
 void uba_set_dpr (uint32 ua, t_bool wr);
 void uba_ubpdn (int32 time);
 t_bool uba_map_addr (uint32 ua, uint32 *ma);
+int32 uba_map_run (uint32 ua, int32 bc, uint32 *ma);
 t_stat set_autocon (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat show_autocon (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 t_stat show_iospace (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
@@ -651,11 +652,9 @@ uint32 ma, dat;
 ba = ba & UBADDRMASK;                                   /* mask UB addr */
 bc = bc & ~01;
 for (i = 0; i < bc; i = i + pbc) {                      /* loop by pages */
-    if (!uba_map_addr (ba + i, &ma))                    /* page inv or NXM? */
+    pbc = uba_map_run (ba + i, bc - i, &ma);            /* map run */
+    if (pbc == 0)                                       /* page inv or NXM? */
         return (bc - i);
-    pbc = VA_PAGSIZE - VA_GETOFF (ma);                  /* left in page */
-    if (pbc > (bc - i))                                 /* limit to rem xfr */
-        pbc = bc - i;
     if (DEBUG_PRI (uba_dev, UBA_DEB_XFR))
         fprintf (sim_deb, ">>UBA: 16b read, ma = %X, bc = %X\n", ma, pbc);
     if ((ma | pbc) & 1) {                               /* aligned word? */
@@ -667,6 +666,10 @@ for (i = 0; i < bc; i = i + pbc) {                      /* loop by pages */
             else *buf = (*buf & ~BMASK) | ReadB (ma);
             }
         }
+    else if (sim_end) {                                 /* little endian host? */
+        memcpy (buf, ((uint8 *) M) + ma, pbc);          /* block copy */
+        buf = buf + (pbc >> 1);
+        }
     else if ((ma | pbc) & 3) {                          /* aligned LW? */
         for (j = 0; j < pbc; ma = ma + 2, j = j + 2) {  /* no, words */
             *buf++ = ReadW (ma);                        /* get word */
@@ -726,11 +729,9 @@ uint32 ma, dat;
 ba = ba & UBADDRMASK;                                   /* mask UB addr */
 bc = bc & ~01;
 for (i = 0; i < bc; i = i + pbc) {                      /* loop by pages */
-    if (!uba_map_addr (ba + i, &ma))                    /* page inv or NXM? */
+    pbc = uba_map_run (ba + i, bc - i, &ma);            /* map run */
+    if (pbc == 0)                                       /* page inv or NXM? */
         return (bc - i);
-    pbc = VA_PAGSIZE - VA_GETOFF (ma);                  /* left in page */
-    if (pbc > (bc - i))                                 /* limit to rem xfr */
-        pbc = bc - i;
     if (DEBUG_PRI (uba_dev, UBA_DEB_XFR))
         fprintf (sim_deb, ">>UBA: 16b write, ma = %X, bc = %X\n", ma, pbc);
     if ((ma | pbc) & 1) {                               /* aligned word? */
@@ -742,6 +743,10 @@ for (i = 0; i < bc; i = i + pbc) {                      /* loop by pages */
             else WriteB (ma, *buf & BMASK);
             }
         }
+    else if (sim_end) {                                 /* little endian host? */
+        memcpy (((uint8 *) M) + ma, buf, pbc);          /* block copy */
+        buf = buf + (pbc >> 1);
+        }
     else if ((ma | pbc) & 3) {                          /* aligned LW? */
         for (j = 0; j < pbc; ma = ma + 2, j = j + 2) {  /* no, words */
             WriteW (ma, *buf);                          /* write word */
@@ -781,6 +786,32 @@ uba_inv_map (ua);                                       /* invalid map */
 return FALSE;
 }
 
+/* Map a run of addresses via the translation map
+
+   Maps ua as uba_map_addr does, then follows the map across registers
+   which select the same data path and point at consecutive memory pages.
+   Returns the number of bytes, at most bc, which can be transferred
+   starting at *ma, or 0 if ua itself can't be mapped.
+*/
+
+int32 uba_map_run (uint32 ua, int32 bc, uint32 *ma)
+{
+uint32 ublk = ua >> VA_V_VPN;                           /* Unibus blk */
+int32 run;
+
+if (!uba_map_addr (ua, ma))                             /* page inv or NXM? */
+    return 0;
+run = VA_PAGSIZE - VA_GETOFF (*ma);                     /* left in page */
+while ((run < bc) &&                                    /* more to xfr and */
+       ((ublk + 1) < UBA_NMAPR) &&                      /* next reg exists and */
+       (uba_map[ublk + 1] == (uba_map[ublk] + 1)) &&    /* next page, same flags and */
+       ADDR_IS_MEM (*ma + run + VA_PAGSIZE - 1)) {      /* in memory? */
+    ublk = ublk + 1;
+    run = run + VA_PAGSIZE;
+    }
+return (run < bc)? run: bc;
+}
+
 /* Map an address via the translation map - console version (no status changes) */
 
 t_bool uba_map_addr_c (uint32 ua, uint32 *ma)
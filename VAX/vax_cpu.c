@@ -192,8 +192,6 @@
 #define UNIT_MSIZE      (1u << UNIT_V_MSIZE)
 #define GET_CUR         acc = ACC_MASK (PSL_GETCUR (PSL))
 
-#define OPND_SIZE       16
-#define INST_SIZE       52
 #define op0             opnd[0]
 #define op1             opnd[1]
 #define op2             opnd[2]
@@ -209,6 +207,10 @@
                             RSVD_ADDR_FAULT
 #define CHECK_FOR_AP    if (rn >= nAP) \
                             RSVD_ADDR_FAULT
+#define ICD_SIZE        4096                            /* decode cache entries, 2**n */
+#define ICD_HASH(pa)    (((pa) ^ ((pa) >> 12)) & (ICD_SIZE - 1))
+#define ICD_MAXV        12                              /* istream values kept */
+#define ICD_MAXLW       6                               /* longwords of image kept */
 #define WRITE_B(r)      if (spec > (GRN | nPC)) \
                             Write (va, r, L_BYTE, WA); \
                         else R[rn] = (R[rn] & ~BMASK) | ((r) & BMASK)
@@ -233,6 +235,15 @@
                         r = arl; \
                         rh = arh
 
+typedef struct {
+    int32               pa;                             /* phys addr of opcode, -1 = empty */
+    uint8               lnt;                            /* instruction length */
+    uint8               nv;                             /* istream values fetched */
+    uint8               nlw;                            /* longwords in image */
+    uint32              mem[ICD_MAXLW];                 /* memory holding the instruction */
+    int32               v[ICD_MAXV];                    /* get_istr results, in order */
+    } ICDENT;
+
 
 uint32 *M = NULL;                                       /* memory */
 int32 R[16];                                            /* registers */
@@ -267,18 +278,51 @@ int32 cpu_astop = 0;
 int32 mchk_va, mchk_ref;                                /* mem ref param */
 int32 ibufl, ibufh;                                     /* prefetch buf */
 int32 ibcnt, ppc;                                       /* prefetch ctl */
+ICDENT *icd_tab = NULL;                                 /* decoded instructions */
+ICDENT *icd_play = NULL;                                /* entry being replayed */
+ICDENT *icd_rec = NULL;                                 /* entry being recorded */
+int32 icd_nv;                                           /* replay position */
+int32 icd_pa;                                           /* phys PC of current instr */
 uint32 cpu_idle_mask = VAX_IDLE_VMS;                    /* idle mask */
 uint32 cpu_idle_type = 1;                               /* default VMS */
 int32 extra_bytes;                                      /* bytes referenced by current string instruction */
 jmp_buf save_env;
 REG *pcq_r = NULL;                                      /* PC queue reg ptr */
 int32 pcq[PCQ_SIZE] = { 0 };                            /* PC queue */
-InstHistory *hst = NULL;                                /* instruction history */
-int32 hst_p = 0;                                        /* history pointer */
-int32 hst_lnt = 0;                                      /* history length */
+
+/* Instruction history ring.  The control block is followed by size bytes
+   of records (see InstHistory).  A mapped history file has the same
+   layout, so it can be examined after the simulator has gone away. */
+
+typedef struct {
+    char                magic[8];                       /* HIST_MAGIC */
+    uint32              order;                          /* HIST_ORDER, in writer's byte order */
+    uint32              version;                        /* HIST_VERSION */
+    uint32              switches;                       /* history option switches */
+    uint32              limit;                          /* most entries kept */
+    t_uint64            size;                           /* ring bytes */
+    t_uint64            head;                           /* offset of next record */
+    t_uint64            tail;                           /* offset of oldest record */
+    t_uint64            count;                          /* records written */
+    t_uint64            first;                          /* number of oldest record */
+    } HIST_RING;
+
+#define HIST_MAGIC      "VAXHIST"
+#define HIST_ORDER      0x01020304
+#define HIST_VERSION    1
+#define HIST_REC(o)     ((InstHistory *) (hst_buf + (o)))
+
+HIST_RING *hst = NULL;                                  /* instruction history */
+uint8 *hst_buf = NULL;                                  /* history records */
+int32 hst_lnt = 0;                                      /* history length, 0 = not recording */
 int32 hst_switches;                                     /* history option switches */
 FILE *hst_log;                                          /* history log file */
-int32 hst_log_p;                                        /* history last log written pointer */
+t_uint64 hst_log_p;                                     /* history next record to log */
+SIM_FMAP *hst_map = NULL;                               /* history file mapping */
+uint32 *hst_res = NULL;                                 /* result slots of last entry */
+int32 hst_res_type;                                     /* result type of last entry */
+static const uint8 hst_res_cnt[DR_M_RESMASK + 1] = {    /* result longwords by type */
+    0, 1, 1, 1, 2, 4, 1, 1, 1, 2, 1, 2, 4, 6, 1, 0 };
 int32 step_out_nest_level = 0;                          /* step to call return - nest level */
 
 const uint32 byte_mask[33] = { 0x00000000,
@@ -313,6 +357,7 @@ t_stat cpu_reset (DEVICE *dptr);
 t_bool cpu_is_pc_a_subroutine_call (t_addr **ret_addrs);
 t_stat cpu_ex (t_value *vptr, t_addr exta, UNIT *uptr, int32 sw);
 t_stat cpu_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw);
+void *cpu_mem_image (UNIT *uptr, size_t *size);
 t_stat cpu_set_size (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat cpu_set_hist (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
@@ -324,9 +369,12 @@ t_stat cpu_show_instruction_set (FILE *st, UNIT *uptr, int32 val, CONST void *de
 const char *cpu_description (DEVICE *dptr);
 int32 cpu_get_vsw (int32 sw);
 static SIM_INLINE int32 get_istr (int32 lnt, int32 acc);
+static SIM_INLINE void icd_lookup (void);
+static void icd_save (void);
 int32 ReadOcta (int32 va, int32 *opnd, int32 j, int32 acc);
-t_bool cpu_show_opnd (FILE *st, InstHistory *h, int32 line);
-t_stat cpu_show_hist_records (FILE *st, t_bool do_header, int32 start, int32 count);
+t_bool cpu_show_opnd (FILE *st, int32 opc, const uint32 *opnd, const uint32 *res, int32 line);
+t_stat cpu_show_hist_records (FILE *st, t_bool do_header, t_uint64 start, t_uint64 count);
+static void cpu_hist_log (void);
 int32 cpu_emulate_exception (int32 *opnd, int32 cc, int32 opc, int32 acc);
 void cpu_idle (void);
 
@@ -483,6 +531,45 @@ sprintf (buf, "VAX CPU with %dMB-%dMB of memory", (int)min_mem, (int)max_mem);
 return buf;
 }
 
+/* Discard the oldest history record, logging it first if need be */
+
+static SIM_INLINE void cpu_hist_discard (void)
+{
+HIST_RING *r = hst;
+
+if (hst_log && (r->first == hst_log_p))                 /* not logged yet? */
+    cpu_hist_log ();
+r->tail = r->tail + HIST_REC (r->tail)->len;
+r->first = r->first + 1;
+if ((r->tail >= r->size) || (HIST_REC (r->tail)->len == 0))
+    r->tail = 0;                                        /* wrapped */
+}
+
+/* Make room for a history record of len bytes at the head of the ring */
+
+static SIM_INLINE InstHistory *cpu_hist_alloc (uint32 len)
+{
+HIST_RING *r = hst;
+InstHistory *h;
+
+if (r->head + len > r->size) {                          /* won't fit before end? */
+    while ((r->first != r->count) && (r->tail >= r->head))
+        cpu_hist_discard ();                            /* drop records past head */
+    if (r->head < r->size)
+        HIST_REC (r->head)->len = 0;                    /* mark wrap */
+    r->head = 0;
+    }
+while ((r->first != r->count) &&                        /* drop records to make room */
+       (r->tail >= r->head) && (r->tail < r->head + len))
+    cpu_hist_discard ();
+if (r->first == r->count)                               /* empty? */
+    r->tail = r->head;
+h = HIST_REC (r->head);
+r->head = r->head + len;
+r->count = r->count + 1;
+return h;
+}
+
 t_stat sim_instr (void)
 {
 volatile int32 opc = 0, cc;                             /* used by setjmp */
@@ -510,15 +597,22 @@ set_map_reg ();                                         /* set map reg */
 GET_CUR;                                                /* set access mask */
 SET_IRQL;                                               /* eval interrupts */
 FLUSH_ISTR;                                             /* clear prefetch */
+if (icd_tab == NULL) {
+    icd_tab = (ICDENT *) calloc (ICD_SIZE, sizeof (ICDENT));
+    if (icd_tab == NULL)
+        return SCPE_MEM;
+    }
+for (temp = 0; temp < ICD_SIZE; temp++)                 /* forget old decodes */
+    icd_tab[temp].pa = -1;
 
 abortval = setjmp (save_env);                           /* set abort hdlr */
 if (abortval > 0) {                                     /* sim stop? */
     PSL = PSL | cc;                                     /* put PSL together */
     pcq_r->qptr = pcq_p;                                /* update pc q ptr */
-    if (hst_log) {                                      /* auto logging history? */
-        cpu_show_hist_records (hst_log, FALSE, hst_log_p, (hst_p < hst_log_p) ? hst_lnt - (hst_log_p - hst_p) : hst_p - hst_log_p);
-        hst_log_p = hst_p;                              /* record everything logged */
-        }
+    if (hst_log)                                        /* auto logging history? */
+        cpu_hist_log ();                                /* record everything logged */
+    if (hst_map && hst_lnt)                             /* history file? */
+        sim_fmap_sync (hst_map, FALSE);                 /* start writeback */
     return abortval;                                    /* return to SCP */
     }
 else if (abortval < 0) {                                /* mm or rsrv or int */
@@ -605,40 +699,35 @@ for ( ;; ) {
 
 /* Optionally record instruction history results from prior instruction */
 
-    if (hst_lnt) {
-        InstHistory *hlast = &hst[hst_p ? hst_p-1 : hst_lnt -1];
+    if (hst_res) {
+        uint32 *hres = hst_res;
 
-        switch (DR_GETRES(drom[hlast->opc][0]) << DR_V_RESMASK) {
-            case RB_O:
-            case RB_OB:
-            case RB_OW:
-            case RB_OL:
-            case RB_OQ:
-                break;
+        hst_res = NULL;
+        switch (hst_res_type) {
             case RB_Q:
-                hlast->res[1] = rh;
-                hlast->res[0] = r;
+                hres[1] = rh;
+                hres[0] = r;
                 break;
             case RB_B:
             case RB_W:
             case RB_L:
-                hlast->res[0] = r;
+                hres[0] = r;
                 break;
             case RB_R5:
-                hlast->res[5] = R[5];
-                hlast->res[4] = R[4];
+                hres[5] = R[5];
+                hres[4] = R[4];
             case RB_R3:
-                hlast->res[3] = R[3];
-                hlast->res[2] = R[2];
+                hres[3] = R[3];
+                hres[2] = R[2];
             case RB_R1:
-                hlast->res[1] = R[1];
+                hres[1] = R[1];
             case RB_R0:
-                hlast->res[0] = R[0];
+                hres[0] = R[0];
                 break;
             case RB_SP:
-                hlast->res[0] = Read (SP, L_LONG, RA);
+                hres[0] = Read (SP, L_LONG, RA);
                 break;
-            default:
+            default:                                    /* octa results by op_octa */
                 break;
             }
         }
@@ -649,6 +738,7 @@ for ( ;; ) {
         }
     fault_PC = PC;
     recqptr = 0;                                        /* clr recovery q */
+    icd_play = icd_rec = NULL;                          /* no decode cache use */
     AIO_CHECK_EVENT;                                    /* queue async events */
     if (sim_interval <= 0) {                            /* chk clock queue */
         temp = sim_process_event ();
@@ -722,6 +812,8 @@ for ( ;; ) {
 
     sim_interval = sim_interval - (1 + (extra_bytes>>5));/* count instr */
     extra_bytes = 0;                                    /* digest string count */
+    if ((PSL & PSL_FPD) == 0)                           /* not restarting? */
+        icd_lookup ();                                  /* replay or record decode */
     GET_ISTR (opc, L_BYTE);                             /* get opcode */
     if (opc == 0xFD) {                                  /* 2 byte op? */
         GET_ISTR (opc, L_BYTE);                         /* get second byte */
@@ -1551,37 +1643,70 @@ for ( ;; ) {
                 }                                       /* end case spec */
             }                                           /* end for */
         }                                               /* end if not FPD */
+    if (icd_play) {                                     /* decode replayed? */
+        ibcnt = 0;                                      /* resume prefetch after it */
+        ppc = (icd_pa + icd_play->lnt) & ~03;
+        icd_play = NULL;
+        }
+    else if (icd_rec)                                   /* decode recorded? */
+        icd_save ();
 
 /* Optionally record instruction history */
 
     if (hst_lnt) {
-        int32 lim;
+        int32 lim, nres, pa, st;
+        uint32 len, *hp;
+        uint8 *ip;
         t_value wd;
-        InstHistory *h = &hst[hst_p];
+        InstHistory *h;
 
-        h->iPC = fault_PC;
-        h->PSL = PSL | cc;
-        h->opc = opc;
-        for (i = 0; i < j; i++)
-            h->opnd[i] = opnd[i];
         lim = PC - fault_PC;
         if ((uint32) lim > INST_SIZE)
             lim = INST_SIZE;
-        for (i = 0; i < lim; i++) {
-            if ((cpu_ex (&wd, fault_PC + i, &cpu_unit, SWMASK ('V'))) == SCPE_OK)
-                h->inst[i] = (uint8) wd;
-            else {
-                h->inst[0] = h->inst[1] = 0xFF;
-                break;
+        hst_res_type = drom[opc][0] & (DR_M_RESMASK << DR_V_RESMASK);
+        nres = hst_res_cnt[hst_res_type >> DR_V_RESMASK];
+        len = sizeof (InstHistory) + ((j + nres) * sizeof (uint32)) + lim;
+        if (hst_switches & SWMASK('T'))
+            len = len + sizeof (double);
+        len = (len + 7) & ~7;                           /* keep records aligned */
+        h = cpu_hist_alloc (len);
+        h->len = (uint16) len;
+        h->opc = (uint16) opc;
+        h->ninst = (uint8) lim;
+        h->nopnd = (uint8) j;
+        h->nres = (uint8) nres;
+        h->flags = 0;
+        h->iPC = fault_PC;
+        h->PSL = PSL | cc;
+        hp = (uint32 *) (h + 1);
+        if (hst_switches & SWMASK('T')) {
+            h->flags = HIST_F_TIME;
+            *((double *) hp) = sim_gtime();
+            hp = hp + 2;
+            }
+        for (i = 0; i < j; i++)
+            hp[i] = opnd[i];
+        hp = hp + j;
+        for (i = 0; i < nres; i++)                      /* results filled in later */
+            hp[i] = 0;
+        hst_res = nres ? hp : NULL;
+        ip = (uint8 *) (hp + nres);
+        pa = Test (fault_PC, acc, &st);                 /* instruction in one page? */
+        if ((pa >= 0) && ((VA_GETOFF (fault_PC) + lim) <= VA_PAGSIZE) &&
+            ADDR_IS_MEM (pa + lim - 1)) {
+            for (i = 0; i < lim; i++, pa++)             /* copy from memory */
+                ip[i] = (uint8) (M[pa >> 2] >> ((pa & 3) << 3));
+            }
+        else {
+            for (i = 0; i < lim; i++) {
+                if ((cpu_ex (&wd, fault_PC + i, &cpu_unit, SWMASK ('V'))) == SCPE_OK)
+                    ip[i] = (uint8) wd;
+                else {
+                    ip[0] = ip[1] = 0xFF;
+                    break;
+                    }
                 }
             }
-        if (hst_switches & SWMASK('T'))
-            h->time = sim_gtime();
-        hst_p = hst_p + 1;
-        if (hst_p >= hst_lnt)
-            hst_p = 0;
-        if (hst_log && (hst_p == hst_log_p))
-            cpu_show_hist_records (hst_log, FALSE, hst_log_p, hst_lnt);
         }
 
 /* Dispatch to instructions */
@@ -3142,8 +3267,7 @@ for ( ;; ) {
     case ADDH2: case ADDH3: case SUBH2: case SUBH3:
     case MULH2: case MULH3: case DIVH2: case DIVH3:
     case ACBH: case POLYH: case EMODH:
-        cc = op_octa (opnd, cc, opc, acc, spec, va, 
-                      (hst_lnt ? &hst[hst_p ? hst_p-1 : hst_lnt -1] : NULL) );
+        cc = op_octa (opnd, cc, opc, acc, spec, va, hst_res);
         if (cc & LSIGN) {                               /* ACBH branch? */
             BRANCHW (brdisp);
             cc = cc & CC_MASK;                          /* mask off flag */
@@ -3157,6 +3281,80 @@ for ( ;; ) {
     }                                                   /* end for */
 }                                                       /* end sim_instr */
 
+/* Decoded instruction cache
+
+   Specifier decoding fetches the opcode, the specifier bytes and any
+   displacements or immediates from the instruction stream in an order
+   that depends only on those bytes.  The cache, keyed on the physical
+   address of the opcode, keeps the values get_istr returned the last
+   time the instruction was decoded, together with an image of the
+   longwords of memory that held it.  When the image still matches
+   memory the values are replayed in place of the prefetch logic; all
+   operand references, register updates, recovery queue entries and
+   faults still happen in the specifier flows as before.
+
+   Because a hit is confirmed against memory, no invalidation is needed
+   for CPU stores, DMA, console deposits or RESTORE, and because the key
+   is physical, TLB and mapping changes do not matter either: the PC is
+   translated exactly as the prefetch logic would before the lookup.
+   Only instructions wholly within one page and decoded without FPD set
+   are cached.
+*/
+
+static SIM_INLINE void icd_lookup (void)
+{
+ICDENT *e;
+int32 i, lw, t;
+
+if ((ppc >= 0) && ((ibcnt != 0) || (VA_GETOFF (ppc) != 0)))
+    icd_pa = ppc - ibcnt + (PC & 03);                   /* prefetch knows PC */
+else {
+    icd_pa = Test (PC & ~03, RD, &t);                   /* xlate PC, as get_istr */
+    if (icd_pa < 0)                                     /* let get_istr fault */
+        return;
+    ppc = icd_pa;                                       /* save it the trouble */
+    ibcnt = 0;
+    icd_pa = icd_pa | (PC & 03);
+    }
+if (!ADDR_IS_MEM (icd_pa))
+    return;
+e = &icd_tab[ICD_HASH (icd_pa)];
+if (e->pa == icd_pa) {                                  /* candidate? */
+    lw = icd_pa >> 2;
+    for (i = 0; i < e->nlw; i++) {                      /* still in memory? */
+        if (M[lw + i] != e->mem[i])
+            break;
+        }
+    if (i == e->nlw) {
+        icd_play = e;
+        icd_nv = 0;
+        return;
+        }
+    }
+e->pa = -1;                                             /* record afresh */
+e->nv = 0;
+icd_rec = e;
+}
+
+static void icd_save (void)
+{
+ICDENT *e = icd_rec;
+int32 i, lw, lnt = PC - fault_PC;
+
+icd_rec = NULL;
+if ((e->nv > ICD_MAXV) ||                               /* too many values? */
+    (lnt <= 0) || (lnt > ((ICD_MAXLW - 1) << 2)) ||     /* too long? */
+    ((VA_GETOFF (icd_pa) + lnt) > VA_PAGSIZE) ||        /* crosses page? */
+    !ADDR_IS_MEM (icd_pa + lnt - 1))
+    return;
+e->lnt = (uint8) lnt;
+e->nlw = (uint8) ((((icd_pa & 03) + lnt + 03) >> 2));
+lw = icd_pa >> 2;
+for (i = 0; i < e->nlw; i++)                            /* image of instruction */
+    e->mem[i] = M[lw + i];
+e->pa = icd_pa;
+}
+
 /* Prefetch buffer routine
 
    Prefetch buffer state
@@ -3181,6 +3379,10 @@ static SIM_INLINE int32 get_istr (int32 lnt, int32 acc)
 int32 bo = PC & 3;
 int32 sc, val, t;
 
+if (icd_play) {                                         /* replaying decode? */
+    PC = PC + lnt;
+    return icd_play->v[icd_nv++];
+    }
 while ((bo + lnt) > ibcnt) {                            /* until enuf bytes */
     if ((ppc < 0) || (VA_GETOFF (ppc) == 0)) {          /* PPC inv, xpg? */
         ppc = Test ((PC + ibcnt) & ~03, RD, &t);        /* xlate PC */
@@ -3210,6 +3412,11 @@ if ((bo + lnt) >= 4) {                                  /* retire ibufl? */
     ibufl = ibufh;
     ibcnt = ibcnt - 4;
     }
+if (icd_rec) {                                          /* recording decode? */
+    if (icd_rec->nv < ICD_MAXV)
+        icd_rec->v[icd_rec->nv] = val;
+    icd_rec->nv = icd_rec->nv + 1;
+    }
 return val;
 }
 
@@ -3299,6 +3506,7 @@ FLUSH_ISTR;                             /* init I-stream */
 if (M == NULL) {                        /* first time init? */
     sim_brk_types = sim_brk_dflt = SWMASK ('E');
     sim_vm_is_subroutine_call = cpu_is_pc_a_subroutine_call;
+    sim_vm_mem_image = &cpu_mem_image;
     pcq_r = find_reg ("PCQ", NULL, dptr);
     if (pcq_r == NULL)
         return SCPE_IERR;
@@ -3403,6 +3611,16 @@ if (ADDR_IS_ROM (addr)) {
 return SCPE_NXM;
 }
 
+/* Memory image for SAVE -B snapshots */
+
+void *cpu_mem_image (UNIT *uptr, size_t *size)
+{
+if (uptr != &cpu_unit)
+    return NULL;
+*size = (size_t) MEMSIZE;
+return M;
+}
+
 /* Memory allocation */
 
 t_stat cpu_set_size (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
@@ -3482,18 +3700,79 @@ else md = PSL_GETCUR (PSL);
 return ACC_MASK (md);
 }
 
+/* Release the history ring */
+
+static void cpu_hist_free (void)
+{
+if (hst_map)
+    sim_fmap_close (hst_map);
+else
+    free (hst);
+hst_map = NULL;
+hst = NULL;
+hst_buf = NULL;
+hst_lnt = 0;
+hst_res = NULL;
+if (hst_log) {
+    fclose (hst_log);
+    hst_log = NULL;
+    }
+}
+
+/* Write the history records not yet logged to the history log file */
+
+static void cpu_hist_log (void)
+{
+cpu_show_hist_records (hst_log, FALSE, hst_log_p, hst->count - hst_log_p);
+hst_log_p = hst->count;
+}
+
+/* Map an existing history file to examine it */
+
+static t_stat cpu_hist_open_file (const char *cptr)
+{
+size_t size;
+void *base;
+HIST_RING *r;
+t_stat st;
+
+cpu_hist_free ();
+st = sim_fmap_open (cptr, &size, TRUE, &hst_map, &base);
+if (st != SCPE_OK)
+    return (st == SCPE_NOFNC) ? sim_messagef (st, "History files aren't available on this host\n") : st;
+r = (HIST_RING *) base;
+if ((size < sizeof (HIST_RING)) ||
+    (memcmp (r->magic, HIST_MAGIC, sizeof (r->magic)) != 0) ||
+    (r->order != HIST_ORDER) ||
+    (r->version != HIST_VERSION) ||
+    (r->size != (t_uint64) (size - sizeof (HIST_RING)))) {
+    sim_fmap_close (hst_map);
+    hst_map = NULL;
+    return sim_messagef (SCPE_FMT, "'%s' isn't a history file written by this simulator on this host\n", cptr);
+    }
+hst = r;
+hst_buf = (uint8 *) (r + 1);
+hst_switches = r->switches;
+return SCPE_OK;
+}
+
 /* Set history */
 
 t_stat cpu_set_hist (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
 {
-int32 i, lnt;
+int32 lnt;
+size_t size;
+void *base;
 char gbuf[CBUFSIZE];
+t_bool map = (sim_switches & SWMASK ('M')) != 0;
 t_stat r;
 
 if (cptr == NULL) {
-    for (i = 0; i < hst_lnt; i++)
-        hst[i].iPC = 0;
-    hst_p = 0;
+    if (hst_lnt) {
+        hst->head = hst->tail = 0;
+        hst->count = hst->first = 0;
+        hst_res = NULL;
+        }
     if (hst_log) {
         sim_set_fsize (hst_log, (t_addr)0);
         hst_log_p = 0;
@@ -3501,39 +3780,53 @@ if (cptr == NULL) {
         }
     return SCPE_OK;
     }
+if (sim_switches & SWMASK ('R'))                        /* examine history file? */
+    return cpu_hist_open_file (cptr);
 cptr = get_glyph (cptr, gbuf, ':');
-lnt = (int32) get_uint (gbuf, 10, HIST_MAX, &r);
+lnt = (int32) get_uint (gbuf, 10, map ? HIST_MAX_MAP : HIST_MAX, &r);
 if (r != SCPE_OK)
     return sim_messagef (SCPE_ARG, "Invalid Numeric Value: %s\n", gbuf);
 if (lnt && (lnt < HIST_MIN))
     return sim_messagef (SCPE_ARG, "%d is less than the minumum history value of %d\n", lnt, HIST_MIN);
-hst_p = 0;
-if (hst_lnt) {
-    free (hst);
-    hst_lnt = 0;
-    hst = NULL;
-    if (hst_log) {
-        fclose (hst_log);
-        hst_log = NULL;
-        }
+if (map && lnt && ((cptr == NULL) || (*cptr == 0)))
+    return sim_messagef (SCPE_2FARG, "A history file name is required with -M\n");
+cpu_hist_free ();
+if (lnt == 0)
+    return SCPE_OK;
+size = sizeof (HIST_RING) + ((size_t) lnt * HIST_AVG);
+if ((double) size != (double) sizeof (HIST_RING) + ((double) lnt * HIST_AVG))
+    return SCPE_MEM;                                    /* too big for host */
+if (map) {
+    r = sim_fmap_open (cptr, &size, FALSE, &hst_map, &base);
+    if (r != SCPE_OK)
+        return (r == SCPE_NOFNC) ? sim_messagef (r, "History files aren't available on this host\n") : r;
+    hst = (HIST_RING *) base;
+    memset (hst, 0, sizeof (*hst));
     }
-if (lnt) {
-    hst = (InstHistory *) calloc (lnt, sizeof (InstHistory));
+else {
+    hst = (HIST_RING *) calloc (1, size);
     if (hst == NULL)
-            return SCPE_MEM;
-    hst_lnt = lnt;
-    hst_switches = sim_switches;
-    if (cptr && *cptr) {
-        hst_log = sim_fopen (cptr, "w");
-        if (hst_log)
-            cpu_show_hist_records (hst_log, TRUE, 0, 0);
-        else {
-            free (hst);
-            hst_lnt = 0;
-            hst = NULL;
-            return sim_messagef(SCPE_OPENERR, "Unable to open file '%s': %s\n", cptr, strerror (errno));
-            }            
+        return SCPE_MEM;
+    }
+hst_buf = (uint8 *) (hst + 1);
+hst_switches = sim_switches;
+memcpy (hst->magic, HIST_MAGIC, sizeof (hst->magic));
+hst->order = HIST_ORDER;
+hst->version = HIST_VERSION;
+hst->switches = (uint32) hst_switches;
+hst->limit = (uint32) lnt;
+hst->size = (t_uint64) (size - sizeof (HIST_RING));
+hst_lnt = lnt;
+if (!map && cptr && *cptr) {
+    hst_log = sim_fopen (cptr, "w");
+    if (hst_log) {
+        hst_log_p = 0;
+        cpu_show_hist_records (hst_log, TRUE, 0, 0);
         }
+    else {
+        cpu_hist_free ();
+        return sim_messagef(SCPE_OPENERR, "Unable to open file '%s': %s\n", cptr, strerror (errno));
+        }            
     }
 return SCPE_OK;
 }
@@ -3542,42 +3835,69 @@ return SCPE_OK;
 
 t_stat cpu_show_hist (FILE *st, UNIT *uptr, int32 val, CONST void *desc)
 {
-int32 di, lnt;
+t_uint64 lnt;
 const char *cptr = (const char *) desc;
 t_stat r;
 
-if (hst_lnt == 0)                                       /* enabled? */
+if (hst == NULL)                                        /* enabled? */
     return SCPE_NOFNC;
 if (cptr) {
-    lnt = (int32) get_uint (cptr, 10, hst_lnt, &r);
+    lnt = (t_uint64) get_uint (cptr, 10, hst->limit, &r);
     if ((r != SCPE_OK) || (lnt == 0))
         return SCPE_ARG;
     }
-else lnt = hst_lnt;
-di = hst_p - lnt;                                       /* work forward */
-if (di < 0)
-    di = di + hst_lnt;
-return cpu_show_hist_records (st, TRUE, di, lnt);
+else lnt = hst->limit;
+if (hst_map && !hst_lnt)                                /* examining a file? */
+    fprintf (st, "%.0f instructions recorded\n", (double) hst->count);
+return cpu_show_hist_records (st, TRUE, (hst->count > lnt) ? hst->count - lnt : 0, lnt);
 }
 
-t_stat cpu_show_hist_records (FILE *st, t_bool do_header, int32 start, int32 count)
+t_stat cpu_show_hist_records (FILE *st, t_bool do_header, t_uint64 start, t_uint64 count)
 {
-int32 i, k, numspec;
+int32 i, numspec;
+t_uint64 seq, off;
+const uint32 *hp;
+const uint8 *ip;
+uint32 opnd[OPND_SIZE], res[RES_SIZE];
+double time;
 InstHistory *h;
 
-if (hst_lnt == 0)                                       /* enabled? */
+if (hst == NULL)                                        /* enabled? */
     return SCPE_NOFNC;
 if (do_header) {
     if (hst_switches & SWMASK('T'))
         fprintf (st," TIME       ");
     fprintf (st, "PC       PSL       IR\n\n");
     }
-for (k = 0; k < count; k++) {                           /* print specified */
-    h = &hst[(start++) % hst_lnt];                      /* entry pointer */
-    if (h->iPC == 0)                                    /* filled in? */
+if (start < hst->first) {                               /* already discarded? */
+    count = (count > (hst->first - start)) ? count - (hst->first - start) : 0;
+    start = hst->first;
+    }
+if (count > hst->count - start)
+    count = hst->count - start;
+for (seq = hst->first, off = hst->tail; seq < start + count; seq++) {
+    if ((off >= hst->size) || (HIST_REC (off)->len == 0))
+        off = 0;                                        /* wrapped */
+    h = HIST_REC (off);
+    if ((h->len < sizeof (InstHistory)) || (off + h->len > hst->size))
+        return sim_messagef (SCPE_IERR, "Instruction history is damaged\n");
+    off = off + h->len;
+    if (seq < start)
         continue;
+    hp = (const uint32 *) (h + 1);
+    time = 0.0;
+    if (h->flags & HIST_F_TIME) {
+        memcpy (&time, hp, sizeof (time));
+        hp = hp + 2;
+        }
+    memset (opnd, 0, sizeof (opnd));
+    memcpy (opnd, hp, ((h->nopnd < OPND_SIZE) ? h->nopnd : OPND_SIZE) * sizeof (uint32));
+    hp = hp + h->nopnd;
+    memset (res, 0, sizeof (res));
+    memcpy (res, hp, ((h->nres < RES_SIZE) ? h->nres : RES_SIZE) * sizeof (uint32));
+    ip = (const uint8 *) (hp + h->nres);
     if (hst_switches & SWMASK('T'))                     /* sim_time */
-        fprintf(st, "%10.0f  ", h->time);
+        fprintf(st, "%10.0f  ", time);
     fprintf(st, "%08X %08X| ", h->iPC, h->PSL);         /* PC, PSL */
     numspec = DR_GETNSP (drom[h->opc][0]);              /* #specifiers */
     if (opcode[h->opc] == NULL)                         /* undefined? */
@@ -3586,15 +3906,18 @@ for (k = 0; k < count; k++) {                           /* print specified */
         fprintf (st, "%s FPD set", opcode[h->opc]);
     else {                                              /* normal */
         for (i = 0; i < INST_SIZE; i++)
-            sim_eval[i] = h->inst[i];
+            sim_eval[i] = (i < h->ninst) ? ip[i] : 0;
         if ((fprint_sym (st, h->iPC, sim_eval, &cpu_unit, SWMASK ('M'))) > 0)
             fprintf (st, "%03X (undefined)", h->opc);
         if ((numspec > 1) ||
             ((numspec == 1) && (drom[h->opc][1] < BB))) {
-            if (cpu_show_opnd (st, h, 0)) {             /* operands; more? */
-                if (cpu_show_opnd (st, h, 1)) {         /* 2nd line; more? */
-                    cpu_show_opnd (st, h, 2);           /* octa, 3rd/4th */
-                    cpu_show_opnd (st, h, 3);
+            if (cpu_show_opnd (st, h->opc, opnd,        /* operands; more? */
+                               res, 0)) {
+                if (cpu_show_opnd (st, h->opc, opnd,    /* 2nd line; more? */
+                                   res, 1)) {
+                    cpu_show_opnd (st, h->opc, opnd,    /* octa, 3rd/4th */
+                                   res, 2);
+                    cpu_show_opnd (st, h->opc, opnd, res, 3);
                     }
                 }
             }
@@ -3605,18 +3928,18 @@ fflush (st);
 return SCPE_OK;
 }
 
-t_bool cpu_show_opnd (FILE *st, InstHistory *h, int32 line)
+t_bool cpu_show_opnd (FILE *st, int32 opc, const uint32 *opnd, const uint32 *res, int32 line)
 {
 
 int32 numspec, i, j, disp;
 t_bool more;
 
-numspec = drom[h->opc][0] & DR_NSPMASK;                 /* #specifiers */
+numspec = drom[opc][0] & DR_NSPMASK;                    /* #specifiers */
 fputs ("\n                  ", st);                     /* space */
 if (hst_switches & SWMASK('T'))
     fputs ("            ", st);
 for (i = 1, j = 0, more = FALSE; i <= numspec; i++) {   /* loop thru specs */
-    disp = drom[h->opc][i];                             /* specifier type */
+    disp = drom[opc][i];                                /* specifier type */
     if (disp == RG)                                     /* fix specials */
         disp = RQ;
     if (disp >= BB)                                     /* ignore branches */
@@ -3627,44 +3950,44 @@ for (i = 1, j = 0, more = FALSE; i <= numspec; i++) {   /* loop thru specs */
     case AB: case AW: case AL: case AQ: case AO:        /* address */
     case MB: case MW: case ML:                          /* modify */
         if (line == 0)
-            fprintf (st, " %08X", h->opnd[j]);
+            fprintf (st, " %08X", opnd[j]);
         else fputs ("         ", st);
         j = j + 1;
         break;
     case RQ: case MQ:                                   /* read, modify quad */
         if (line <= 1)
-            fprintf (st, " %08X", h->opnd[j + line]);
+            fprintf (st, " %08X", opnd[j + line]);
         else fputs ("         ", st);
         if (line == 0)
             more = TRUE;
         j = j + 2;
         break;
     case RO: case MO:                                   /* read, modify octa */
-        fprintf (st, " %08X", h->opnd[j + line]);
+        fprintf (st, " %08X", opnd[j + line]);
         more = TRUE;
         j = j + 4;
         break;
     case WB: case WW: case WL: case WQ: case WO:        /* write */
         if (line == 0)
-            fprintf (st, " %08X", h->opnd[j + 1]);
+            fprintf (st, " %08X", opnd[j + 1]);
         else fputs ("         ", st);
         j = j + 2;
         break;
         }                                       /* end case */
     }                                           /* end for */
-if ((line == 0) && (DR_GETRES(drom[h->opc][0]))) {
+if ((line == 0) && (DR_GETRES(drom[opc][0]))) {
     fprintf (st, " ->");
-    switch (DR_GETRES(drom[h->opc][0]) << DR_V_RESMASK) {
+    switch (DR_GETRES(drom[opc][0]) << DR_V_RESMASK) {
         case RB_O:
-            fprintf (st, " %08X %08X %08X %08X", h->res[0], h->res[1], h->res[2], h->res[3]);
+            fprintf (st, " %08X %08X %08X %08X", res[0], res[1], res[2], res[3]);
             break;
         case RB_Q:
-            fprintf (st, " %08X %08X", h->res[0], h->res[1]);
+            fprintf (st, " %08X %08X", res[0], res[1]);
             break;
         case RB_B:
         case RB_W:
         case RB_L:
-            fprintf (st, " %08X", h->res[0]);
+            fprintf (st, " %08X", res[0]);
             break;
         case RB_R5:
         case RB_R3:
@@ -3674,12 +3997,12 @@ if ((line == 0) && (DR_GETRES(drom[h->opc][0]))) {
                 static const int rcnts[] = {1, 2, 4, 6};
                 int i;
 
-                for (i = 0; i < rcnts[DR_GETRES(drom[h->opc][0]) - DR_GETRES(RB_R0)]; i++)
-                    fprintf (st, " R%d:%08X", i, h->res[i]);
+                for (i = 0; i < rcnts[DR_GETRES(drom[opc][0]) - DR_GETRES(RB_R0)]; i++)
+                    fprintf (st, " R%d:%08X", i, res[i]);
                 }
             break;
         case RB_SP:
-            fprintf (st, " SP: %08X", h->res[0]);
+            fprintf (st, " SP: %08X", res[0]);
             break;
         default:
             break;
@@ -3959,13 +4282,23 @@ fprintf (st, "This is controlled by the SET CPU HISTORY and SHOW CPU HISTORY com
 fprintf (st, "   sim> SET CPU HISTORY                 clear history buffer\n");
 fprintf (st, "   sim> SET CPU HISTORY=0               disable history\n");
 fprintf (st, "   sim> SET CPU {-T} HISTORY=n{:file}   enable history, length = n\n");
+fprintf (st, "   sim> SET CPU -M {-T} HISTORY=n:file  enable history, kept in a mapped file\n");
+fprintf (st, "   sim> SET CPU -R HISTORY=file         examine a mapped history file\n");
 fprintf (st, "   sim> SHOW CPU HISTORY                print CPU history\n");
-fprintf (st, "   sim> SHOW CPU HISTORY=n              print first n entries of CPU history\n\n");
+fprintf (st, "   sim> SHOW CPU HISTORY=n              print last n entries of CPU history\n\n");
 fprintf (st, "The -T switch causes simulator time to be recorded (and displayed)\n");
 fprintf (st, "with each history entry.\n");
+fprintf (st, "History entries vary in size with the instruction recorded.  The history\n");
+fprintf (st, "buffer holds n entries of typical size, and often more.\n");
 fprintf (st, "When writing history to a file (SET CPU HISTORY=n:file), 'n' specifies\n");
 fprintf (st, "the buffer flush frequency.  Warning: prodigious amounts of disk space\n");
 fprintf (st, "may be comsumed.  The maximum length for the history is %d entries.\n\n", HIST_MAX);
+fprintf (st, "With -M, the history buffer itself is a memory mapped file which the host\n");
+fprintf (st, "writes back as the simulator runs, so the most recent n entries remain\n");
+fprintf (st, "available even if the simulator is killed or crashes.  The history in\n");
+fprintf (st, "such a file can later be displayed with SET CPU -R HISTORY=file followed\n");
+fprintf (st, "by SHOW CPU HISTORY.  A mapped history may hold up to %d entries\n", HIST_MAX_MAP);
+fprintf (st, "(%d bytes of file per entry).\n\n", HIST_AVG);
 fprintf (st, "Different VAX systems implemented different VAX architecture instructions\n");
 fprintf (st, "in hardware with other instructions possibly emulated by software in the\n");
 fprintf (st, "system.  The instructions that a particular simulator implements can be\n");
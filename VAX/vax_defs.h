@@ -845,23 +845,37 @@ extern const uint16 drom[NUM_INST][MAX_SPEC + 1];
 extern int32 cpu_emulate_exception (int32 *opnd, int32 cc, int32 opc, int32 acc);
 void cpu_idle (void);
 
-/* Instruction History */
+/* Instruction History
+
+   History entries are variable length records in a ring of bytes, so an
+   entry holds only the instruction bytes, operands and results which its
+   instruction has.  Each record is followed by the optional simulator
+   time (double), nopnd operand longwords, nres result longwords and ninst
+   instruction bytes, padded to a multiple of 8 bytes.  A record length
+   of zero marks the point at which the ring wraps. */
+
 #define HIST_MIN        64
-#define HIST_MAX        250000
+#define HIST_MAX        250000                          /* in memory */
+#define HIST_MAX_MAP    0x7FFFFFFF                      /* in a mapped file */
+#define HIST_AVG        64                              /* ring bytes per entry */
 
 #define OPND_SIZE       16
 #define INST_SIZE       52
+#define RES_SIZE        6
 
 typedef struct {
-    double              time;
-    int32               iPC;
-    int32               PSL;
-    int32               opc;
-    uint8               inst[INST_SIZE];
-    uint32              opnd[OPND_SIZE];
-    uint32              res[6];
+    uint16              len;                            /* record length, 0 = wrap */
+    uint16              opc;                            /* opcode */
+    uint8               ninst;                          /* instruction bytes */
+    uint8               nopnd;                          /* operand longwords */
+    uint8               nres;                           /* result longwords */
+    uint8               flags;                          /* HIST_F_xxx */
+    uint32              iPC;
+    uint32              PSL;
     } InstHistory;
 
+#define HIST_F_TIME     0x01                            /* time recorded */
+
 
 /* CPU Register definitions */
 
@@ -954,7 +968,7 @@ extern void op_polyd (int32 *opnd, int32 acc);
 extern void op_polyg (int32 *opnd, int32 acc);
 
 /* vax_octa.c externals */
-extern int32 op_octa (int32 *opnd, int32 cc, int32 opc, int32 acc, int32 spec, int32 va, InstHistory *hst);
+extern int32 op_octa (int32 *opnd, int32 cc, int32 opc, int32 acc, int32 spec, int32 va, uint32 *hres);
 
 /* vax_cmode.c externals */
 extern int32 op_cmode (int32 cc);
@@ -132,6 +132,7 @@ t_stat qba_ex (t_value *vptr, t_addr exta, UNIT *uptr, int32 sw);
 t_stat qba_dep (t_value val, t_addr exta, UNIT *uptr, int32 sw);
 t_bool qba_map_addr (uint32 qa, uint32 *ma);
 t_bool qba_map_addr_c (uint32 qa, uint32 *ma);
+int32 qba_map_run (uint32 qa, int32 bc, uint32 *ma);
 t_stat set_autocon (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat show_autocon (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 t_stat show_iospace (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
@@ -681,6 +682,40 @@ cq_serr (0);                                            /* inv mem */
 return FALSE;
 }
 
+/* Map a run of addresses via the translation map
+
+   Maps qa as qba_map_addr does, then follows the map across pages whose
+   entries are valid and point at consecutive memory pages.  Returns the
+   number of bytes, at most bc, which can be transferred starting at *ma,
+   or 0 if qa itself can't be mapped.
+*/
+
+int32 qba_map_run (uint32 qa, int32 bc, uint32 *ma)
+{
+int32 qblk = (qa >> VA_V_VPN);                          /* Qbus blk */
+int32 run = VA_PAGSIZE - VA_GETOFF (qa);                /* left in page */
+int32 qmma;
+uint32 qmap, nmap;
+
+if (!qba_map_addr (qa, ma))                             /* inv or NXM? */
+    return 0;
+qmap = M[(((qblk << 2) & CQMAPAMASK) + cq_mbr) >> 2];   /* first map entry */
+while (run < bc) {                                      /* more to xfr? */
+    qmma = (((qblk + 1) << 2) & CQMAPAMASK) + cq_mbr;   /* next map entry */
+    if (!ADDR_IS_MEM (qmma))
+        break;
+    nmap = M[qmma >> 2];
+    if (((nmap & CQMAP_VLD) == 0) ||                    /* invalid or */
+        ((nmap & CQMAP_PAG) != ((qmap + 1) & CQMAP_PAG)) || /* not contiguous or */
+        !ADDR_IS_MEM (*ma + run + VA_PAGSIZE - 1))      /* past end of mem? */
+        break;
+    qblk = qblk + 1;
+    qmap = nmap;
+    run = run + VA_PAGSIZE;
+    }
+return (run < bc)? run: bc;
+}
+
 /* Map an address via the translation map - console version (no status changes) */
 
 t_bool qba_map_addr_c (uint32 qa, uint32 *ma)
@@ -794,12 +829,20 @@ return 0;
 
 int32 Map_ReadW (uint32 ba, int32 bc, uint16 *buf)
 {
-int32 i;
+int32 i, run;
 uint32 ma,dat;
 
 ba = ba & ~01;
 bc = bc & ~01;
-if ((ba | bc) & 03) {                                   /* check alignment */
+if (sim_end) {                                          /* little endian host? */
+    for (i = 0; i < bc; i = i + run, buf = buf + (run >> 1)) {/* by map runs */
+        run = qba_map_run (ba + i, bc - i, &ma);
+        if (run == 0)                                   /* inv or NXM? */
+            return (bc - i);
+        memcpy (buf, ((uint8 *) M) + ma, run);          /* memory is in VAX order */
+        }
+    }
+else if ((ba | bc) & 03) {                                   /* check alignment */
     for (i = ma = 0; i < bc; i = i + 2, buf++) {        /* by words */
         if ((ma & VA_M_OFF) == 0) {                     /* need map? */
             if (!qba_map_addr (ba + i, &ma))            /* inv or NXM? */
@@ -858,12 +901,20 @@ return 0;
 
 int32 Map_WriteW (uint32 ba, int32 bc, const uint16 *buf)
 {
-int32 i;
+int32 i, run;
 uint32 ma, dat;
 
 ba = ba & ~01;
 bc = bc & ~01;
-if ((ba | bc) & 03) {                                   /* check alignment */
+if (sim_end) {                                          /* little endian host? */
+    for (i = 0; i < bc; i = i + run, buf = buf + (run >> 1)) {/* by map runs */
+        run = qba_map_run (ba + i, bc - i, &ma);
+        if (run == 0)                                   /* inv or NXM? */
+            return (bc - i);
+        memcpy (((uint8 *) M) + ma, buf, run);          /* memory is in VAX order */
+        }
+    }
+else if ((ba | bc) & 03) {                                   /* check alignment */
     for (i = ma = 0; i < bc; i = i + 2, buf++) {        /* by words */
         if ((ma & VA_M_OFF) == 0) {                     /* need map? */
             if (!qba_map_addr (ba + i, &ma))            /* inv or NXM? */
@@ -0,0 +1,691 @@
+/* DebugTraceDecode.c: binary debug trace (SET DEBUG -C) decoder
+
+   Copyright (c) 2026, The SIMH authors
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+   THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   This program converts a binary debug trace file written by a simulator
+   with SET DEBUG -C into the text which the simulator would have written
+   without -C.  The message prefix, line termination and summarization of
+   duplicate lines follow the debug routines in scp.c.  The file layout is
+   described in sim_debug_trace.h.
+
+   Usage: debugtracedecode trace-file [output-file]
+
+   Times of day (SET DEBUG -T) are displayed in the local time zone of the
+   host running the decoder.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sim_debug_trace.h"
+
+typedef unsigned char       uint8;
+typedef unsigned int        uint32;
+typedef unsigned long long  uint64;
+
+#define SWMASK(x) (1u << (((int) (x)) - ((int) 'A')))
+
+#define PV_RZRO         0                               /* sprint_val formats, from sim_defs.h */
+#define PV_RSPC         1
+#define PV_RCOMMA       2
+#define PV_LEFT         3
+#define PV_RCOMMASIGN   6
+#define PV_LEFTSIGN     7
+#define MAX_WIDTH(bytes) ((int) ((8 * (bytes) * 4 + 3)/3))
+
+/* Trace file state */
+
+static int swap;                                        /* file byte order differs from ours */
+static uint32 deb_switches;
+static long long base_sec;
+static long base_nsec;
+static uint32 pc_radix, pc_width, pc_format, value_size = 4;
+static char pc_name[32];
+static char **strings;                                  /* string text by id */
+static size_t *string_lens;
+static uint32 string_count;
+
+/* Record field access */
+
+typedef struct FIELDS {
+    const uint8 *p;
+    const uint8 *end;
+    } FIELDS;
+
+static int get_bytes (FIELDS *f, void *buf, size_t len)
+{
+if ((size_t)(f->end - f->p) < len) {                    /* truncated record? */
+    memset (buf, 0, len);
+    f->p = f->end;
+    return 0;
+    }
+memcpy (buf, f->p, len);
+if (swap && (len > 1)) {
+    uint8 *b = (uint8 *)buf;
+    size_t i;
+
+    for (i = 0; i < len / 2; i++) {
+        uint8 t = b[i];
+
+        b[i] = b[len - 1 - i];
+        b[len - 1 - i] = t;
+        }
+    }
+f->p += len;
+return 1;
+}
+
+static uint32 get32 (FIELDS *f)
+{
+uint32 val;
+
+get_bytes (f, &val, sizeof (val));
+return val;
+}
+
+static uint64 get64 (FIELDS *f)
+{
+uint64 val;
+
+get_bytes (f, &val, sizeof (val));
+return val;
+}
+
+static double get_double (FIELDS *f)
+{
+double val;
+
+get_bytes (f, &val, sizeof (val));
+return val;
+}
+
+static const char *get_cstring (FIELDS *f)
+{
+const char *s = (const char *)f->p;
+const uint8 *nul = (const uint8 *)memchr (f->p, 0, (size_t)(f->end - f->p));
+
+if (nul == NULL) {
+    f->p = f->end;
+    return "";
+    }
+f->p = nul + 1;
+return s;
+}
+
+static const char *string_text (uint32 id)
+{
+if ((id < string_count) && strings[id])
+    return strings[id];
+return "";
+}
+
+/* Read the next item of the file.  Returns 0 at end of file, the record
+   type for a record (in rec, length in *len) or -1 for a byte of
+   pass-through text (in rec[0]). */
+
+static int next_item (FILE *f, uint8 *rec, size_t *len)
+{
+int c = getc (f);
+
+if (c == EOF)
+    return 0;
+rec[0] = (uint8)c;
+if (c != SIM_DTRC_SYNC)
+    return -1;
+if (fread (&rec[1], 1, SIM_DTRC_HDR_SIZE - 1, f) != SIM_DTRC_HDR_SIZE - 1)
+    return 0;
+*len = ((size_t)rec[2] << 8) | rec[3];
+if ((*len < SIM_DTRC_HDR_SIZE) || (*len > SIM_DTRC_MAX_RECORD) ||
+    (fread (&rec[SIM_DTRC_HDR_SIZE], 1, *len - SIM_DTRC_HDR_SIZE, f) != *len - SIM_DTRC_HDR_SIZE))
+    return 0;
+return rec[1];
+}
+
+static void load_header (const uint8 *rec, size_t len)
+{
+FIELDS f;
+uint32 order;
+
+f.p = rec + SIM_DTRC_HDR_SIZE;
+f.end = rec + len;
+swap = 0;
+order = get32 (&f);
+swap = (order != SIM_DTRC_BYTE_ORDER);
+get32 (&f);                                             /* version */
+deb_switches = get32 (&f);
+base_sec = (long long)get64 (&f);
+base_nsec = (long)get32 (&f);
+pc_radix = get32 (&f);
+pc_width = get32 (&f);
+pc_format = get32 (&f);
+value_size = get32 (&f);
+if ((value_size != 4) && (value_size != 8))
+    value_size = 8;
+strncpy (pc_name, get_cstring (&f), sizeof (pc_name) - 1);
+}
+
+static void load_string (const uint8 *rec, size_t len)
+{
+FIELDS f;
+uint32 id;
+size_t slen;
+
+f.p = rec + SIM_DTRC_HDR_SIZE;
+f.end = rec + len;
+id = get32 (&f);
+slen = (size_t)(f.end - f.p);
+if (id >= string_count) {
+    uint32 count = id + 1024;
+
+    strings = (char **)realloc (strings, count * sizeof (*strings));
+    string_lens = (size_t *)realloc (string_lens, count * sizeof (*string_lens));
+    if ((strings == NULL) || (string_lens == NULL)) {
+        fprintf (stderr, "Out of memory\n");
+        exit (1);
+        }
+    memset (&strings[string_count], 0, (count - string_count) * sizeof (*strings));
+    string_count = count;
+    }
+free (strings[id]);
+strings[id] = (char *)malloc (slen + 1);
+if (strings[id] == NULL) {
+    fprintf (stderr, "Out of memory\n");
+    exit (1);
+    }
+memcpy (strings[id], f.p, slen);
+strings[id][slen] = '\0';
+string_lens[id] = slen;
+}
+
+/* Output with duplicate line summarization, as _sim_debug_write_flush */
+
+static FILE *out;
+static int debug_unterm = 0;
+static char *debug_line_buf_last = NULL;
+static size_t debug_line_buf_last_endprefix_offset = 0;
+static char debug_line_last_prefix[256];
+static char *debug_line_buf = NULL;
+static size_t debug_line_bufsize = 0;
+static size_t debug_line_offset = 0;
+static size_t debug_line_count = 0;
+
+static void debug_write_flush (const char *buf, size_t len, int flush)
+{
+char *eol;
+
+if (deb_switches & SWMASK ('F')) {                      /* filtering disabled? */
+    if (len > 0)
+        fwrite (buf, 1, len, out);
+    return;
+    }
+if (debug_line_offset + len + 1 > debug_line_bufsize) {
+    debug_line_bufsize += (debug_line_offset + len + 1 > 1024) ? debug_line_offset + len + 1 : 1024;
+    debug_line_buf = (char *)realloc (debug_line_buf, debug_line_bufsize);
+    debug_line_buf_last = (char *)realloc (debug_line_buf_last, debug_line_bufsize);
+    if ((debug_line_buf == NULL) || (debug_line_buf_last == NULL)) {
+        fprintf (stderr, "Out of memory\n");
+        exit (1);
+        }
+    }
+memcpy (&debug_line_buf[debug_line_offset], buf, len);
+debug_line_buf[debug_line_offset + len] = '\0';
+debug_line_offset += len;
+while ((eol = strchr (debug_line_buf, '\n')) || flush) {
+    char *endprefix = strstr (debug_line_buf, ")> ");
+    size_t linesize = (eol - debug_line_buf) + 1;
+
+    if ((0 != memcmp ("DBG(", debug_line_buf, 4)) || (endprefix == NULL)) {
+        if (debug_line_count > 0)
+            fputs (debug_line_buf_last, out);
+        if (debug_line_count > 1) {
+            fputs (debug_line_last_prefix, out);
+            fprintf (out, "same as above (%d time%s)\r\n", (int)(debug_line_count - 1), ((debug_line_count - 1) != 1) ? "s" : "");
+            }
+        if (flush) {
+            linesize = debug_line_offset;
+            flush = 0;                                  /* already flushed */
+            }
+        if (linesize)
+            fwrite (debug_line_buf, 1, linesize, out);
+        debug_line_count = 0;
+        }
+    else {
+        linesize = debug_line_offset;
+        if (debug_line_count == 0) {
+            debug_line_buf_last_endprefix_offset = endprefix - debug_line_buf;
+            memcpy (debug_line_buf_last, debug_line_buf, linesize);
+            debug_line_buf_last[linesize] = '\0';
+            debug_line_count = 1;
+            }
+        else {
+            if (0 == memcmp (&debug_line_buf[endprefix - debug_line_buf],
+                             &debug_line_buf_last[debug_line_buf_last_endprefix_offset],
+                             (eol - endprefix)+ 1)) {
+                ++debug_line_count;
+                memcpy (debug_line_last_prefix, debug_line_buf, (endprefix - debug_line_buf) + 3);
+                debug_line_last_prefix[(endprefix - debug_line_buf) + 3] = '\0';
+                }
+            else {
+                fputs (debug_line_buf_last, out);
+                if (debug_line_count > 1) {
+                    fputs (debug_line_last_prefix, out);
+                    fprintf (out, "same as above (%d time%s)\r\n", (int)(debug_line_count - 1), ((debug_line_count - 1) != 1) ? "s" : "");
+                    }
+                debug_line_buf_last_endprefix_offset = endprefix - debug_line_buf;
+                memcpy (debug_line_buf_last, debug_line_buf, linesize);
+                debug_line_buf_last[linesize] = '\0';
+                debug_line_count = 1;
+                }
+            }
+        }
+    debug_line_offset -= linesize;
+    if ((debug_line_offset > 0) && (!flush))
+        memmove (debug_line_buf, eol + 1, debug_line_offset);
+    debug_line_buf[debug_line_offset] = '\0';
+    }
+}
+
+/* Value formatting, as sprint_val in scp.c */
+
+static void print_val (char *buffer, uint64 val, uint32 radix, uint32 width, uint32 format)
+{
+int max_width = MAX_WIDTH (value_size);
+uint64 vmask = (value_size == 8) ? ~(uint64)0 : 0xFFFFFFFFull;
+uint64 wmask = (width >= 64) ? ~(uint64)0 : (((uint64)1 << width) - 1);
+uint64 owtest, wtest;
+int negative = 0;
+int d, digit, ndigits, commas = 0;
+char dbuf[MAX_WIDTH (8) + 1];
+
+*buffer = '\0';
+if (radix < 2)
+    return;
+val &= vmask;
+if (((format == PV_LEFTSIGN) || (format == PV_RCOMMASIGN)) &&
+    (val & ~(vmask >> 1))) {
+    val = (0 - val) & vmask;
+    negative = 1;
+    }
+for (d = 0; d < max_width; d++)
+    dbuf[d] = (format == PV_RZRO)? '0': ' ';
+dbuf[max_width] = 0;
+d = max_width;
+do {
+    d = d - 1;
+    digit = (int) (val % radix);
+    val = val / radix;
+    dbuf[d] = (char)((digit <= 9)? '0' + digit: 'A' + (digit - 10));
+    } while ((d > 0) && (val != 0));
+if (negative && (format == PV_LEFTSIGN))
+    dbuf[--d] = '-';
+
+switch (format) {
+    case PV_LEFT:
+    case PV_LEFTSIGN:
+        break;
+    case PV_RCOMMA:
+    case PV_RCOMMASIGN:
+        for (digit = 0; digit < max_width; digit++)
+            if (dbuf[digit] != ' ')
+                break;
+        ndigits = max_width - digit;
+        commas = (ndigits - 1)/3;
+        for (digit=0; digit<ndigits-3; digit++)
+            dbuf[max_width + (digit - ndigits) - (ndigits - digit - 1)/3] = dbuf[max_width + (digit - ndigits)];
+        for (digit=1; digit<=commas; digit++)
+            dbuf[max_width - (digit * 4)] = ',';
+        d = d - commas;
+        if (negative && (format == PV_RCOMMASIGN))
+            dbuf[--d] = '-';
+        if (width > (uint32)max_width) {
+            sprintf (buffer, "%*s", -((int)width), dbuf);
+            return;
+            }
+        else
+            if (width > 0)
+                d = max_width - width;
+        break;
+    case PV_RZRO:
+    case PV_RSPC:
+        wtest = owtest = radix;
+        ndigits = 1;
+        while ((wtest < (wmask & vmask)) && (wtest >= owtest)) {
+            owtest = wtest;
+            wtest = (wtest * radix) & vmask;
+            ndigits = ndigits + 1;
+            }
+        if ((max_width - (ndigits + commas)) < d)
+            d = max_width - (ndigits + commas);
+        break;
+    }
+if (width < strlen (dbuf+d))
+    return;
+strcpy (buffer, dbuf+d);
+}
+
+/* Message prefix, as sim_debug_prefix in scp.c */
+
+static void debug_prefix (char *buf, FIELDS *f, uint32 flags, const char *dev, const char *verb)
+{
+double gtime = get_double (f);
+char tim_t[32] = "";
+char pc_s[160] = "";
+
+if (flags & SIM_DTRC_F_TIME) {
+    long long sec = (long long)get64 (f);
+    long nsec = (long)get32 (f);
+
+    if (deb_switches & SWMASK ('R')) {
+        sec -= base_sec;
+        nsec -= base_nsec;
+        if (nsec < 0) {
+            nsec += 1000000000;
+            --sec;
+            }
+        }
+    if (deb_switches & SWMASK ('T')) {
+        time_t tnow = (time_t)sec;
+        struct tm *now = localtime (&tnow);
+
+        if (now)
+            sprintf (tim_t, "%02d:%02d:%02d.%03d ", now->tm_hour, now->tm_min, now->tm_sec, (int)(nsec/1000000));
+        }
+    if (deb_switches & SWMASK ('A'))
+        sprintf (tim_t, "%lld.%03d ", sec, (int)(nsec/1000000));
+    }
+if (flags & SIM_DTRC_F_PC) {
+    uint64 val = get64 (f);
+
+    sprintf (pc_s, "-%s:", pc_name);
+    print_val (&pc_s[strlen (pc_s)], val, pc_radix, pc_width, pc_format);
+    }
+sprintf (buf, "DBG(%s%.0f%s)%s> %s %s: ", tim_t, gtime, pc_s, (flags & SIM_DTRC_F_THREAD) ? "+" : "", dev, verb);
+}
+
+/* Append formatted text to a growing buffer */
+
+typedef struct TEXT {
+    char    *buf;
+    size_t  len;
+    size_t  size;
+    } TEXT;
+
+static void text_room (TEXT *t, size_t len)
+{
+if (t->len + len + 1 > t->size) {
+    t->size = 2 * (t->len + len + 1);
+    t->buf = (char *)realloc (t->buf, t->size);
+    if (t->buf == NULL) {
+        fprintf (stderr, "Out of memory\n");
+        exit (1);
+        }
+    }
+}
+
+static void text_append (TEXT *t, const char *s, size_t len)
+{
+text_room (t, len);
+memcpy (t->buf + t->len, s, len);
+t->len += len;
+t->buf[t->len] = '\0';
+}
+
+/* Append a single conversion, however long its result */
+
+static void text_printf (TEXT *t, const char *fmt, ...)
+{
+va_list args;
+int len;
+
+va_start (args, fmt);
+len = vsnprintf (NULL, 0, fmt, args);
+va_end (args);
+if (len <= 0)
+    return;
+text_room (t, (size_t)len);
+va_start (args, fmt);
+vsnprintf (t->buf + t->len, (size_t)len + 1, fmt, args);
+va_end (args);
+t->len += (size_t)len;
+}
+
+/* Build the conversion for a single recorded argument */
+
+static void conversion (char *cbuf, const SIM_DTRC_SPEC *spec, int have_width, int width, int have_prec, int prec, const char *mods)
+{
+char *c = cbuf;
+
+*c++ = '%';
+memcpy (c, spec->flags, spec->flags_len);
+c += spec->flags_len;
+if (have_width)
+    c += sprintf (c, "%d", width);
+else {
+    memcpy (c, spec->width, spec->width_len);
+    c += spec->width_len;
+    }
+if (have_prec) {
+    if (prec >= 0)
+        c += sprintf (c, ".%d", prec);
+    }
+else
+    if (spec->has_prec) {
+        *c++ = '.';
+        memcpy (c, spec->prec, spec->prec_len);
+        c += spec->prec_len;
+        }
+strcpy (c, mods);
+c += strlen (mods);
+*c++ = spec->conv;
+*c = '\0';
+}
+
+static void format_event (TEXT *t, const char *fmt, FIELDS *f)
+{
+SIM_DTRC_SPEC spec;
+const char *c, *next;
+char cbuf[128];
+
+t->len = 0;
+text_append (t, "", 0);
+for (c = fmt; (next = sim_debug_trace_spec (c, &spec)) != NULL; c = next) {
+    int width = 0, prec = -1;
+    char mods[4] = "";
+    size_t i;
+
+    text_append (t, c, (size_t)(spec.start - c));
+    if ((spec.end - spec.start) > 64)                   /* absurd conversion? */
+        spec.cls = SIM_DTRC_ARG_NONE;
+    if (spec.width_star)
+        width = (int)get32 (f);
+    if (spec.prec_star)
+        prec = (int)get32 (f);
+    switch (spec.cls) {
+        case SIM_DTRC_ARG_INT:
+            for (i = 0; (i < spec.mods_len) && (i < 2); i++)
+                if (spec.mods[i] == 'h')                /* keep h and hh */
+                    strcat (mods, "h");
+            conversion (cbuf, &spec, spec.width_star, width, spec.prec_star, prec, mods);
+            text_printf (t, cbuf, (int)get32 (f));
+            break;
+        case SIM_DTRC_ARG_LONG:
+            conversion (cbuf, &spec, spec.width_star, width, spec.prec_star, prec, "ll");
+            text_printf (t, cbuf, (long long)get64 (f));
+            break;
+        case SIM_DTRC_ARG_DOUBLE:
+            conversion (cbuf, &spec, spec.width_star, width, spec.prec_star, prec, "");
+            text_printf (t, cbuf, get_double (f));
+            break;
+        case SIM_DTRC_ARG_POINTER:
+            conversion (cbuf, &spec, spec.width_star, width, spec.prec_star, prec, "");
+            text_printf (t, cbuf, (void *)(size_t)get64 (f));
+            break;
+        case SIM_DTRC_ARG_STRING: {
+            unsigned short slen;
+            size_t len;
+            char *s;
+
+            get_bytes (f, &slen, sizeof (slen));
+            len = slen;
+            if (len > (size_t)(f->end - f->p))
+                len = (size_t)(f->end - f->p);
+            s = (char *)malloc (len + 1);
+            if (s == NULL)
+                break;
+            memcpy (s, f->p, len);
+            s[len] = '\0';
+            f->p += len;
+            conversion (cbuf, &spec, spec.width_star, width, spec.prec_star, prec, "");
+            text_printf (t, cbuf, s);
+            free (s);
+            }
+            break;
+        case SIM_DTRC_ARG_SKIP:
+            break;
+        default:
+            if (spec.conv == '%')
+                text_append (t, "%", 1);
+            else
+                text_append (t, spec.start, (size_t)(spec.end - spec.start));
+            break;
+        }
+    }
+text_append (t, c, strlen (c));
+}
+
+/* Render an event, as _sim_vdebug in scp.c */
+
+static void render_event (const uint8 *rec, size_t reclen, TEXT *t)
+{
+FIELDS f;
+const char *fmt, *dev, *verb;
+uint32 flags;
+char prefix[512];
+size_t i, j, len;
+const char *buf;
+
+f.p = rec + SIM_DTRC_HDR_SIZE;
+f.end = rec + reclen;
+fmt = string_text (get32 (&f));
+dev = string_text (get32 (&f));
+verb = string_text (get32 (&f));
+flags = get32 (&f);
+debug_prefix (prefix, &f, flags, dev, verb);
+format_event (t, fmt, &f);
+buf = t->buf;
+len = t->len;
+for (i = j = 0; i < len; ++i) {
+    if ('\n' == buf[i]) {
+        if (i >= j) {
+            if ((i != j) || (i == 0)) {
+                if (!debug_unterm)                      /* print prefix when required */
+                    debug_write_flush (prefix, strlen (prefix), 0);
+                debug_write_flush (&buf[j], i-j, 0);
+                debug_write_flush ("\r\n", 2, 0);
+                }
+            debug_unterm = 0;
+            }
+        j = i + 1;
+        }
+    }
+if (i > j) {
+    if (!debug_unterm)                                  /* print prefix when required */
+        debug_write_flush (prefix, strlen (prefix), 0);
+    debug_write_flush (&buf[j], i-j, 0);
+    }
+debug_unterm = len ? (((buf[len-1]=='\n')) ? 0 : 1) : debug_unterm;
+}
+
+/* Render fprintf (sim_deb, ...) output, as Fprintf in scp.c */
+
+static void render_text (const uint8 *rec, size_t reclen, TEXT *t)
+{
+FIELDS f;
+
+f.p = rec + SIM_DTRC_HDR_SIZE;
+f.end = rec + reclen;
+format_event (t, string_text (get32 (&f)), &f);
+debug_write_flush (t->buf, t->len, 0);
+}
+
+int main (int argc, char *argv[])
+{
+FILE *in;
+uint8 rec[SIM_DTRC_MAX_RECORD];
+size_t len = 0;
+int type;
+TEXT text = {NULL, 0, 0};
+unsigned long events = 0;
+
+if ((argc < 2) || (argc > 3)) {
+    fprintf (stderr, "Usage: %s trace-file [output-file]\n", argv[0]);
+    return 1;
+    }
+in = fopen (argv[1], "rb");
+if (in == NULL) {
+    perror (argv[1]);
+    return 1;
+    }
+out = stdout;
+if ((argc == 3) && ((out = fopen (argv[2], "w")) == NULL)) {
+    perror (argv[2]);
+    return 1;
+    }
+
+/* Strings may be defined after their first use, so collect them first */
+
+while ((type = next_item (in, rec, &len)) != 0) {
+    if (type == SIM_DTRC_HEADER)
+        load_header (rec, len);
+    else if (type == SIM_DTRC_STRING)
+        load_string (rec, len);
+    }
+rewind (in);
+while ((type = next_item (in, rec, &len)) != 0) {
+    switch (type) {
+        case -1:                                        /* text written directly */
+            putc (rec[0], out);
+            break;
+        case SIM_DTRC_HEADER:
+            load_header (rec, len);
+            break;
+        case SIM_DTRC_EVENT:
+            render_event (rec, len, &text);
+            ++events;
+            break;
+        case SIM_DTRC_TEXT:
+            render_text (rec, len, &text);
+            break;
+        case SIM_DTRC_FLUSH:
+            debug_write_flush ("", 0, 1);
+            break;
+        default:
+            break;
+        }
+    }
+debug_write_flush ("", 0, 1);
+fclose (in);
+if (out != stdout)
+    fclose (out);
+fprintf (stderr, "%lu debug events decoded\n", events);
+return 0;
+}
@@ -107,6 +107,15 @@ simulation_time = sim_time;
 update_display = 1;
 }
 
+volatile int callback_count = 0;
+
+static void
+CountingCallback (PANEL *panel, unsigned long long sim_time, void *context)
+{
+simulation_time = sim_time;
+++callback_count;
+}
+
 static void
 DisplayRegisters (PANEL *panel, int get_pos, int set_pos)
 {
@@ -664,6 +673,84 @@ struct execution_breakpoint {
         {0x0, NULL}
     };
 
+struct {
+    unsigned int addr;
+    const char *instr;
+    } long_running_program[] = {
+        {0x2000,  "MOVL #7FFFFFFF,R0"},
+        {0x2007,  "MOVL #7FFFFFFF,R1"},
+        {0x200E,  "SOBGTR R1,200E"},
+        {0x2011,  "SOBGTR R0,2007"},
+        {0x2014,  "HALT"},
+        {0,NULL}
+    };
+
+int
+load_long_running_program (PANEL *panel)
+{
+int i;
+
+for (i=0; long_running_program[i].instr; i++)
+    if (sim_panel_mem_deposit_instruction (panel, sizeof(long_running_program[i].addr), 
+                                           &long_running_program[i].addr, long_running_program[i].instr)) {
+        printf ("Error setting depositing instruction '%s' into memory at location %XR0: %s\n", 
+                long_running_program[i].instr, long_running_program[i].addr, sim_panel_get_error());
+        return -1;
+        }
+if (sim_panel_gen_deposit (panel, "PC", sizeof(long_running_program[0].addr), &long_running_program[0].addr)) {
+    printf ("Error setting PC to %X: %s\n", long_running_program[0].addr, sim_panel_get_error());
+    return -1;
+    }
+return 0;
+}
+
+/* Measure register delivery at a 1ms callback interval while the simulator 
+   runs, and the simulator's instruction rate while it is delivering */
+
+int
+throughput_test ()
+{
+unsigned long long start_time, end_time;
+int seconds = 2, callbacks;
+
+sim_panel_debug (panel, "Testing register delivery throughput");
+if (load_long_running_program (panel))
+    return -1;
+if (sim_panel_get_registers (panel, &start_time)) {
+    printf ("Error getting register data: %s\n", sim_panel_get_error());
+    return -1;
+    }
+if (sim_panel_set_display_callback_interval (panel, NULL, NULL, 0) ||
+    sim_panel_set_display_callback_interval (panel, &CountingCallback, NULL, 1000)) {
+    printf ("Error setting automatic display callback: %s\n", sim_panel_get_error());
+    return -1;
+    }
+usleep (1000000);   /* let register delivery get established */
+callback_count = 0;
+if (sim_panel_exec_run (panel)) {
+    printf ("Error starting simulator execution: %s\n", sim_panel_get_error());
+    return -1;
+    }
+usleep (seconds * 1000000);
+callbacks = callback_count;
+if (sim_panel_exec_halt (panel)) {
+    printf ("Error halting simulator execution: %s\n", sim_panel_get_error());
+    return -1;
+    }
+if (sim_panel_set_display_callback_interval (panel, NULL, NULL, 0) ||
+    sim_panel_get_registers (panel, &end_time)) {
+    printf ("Error getting register data: %s\n", sim_panel_get_error());
+    return -1;
+    }
+printf ("Register Delivery: %d callbacks in %d seconds (%d/sec), %d registers each\n", callbacks, seconds, callbacks / seconds, 18 + (int)(sizeof(PCQ)/sizeof(PCQ[0])));
+printf ("Simulator: %llu instructions in %d seconds (%llu/sec) while delivering\n", end_time - start_time, seconds, (end_time - start_time) / seconds);
+if (callbacks == 0) {
+    printf ("No register callbacks while running\n");
+    return -1;
+    }
+return 0;
+}
+
 int
 main (int argc, char **argv)
 {
@@ -675,31 +762,9 @@ if ((argc > 1) && ((!strcmp("-d", argv[1])) || (!strcmp("-D", argv[1])) || (!str
 if (panel_setup())
     goto Done;
 if (1) {
-    struct {
-        unsigned int addr;
-        const char *instr;
-        } long_running_program[] = {
-            {0x2000,  "MOVL #7FFFFFFF,R0"},
-            {0x2007,  "MOVL #7FFFFFFF,R1"},
-            {0x200E,  "SOBGTR R1,200E"},
-            {0x2011,  "SOBGTR R0,2007"},
-            {0x2014,  "HALT"},
-            {0,NULL}
-        };
-    int i;
-
     sim_panel_debug (panel, "Testing sim_panel_exec_halt and sim_panel_destroy() () with simulator in Run State");
-    for (i=0; long_running_program[i].instr; i++)
-        if (sim_panel_mem_deposit_instruction (panel, sizeof(long_running_program[i].addr), 
-                                               &long_running_program[i].addr, long_running_program[i].instr)) {
-            printf ("Error setting depositing instruction '%s' into memory at location %XR0: %s\n", 
-                    long_running_program[i].instr, long_running_program[i].addr, sim_panel_get_error());
-            goto Done;
-            }
-    if (sim_panel_gen_deposit (panel, "PC", sizeof(long_running_program[0].addr), &long_running_program[0].addr)) {
-        printf ("Error setting PC to %X: %s\n", long_running_program[0].addr, sim_panel_get_error());
+    if (load_long_running_program (panel))
         goto Done;
-        }
     if (sim_panel_exec_start (panel)) {
         printf ("Error starting simulator execution: %s\n", sim_panel_get_error());
         goto Done;
@@ -720,6 +785,12 @@ if (1) {
     sim_panel_destroy (panel);
     }
 sim_panel_clear_error ();
+if (panel_setup ())
+    goto Done;
+if (throughput_test ())
+    goto Done;
+sim_panel_destroy (panel);
+sim_panel_clear_error ();
 InitDisplay ();
 if (panel_setup ())
     goto Done;
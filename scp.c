@@ -230,6 +230,7 @@
 #endif
 #include "sim_sock.h"
 #include "sim_frontpanel.h"
+#include "sim_debug_trace.h"
 #include <signal.h>
 #include <ctype.h>
 #include <time.h>
@@ -380,47 +381,158 @@ int32 sim_asynch_check;
 int32 sim_asynch_latency = 4000;      /* 4 usec interrupt latency */
 int32 sim_asynch_inst_latency = 20;   /* assume 5 mip simulator */
 
+volatile t_bool sim_asynch_pending;   /* completions are waiting to be collected */
+
+/* Completion statistics (maintained by the main thread) */
+
+static t_uint64 sim_asynch_completions;              /* activations collected */
+static t_uint64 sim_asynch_drains;                  /* collections which found something */
+static uint32 sim_asynch_max_batch;                 /* most activations collected at once */
+
+#if defined (USE_AIO_INTRINSICS)
+/* Completion ring
+
+   I/O threads post unit activations into a fixed ring of unit pointers.
+   A producer first claims the unit (a_next goes from NULL to
+   QUEUE_LIST_END), then reserves a slot by advancing the tail with
+   compare and swap and publishes the unit pointer into it.  Only the
+   main thread consumes, so the head needs no interlocking.  A reserved
+   slot which hasn't been published yet stops the drain; its producer
+   raises sim_asynch_pending once it has published.  If the ring is ever
+   full, activations fall back to the lock free sim_asynch_queue list.
+*/
+
+#define AIO_RING_SIZE 256                           /* power of 2 */
+
+static UNIT * volatile sim_asynch_ring[AIO_RING_SIZE];
+static void * volatile sim_asynch_ring_tail;        /* next slot to reserve (producers) */
+static volatile size_t sim_asynch_ring_head;        /* next slot to drain (main thread) */
+static t_uint64 sim_asynch_overflows;               /* activations which didn't fit in the ring */
+#endif
+
+static void _sim_aio_dispatch (UNIT *uptr)
+{
+int32 a_event_time;
+ACTIVATE_API a_activate_call = uptr->a_activate_call;
+
+sim_debug (SIM_DBG_AIO_QUEUE, &sim_scp_dev, "Migrating Asynch event for %s after %d instructions\n", sim_uname(uptr), uptr->a_event_time);
+if (a_activate_call != &sim_activate_notbefore) {
+    a_event_time = uptr->a_event_time-((sim_asynch_inst_latency+1)/2);
+    if (a_event_time < 0)
+        a_event_time = 0;
+    }
+else
+    a_event_time = uptr->a_event_time;
+uptr->a_next = NULL;                /* hygiene */
+a_activate_call (uptr, a_event_time);
+if (uptr->a_check_completion) {
+    sim_debug (SIM_DBG_AIO_QUEUE, &sim_scp_dev, "Calling Completion Check for asynch event on %s\n", sim_uname(uptr));
+    uptr->a_check_completion (uptr);
+    }
+}
+
 int sim_aio_update_queue (void)
 {
 int migrated = 0;
+UNIT *q, *uptr;
 
+if (!sim_asynch_pending)
+    return 0;
+#if defined (USE_AIO_INTRINSICS)
+if (1) {
+    UNIT *batch[AIO_RING_SIZE];
+    int i;
+
+    sim_asynch_pending = FALSE;
+    q = AIO_QUEUE_VAL;                  /* interlocked read orders the flag clear before the drain */
+    while (migrated < AIO_RING_SIZE) {  /* collect the published activations */
+        UNIT * volatile *slot = &sim_asynch_ring[sim_asynch_ring_head & (AIO_RING_SIZE - 1)];
+
+        uptr = *slot;
+        if (uptr == NULL)               /* empty, or reserved but not published yet */
+            break;
+        (void)InterlockedCompareExchangePointer ((void * volatile *)slot, NULL, uptr);/* release slot */
+        ++sim_asynch_ring_head;
+        batch[migrated++] = uptr;
+        }
+    if (migrated == AIO_RING_SIZE)      /* may have stopped short? */
+        sim_asynch_pending = TRUE;
+    if (q != QUEUE_LIST_END) {          /* overflow list !Empty */
+        do {                            /* Grab current queue */
+            q = AIO_QUEUE_VAL;
+            } while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));
+        }
+    for (i = 0; i < migrated; i++)
+        _sim_aio_dispatch (batch[i]);
+    while (q != QUEUE_LIST_END) {       /* List !Empty */
+        uptr = q;
+        q = q->a_next;
+        ++migrated;
+        ++sim_asynch_overflows;
+        _sim_aio_dispatch (uptr);
+        }
+    }
+#else
 AIO_ILOCK;
+sim_asynch_pending = FALSE;
 if (AIO_QUEUE_VAL != QUEUE_LIST_END) {  /* List !Empty */
-    UNIT *q, *uptr;
-    int32 a_event_time;
     do {                                /* Grab current queue */
         q = AIO_QUEUE_VAL;
         } while (q != AIO_QUEUE_SET(QUEUE_LIST_END, q));
     while (q != QUEUE_LIST_END) {       /* List !Empty */
-        sim_debug (SIM_DBG_AIO_QUEUE, &sim_scp_dev, "Migrating Asynch event for %s after %d instructions\n", sim_uname(q), q->a_event_time);
         ++migrated;
         uptr = q;
         q = q->a_next;
-        uptr->a_next = NULL;        /* hygiene */
-        if (uptr->a_activate_call != &sim_activate_notbefore) {
-            a_event_time = uptr->a_event_time-((sim_asynch_inst_latency+1)/2);
-            if (a_event_time < 0)
-                a_event_time = 0;
-            }
-        else
-            a_event_time = uptr->a_event_time;
         AIO_IUNLOCK;
-        uptr->a_activate_call (uptr, a_event_time);
-        if (uptr->a_check_completion) {
-            sim_debug (SIM_DBG_AIO_QUEUE, &sim_scp_dev, "Calling Completion Check for asynch event on %s\n", sim_uname(uptr));
-            uptr->a_check_completion (uptr);
-            }
+        _sim_aio_dispatch (uptr);
         AIO_ILOCK;
         }
     }
 AIO_IUNLOCK;
+#endif
+if (migrated) {
+    ++sim_asynch_drains;
+    sim_asynch_completions += migrated;
+    if ((uint32)migrated > sim_asynch_max_batch)
+        sim_asynch_max_batch = (uint32)migrated;
+    }
 return migrated;
 }
 
 void sim_aio_activate (ACTIVATE_API caller, UNIT *uptr, int32 event_time)
 {
-AIO_ILOCK;
 sim_debug (SIM_DBG_AIO_QUEUE, &sim_scp_dev, "Queueing Asynch event for %s after %d instructions\n", sim_uname(uptr), event_time);
+#if defined (USE_AIO_INTRINSICS)
+if (InterlockedCompareExchangePointer ((void * volatile *)&uptr->a_next, QUEUE_LIST_END, NULL) != NULL)
+    uptr->a_activate_call = sim_activate_abs;       /* already queued */
+else {
+    UNIT *q;
+    size_t tail;
+    t_bool reserved = FALSE;
+
+    uptr->a_event_time = event_time;
+    uptr->a_activate_call = caller;
+    do {                                            /* reserve a ring slot */
+        tail = (size_t)sim_asynch_ring_tail;
+        if ((tail - sim_asynch_ring_head) >= AIO_RING_SIZE)
+            break;                                  /* full */
+        reserved = (InterlockedCompareExchangePointer (&sim_asynch_ring_tail, (void *)(tail + 1), (void *)tail) == (void *)tail);
+        } while (!reserved);
+    if (reserved) {                                 /* the slot is ours and must be published */
+        UNIT * volatile *slot = &sim_asynch_ring[tail & (AIO_RING_SIZE - 1)];
+
+        while (InterlockedCompareExchangePointer ((void * volatile *)slot, uptr, NULL) != NULL)
+            ;                                       /* previous occupant is being released */
+        }
+    else {
+        do {                                        /* push on the overflow list */
+            q = AIO_QUEUE_VAL;
+            uptr->a_next = q;
+            } while (q != AIO_QUEUE_SET(uptr, q));
+        }
+    }
+#else
+AIO_ILOCK;
 if (uptr->a_next) {
     uptr->a_activate_call = sim_activate_abs;
     }
@@ -434,6 +546,8 @@ else {
         } while (q != AIO_QUEUE_SET(uptr, q));
     }
 AIO_IUNLOCK;
+#endif
+sim_asynch_pending = TRUE;
 sim_asynch_check = 0;                             /* try to force check */
 if (sim_idle_wait) {
     sim_debug (TIMER_DBG_IDLE, &sim_timer_dev, "waking due to event on %s after %d instructions\n", sim_uname(uptr), event_time);
@@ -457,6 +571,7 @@ t_addr (*sim_vm_parse_addr) (DEVICE *dptr, CONST char *cptr, CONST char **tptr)
 t_value (*sim_vm_pc_value) (void) = NULL;
 t_bool (*sim_vm_is_subroutine_call) (t_addr **ret_addrs) = NULL;
 t_bool (*sim_vm_fprint_stopped) (FILE *st, t_stat reason) = NULL;
+void *(*sim_vm_mem_image) (UNIT *uptr, size_t *size) = NULL;
 
 /* Prototypes */
 
@@ -561,9 +676,15 @@ t_stat do_cmd_label (int32 flag, CONST char *cptr, CONST char *label);
 void int_handler (int signal);
 t_stat set_prompt (int32 flag, CONST char *cptr);
 t_stat sim_set_asynch (int32 flag, CONST char *cptr);
+t_stat sim_set_queue (int32 flag, CONST char *cptr);
+t_stat show_queue_statistics (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr);
+static t_stat _sim_queue_set_engine (int32 engine);
+static void _sim_queue_rebase (double delta);
 static const char *_get_dbg_verb (uint32 dbits, DEVICE* dptr, UNIT *uptr);
 static t_stat sim_library_unit_tests (void);
 static t_stat _sim_debug_flush (void);
+static void _sim_debug_trace_flush (void);
+static void _sim_debug_trace_buf (const char *buf, size_t len);
 
 /* Global data */
 
@@ -585,6 +706,7 @@ int32 sim_opt_out = 0;
 volatile t_bool sim_is_running = FALSE;
 t_bool sim_processing_event = FALSE;
 uint32 sim_brk_summ = 0;
+uint32 sim_brk_map[SIM_BRK_MAP_SIZE];
 uint32 sim_brk_types = 0;
 BRKTYPTAB *sim_brk_type_desc = NULL;                  /* type descriptions */
 uint32 sim_brk_dflt = 0;
@@ -605,6 +727,57 @@ size_t *sim_sub_instr_off = NULL;   /* offsets in substitution buffer where orig
 static double sim_time;
 static uint32 sim_rtime;
 static int32 noqueue_time;
+static int32 sim_queue_engine = 0;                      /* event queue engine (index into sim_queue_engines) */
+static int32 sim_queue_depth = 0;                       /* number of entries on the event queue */
+static UNIT **sim_queue_heap = NULL;                    /* heap engine entries */
+static int32 sim_queue_heap_size = 0;                   /* heap engine allocated entries */
+static t_uint64 sim_queue_seq = 0;                      /* heap engine activation sequence */
+
+typedef struct QUEUE_ENGINE {
+    const char  *name;                                  /* engine name */
+    const char  *desc;                                  /* engine description */
+    void        (*insert)(UNIT *uptr, int32 event_time);/* queue entry event_time from now */
+    t_bool      (*remove)(UNIT *uptr);                  /* dequeue entry, FALSE if not queued */
+    UNIT        *(*pop)(void);                          /* dequeue first entry and set sim_interval */
+    int32       (*offset)(UNIT *uptr);                  /* time past first entry, -1 if not queued */
+    int32       (*entries)(UNIT ***units, int32 **times);/* queued entries and times in firing order */
+    } QUEUE_ENGINE;
+
+typedef struct QUEUE_STATS {
+    t_uint64    inserts;                                /* activations */
+    t_uint64    insert_steps;                           /* entries visited during activations */
+    t_uint64    cancels;                                /* cancels of queued entries */
+    t_uint64    cancel_steps;                           /* entries visited during cancels */
+    t_uint64    dispatches;                             /* entries dequeued for processing */
+    t_uint64    dispatch_steps;                         /* entries visited during dispatch */
+    int32       max_depth;                              /* peak number of queued entries */
+    } QUEUE_STATS;
+
+static void _sim_queue_list_insert (UNIT *uptr, int32 event_time);
+static t_bool _sim_queue_list_remove (UNIT *uptr);
+static UNIT *_sim_queue_list_pop (void);
+static int32 _sim_queue_list_offset (UNIT *uptr);
+static int32 _sim_queue_list_entries (UNIT ***units, int32 **times);
+static void _sim_queue_heap_insert (UNIT *uptr, int32 event_time);
+static t_bool _sim_queue_heap_remove (UNIT *uptr);
+static UNIT *_sim_queue_heap_pop (void);
+static int32 _sim_queue_heap_offset (UNIT *uptr);
+static int32 _sim_queue_heap_entries (UNIT ***units, int32 **times);
+
+static QUEUE_ENGINE sim_queue_engines[] = {
+    { "LIST", "delta encoded linked list",
+      &_sim_queue_list_insert, &_sim_queue_list_remove, &_sim_queue_list_pop, 
+      &_sim_queue_list_offset, &_sim_queue_list_entries },
+    { "HEAP", "binary heap ordered by absolute time",
+      &_sim_queue_heap_insert, &_sim_queue_heap_remove, &_sim_queue_heap_pop, 
+      &_sim_queue_heap_offset, &_sim_queue_heap_entries },
+    { NULL }
+    };
+
+static QUEUE_STATS sim_queue_stats[sizeof (sim_queue_engines) / sizeof (sim_queue_engines[0]) - 1];
+
+#define QUEUE_ENGINE_COUNT (int32)(sizeof (sim_queue_stats) / sizeof (sim_queue_stats[0]))
+
 volatile t_bool stop_cpu = FALSE;
 volatile t_bool sigterm_received = FALSE;
 static unsigned int sim_stop_sleep_ms = 250;
@@ -708,6 +881,7 @@ const char *sim_savename = sim_name;      /* Simulator Name used in SAVE/RESTORE
 /* Tables and strings */
 
 const char save_vercur[] = "V4.0";
+const char save_ver41[] = "V4.1";                       /* V4.0 plus memory image snapshot */
 const char save_ver40[] = "V4.0";
 const char save_ver35[] = "V3.5";
 const char save_ver32[] = "V3.2";
@@ -951,6 +1125,17 @@ static const char simh_help[] =
       " to a file.  This includes the contents of main memory and all registers,\n"
       " and the I/O connections of devices:\n\n"
       "++SAVE <filename>\n\n"
+      "4Switches\n"
+      " Switches can influence the output and behavior of the SAVE command\n\n"
+      "++-B      Saves memory as a binary snapshot\n"
+      "++-I      Saves memory as an incremental binary snapshot\n\n"
+      " A binary snapshot holds a copy of the memory of simulators which support\n"
+      " it, so large memories are saved and restored in a small fraction of the\n"
+      " time.  An incremental snapshot only holds the memory pages which changed\n"
+      " since the last binary snapshot which was saved or restored, and refers to\n"
+      " that snapshot for the rest, so it must remain available to restore the\n"
+      " incremental snapshot.  Binary snapshots can only be restored on hosts\n"
+      " with the same byte order.\n"
 #define HLP_RESTORE     "*Commands Saving_and_Restoring_State RESTORE"
       "3RESTORE\n"
       " The RESTORE command (abbreviation REST, alternately GET) restores a\n"
@@ -963,7 +1148,8 @@ static const char simh_help[] =
       "++-F      Overrides the related file timestamp validation check\n"
       "\n"
       "4Notes:\n"
-      " 1) SAVE file format compresses zeroes to minimize file size.\n"
+      " 1) SAVE file format compresses zeroes to minimize file size.  Binary\n"
+      " snapshots leave out memory pages which are all zeroes.\n"
       " 2) The simulator can't restore active incoming telnet sessions to\n"
       " multiplexer devices, but the listening ports will be restored across a\n"
       " save/restore.\n"
@@ -1294,6 +1480,15 @@ static const char simh_help[] =
       " The size of the circular memory buffer that is used is specified on\n"
       " the SET DEBUG command line, for example:\n\n"
       "++SET DEBUG -B <sizeinMB> <debug-destination>\n\n"
+      "5-C\n"
+      " The -C switch causes debug messages to be recorded in a compact binary\n"
+      " form rather than being formatted as they occur.  This greatly reduces\n"
+      " the cost of debugging busy devices.  The debug destination must be a\n"
+      " file, which is always created new.  The debugtracedecode tool converts\n"
+      " the file into the text that would otherwise have been written:\n\n"
+      "++SET DEBUG -C <trace-file>\n"
+      "++debugtracedecode <trace-file> [<text-file>]\n\n"
+      " The -C switch can't be combined with the -B switch.\n"
 #define HLP_SET_BREAK  "*Commands SET Breakpoints"
       "3Breakpoints\n"
       "+SET BREAK <list>            set breakpoints\n"
@@ -1342,6 +1537,18 @@ static const char simh_help[] =
       "3Asynch\n"
       "+SET ASYNCH                  enable asynchronous I/O\n"
       "+SET NOASYNCH                disable asynchronous I/O\n"
+#define HLP_SET_QUEUE "*Commands SET Queue"
+      "3Queue\n"
+      "+SET QUEUE ENGINE=LIST       order pending events on a linked list\n"
+      "+SET QUEUE ENGINE=HEAP       order pending events in a binary heap\n"
+      "+SET QUEUE STATISTICS=RESET  clear event queue statistics\n\n"
+      " The event queue engine determines how pending unit events are kept in\n"
+      " time order.  The LIST engine (the default) is fastest when few events are\n"
+      " pending.  The HEAP engine keeps activation and cancel costs proportional\n"
+      " to the logarithm of the number of pending events, which helps\n"
+      " configurations with many active units.  The engine may be changed at any\n"
+      " time and pending events keep their order and timing.  The SHOW QUEUE\n"
+      " STATISTICS command displays the work each engine has done.\n"
 #define HLP_SET_ENVIRON "*Commands SET Environment"
       "3Environment\n"
       "4Explicitily Changing a Variable\n"
@@ -1424,6 +1631,27 @@ static const char simh_help[] =
 #define HLP_SET_PROMPT "*Commands SET Command_Prompt"
       "3Command Prompt\n"
       "+SET PROMPT \"string\"        sets an alternate simulator prompt string\n"
+#if defined(USE_SIM_VIDEO)
+#define HLP_SET_VIDEO "*Commands SET Video"
+      "3Video\n"
+      "+SET VIDEO HEADLESS          keep the video display in memory, without\n"
+      "++++++++                     a window\n"
+      "+SET VIDEO WINDOW            display video in a window (the default when\n"
+      "++++++++                     built with SDL)\n"
+      "+SET VIDEO FORMAT=RAW|PNG    set the format of streamed frames\n"
+      "+SET VIDEO RATE=n            stream at most n frames per second\n"
+      "++++++++                     (0 for every refresh, default 10)\n"
+      "+SET VIDEO STREAM=file       write headless display frames to file\n"
+      "+SET VIDEO STREAM=|command   write headless display frames to the\n"
+      "++++++++                     input of command\n"
+      "+SET VIDEO NOSTREAM          stop streaming frames\n\n"
+      " The mode must be chosen before the video device is enabled.  A headless\n"
+      " display can be saved with SCREENSHOT and, while streaming, each changed\n"
+      " frame is written when the device refreshes the display.  RAW frames are\n"
+      " the display pixels, 4 bytes each in blue, green, red, alpha order, with\n"
+      " no header (ffmpeg -f rawvideo -pix_fmt bgra).  PNG frames are complete\n"
+      " PNG images.  STREAM= takes the rest of the line, so it must be last.\n"
+#endif
       "3Device and Unit\n"
       "+SET <dev> OCT|DEC|HEX|BIN   set device display radix\n"
       "+SET <dev> ENABLED           enable device\n"
@@ -1448,6 +1676,7 @@ static const char simh_help[] =
       "+sh{ow} s{how}               show SHOW commands for all devices\n" 
       "+sh{ow} n{ames}              show logical names\n"
       "+sh{ow} q{ueue}              show event queue\n"
+      "+sh{ow} q{ueue} st{atistics} show event queue engine statistics\n"
       "+sh{ow} ti{me}               show simulated time\n"
       "+sh{ow} th{rottle}           show simulation rate\n"
       "+sh{ow} a{synch}             show asynchronouse I/O state\n" 
@@ -2279,8 +2508,9 @@ static const char simh_help[] =
 #define HLP_SCREENSHOT  "*Commands Screenshot_Video_Window"
       "2Screenshot Video Window\n"
       " Simulators with Video devices display the simulated video in a window\n"
-      " on the local system.  The contents of that display can be saved in a\n"
-      " file with the SCREENSHOT command:\n\n"
+      " on the local system, or keep it in memory when the display is headless\n"
+      " (see SET VIDEO).  The contents of that display can be saved in a file\n"
+      " with the SCREENSHOT command:\n\n"
       "++SCREENSHOT screenshotfile\n\n"
 #if defined(HAVE_LIBPNG)
       " which will create a screen shot file called screenshotfile.png\n"
@@ -2385,6 +2615,7 @@ static CTAB set_glob_tab[] = {
     { "CLOCKS",     &sim_set_timers,            1, HLP_SET_CLOCK },
     { "ASYNCH",     &sim_set_asynch,            1, HLP_SET_ASYNCH },
     { "NOASYNCH",   &sim_set_asynch,            0, HLP_SET_ASYNCH },
+    { "QUEUE",      &sim_set_queue,             0, HLP_SET_QUEUE },
     { "ENVIRONMENT", &sim_set_environment,      1, HLP_SET_ENVIRON },
     { "ON",         &set_on,                    1, HLP_SET_ON },
     { "NOON",       &set_on,                    0, HLP_SET_ON },
@@ -2397,6 +2628,9 @@ static CTAB set_glob_tab[] = {
     { "QUIET",      &set_quiet,                 1, HLP_SET_QUIET },
     { "NOQUIET",    &set_quiet,                 0, HLP_SET_QUIET },
     { "PROMPT",     &set_prompt,                0, HLP_SET_PROMPT },
+#if defined(USE_SIM_VIDEO)
+    { "VIDEO",      &vid_set,                   0, HLP_SET_VIDEO },
+#endif
     { NULL,         NULL,                       0 }
     };
 
@@ -5126,6 +5360,12 @@ if (cptr && (*cptr != 0))
     return SCPE_2MARG;
 #ifdef SIM_ASYNCH_IO
 fprintf (st, "Asynchronous I/O is %sabled, %s\n", (sim_asynch_enabled) ? "en" : "dis", AIO_QUEUE_MODE);
+fprintf (st, "Asynchronous completions: %" LL_FMT "u in %" LL_FMT "u batches (largest %u)",
+             sim_asynch_completions, sim_asynch_drains, sim_asynch_max_batch);
+#if defined (USE_AIO_INTRINSICS)
+fprintf (st, ", %" LL_FMT "u overflowed the %d entry ring", sim_asynch_overflows, AIO_RING_SIZE);
+#endif
+fprintf (st, "\n");
 #if defined(SIM_ASYNCH_MUX)
 fprintf (st, "Asynchronous Multiplexer support is available\n");
 #endif
@@ -5138,6 +5378,44 @@ fprintf (st, "Asynchronous I/O is not available in this simulator\n");
 return SCPE_OK;
 }
 
+/* Set event queue routine */
+
+t_stat sim_set_queue (int32 flag, CONST char *cptr)
+{
+char *cvptr, gbuf[CBUFSIZE], vbuf[CBUFSIZE];
+int32 i;
+t_stat r;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+while (*cptr != 0) {                                    /* do all mods */
+    cptr = get_glyph_nc (cptr, gbuf, ',');              /* get modifier */
+    if ((cvptr = strchr (gbuf, '=')))                   /* = value? */
+        *cvptr++ = 0;
+    get_glyph (gbuf, gbuf, 0);                          /* modifier to UC */
+    if ((cvptr == NULL) || (*cvptr == 0))
+        return sim_messagef (SCPE_MISVAL, "Missing value for %s\n", gbuf);
+    get_glyph (cvptr, vbuf, 0);                         /* value to UC */
+    if (MATCH_CMD (gbuf, "ENGINE") == 0) {
+        for (i = 0; sim_queue_engines[i].name != NULL; i++)
+            if (strcmp (vbuf, sim_queue_engines[i].name) == 0)
+                break;
+        if (sim_queue_engines[i].name == NULL)
+            return sim_messagef (SCPE_ARG, "Unknown event queue engine: %s\n", vbuf);
+        r = _sim_queue_set_engine (i);
+        if (r != SCPE_OK)
+            return r;
+        }
+    else {
+        if ((MATCH_CMD (gbuf, "STATISTICS") != 0) || (MATCH_CMD (vbuf, "RESET") != 0))
+            return SCPE_NOPARAM;
+        memset (sim_queue_stats, 0, sizeof (sim_queue_stats));
+        sim_queue_stats[sim_queue_engine].max_depth = sim_queue_depth;
+        }
+    }
+return SCPE_OK;
+}
+
 /* Set environment routine */
 
 t_stat sim_set_environment (int32 flag, CONST char *cptr)
@@ -6011,16 +6289,39 @@ else if (!flag)
 return SCPE_OK;
 }
 
+#if defined (SIM_ASYNCH_IO)
+static void _sim_show_aio_event (FILE *st, UNIT *uptr, const char *note)
+{
+DEVICE *dptr;
+
+if ((dptr = find_dev_from_unit (uptr)) != NULL) {
+    fprintf (st, "  %s", sim_dname (dptr));
+    if (dptr->numunits > 1) fprintf (st, " unit %d",
+        (int32) (uptr - dptr->units));
+    }
+else fprintf (st, "  Unknown");
+fprintf (st, " event delay %d%s\n", uptr->a_event_time, note);
+}
+#endif
+
 t_stat show_queue (FILE *st, DEVICE *dnotused, UNIT *unotused, int32 flag, CONST char *cptr)
 {
 DEVICE *dptr;
 UNIT *uptr;
-int32 accum;
+UNIT **units;
+int32 *times;
+int32 i, count;
 MEMFILE buf;
 
 memset (&buf, 0, sizeof (buf));
-if (cptr && (*cptr != 0))
-    return SCPE_2MARG;
+if (cptr && (*cptr != 0)) {
+    char gbuf[CBUFSIZE];
+
+    cptr = get_glyph (cptr, gbuf, 0);
+    if ((*cptr != 0) || (MATCH_CMD (gbuf, "STATISTICS") != 0))
+        return SCPE_2MARG;
+    return show_queue_statistics (st, dnotused, unotused, flag, cptr);
+    }
 if (sim_clock_queue == QUEUE_LIST_END)
     fprintf (st, "%s event queue empty, time = %.0f, executing %s instructios/sec\n",
              sim_name, sim_time, sim_fmt_numeric (sim_timer_inst_per_sec ()));
@@ -6030,8 +6331,9 @@ else {
 
     fprintf (st, "%s event queue status, time = %.0f, executing %s instructions/sec\n",
              sim_name, sim_time, sim_fmt_numeric (inst_per_sec));
-    accum = 0;
-    for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next) {
+    count = sim_queue_engines[sim_queue_engine].entries (&units, &times);
+    for (i = 0; i < count; i++) {
+        uptr = units[i];
         if (uptr == &sim_step_unit)
             fprintf (st, "  Step timer");
         else
@@ -6046,36 +6348,45 @@ else {
                 else
                     fprintf (st, "  Unknown");
         if (inst_per_sec != 0.0)
-            tim = sim_fmt_secs(((accum + uptr->time) / sim_timer_inst_per_sec ()) + (uptr->usecs_remaining / 1000000.0));
+            tim = sim_fmt_secs((times[i] / sim_timer_inst_per_sec ()) + (uptr->usecs_remaining / 1000000.0));
         if (uptr->usecs_remaining)
-            fprintf (st, " at %d plus %.0f usecs%s%s%s%s\n", accum + uptr->time, uptr->usecs_remaining,
+            fprintf (st, " at %d plus %.0f usecs%s%s%s%s\n", times[i], uptr->usecs_remaining,
                                             (*tim) ? " (" : "", tim, (*tim) ? " total)" : "",
                                             (uptr->flags & UNIT_IDLE) ? " (Idle capable)" : "");
         else
-            fprintf (st, " at %d%s%s%s%s\n", accum + uptr->time, 
+            fprintf (st, " at %d%s%s%s%s\n", times[i], 
                                             (*tim) ? " (" : "", tim, (*tim) ? ")" : "",
                                             (uptr->flags & UNIT_IDLE) ? " (Idle capable)" : "");
-        accum = accum + uptr->time;
         }
+    free (units);
+    free (times);
     }
 sim_show_clock_queues (st, dnotused, unotused, flag, cptr);
 #if defined (SIM_ASYNCH_IO)
 pthread_mutex_lock (&sim_asynch_lock);
 sim_mfile = &buf;
 fprintf (st, "asynchronous pending event queue\n");
-if (sim_asynch_queue == QUEUE_LIST_END)
-    fprintf (st, "  Empty\n");
-else {
-    for (uptr = sim_asynch_queue; uptr != QUEUE_LIST_END; uptr = uptr->a_next) {
-        if ((dptr = find_dev_from_unit (uptr)) != NULL) {
-            fprintf (st, "  %s", sim_dname (dptr));
-            if (dptr->numunits > 1) fprintf (st, " unit %d",
-                (int32) (uptr - dptr->units));
-            }
-        else fprintf (st, "  Unknown");
-        fprintf (st, " event delay %d\n", uptr->a_event_time);
+count = 0;
+#if defined (USE_AIO_INTRINSICS)
+if (1) {                                        /* activations in the ring, oldest first */
+    size_t slot, tail = (size_t)sim_asynch_ring_tail;
+
+    for (slot = sim_asynch_ring_head; slot != tail; slot++) {
+        uptr = sim_asynch_ring[slot & (AIO_RING_SIZE - 1)];
+        if (uptr == NULL)                       /* reserved but not published yet */
+            continue;
+        _sim_show_aio_event (st, uptr, "");
+        ++count;
         }
     }
+for (uptr = sim_asynch_queue; uptr != QUEUE_LIST_END; uptr = uptr->a_next, ++count)
+    _sim_show_aio_event (st, uptr, " (ring overflow)");
+#else
+for (uptr = sim_asynch_queue; uptr != QUEUE_LIST_END; uptr = uptr->a_next, ++count)
+    _sim_show_aio_event (st, uptr, "");
+#endif
+if (count == 0)
+    fprintf (st, "  Empty\n");
 fprintf (st, "asynch latency: %d nanoseconds\n", sim_asynch_latency);
 fprintf (st, "asynch instruction latency: %d instructions\n", sim_asynch_inst_latency);
 pthread_mutex_unlock (&sim_asynch_lock);
@@ -6086,6 +6397,33 @@ free (buf.buf);
 return SCPE_OK;
 }
 
+t_stat show_queue_statistics (FILE *st, DEVICE *dnotused, UNIT *unotused, int32 flag, CONST char *cptr)
+{
+int32 i;
+
+fprintf (st, "%s event queue engine: %s - %s, %d entr%s pending\n", sim_name, 
+             sim_queue_engines[sim_queue_engine].name, sim_queue_engines[sim_queue_engine].desc, 
+             sim_queue_depth, (sim_queue_depth == 1) ? "y" : "ies");
+for (i = 0; i < QUEUE_ENGINE_COUNT; i++) {
+    QUEUE_STATS *qs = &sim_queue_stats[i];
+
+    if ((i != sim_queue_engine) && (qs->inserts == 0) && (qs->dispatches == 0))
+        continue;
+    fprintf (st, "  %s engine:\n", sim_queue_engines[i].name);
+    fprintf (st, "    Activations:      %s", sim_fmt_numeric ((double)qs->inserts));
+    if (qs->inserts)
+        fprintf (st, " (%.2f entries visited per activation)", (double)qs->insert_steps / qs->inserts);
+    fprintf (st, "\n    Cancels:          %s", sim_fmt_numeric ((double)qs->cancels));
+    if (qs->cancels)
+        fprintf (st, " (%.2f entries visited per cancel)", (double)qs->cancel_steps / qs->cancels);
+    fprintf (st, "\n    Dispatches:       %s", sim_fmt_numeric ((double)qs->dispatches));
+    if (qs->dispatches)
+        fprintf (st, " (%.2f entries visited per dispatch)", (double)qs->dispatch_steps / qs->dispatches);
+    fprintf (st, "\n    Peak depth:       %d\n", qs->max_depth);
+    }
+return SCPE_OK;
+}
+
 t_stat show_time (FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, CONST char *cptr)
 {
 if (cptr && (*cptr != 0))
@@ -7249,6 +7587,406 @@ return uptr->uname = strcpy ((char *)malloc (1 + strlen (uname)), uname);
 }
 
 
+/* Memory image snapshots
+
+   SAVE -B writes the contents of the memory units which the simulator
+   exposes through sim_vm_mem_image as raw host memory pages at the end of
+   the save file, rather than one examined value at a time, and RESTORE
+   reads them back directly into memory.  Pages which are all zero are
+   left out.  SAVE -I also leaves out the pages which are unchanged since
+   the last snapshot which was saved or restored, and names that snapshot
+   as its base.  Only a hash of each page is kept between snapshots.  A
+   page whose hash is unchanged is read back from the base snapshot and
+   compared byte for byte, so a page is only left out when it is exactly
+   as the base has it.  The base is named by its absolute path.
+
+   The memory image section starts on a page boundary:
+
+        base snapshot file name (empty line if none)
+        for each memory image:
+            unit name
+            t_uint64        memory size in bytes
+            uint8[pages]    page types (SIM_SNAP_ZERO, _DATA or _BASE)
+            padding to a page boundary
+            the SIM_SNAP_DATA pages in order
+        empty line
+
+   and the file ends with a trailer locating it:
+
+        t_uint64        file offset of the memory image section
+        uint32          SIM_SNAP_BYTE_ORDER
+        uint32          SIM_SNAP_MAGIC
+
+   Values are in host byte order, so a snapshot can only be restored on a
+   host with the same byte order.
+*/
+
+#define SIM_SNAP_PAGE           4096
+#define SIM_SNAP_ZERO           0                       /* page is all zeroes */
+#define SIM_SNAP_DATA           1                       /* page is in this file */
+#define SIM_SNAP_BASE           2                       /* page is as in the base snapshot */
+#define SIM_SNAP_MAGIC          0x50414E53              /* "SNAP" */
+#define SIM_SNAP_BYTE_ORDER     0x01020304
+#define SIM_SNAP_MAX_DEPTH      64                      /* longest chain of base snapshots */
+
+typedef struct SIM_SNAP_HASHES {
+    char                *uname;                         /* memory unit name */
+    size_t              size;                           /* memory size when hashed */
+    t_uint64            *hash;                          /* page content hashes */
+    } SIM_SNAP_HASHES;
+
+/* Reads the pages of a unit's memory image as a snapshot has them,
+   following its chain of base snapshots.  Pages are read in ascending
+   order. */
+
+typedef struct SIM_SNAP_READER {
+    FILE                *file;
+    char                base[CBUFSIZE];                 /* its base snapshot */
+    uint8               *map;                           /* page types */
+    size_t              pages;
+    size_t              page;                           /* page at data */
+    t_offset            data;                           /* file offset of data pages from page */
+    int32               depth;                          /* bases followed to get here */
+    t_bool              no_base;                        /* base can't be read */
+    struct SIM_SNAP_READER *base_reader;                /* opened when first needed */
+    } SIM_SNAP_READER;
+
+static SIM_SNAP_HASHES *sim_snap_hashes = NULL;         /* page hashes as of the last snapshot */
+static int32 sim_snap_hash_count = 0;
+static char *sim_snap_last = NULL;                      /* last snapshot saved or restored */
+static const char *sim_snap_base = NULL;                /* base of the snapshot being saved */
+static t_bool sim_snap_restored = FALSE;                /* last restore was of a snapshot */
+static const uint8 sim_snap_zero_page[SIM_SNAP_PAGE] = {0};
+
+/* Hash a page of memory one 64 bit word at a time */
+
+static t_uint64 sim_snap_page_hash (const uint8 *page, size_t len)
+{
+const t_uint64 prime1 = (((t_uint64)0x9E3779B1) << 32) | 0x85EBCA87;
+const t_uint64 prime2 = (((t_uint64)0xC2B2AE3D) << 32) | 0x27D4EB4F;
+t_uint64 h = prime1 + len;
+t_uint64 w;
+size_t i;
+
+for (i = 0; i + sizeof (w) <= len; i += sizeof (w)) {
+    memcpy (&w, page + i, sizeof (w));
+    h += w * prime2;
+    h = ((h << 31) | (h >> 33)) * prime1;
+    }
+for (; i < len; i++) {
+    h += page[i] * prime2;
+    h = ((h << 31) | (h >> 33)) * prime1;
+    }
+return h;
+}
+
+static SIM_SNAP_HASHES *sim_snap_find_hashes (const char *uname)
+{
+int32 i;
+
+for (i = 0; i < sim_snap_hash_count; i++)
+    if (0 == strcmp (sim_snap_hashes[i].uname, uname))
+        return &sim_snap_hashes[i];
+sim_snap_hashes = (SIM_SNAP_HASHES *)realloc (sim_snap_hashes, (sim_snap_hash_count + 1) * sizeof (*sim_snap_hashes));
+memset (&sim_snap_hashes[sim_snap_hash_count], 0, sizeof (*sim_snap_hashes));
+sim_snap_hashes[sim_snap_hash_count].uname = (char *)malloc (1 + strlen (uname));
+strcpy (sim_snap_hashes[sim_snap_hash_count].uname, uname);
+return &sim_snap_hashes[sim_snap_hash_count++];
+}
+
+/* Remember the absolute file name and the page hashes of the memory of
+   the last snapshot.  The hashes are already known when the snapshot was
+   saved. */
+
+static void sim_snap_remember (const char *fname, t_bool rehash)
+{
+uint32 i, j;
+DEVICE *dptr;
+UNIT *uptr;
+
+free (sim_snap_last);
+sim_snap_last = sim_filepath_parts (fname, "f");        /* still found after a CD */
+if (sim_snap_last == NULL)
+    sim_snap_last = strcpy ((char *)malloc (1 + strlen (fname)), fname);
+for (i = 0; rehash && (sim_vm_mem_image != NULL) && ((dptr = sim_devices[i]) != NULL); i++) {
+    for (j = 0; j < dptr->numunits; j++) {
+        SIM_SNAP_HASHES *sh;
+        size_t size, pages, p;
+        uint8 *mem;
+
+        uptr = dptr->units + j;
+        if ((mem = (uint8 *)sim_vm_mem_image (uptr, &size)) == NULL)
+            continue;
+        sh = sim_snap_find_hashes (sim_uname (uptr));
+        pages = (size + SIM_SNAP_PAGE - 1) / SIM_SNAP_PAGE;
+        free (sh->hash);
+        sh->hash = (t_uint64 *)malloc ((pages ? pages : 1) * sizeof (*sh->hash));
+        sh->size = sh->hash ? size : 0;
+        for (p = 0; (sh->hash != NULL) && (p < pages); p++)
+            sh->hash[p] = sim_snap_page_hash (mem + p * SIM_SNAP_PAGE, MIN (SIM_SNAP_PAGE, size - p * SIM_SNAP_PAGE));
+        }
+    }
+}
+
+/* Pad a snapshot file being written to a page boundary */
+
+static t_offset sim_snap_align (FILE *sfile)
+{
+t_offset pos = sim_ftell (sfile);
+
+if (pos % SIM_SNAP_PAGE) {
+    fwrite (sim_snap_zero_page, 1, (size_t)(SIM_SNAP_PAGE - (pos % SIM_SNAP_PAGE)), sfile);
+    pos += SIM_SNAP_PAGE - (pos % SIM_SNAP_PAGE);
+    }
+return pos;
+}
+
+/* Find a unit's memory image in a snapshot.  Returns the snapshot's base
+   and the image's size and page types (in a map the caller frees), with
+   the file positioned at the image's first data page. */
+
+static t_stat sim_snap_find_image (FILE *rfile, const char *fname, UNIT *uptr, char *base, size_t base_size, uint8 **pmap, size_t *ppages, t_uint64 *psize64)
+{
+char name[CBUFSIZE];
+t_uint64 image_offset, size64 = 0;
+uint32 trailer[2];
+uint8 *map = NULL;
+size_t pages = 0, p;
+t_offset skip;
+t_stat r = SCPE_OK;
+
+*pmap = NULL;
+if ((sim_fseeko (rfile, -(t_offset)(sizeof (image_offset) + sizeof (trailer)), SEEK_END)) ||
+    (fread (&image_offset, sizeof (image_offset), 1, rfile) != 1) ||
+    (fread (trailer, sizeof (trailer), 1, rfile) != 1) ||
+    (trailer[1] != SIM_SNAP_MAGIC))
+    return sim_messagef (SCPE_INCOMP, "%s: no memory image section\n", fname);
+if (trailer[0] != SIM_SNAP_BYTE_ORDER)
+    return sim_messagef (SCPE_INCOMP, "%s: memory images were saved on a host with a different byte order\n", fname);
+if ((sim_fseeko (rfile, (t_offset)image_offset, SEEK_SET)) ||
+    (read_line (base, (int32)base_size, rfile) == NULL))
+    return SCPE_IOERR;
+for ( ;; ) {                                            /* find the unit's image */
+    if ((read_line (name, sizeof (name), rfile) == NULL) ||
+        (name[0] == '\0')) {
+        free (map);
+        return sim_messagef (SCPE_INCOMP, "%s: no memory image for %s\n", fname, sim_uname (uptr));
+        }
+    if (fread (&size64, sizeof (size64), 1, rfile) != 1) {
+        r = SCPE_IOERR;
+        break;
+        }
+    pages = (size_t)((size64 + SIM_SNAP_PAGE - 1) / SIM_SNAP_PAGE);
+    free (map);
+    map = (uint8 *)malloc (pages ? pages : 1);
+    if ((map == NULL) ||
+        (fread (map, 1, pages, rfile) != pages) ||
+        (sim_fseeko (rfile, ((sim_ftell (rfile) + SIM_SNAP_PAGE - 1) / SIM_SNAP_PAGE) * SIM_SNAP_PAGE, SEEK_SET))) {
+        r = SCPE_IOERR;
+        break;
+        }
+    if (0 == strcmp (name, sim_uname (uptr)))
+        break;
+    for (p = 0, skip = 0; p < pages; p++)               /* skip another unit's data pages */
+        if (map[p] == SIM_SNAP_DATA)
+            skip += (t_offset)MIN ((t_uint64)SIM_SNAP_PAGE, size64 - p * SIM_SNAP_PAGE);
+    if (sim_fseeko (rfile, skip, SEEK_CUR)) {
+        r = SCPE_IOERR;
+        break;
+        }
+    }
+if (r != SCPE_OK) {
+    free (map);
+    return r;
+    }
+*pmap = map;
+*ppages = pages;
+*psize64 = size64;
+return SCPE_OK;
+}
+
+static void sim_snap_close_reader (SIM_SNAP_READER *rd)
+{
+while (rd != NULL) {
+    SIM_SNAP_READER *base_reader = rd->base_reader;
+
+    if (rd->file != NULL)
+        fclose (rd->file);
+    free (rd->map);
+    free (rd);
+    rd = base_reader;
+    }
+}
+
+static SIM_SNAP_READER *sim_snap_open_reader (const char *fname, UNIT *uptr, size_t size, int32 depth)
+{
+SIM_SNAP_READER *rd;
+t_uint64 size64;
+
+if ((depth >= SIM_SNAP_MAX_DEPTH) || (fname[0] == '\0') ||
+    (NULL == (rd = (SIM_SNAP_READER *)calloc (1, sizeof (*rd)))))
+    return NULL;
+rd->depth = depth;
+if ((NULL == (rd->file = sim_fopen (fname, "rb"))) ||
+    (SCPE_OK != sim_snap_find_image (rd->file, fname, uptr, rd->base, sizeof (rd->base), &rd->map, &rd->pages, &size64)) ||
+    (size64 != (t_uint64)size)) {
+    sim_snap_close_reader (rd);
+    return NULL;
+    }
+rd->data = sim_ftell (rd->file);
+return rd;
+}
+
+/* Read len bytes of page p as the snapshot has them.  Returns FALSE if
+   they can't be read. */
+
+static t_bool sim_snap_read_page (SIM_SNAP_READER *rd, UNIT *uptr, size_t size, size_t p, uint8 *buf, size_t len)
+{
+if ((p >= rd->pages) || (p < rd->page))
+    return FALSE;
+for (; rd->page < p; rd->page++)                        /* skip to the page's data */
+    if (rd->map[rd->page] == SIM_SNAP_DATA)
+        rd->data += SIM_SNAP_PAGE;
+switch (rd->map[p]) {
+    case SIM_SNAP_ZERO:
+        memset (buf, 0, len);
+        return TRUE;
+    case SIM_SNAP_DATA:
+        return ((0 == sim_fseeko (rd->file, rd->data, SEEK_SET)) &&
+                (len == fread (buf, 1, len, rd->file)));
+    case SIM_SNAP_BASE:
+        if ((rd->base_reader == NULL) && !rd->no_base) {
+            rd->base_reader = sim_snap_open_reader (rd->base, uptr, size, rd->depth + 1);
+            rd->no_base = (rd->base_reader == NULL);
+            }
+        return (rd->base_reader != NULL) &&
+               sim_snap_read_page (rd->base_reader, uptr, size, p, buf, len);
+    default:
+        break;
+    }
+return FALSE;
+}
+
+/* Write the memory image section of a snapshot */
+
+static t_stat sim_snap_save (FILE *sfile, UNIT **units, int32 count)
+{
+t_uint64 image_offset = (t_uint64)sim_snap_align (sfile);
+uint32 trailer[2] = {SIM_SNAP_BYTE_ORDER, SIM_SNAP_MAGIC};
+int32 i;
+
+fprintf (sfile, "%s\n", sim_snap_base ? sim_snap_base : "");
+for (i = 0; i < count; i++) {
+    SIM_SNAP_HASHES *sh = sim_snap_find_hashes (sim_uname (units[i]));
+    SIM_SNAP_READER *rd = NULL;
+    t_bool incremental = (sim_snap_base != NULL);
+    size_t size, pages, p, run, len;
+    t_uint64 size64, *hash;
+    uint8 *mem, *map, *bpage;
+
+    mem = (uint8 *)sim_vm_mem_image (units[i], &size);
+    size64 = size;
+    pages = (size + SIM_SNAP_PAGE - 1) / SIM_SNAP_PAGE;
+    hash = (t_uint64 *)malloc ((pages ? pages : 1) * sizeof (*hash));
+    map = (uint8 *)malloc (pages ? pages : 1);
+    bpage = (uint8 *)malloc (SIM_SNAP_PAGE);
+    if ((hash == NULL) || (map == NULL) || (bpage == NULL)) {
+        free (hash);
+        free (map);
+        free (bpage);
+        return SCPE_MEM;
+        }
+    if ((sh->hash == NULL) || (sh->size != size))       /* base memory was a different size? */
+        incremental = FALSE;
+    for (p = 0; p < pages; p++) {
+        uint8 *page = mem + p * SIM_SNAP_PAGE;
+
+        len = MIN (SIM_SNAP_PAGE, size - p * SIM_SNAP_PAGE);
+        hash[p] = sim_snap_page_hash (page, len);
+        if (0 == memcmp (page, sim_snap_zero_page, len))
+            map[p] = SIM_SNAP_ZERO;
+        else {
+            map[p] = SIM_SNAP_DATA;
+            if (incremental && (sh->hash[p] == hash[p])) {  /* unchanged unless the hashes collide */
+                if (rd == NULL)
+                    incremental = (NULL != (rd = sim_snap_open_reader (sim_snap_base, units[i], size, 0)));
+                if (incremental &&                      /* so check the base's copy */
+                    sim_snap_read_page (rd, units[i], size, p, bpage, len) &&
+                    (0 == memcmp (page, bpage, len)))
+                    map[p] = SIM_SNAP_BASE;
+                }
+            }
+        }
+    sim_snap_close_reader (rd);
+    free (bpage);
+    fprintf (sfile, "%s\n", sim_uname (units[i]));
+    fwrite (&size64, sizeof (size64), 1, sfile);
+    fwrite (map, 1, pages, sfile);
+    sim_snap_align (sfile);
+    for (p = 0; p < pages; p = run) {                   /* write runs of data pages */
+        for (run = p; (run < pages) && (map[run] == SIM_SNAP_DATA); run++)
+            ;
+        if (run == p)
+            ++run;
+        else
+            fwrite (mem + p * SIM_SNAP_PAGE, 1, MIN (run * SIM_SNAP_PAGE, size) - p * SIM_SNAP_PAGE, sfile);
+        }
+    free (map);
+    free (sh->hash);                                    /* these are now the base hashes */
+    sh->hash = hash;
+    sh->size = size;
+    }
+fputc ('\n', sfile);                                    /* end memory images */
+fwrite (&image_offset, sizeof (image_offset), 1, sfile);
+fwrite (trailer, sizeof (trailer), 1, sfile);
+return (ferror (sfile))? SCPE_IOERR: SCPE_OK;
+}
+
+/* Load a unit's memory image from a snapshot, starting with its base
+   snapshot when the image refers to it */
+
+static t_stat sim_snap_load (FILE *rfile, const char *fname, UNIT *uptr, uint8 *mem, size_t size, int32 depth)
+{
+char base[CBUFSIZE];
+t_uint64 size64;
+uint8 *map = NULL;
+size_t pages = 0, p, run, start, end;
+t_stat r;
+
+r = sim_snap_find_image (rfile, fname, uptr, base, sizeof (base), &map, &pages, &size64);
+if ((r == SCPE_OK) && (size64 != (t_uint64)size))
+    r = sim_messagef (SCPE_INCOMP, "%s: memory image of %s is %.0f bytes, memory is %.0f bytes\n", fname, sim_uname (uptr), (double)size64, (double)size);
+if ((r == SCPE_OK) && (pages > 0) && memchr (map, SIM_SNAP_BASE, pages)) {
+    FILE *bfile;
+
+    if ((depth >= SIM_SNAP_MAX_DEPTH) || (base[0] == '\0'))
+        r = sim_messagef (SCPE_INCOMP, "%s: invalid base snapshot reference\n", fname);
+    else {
+        if ((bfile = sim_fopen (base, "rb")) == NULL)
+            r = sim_messagef (SCPE_OPENERR, "%s: can't open base snapshot %s\n", fname, base);
+        else {
+            r = sim_snap_load (bfile, base, uptr, mem, size, depth + 1);
+            fclose (bfile);
+            }
+        }
+    }
+for (p = 0; (r == SCPE_OK) && (p < pages); p = run) {   /* then this snapshot's pages */
+    for (run = p + 1; (run < pages) && (map[run] == map[p]); run++)
+        ;
+    start = p * SIM_SNAP_PAGE;
+    end = MIN (run * SIM_SNAP_PAGE, size);
+    if (map[p] == SIM_SNAP_ZERO)
+        memset (mem + start, 0, end - start);
+    else {
+        if ((map[p] == SIM_SNAP_DATA) &&
+            (fread (mem + start, 1, end - start, rfile) != end - start))
+            r = SCPE_IOERR;
+        }
+    }
+free (map);
+return r;
+}
+
 /* Save command
 
    sa[ve] filename              save state to specified file
@@ -7266,10 +8004,30 @@ if (*cptr == 0)                                         /* must be more */
 gbuf[sizeof(gbuf)-1] = '\0';
 strlcpy (gbuf, cptr, sizeof(gbuf));
 sim_trim_endspc (gbuf);
+sim_snap_base = NULL;
+if (sim_switches & SWMASK ('I')) {                      /* incremental snapshot? */
+    char *fullname;
+
+    if (sim_snap_last == NULL)
+        return sim_messagef (SCPE_ARG, "No previous snapshot for an incremental snapshot to refer to\n");
+    fullname = sim_filepath_parts (gbuf, "f");
+    if ((fullname == NULL) ||
+        (strcmp (fullname, sim_snap_last) != 0))        /* not replacing its base? */
+        sim_snap_base = sim_snap_last;
+    free (fullname);
+    }
 if ((sfile = sim_fopen (gbuf, "wb")) == NULL)
     return SCPE_OPENERR;
 r = sim_save (sfile);
 fclose (sfile);
+if (sim_switches & (SWMASK ('B') | SWMASK ('I'))) {
+    if (r == SCPE_OK)
+        sim_snap_remember (gbuf, FALSE);                /* the next incremental's base */
+    else {
+        free (sim_snap_last);                           /* page hashes may not match any file */
+        sim_snap_last = NULL;
+        }
+    }
 return r;
 }
 
@@ -7286,13 +8044,16 @@ size_t sz;
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
+t_bool snapshot = ((sim_switches & (SWMASK ('B') | SWMASK ('I'))) != 0);
+UNIT **snapunits = NULL;
+int32 snapcnt = 0;
 
 #define WRITE_I(xx) sim_fwrite (&(xx), sizeof (xx), 1, sfile)
 
 /* Don't make changes below without also changing save_vercur above */
 
 fprintf (sfile, "%s\n%s\n%s\n%s\n%s\n%.0f\n",
-    save_vercur,                                        /* [V2.5] save format */
+    snapshot ? save_ver41 : save_vercur,                /* [V2.5] save format */
     sim_savename,                                       /* sim name */
     sim_si64, sim_sa64, eth_capabilities(),             /* [V3.5] options */
     sim_time);                                          /* [V3.2] sim time */
@@ -7356,33 +8117,42 @@ for (i = 0; i < (device_count + sim_internal_device_count); i++) {/* loop thru d
              (dptr->examine != NULL) &&
              ((high = uptr->capac) != 0)) {             /* memory-like unit? */
             WRITE_I (high);                             /* [V2.5] write size */
-            sz = SZ_D (dptr);
-            if ((mbuf = calloc (SRBSIZ, sz)) == NULL) {
-                fclose (sfile);
-                return SCPE_MEM;
+            if (snapshot && (sim_vm_mem_image != NULL) &&
+                (sim_vm_mem_image (uptr, &sz) != NULL)) {
+                l = 0;                                  /* [V4.1] contents are in the */
+                WRITE_I (l);                            /* memory image section */
+                snapunits = (UNIT **)realloc (snapunits, sizeof (*snapunits)*(snapcnt+1));
+                snapunits[snapcnt++] = uptr;
                 }
-            for (k = 0; k < high; ) {                   /* loop thru mem */
-                zeroflg = TRUE;
-                for (l = 0; (l < SRBSIZ) && (k < high); l++,
-                     k = k + (dptr->aincr)) {           /* check for 0 block */
-                    r = dptr->examine (&val, k, uptr, SIM_SW_REST);
-                    if (r != SCPE_OK) {
-                        free (mbuf);
-                        return r;
-                        }
-                    if (val) zeroflg = FALSE;
-                    SZ_STORE (sz, val, mbuf, l);
-                    }                                   /* end for l */
-                if (zeroflg) {                          /* all zero's? */
-                    l = -l;                             /* invert block count */
-                    WRITE_I (l);                        /* write only count */
-                    }
-                else {
-                    WRITE_I (l);                        /* block count */
-                    sim_fwrite (mbuf, sz, l, sfile);
+            else {
+                sz = SZ_D (dptr);
+                if ((mbuf = calloc (SRBSIZ, sz)) == NULL) {
+                    fclose (sfile);
+                    return SCPE_MEM;
                     }
-                }                                       /* end for k */
-            free (mbuf);                                /* dealloc buffer */
+                for (k = 0; k < high; ) {               /* loop thru mem */
+                    zeroflg = TRUE;
+                    for (l = 0; (l < SRBSIZ) && (k < high); l++,
+                         k = k + (dptr->aincr)) {       /* check for 0 block */
+                        r = dptr->examine (&val, k, uptr, SIM_SW_REST);
+                        if (r != SCPE_OK) {
+                            free (mbuf);
+                            return r;
+                            }
+                        if (val) zeroflg = FALSE;
+                        SZ_STORE (sz, val, mbuf, l);
+                        }                               /* end for l */
+                    if (zeroflg) {                      /* all zero's? */
+                        l = -l;                         /* invert block count */
+                        WRITE_I (l);                    /* write only count */
+                        }
+                    else {
+                        WRITE_I (l);                    /* block count */
+                        sim_fwrite (mbuf, sz, l, sfile);
+                        }
+                    }                                   /* end for k */
+                free (mbuf);                            /* dealloc buffer */
+                }
             }                                           /* end if mem */
         else {                                          /* no memory */
             high = 0;                                   /* write 0 */
@@ -7404,6 +8174,12 @@ for (i = 0; i < (device_count + sim_internal_device_count); i++) {/* loop thru d
     fputc ('\n', sfile);                                /* end registers */
     }
 fputc ('\n', sfile);                                    /* end devices */
+r = SCPE_OK;
+if (snapshot)                                           /* [V4.1] memory images */
+    r = sim_snap_save (sfile, snapunits, snapcnt);
+free (snapunits);
+if (r != SCPE_OK)
+    return r;
 return (ferror (sfile))? SCPE_IOERR: SCPE_OK;           /* error during save? */
 }
 
@@ -7426,8 +8202,11 @@ strlcpy (gbuf, cptr, sizeof(gbuf));
 sim_trim_endspc (gbuf);
 if ((rfile = sim_fopen (gbuf, "rb")) == NULL)
     return SCPE_OPENERR;
+sim_snap_restored = FALSE;
 r = sim_rest (rfile);
 fclose (rfile);
+if ((r == SCPE_OK) && sim_snap_restored)
+    sim_snap_remember (gbuf, TRUE);                     /* the next incremental's base */
 return r;
 }
 
@@ -7438,6 +8217,8 @@ char **attnames = NULL;
 UNIT **attunits = NULL;
 int32 *attswitches = NULL;
 int32 attcnt = 0;
+UNIT **snapunits = NULL;
+int32 snapcnt = 0;
 void *mbuf;
 int32 j, blkcnt, limit, unitno, time, flg;
 uint32 us, depth;
@@ -7445,7 +8226,8 @@ t_addr k, high, old_capac;
 t_value val, mask;
 t_stat r;
 size_t sz;
-t_bool v40, v35, v32;
+t_bool v41, v40, v35, v32;
+double old_time;
 DEVICE *dptr;
 UNIT *uptr;
 REG *rptr;
@@ -7470,8 +8252,10 @@ if (fstat (fileno (rfile), &rstat)) {
     goto Cleanup_Return;
     }
 READ_S (buf);                                           /* [V2.5+] read version */
-v40 = v35 = v32 = FALSE;
-if (strcmp (buf, save_ver40) == 0)                      /* version 4.0? */
+v41 = v40 = v35 = v32 = FALSE;
+if (strcmp (buf, save_ver41) == 0)                      /* version 4.1? */
+    v41 = v40 = v35 = v32 = TRUE;
+else if (strcmp (buf, save_ver40) == 0)                 /* version 4.0? */
     v40 = v35 = v32 = TRUE;
 else if (strcmp (buf, save_ver35) == 0)                 /* version 3.5? */
     v35 = v32 = TRUE;
@@ -7481,7 +8265,7 @@ else if (strcmp (buf, save_ver30) != 0) {               /* version 3.0? */
     sim_printf ("Invalid file version: %s\n", buf);
     return SCPE_INCOMP;
     }
-if ((strcmp (buf, save_ver40) != 0) && (!sim_quiet) && (!suppress_warning)) {
+if ((!v40) && (!sim_quiet) && (!suppress_warning)) {
     sim_printf ("warning - attempting to restore a saved simulator image in %s image format.\n", buf);
     warned = TRUE;
     }
@@ -7503,11 +8287,13 @@ if (v35) {                                              /* [V3.5+] options */
         }
     READ_S (buf);                                       /* Ethernet */
     }
+old_time = sim_gtime ();
 if (v32) {                                              /* [V3.2+] time as string */
     READ_S (buf);
     sscanf (buf, "%lf", &sim_time);
     }
 else READ_I (sim_time);                                 /* sim time */
+_sim_queue_rebase (sim_time - old_time);                /* keep pending events relative */
 READ_I (sim_rtime);                                     /* [V2.6+] sim rel time */
 if (v40) {
     READ_S (buf);                                       /* read git commit id */
@@ -7665,6 +8451,12 @@ for ( ;; ) {                                            /* device loop */
                     r = SCPE_IOERR;
                     goto Cleanup_Return;
                     }
+                if ((blkcnt == 0) && v41 &&             /* [V4.1] in memory image section? */
+                    (sim_vm_mem_image != NULL)) {
+                    snapunits = (UNIT **)realloc (snapunits, sizeof (*snapunits)*(snapcnt+1));
+                    snapunits[snapcnt++] = uptr;
+                    break;
+                    }
                 if (blkcnt < 0)                         /* compressed? */
                     limit = -blkcnt;
                 else limit = (int32)sim_fread (mbuf, sz, blkcnt, rfile);
@@ -7716,6 +8508,20 @@ for ( ;; ) {                                            /* device loop */
             }
         }                                               /* end register loop */
     }                                                   /* end device loop */
+for (j=0; j<snapcnt; j++) {                             /* [V4.1] load memory images */
+    size_t size;
+    uint8 *mem = (uint8 *)sim_vm_mem_image (snapunits[j], &size);
+
+    if (mem == NULL) {
+        sim_printf ("Can't restore memory: %s\n", sim_uname (snapunits[j]));
+        r = SCPE_INCOMP;
+        goto Cleanup_Return;
+        }
+    r = sim_snap_load (rfile, "Restore file", snapunits[j], mem, size, 0);
+    if (r != SCPE_OK)
+        goto Cleanup_Return;
+    }
+sim_snap_restored = v41;
 /* Now that all of the register state has been imported, we can attach 
    units which were originally attached.  Some of these attach operations 
    may depend on the state of the device (in registers) to work correctly */
@@ -7762,6 +8568,7 @@ for (j=0; j < attcnt; j++)
 free (attnames);
 free (attunits);
 free (attswitches);
+free (snapunits);
 if (warned)
     sim_printf ("restore with the -Q switch to suppress warning messages\n");
 return r;
@@ -10736,10 +11543,371 @@ return buf;
    and to see if further events need to be processed, or sim_interval
    reset to count the next one.
 
-   The event queue is maintained in clock order; entry timeouts are
-   RELATIVE to the time in the previous entry.
+   The event queue is maintained in clock order by one of the queue 
+   engines below, selected with SET QUEUE ENGINE=name:
 
-   sim_process_event - process event
+        LIST    entries are kept on a linked list through the unit next
+                field and entry timeouts are RELATIVE to the time in the
+                previous entry.  Insertion and cancellation walk the list.
+        HEAP    entries are kept in a binary heap ordered by their
+                ABSOLUTE due time (sim_gtime based) with ties resolved in
+                activation order.  Insertion and cancellation are O(log n).
+                The unit next field of a queued entry is QUEUE_LIST_END.
+
+   With either engine sim_clock_queue is the first entry to be processed
+   and sim_clock_queue->time is the time remaining until it is due as of
+   the last UPDATE_SIM_TIME, so code outside of the engine may examine the
+   head of the queue but must not walk it.
+
+   SHOW QUEUE STATISTICS reports the activity and the number of entries
+   visited for each engine so that the engines can be compared.
+*/
+
+static void _sim_queue_depth_adjust (int32 change)
+{
+sim_queue_depth += change;
+if (sim_queue_depth > sim_queue_stats[sim_queue_engine].max_depth)
+    sim_queue_stats[sim_queue_engine].max_depth = sim_queue_depth;
+}
+
+/* List engine */
+
+static void _sim_queue_list_insert (UNIT *uptr, int32 event_time)
+{
+UNIT *cptr, *prvptr;
+int32 accum;
+t_uint64 steps = 0;
+
+prvptr = NULL;
+accum = 0;
+for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+    ++steps;
+    if (event_time < (accum + cptr->time))
+        break;
+    accum = accum + cptr->time;
+    prvptr = cptr;
+    }
+if (prvptr == NULL) {                                   /* insert at head */
+    cptr = uptr->next = sim_clock_queue;
+    sim_clock_queue = uptr;
+    }
+else {
+    cptr = uptr->next = prvptr->next;                   /* insert at prvptr */
+    prvptr->next = uptr;
+    }
+uptr->time = event_time - accum;
+if (cptr != QUEUE_LIST_END)
+    cptr->time = cptr->time - uptr->time;
+_sim_queue_depth_adjust (1);
+sim_queue_stats[sim_queue_engine].insert_steps += steps;
+}
+
+static t_bool _sim_queue_list_remove (UNIT *uptr)
+{
+UNIT *cptr, *nptr;
+t_uint64 steps = 1;
+
+nptr = QUEUE_LIST_END;
+if (sim_clock_queue == uptr) {
+    nptr = sim_clock_queue = uptr->next;
+    uptr->next = NULL;                                  /* hygiene */
+    }
+else {
+    for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+        ++steps;
+        if (cptr->next == uptr) {
+            nptr = cptr->next = uptr->next;
+            uptr->next = NULL;                          /* hygiene */
+            break;                                      /* end queue scan */
+            }
+        }
+    }
+sim_queue_stats[sim_queue_engine].cancel_steps += steps;
+if (nptr != QUEUE_LIST_END)
+    nptr->time += (uptr->next) ? 0 : uptr->time;
+if (uptr->next)
+    return FALSE;
+uptr->time = 0;
+_sim_queue_depth_adjust (-1);
+return TRUE;
+}
+
+static UNIT *_sim_queue_list_pop (void)
+{
+UNIT *uptr;
+
+uptr = sim_clock_queue;                                 /* get first */
+sim_clock_queue = uptr->next;                           /* remove first */
+uptr->next = NULL;                                      /* hygiene */
+uptr->time = 0;
+if (sim_clock_queue != QUEUE_LIST_END)
+    sim_interval += sim_clock_queue->time;
+else
+    sim_interval = noqueue_time = NOQUEUE_WAIT;
+_sim_queue_depth_adjust (-1);
+sim_queue_stats[sim_queue_engine].dispatch_steps += 1;
+return uptr;
+}
+
+static int32 _sim_queue_list_offset (UNIT *uptr)
+{
+UNIT *cptr;
+int32 accum;
+
+if (sim_clock_queue == uptr)
+    return 0;
+accum = 0;
+for (cptr = sim_clock_queue->next; cptr != QUEUE_LIST_END; cptr = cptr->next) {
+    accum = accum + cptr->time;
+    if (cptr == uptr)
+        return accum;
+    }
+return -1;
+}
+
+static int32 _sim_queue_list_entries (UNIT ***units, int32 **times)
+{
+UNIT *cptr;
+int32 i, accum;
+
+*units = (UNIT **)calloc (sim_queue_depth + 1, sizeof (**units));
+*times = (int32 *)calloc (sim_queue_depth + 1, sizeof (**times));
+accum = 0;
+for (i = 0, cptr = sim_clock_queue; (cptr != QUEUE_LIST_END) && (i < sim_queue_depth); cptr = cptr->next, i++) {
+    accum = accum + cptr->time;
+    (*units)[i] = cptr;
+    (*times)[i] = accum;
+    }
+return i;
+}
+
+/* Heap engine */
+
+static t_bool _sim_queue_heap_before (UNIT *a, UNIT *b)
+{
+if (a->event_due != b->event_due)
+    return (a->event_due < b->event_due);
+return (a->event_seq < b->event_seq);
+}
+
+static void _sim_queue_heap_store (int32 slot, UNIT *uptr)
+{
+sim_queue_heap[slot] = uptr;
+uptr->event_slot = slot;
+}
+
+static int32 _sim_queue_heap_sift_up (int32 slot)
+{
+UNIT *uptr = sim_queue_heap[slot];
+int32 steps = 0;
+
+while (slot > 0) {
+    int32 parent = (slot - 1) / 2;
+
+    if (!_sim_queue_heap_before (uptr, sim_queue_heap[parent]))
+        break;
+    _sim_queue_heap_store (slot, sim_queue_heap[parent]);
+    slot = parent;
+    ++steps;
+    }
+_sim_queue_heap_store (slot, uptr);
+return steps;
+}
+
+static int32 _sim_queue_heap_sift_down (int32 slot)
+{
+UNIT *uptr = sim_queue_heap[slot];
+int32 steps = 0;
+
+while (1) {
+    int32 child = 2 * slot + 1;
+
+    if (child >= sim_queue_depth)
+        break;
+    if ((child + 1 < sim_queue_depth) &&
+        _sim_queue_heap_before (sim_queue_heap[child + 1], sim_queue_heap[child]))
+        ++child;
+    if (!_sim_queue_heap_before (sim_queue_heap[child], uptr))
+        break;
+    _sim_queue_heap_store (slot, sim_queue_heap[child]);
+    slot = child;
+    ++steps;
+    }
+_sim_queue_heap_store (slot, uptr);
+return steps;
+}
+
+/* Make the heap's first entry the queue head and set its remaining time */
+
+static void _sim_queue_heap_head (void)
+{
+double remaining;
+
+if (sim_queue_depth == 0) {
+    sim_clock_queue = QUEUE_LIST_END;
+    return;
+    }
+sim_clock_queue = sim_queue_heap[0];
+remaining = sim_clock_queue->event_due - sim_time;
+if (remaining > (double)INT_MAX)
+    remaining = (double)INT_MAX;
+if (remaining < (double)INT_MIN)
+    remaining = (double)INT_MIN;
+sim_clock_queue->time = (int32)remaining;
+}
+
+static t_bool _sim_queue_heap_contains (UNIT *uptr)
+{
+return ((uptr->next != NULL) && 
+        (uptr->event_slot >= 0) && 
+        (uptr->event_slot < sim_queue_depth) && 
+        (sim_queue_heap[uptr->event_slot] == uptr));
+}
+
+/* Remove the entry at slot, returns the number of entries visited */
+
+static int32 _sim_queue_heap_delete (int32 slot)
+{
+UNIT *uptr = sim_queue_heap[slot];
+UNIT *last;
+int32 steps = 1;
+
+_sim_queue_depth_adjust (-1);
+last = sim_queue_heap[sim_queue_depth];
+sim_queue_heap[sim_queue_depth] = NULL;
+if (slot < sim_queue_depth) {
+    _sim_queue_heap_store (slot, last);
+    if ((slot > 0) && _sim_queue_heap_before (last, sim_queue_heap[(slot - 1) / 2]))
+        steps += _sim_queue_heap_sift_up (slot);
+    else
+        steps += _sim_queue_heap_sift_down (slot);
+    }
+uptr->next = NULL;                                      /* hygiene */
+uptr->time = 0;
+uptr->event_slot = -1;
+return steps;
+}
+
+static void _sim_queue_heap_insert (UNIT *uptr, int32 event_time)
+{
+if (sim_queue_depth >= sim_queue_heap_size) {
+    int32 new_size = (sim_queue_heap_size == 0) ? 64 : 2 * sim_queue_heap_size;
+    UNIT **new_heap = (UNIT **)realloc (sim_queue_heap, new_size * sizeof (*new_heap));
+
+    if (new_heap == NULL) {
+        sim_printf ("Event queue heap allocation failure for %s\n", sim_uname(uptr));
+        abort ();
+        }
+    sim_queue_heap = new_heap;
+    sim_queue_heap_size = new_size;
+    }
+uptr->event_due = sim_time + event_time;
+uptr->event_seq = sim_queue_seq++;
+uptr->time = event_time;
+uptr->next = QUEUE_LIST_END;                            /* flag as active */
+sim_queue_heap[sim_queue_depth] = uptr;
+_sim_queue_depth_adjust (1);
+sim_queue_stats[sim_queue_engine].insert_steps += 1 + _sim_queue_heap_sift_up (sim_queue_depth - 1);
+_sim_queue_heap_head ();
+}
+
+static t_bool _sim_queue_heap_remove (UNIT *uptr)
+{
+if (!_sim_queue_heap_contains (uptr))
+    return FALSE;
+sim_queue_stats[sim_queue_engine].cancel_steps += _sim_queue_heap_delete (uptr->event_slot);
+_sim_queue_heap_head ();
+return TRUE;
+}
+
+static UNIT *_sim_queue_heap_pop (void)
+{
+UNIT *uptr;
+
+UPDATE_SIM_TIME;                                        /* account for any sim_interval adjustments */
+uptr = sim_clock_queue;
+sim_queue_stats[sim_queue_engine].dispatch_steps += _sim_queue_heap_delete (0);
+_sim_queue_heap_head ();
+if (sim_clock_queue != QUEUE_LIST_END)
+    sim_interval = sim_clock_queue->time;
+else
+    sim_interval = noqueue_time = NOQUEUE_WAIT;
+return uptr;
+}
+
+static int32 _sim_queue_heap_offset (UNIT *uptr)
+{
+if (!_sim_queue_heap_contains (uptr))
+    return -1;
+return (int32)(uptr->event_due - sim_clock_queue->event_due);
+}
+
+static int _sim_queue_heap_compare (const void *pa, const void *pb)
+{
+UNIT *a = *(UNIT * const *)pa;
+UNIT *b = *(UNIT * const *)pb;
+
+return _sim_queue_heap_before (a, b) ? -1 : (_sim_queue_heap_before (b, a) ? 1 : 0);
+}
+
+static int32 _sim_queue_heap_entries (UNIT ***units, int32 **times)
+{
+int32 i;
+
+*units = (UNIT **)calloc (sim_queue_depth + 1, sizeof (**units));
+*times = (int32 *)calloc (sim_queue_depth + 1, sizeof (**times));
+if (sim_queue_depth == 0)
+    return 0;
+memcpy (*units, sim_queue_heap, sim_queue_depth * sizeof (**units));
+qsort (*units, sim_queue_depth, sizeof (**units), _sim_queue_heap_compare);
+for (i = 0; i < sim_queue_depth; i++)
+    (*times)[i] = sim_clock_queue->time + (int32)((*units)[i]->event_due - sim_clock_queue->event_due);
+return sim_queue_depth;
+}
+
+/* Shift absolute due times after sim_time has been explicitly changed */
+
+static void _sim_queue_rebase (double delta)
+{
+int32 i;
+
+if (sim_queue_engines[sim_queue_engine].insert != &_sim_queue_heap_insert)
+    return;                                         /* list times are relative */
+for (i = 0; i < sim_queue_depth; i++)
+    if (sim_queue_heap[i])
+        sim_queue_heap[i]->event_due += delta;
+}
+
+/* Move all pending entries to a different engine preserving their order and timing */
+
+static t_stat _sim_queue_set_engine (int32 engine)
+{
+UNIT **units;
+int32 *times;
+int32 i, count;
+
+if (engine == sim_queue_engine)
+    return SCPE_OK;
+AIO_UPDATE_QUEUE;
+UPDATE_SIM_TIME;
+count = sim_queue_engines[sim_queue_engine].entries (&units, &times);
+for (i = 0; i < count; i++) {
+    units[i]->next = NULL;
+    units[i]->event_slot = -1;
+    }
+sim_clock_queue = QUEUE_LIST_END;
+sim_queue_depth = 0;
+sim_queue_engine = engine;
+for (i = 0; i < count; i++)
+    sim_queue_engines[sim_queue_engine].insert (units[i], times[i]);
+if (sim_clock_queue != QUEUE_LIST_END)
+    sim_interval = sim_clock_queue->time;
+free (units);
+free (times);
+return SCPE_OK;
+}
+
+/* sim_process_event - process event
 
    Inputs:
         none
@@ -10767,14 +11935,8 @@ if (sim_clock_queue == QUEUE_LIST_END) {                /* queue empty? */
     }
 sim_processing_event = TRUE;
 do {
-    uptr = sim_clock_queue;                             /* get first */
-    sim_clock_queue = uptr->next;                       /* remove first */
-    uptr->next = NULL;                                  /* hygiene */
-    uptr->time = 0;
-    if (sim_clock_queue != QUEUE_LIST_END)
-        sim_interval += sim_clock_queue->time;
-    else
-        sim_interval = noqueue_time = NOQUEUE_WAIT;
+    uptr = sim_queue_engines[sim_queue_engine].pop ();  /* get first */
+    ++sim_queue_stats[sim_queue_engine].dispatches;
     AIO_EVENT_BEGIN(uptr);
     if (uptr->usecs_remaining) {
         sim_debug (SIM_DBG_EVENT, &sim_scp_dev, "Requeueing %s after %.0f usecs\n", sim_uname (uptr), uptr->usecs_remaining);
@@ -10836,9 +11998,6 @@ return _sim_activate (uptr, event_time);
 
 t_stat _sim_activate (UNIT *uptr, int32 event_time)
 {
-UNIT *cptr, *prvptr;
-int32 accum;
-
 AIO_ACTIVATE (_sim_activate, uptr, event_time);
 if (sim_is_active (uptr))                               /* already active? */
     return SCPE_OK;
@@ -10846,25 +12005,8 @@ UPDATE_SIM_TIME;                                        /* update sim time */
 
 sim_debug (SIM_DBG_ACTIVATE, &sim_scp_dev, "Activating %s delay=%d\n", sim_uname (uptr), event_time);
 
-prvptr = NULL;
-accum = 0;
-for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-    if (event_time < (accum + cptr->time))
-        break;
-    accum = accum + cptr->time;
-    prvptr = cptr;
-    }
-if (prvptr == NULL) {                                   /* insert at head */
-    cptr = uptr->next = sim_clock_queue;
-    sim_clock_queue = uptr;
-    }
-else {
-    cptr = uptr->next = prvptr->next;                   /* insert at prvptr */
-    prvptr->next = uptr;
-    }
-uptr->time = event_time - accum;
-if (cptr != QUEUE_LIST_END)
-    cptr->time = cptr->time - uptr->time;
+sim_queue_engines[sim_queue_engine].insert (uptr, event_time);
+++sim_queue_stats[sim_queue_engine].inserts;
 sim_interval = sim_clock_queue->time;
 return SCPE_OK;
 }
@@ -10964,8 +12106,6 @@ return sim_timer_activate_after (uptr, usec_delay);
 
 t_stat sim_cancel (UNIT *uptr)
 {
-UNIT *cptr, *nptr;
-
 AIO_VALIDATE(uptr);
 if ((uptr->cancel) && uptr->cancel (uptr))
     return SCPE_OK;
@@ -10979,25 +12119,8 @@ UPDATE_SIM_TIME;                                        /* update sim time */
 if (!sim_is_active (uptr))
     return SCPE_OK;
 sim_debug (SIM_DBG_EVENT, &sim_scp_dev, "Canceling Event for %s\n", sim_uname(uptr));
-nptr = QUEUE_LIST_END;
-
-if (sim_clock_queue == uptr) {
-    nptr = sim_clock_queue = uptr->next;
-    uptr->next = NULL;                                  /* hygiene */
-    }
-else {
-    for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-        if (cptr->next == uptr) {
-            nptr = cptr->next = uptr->next;
-            uptr->next = NULL;                          /* hygiene */
-            break;                                      /* end queue scan */
-            }
-        }
-    }
-if (nptr != QUEUE_LIST_END)
-    nptr->time += (uptr->next) ? 0 : uptr->time;
-if (!uptr->next)
-    uptr->time = 0;
+if (sim_queue_engines[sim_queue_engine].remove (uptr))
+    ++sim_queue_stats[sim_queue_engine].cancels;
 uptr->usecs_remaining = 0;
 if (sim_clock_queue != QUEUE_LIST_END)
     sim_interval = sim_clock_queue->time;
@@ -11036,21 +12159,14 @@ return (((uptr->next) || AIO_IS_ACTIVE(uptr) || ((uptr->dynflags & UNIT_TMR_UNIT
 
 int32 _sim_activate_time (UNIT *uptr)
 {
-UNIT *cptr;
 int32 accum;
 
-accum = 0;
-for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-    if (cptr == sim_clock_queue) {
-        if (sim_interval > 0)
-            accum = accum + sim_interval;
-        }
-    else
-        accum = accum + cptr->time;
-    if (cptr == uptr)
-        return accum + 1 + (int32)((uptr->usecs_remaining * sim_timer_inst_per_sec ()) / 1000000.0);
-    }
-return 0;
+if ((sim_clock_queue == QUEUE_LIST_END) || 
+    ((accum = sim_queue_engines[sim_queue_engine].offset (uptr)) < 0))
+    return 0;
+if (sim_interval > 0)
+    accum = accum + sim_interval;
+return accum + 1 + (int32)((uptr->usecs_remaining * sim_timer_inst_per_sec ()) / 1000000.0);
 }
 
 int32 sim_activate_time (UNIT *uptr)
@@ -11066,7 +12182,6 @@ return _sim_activate_time (uptr);
 
 double sim_activate_time_usecs (UNIT *uptr)
 {
-UNIT *cptr;
 int32 accum;
 double result;
 
@@ -11074,18 +12189,12 @@ AIO_VALIDATE(uptr);
 result = sim_timer_activate_time_usecs (uptr);
 if (result >= 0)
     return result;
-accum = 0;
-for (cptr = sim_clock_queue; cptr != QUEUE_LIST_END; cptr = cptr->next) {
-    if (cptr == sim_clock_queue) {
-        if (sim_interval > 0)
-            accum = accum + sim_interval;
-        }
-    else
-        accum = accum + cptr->time;
-    if (cptr == uptr)
-        return 1.0 + uptr->usecs_remaining + ((1000000.0 * accum) / sim_timer_inst_per_sec ());
-    }
-return 0.0;
+if ((sim_clock_queue == QUEUE_LIST_END) || 
+    ((accum = sim_queue_engines[sim_queue_engine].offset (uptr)) < 0))
+    return 0.0;
+if (sim_interval > 0)
+    accum = accum + sim_interval;
+return 1.0 + uptr->usecs_remaining + ((1000000.0 * accum) / sim_timer_inst_per_sec ());
 }
 
 /* sim_gtime - return global time
@@ -11119,13 +12228,7 @@ return sim_rtime;
 
 int32 sim_qcount (void)
 {
-int32 cnt;
-UNIT *uptr;
-
-cnt = 0;
-for (uptr = sim_clock_queue; uptr != QUEUE_LIST_END; uptr = uptr->next)
-    cnt++;
-return cnt;
+return sim_queue_depth;
 }
 
 /* Breakpoint package.  This module replaces the VM-implemented one
@@ -11147,6 +12250,12 @@ return cnt;
    is the bitwise OR of all the type fields).  A simulator need only check for
    a breakpoint of type X if bit SWMASK('X') is set in sim_brk_summ.
 
+   sim_brk_map refines sim_brk_summ per page of addresses: each slot is the
+   bitwise OR of the type fields of the breakpoints on the pages which hash
+   to it.  sim_brk_test consults it before searching the table, and hot
+   simulator paths (data watchpoints on every memory reference) can use the
+   SIM_BRK_TEST macro to avoid the call entirely for unwatched pages.
+
    The package contains the following public routines:
 
         sim_brk_init            initialize
@@ -11184,6 +12293,7 @@ sim_brk_tab = (BRKTAB **) realloc (sim_brk_tab, sim_brk_lnt*sizeof (BRKTAB*));
 if (sim_brk_tab == NULL)
     return SCPE_MEM;
 memset (sim_brk_tab, 0, sim_brk_lnt*sizeof (BRKTAB*));
+memset (sim_brk_map, 0, sizeof (sim_brk_map));
 sim_brk_ent = sim_brk_ins = 0;
 sim_brk_clract ();
 sim_brk_npc (0);
@@ -11317,6 +12427,7 @@ if ((act != NULL) && (*act != 0)) {                     /* new action? */
     bp->act = newp;                                     /* set pointer */
     }
 sim_brk_summ = sim_brk_summ | (sw & ~BRK_TYP_TEMP);
+sim_brk_map[SIM_BRK_MAP_SLOT (loc)] |= (sw & ~BRK_TYP_TEMP);
 return SCPE_OK;
 }
 
@@ -11354,10 +12465,12 @@ if (sim_brk_tab[sim_brk_ins] == NULL) {                 /* erased entry */
         sim_brk_tab[i] = sim_brk_tab[i+1];
     }
 sim_brk_summ = 0;                                       /* recalc summary */
+memset (sim_brk_map, 0, sizeof (sim_brk_map));          /* and page map */
 for (i = 0; i < sim_brk_ent; i++) {
     bp = sim_brk_tab[i];
     while (bp) {
         sim_brk_summ |= (bp->typ & ~BRK_TYP_TEMP);
+        sim_brk_map[SIM_BRK_MAP_SLOT (bp->addr)] |= (bp->typ & ~BRK_TYP_TEMP);
         bp = bp->next;
         }
     }
@@ -11500,6 +12613,8 @@ uint32 sim_brk_test (t_addr loc, uint32 btyp)
 BRKTAB *bp;
 uint32 spc = (btyp >> SIM_BKPT_V_SPC) & (SIM_BKPT_N_SPC - 1);
 
+if (!SIM_BRK_MAP_TEST (loc, btyp))                      /* nothing on this page? */
+    return 0;
 if (sim_brk_summ & BRK_TYP_DYN_ALL)
     btyp |= BRK_TYP_DYN_ALL;
 
@@ -11801,9 +12916,13 @@ free (ep->match);                                       /* deallocate match stri
 free (ep->match_pattern);                               /* deallocate the display format match string */
 free (ep->act);                                         /* deallocate action */
 #if defined(USE_REGEX)
-if (ep->switches & EXP_TYP_REGEX)
+if (ep->switches & EXP_TYP_REGEX) {
     regfree (&ep->regex);                               /* release compiled regex */
+    regfree (&ep->regex_nosub);
+    free (ep->matches);
+    }
 #endif
+exp->compiled = FALSE;                                  /* rules changed */
 exp->size -= 1;                                         /* decrement count */
 for (i=ep-exp->rules; i<exp->size; i++)                 /* shuffle up remaining rules */
     exp->rules[i] = exp->rules[i+1];
@@ -11836,8 +12955,11 @@ for (i=0; i<exp->size; i++) {
     free (exp->rules[i].match_pattern);                 /* deallocate display format match string */
     free (exp->rules[i].act);                           /* deallocate action */
 #if defined(USE_REGEX)
-    if (exp->rules[i].switches & EXP_TYP_REGEX)
+    if (exp->rules[i].switches & EXP_TYP_REGEX) {
         regfree (&exp->rules[i].regex);                               /* release compiled regex */
+        regfree (&exp->rules[i].regex_nosub);
+        free (exp->rules[i].matches);
+        }
 #endif
     }
 free (exp->rules);
@@ -11847,9 +12969,47 @@ free (exp->buf);
 exp->buf = NULL;
 exp->buf_size = 0;
 exp->buf_data = exp->buf_ins = 0;
+free (exp->lit_next);
+exp->lit_next = NULL;
+free (exp->lit_rule);
+exp->lit_rule = NULL;
+exp->lit_state = 0;
+exp->regex_rules = 0;
+free (exp->rbuf);
+exp->rbuf = NULL;
+exp->rbuf_ins = exp->rbuf_size = 0;
+exp->compiled = FALSE;
 return SCPE_OK;
 }
 
+/* Longest text a RegEx rule can match, or 0 when that isn't bounded.
+
+   Without repetition operators, back references and assertions about
+   the surrounding text, each pattern character matches at most one
+   character of output, so the pattern length bounds a match and only
+   that much of the most recent output needs to be searched. */
+
+#if defined(USE_REGEX)
+static uint32 sim_exp_regex_window (const char *pattern)
+{
+const char *c;
+
+for (c = pattern; *c; c++) {
+    if (*c == '\\') {
+        ++c;
+        if ((*c == '\0') || strchr ("<>`'", *c) ||
+            (sim_isalnum (*c) && !strchr ("dDsSwWtnrf", *c)))
+            return 0;
+        continue;
+        }
+    if (strchr ("*+{", *c) ||
+        ((*c == '(') && (c[1] == '?')))                 /* PCRE extensions */
+        return 0;
+    }
+return (uint32)strlen (pattern);
+}
+#endif
+
 /* Set/Add an expect rule */
 
 t_stat sim_exp_set (EXPECT *exp, const char *match, int32 cnt, uint32 after, int32 switches, const char *act)
@@ -11912,6 +13072,7 @@ if (after && exp->size)
 exp->rules = (EXPTAB *) realloc (exp->rules, sizeof (*exp->rules)*(exp->size + 1));
 ep = &exp->rules[exp->size];
 exp->size += 1;
+exp->compiled = FALSE;                                  /* rules changed */
 memset (ep, 0, sizeof(*ep));
 ep->after = after;                                     /* set halt after value */
 ep->match_pattern = (char *)malloc (strlen (match) + 1);
@@ -11927,9 +13088,19 @@ if ((match_buf == NULL) || (ep->match_pattern == NULL)) {
     }
 if (switches & EXP_TYP_REGEX) {
 #if defined(USE_REGEX)
+    int cflags = REG_EXTENDED | ((switches & EXP_TYP_REGEX_I) ? REG_ICASE : 0);
+
     memcpy (match_buf, match+1, strlen(match)-2);      /* extract string without surrounding quotes */
     match_buf[strlen(match)-2] = '\0';
-    regcomp (&ep->regex, (char *)match_buf, REG_EXTENDED);
+    regcomp (&ep->regex, (char *)match_buf, cflags);
+    regcomp (&ep->regex_nosub, (char *)match_buf, cflags | REG_NOSUB);
+    ep->matches = (regmatch_t *)calloc (ep->regex.re_nsub + 1, sizeof (*ep->matches));
+    ep->window = sim_exp_regex_window ((char *)match_buf);
+    if (ep->matches == NULL) {
+        sim_exp_clr_tab (exp, ep);                      /* clear it */
+        free (match_buf);
+        return SCPE_MEM;
+        }
 #endif
     free (match_buf);
     match_buf = NULL;
@@ -11966,6 +13137,8 @@ for (i=0; i<exp->size; i++) {
     if (compare_size >= exp->buf_size) {
         exp->buf = (uint8 *)realloc (exp->buf, compare_size + 2); /* Extra byte to null terminate regex compares */
         exp->buf_size = compare_size + 1;
+        if (exp->buf_data > exp->buf_ins)               /* data before a wrap is no longer contiguous */
+            exp->buf_data = exp->buf_ins;
         }
     }
 return SCPE_OK;
@@ -12043,64 +13216,183 @@ for (i=0; i < exp->size; i++)
 return SCPE_OK;
 }
 
+/* Compile the rules of an expect context for sim_exp_check.
+
+   The literal rules are combined into one Aho-Corasick automaton which
+   advances a single state per output character.  Each state records the
+   lowest numbered rule whose match string ends there, so the rule order
+   precedence of checking each rule in turn is preserved.  The automaton
+   is rebuilt when the rules change and is brought up to date with the
+   output data which arrived since the last match.
+
+   RegEx rules see the output with NUL characters removed, which is kept
+   in a separate buffer as it arrives rather than being rebuilt for each
+   check.  A rule may have been added after output it matches arrived,
+   so the first check after compiling searches all of that buffer. */
+
+static t_stat sim_exp_compile (EXPECT *exp)
+{
+uint32 states = 1, max_states = 1;
+uint32 *fail, *queue;
+uint32 head, tail, s, f, t, n;
+int32 i;
+int c;
+
+free (exp->lit_next);
+free (exp->lit_rule);
+exp->regex_rules = 0;
+for (i=0; i<exp->size; i++) {
+    if (exp->rules[i].switches & EXP_TYP_REGEX)
+        ++exp->regex_rules;
+    else
+        max_states += exp->rules[i].size;
+    }
+exp->lit_next = (uint32 *)calloc (max_states * 256, sizeof (*exp->lit_next));
+exp->lit_rule = (int32 *)malloc (max_states * sizeof (*exp->lit_rule));
+fail = (uint32 *)calloc (max_states, sizeof (*fail));
+queue = (uint32 *)malloc (max_states * sizeof (*queue));
+if (exp->regex_rules && (exp->rbuf_size < exp->buf_size)) {
+    char *rbuf = (char *)realloc (exp->rbuf, exp->buf_size + 1);
+
+    if (rbuf) {
+        exp->rbuf = rbuf;
+        exp->rbuf_size = exp->buf_size;
+        }
+    }
+if ((!exp->lit_next) || (!exp->lit_rule) || (!fail) || (!queue) ||
+    (exp->regex_rules && (exp->rbuf_size < exp->buf_size))) {
+    free (exp->lit_next);
+    exp->lit_next = NULL;
+    free (exp->lit_rule);
+    exp->lit_rule = NULL;
+    free (fail);
+    free (queue);
+    return SCPE_MEM;
+    }
+for (s=0; s<max_states; s++)
+    exp->lit_rule[s] = -1;
+for (i=0; i<exp->size; i++) {                           /* build the trie of match strings */
+    EXPTAB *ep = &exp->rules[i];
+
+    if (ep->switches & EXP_TYP_REGEX)
+        continue;
+    for (s=0, n=0; n<ep->size; n++) {
+        uint32 *next = &exp->lit_next[s * 256 + ep->match[n]];
+
+        if (*next == 0)                                 /* state 0 is the root, never a successor */
+            *next = states++;
+        s = *next;
+        }
+    if (exp->lit_rule[s] < 0)                           /* identical strings match the first rule */
+        exp->lit_rule[s] = i;
+    }
+head = tail = 0;
+for (c=0; c<256; c++)                                   /* failure links of depth 1 states are the root */
+    if (exp->lit_next[c])
+        queue[tail++] = exp->lit_next[c];
+while (head < tail) {                                   /* breadth first over deeper states */
+    s = queue[head++];
+    f = fail[s];
+    if ((exp->lit_rule[f] >= 0) &&                      /* a shorter match ends here too? */
+        ((exp->lit_rule[s] < 0) || (exp->lit_rule[f] < exp->lit_rule[s])))
+        exp->lit_rule[s] = exp->lit_rule[f];
+    for (c=0; c<256; c++) {
+        t = exp->lit_next[s * 256 + c];
+        if (t) {
+            fail[t] = exp->lit_next[f * 256 + c];
+            queue[tail++] = t;
+            }
+        else                                            /* no trie edge, follow the failure link */
+            exp->lit_next[s * 256 + c] = exp->lit_next[f * 256 + c];
+        }
+    }
+free (fail);
+free (queue);
+exp->lit_state = exp->rbuf_ins = 0;
+for (n=exp->buf_data; n > 0; n--) {                     /* catch up with the unmatched data */
+    uint8 data = exp->buf[(exp->buf_ins + exp->buf_size - n) % exp->buf_size];
+
+    exp->lit_state = exp->lit_next[exp->lit_state * 256 + data];
+    if (exp->regex_rules && (data != '\0'))
+        exp->rbuf[exp->rbuf_ins++] = (char)data;
+    }
+if (exp->regex_rules)
+    exp->rbuf[exp->rbuf_ins] = '\0';
+exp->regex_full = (exp->regex_rules != 0);
+exp->compiled = TRUE;
+sim_debug (exp->dbit, exp->dptr, "Compiled %d literal rules into %d states, %d RegEx rules\n", (int)(exp->size - exp->regex_rules), (int)states, (int)exp->regex_rules);
+return SCPE_OK;
+}
+
 /* Test for expect match */
 
 t_stat sim_exp_check (EXPECT *exp, uint8 data)
 {
-int32 i;
+int32 match;
 EXPTAB *ep;
-int regex_checks = 0;
-char *tstr = NULL;
 
 if ((!exp) || (!exp->rules))                            /* Anying to check? */
     return SCPE_OK;
+if ((!exp->compiled) && (sim_exp_compile (exp) != SCPE_OK))
+    return SCPE_MEM;
 
 exp->buf[exp->buf_ins++] = data;                        /* Save new data */
-exp->buf[exp->buf_ins] = '\0';                          /* Nul terminate for RegEx match */
 if (exp->buf_data < exp->buf_size)
     ++exp->buf_data;                                    /* Record amount of data in buffer */
+if (exp->buf_ins == exp->buf_size)                      /* At end of match buffer? */
+    exp->buf_ins = 0;                                   /* wrap around to beginning */
+exp->lit_state = exp->lit_next[exp->lit_state * 256 + data];
+match = exp->lit_rule[exp->lit_state];                  /* lowest numbered literal rule matched (or -1) */
 
-for (i=0; i < exp->size; i++) {
-    ep = &exp->rules[i];
-    if (ep->switches & EXP_TYP_REGEX) {
 #if defined (USE_REGEX)
-        regmatch_t *matches;
-        char *cbuf = (char *)exp->buf;
-        static size_t sim_exp_match_sub_count = 0;
-
-        if (tstr)
-            cbuf = tstr;
-        else {
-            if (strlen ((char *)exp->buf) != exp->buf_ins) { /* Nul characters in buffer? */
-                size_t off;
-
-                tstr = (char *)malloc (exp->buf_ins + 1);
-                tstr[0] = '\0';
-                for (off=0; off < exp->buf_ins; off += 1 + strlen ((char *)&exp->buf[off]))
-                    strcpy (&tstr[strlen (tstr)], (char *)&exp->buf[off]);
-                cbuf = tstr;
-                }
-            }
-        ++regex_checks;
-        matches = (regmatch_t *)calloc ((ep->regex.re_nsub + 1), sizeof(*matches));
+if (exp->regex_rules && (data != '\0')) {               /* NUL characters are invisible to RegEx rules */
+    static size_t sim_exp_match_sub_count = 0;
+    int32 i;
+
+    if (exp->rbuf_ins == exp->rbuf_size) {              /* RegEx buffer full? */
+        /* Shuffle the buffer contents down by half the buffer size so 
+           that the regular expressions have a single contiguous buffer 
+           to match against */
+        memmove (exp->rbuf, &exp->rbuf[exp->rbuf_size/2], exp->rbuf_size-(exp->rbuf_size/2));
+        exp->rbuf_ins -= exp->rbuf_size/2;
+        sim_debug (exp->dbit, exp->dptr, "Buffer Full - sliding the last %d bytes to start of buffer new insert at: %d\n", (exp->rbuf_size/2), exp->rbuf_ins);
+        }
+    exp->rbuf[exp->rbuf_ins++] = (char)data;
+    exp->rbuf[exp->rbuf_ins] = '\0';
+    for (i=0; i < ((match < 0) ? exp->size : match); i++) {
+        char *cbuf = exp->rbuf;
+
+        ep = &exp->rules[i];
+        if (!(ep->switches & EXP_TYP_REGEX))
+            continue;
+        /* The data is checked as each character arrives, so a new 
+           match must end with this character and only the most recent 
+           window of data can be part of a bounded length match */
+        if ((ep->window) && (ep->window < exp->rbuf_ins) && !exp->regex_full)
+            cbuf = &exp->rbuf[exp->rbuf_ins - ep->window];
         if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-            char *estr = sim_encode_quoted_string (exp->buf, exp->buf_ins);
+            char *estr = sim_encode_quoted_string ((uint8 *)cbuf, strlen (cbuf));
             sim_debug (exp->dbit, exp->dptr, "Checking String: %s\n", estr);
             sim_debug (exp->dbit, exp->dptr, "Against RegEx Match Rule: %s\n", ep->match_pattern);
             free (estr);
             }
-        if (!regexec (&ep->regex, cbuf, ep->regex.re_nsub + 1, matches, REG_NOTBOL)) {
+        if ((!regexec (&ep->regex_nosub, cbuf, 0, NULL, REG_NOTBOL)) &&
+            (!regexec (&ep->regex, cbuf, ep->regex.re_nsub + 1, ep->matches, REG_NOTBOL))) {
             size_t j;
-            char *buf = (char *)malloc (1 + exp->buf_ins);
 
             for (j=0; j<ep->regex.re_nsub + 1; j++) {
                 char env_name[32];
+                regmatch_t *m = &ep->matches[j];
+                char save;
 
                 sprintf (env_name, "_EXPECT_MATCH_GROUP_%d", (int)j);
-                memcpy (buf, &cbuf[matches[j].rm_so], matches[j].rm_eo-matches[j].rm_so);
-                buf[matches[j].rm_eo-matches[j].rm_so] = '\0';
-                setenv (env_name, buf, 1);      /* Make the match and substrings available as environment variables */
-                sim_debug (exp->dbit, exp->dptr, "%s=%s\n", env_name, buf);
+                if (m->rm_so < 0)                       /* sub expression not part of the match */
+                    m->rm_so = m->rm_eo = 0;
+                save = cbuf[m->rm_eo];
+                cbuf[m->rm_eo] = '\0';
+                setenv (env_name, &cbuf[m->rm_so], 1);  /* Make the match and substrings available as environment variables */
+                sim_debug (exp->dbit, exp->dptr, "%s=%s\n", env_name, &cbuf[m->rm_so]);
+                cbuf[m->rm_eo] = save;
                 }
             for (; j<sim_exp_match_sub_count; j++) {
                 char env_name[32];
@@ -12109,81 +13401,15 @@ for (i=0; i < exp->size; i++) {
                 setenv (env_name, "", 1);      /* Remove previous extra environment variables */
                 }
             sim_exp_match_sub_count = ep->regex.re_nsub;
-            free (matches);
-            free (buf);
+            match = i;
             break;
             }
-        free (matches);
-#endif
-        }
-    else {
-        if (exp->buf_data < ep->size)                           /* Too little data to match yet? */
-            continue;                                           /* Yes, Try next one. */
-        if (exp->buf_ins < ep->size) {                          /* Match might stradle end of buffer */
-            /* 
-             * First compare the newly deposited data at the beginning 
-             * of buffer with the end of the match string
-             */
-            if (exp->buf_ins) {
-                if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-                    char *estr = sim_encode_quoted_string (exp->buf, exp->buf_ins);
-                    char *mstr = sim_encode_quoted_string (&ep->match[ep->size-exp->buf_ins], exp->buf_ins);
-
-                    sim_debug (exp->dbit, exp->dptr, "Checking String[0:%d]: %s\n", exp->buf_ins, estr);
-                    sim_debug (exp->dbit, exp->dptr, "Against Match Data: %s\n", mstr);
-                    free (estr);
-                    free (mstr);
-                    }
-                if (memcmp (exp->buf, &ep->match[ep->size-exp->buf_ins], exp->buf_ins)) /* Tail Match? */
-                    continue;                                   /* Nope, Try next one. */
-                }
-            if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-                char *estr = sim_encode_quoted_string (&exp->buf[exp->buf_size-(ep->size-exp->buf_ins)], ep->size-exp->buf_ins);
-                char *mstr = sim_encode_quoted_string (ep->match, ep->size-exp->buf_ins);
-
-                sim_debug (exp->dbit, exp->dptr, "Checking String[%d:%d]: %s\n", exp->buf_size-(ep->size-exp->buf_ins), ep->size-exp->buf_ins, estr);
-                sim_debug (exp->dbit, exp->dptr, "Against Match Data: %s\n", mstr);
-                free (estr);
-                free (mstr);
-                }
-            if (memcmp (&exp->buf[exp->buf_size-(ep->size-exp->buf_ins)], ep->match, ep->size-exp->buf_ins)) /* Front Match? */
-                continue;                                       /* Nope, Try next one. */
-            break;
-            }
-        else {
-            if (sim_deb && exp->dptr && (exp->dptr->dctrl & exp->dbit)) {
-                char *estr = sim_encode_quoted_string (&exp->buf[exp->buf_ins-ep->size], ep->size);
-                char *mstr = sim_encode_quoted_string (ep->match, ep->size);
-
-                sim_debug (exp->dbit, exp->dptr, "Checking String[%d:%d]: %s\n", exp->buf_ins-ep->size, ep->size, estr);
-                sim_debug (exp->dbit, exp->dptr, "Against Match Data: %s\n", mstr);
-                free (estr);
-                free (mstr);
-                }
-            if (memcmp (&exp->buf[exp->buf_ins-ep->size], ep->match, ep->size)) /* Whole string match? */
-                continue;                                       /* Nope, Try next one. */
-            break;
-            }
-        }
-    }
-if (exp->buf_ins == exp->buf_size) {                    /* At end of match buffer? */
-    if (regex_checks) {
-        /* When processing regular expressions, let the match buffer fill 
-           up and then shuffle the buffer contents down by half the buffer size
-           so that the regular expression has a single contiguous buffer to 
-           match against instead of the wrapping buffer paradigm which is 
-           used when no regular expression rules are in effect */
-        memmove (exp->buf, &exp->buf[exp->buf_size/2], exp->buf_size-(exp->buf_size/2));
-        exp->buf_ins -= exp->buf_size/2;
-        exp->buf_data = exp->buf_ins;
-        sim_debug (exp->dbit, exp->dptr, "Buffer Full - sliding the last %d bytes to start of buffer new insert at: %d\n", (exp->buf_size/2), exp->buf_ins);
-        }
-    else {
-        exp->buf_ins = 0;                               /* wrap around to beginning */
-        sim_debug (exp->dbit, exp->dptr, "Buffer wrapping\n");
         }
+    exp->regex_full = FALSE;
     }
-if (i != exp->size) {                                   /* Found? */
+#endif
+if (match >= 0) {                                       /* Found? */
+    ep = &exp->rules[match];
     sim_debug (exp->dbit, exp->dptr, "Matched expect pattern: %s\n", ep->match_pattern);
     setenv ("_EXPECT_MATCH_PATTERN", ep->match_pattern, 1);   /* Make the match detail available as an environment variable */
     if (ep->cnt > 0) {
@@ -12215,8 +13441,11 @@ if (i != exp->size) {                                   /* Found? */
         }
     /* Matched data is no longer available for future matching */
     exp->buf_data = exp->buf_ins = 0;
+    exp->lit_state = 0;
+    exp->rbuf_ins = 0;
+    if (exp->rbuf)
+        exp->rbuf[0] = '\0';
     }
-free (tstr);
 return SCPE_OK;
 }
 
@@ -12398,6 +13627,10 @@ static void _sim_debug_write_flush (const char *buf, size_t len, t_bool flush)
 {
 char *eol;
 
+if (sim_deb_switches & SWMASK ('C')) {              /* binary trace? */
+    _sim_debug_trace_buf (buf, len);
+    return;
+    }
 if (sim_deb_switches & SWMASK ('F')) {              /* filtering disabled? */
     if (len > 0)
         _debug_fwrite (buf, len);                   /* output now. */
@@ -12490,6 +13723,12 @@ char saved_debug_filename[CBUFSIZE];
 if (sim_deb == NULL)                                    /* no debug? */
     return SCPE_OK;
 
+if (sim_deb_switches & SWMASK ('C')) {                 /* binary trace? */
+    _sim_debug_trace_flush ();
+    fflush (sim_deb);
+    return SCPE_OK;
+    }
+
 _sim_debug_write_flush ("", 0, TRUE);
 
 if (sim_deb == sim_log) {                               /* debug is log */
@@ -12582,11 +13821,491 @@ sprintf(debug_line_prefix, "DBG(%s%s%.0f%s)%s> %s %s: ", tim_t, tim_a, sim_gtime
 return debug_line_prefix;
 }
 
-void fprint_fields (FILE *stream, t_value before, t_value after, BITFIELD* bitdefs)
+/* Binary debug trace output (SET DEBUG -C)
+
+   Rather than formatting each message, sim_debug calls record the format
+   string, the raw arguments and the prefix values into a ring buffer which
+   belongs to the calling thread.  A ring has a single producer (its thread)
+   and is emptied into the debug file under AIO_LOCK when it fills, when
+   debug output is flushed and when debug output is closed.  Strings which
+   are referenced by pointer (formats, device names and debug flag names) are
+   given ids as they are first seen.  The debugtracedecode tool renders the
+   resulting file as the text that would otherwise have been written.
+   The file layout is described in sim_debug_trace.h.
+
+   A format which isn't a literal (a buffer whose address has been seen
+   with different text) isn't given an id, nor is any string once the table
+   is full.  Such calls, and calls whose arguments can't all be recorded,
+   are formatted as the text output would be and recorded as text.  A
+   thread's ring is freed when the thread exits, and the main thread's when
+   debug output is closed.
+*/
+
+#define DTRC_RING_SIZE      (1024 * 1024)               /* per thread ring buffer size */
+#define DTRC_STR_HASH       4096                        /* string table hash buckets */
+#define DTRC_STR_MAX        65536                       /* most strings given ids */
+
+#if !defined(va_copy)
+#define va_copy(dst, src) ((dst) = (src))
+#endif
+
+#if defined(_MSC_VER)
+#define DTRC_BARRIER() MemoryBarrier ()
+#elif defined(__GNUC__)
+#define DTRC_BARRIER() __sync_synchronize ()
+#else
+#define DTRC_BARRIER()
+#endif
+
+typedef struct DTRC_RING {
+    struct DTRC_RING    *next;                          /* next ring */
+    volatile size_t     head;                           /* bytes written by the owning thread */
+    volatile size_t     tail;                           /* bytes written to the file */
+    uint8               data[DTRC_RING_SIZE];
+    } DTRC_RING;
+
+typedef struct DTRC_STRING {
+    struct DTRC_STRING  *next;                          /* next in hash bucket */
+    const char          *ptr;                           /* string address */
+    size_t              len;                            /* string length */
+    uint32              id;                             /* id in trace file */
+    volatile uint32     gen;                            /* trace file this was last defined in */
+    char                text[1];                        /* string contents */
+    } DTRC_STRING;
+
+static DTRC_RING *dtrc_rings = NULL;                    /* all thread rings */
+static AIO_TLS DTRC_RING *dtrc_ring = NULL;             /* this thread's ring */
+static DTRC_STRING * volatile dtrc_strings[DTRC_STR_HASH];
+static uint32 dtrc_string_count = 0;                    /* ids assigned */
+static volatile uint32 dtrc_gen = 0;                    /* current trace file */
+static const char *dtrc_text_fmt = "%s";                /* format of text records */
+#if defined (SIM_ASYNCH_IO)
+static pthread_key_t dtrc_ring_key;                     /* frees a ring at thread exit */
+static t_bool dtrc_ring_key_created = FALSE;
+#endif
+
+static void _dtrc_put8 (uint8 **p, uint8 val)
+{
+*(*p)++ = val;
+}
+
+static void _dtrc_put16 (uint8 **p, uint16 val)
+{
+memcpy (*p, &val, sizeof (val));
+*p += sizeof (val);
+}
+
+static void _dtrc_put32 (uint8 **p, uint32 val)
+{
+memcpy (*p, &val, sizeof (val));
+*p += sizeof (val);
+}
+
+static void _dtrc_put64 (uint8 **p, t_uint64 val)
+{
+memcpy (*p, &val, sizeof (val));
+*p += sizeof (val);
+}
+
+static void _dtrc_put_double (uint8 **p, double val)
+{
+memcpy (*p, &val, sizeof (val));
+*p += sizeof (val);
+}
+
+static void _dtrc_put_bytes (uint8 **p, const void *buf, size_t len)
+{
+memcpy (*p, buf, len);
+*p += len;
+}
+
+/* Complete a record's header */
+
+static size_t _dtrc_record (uint8 *rec, uint8 type, uint8 *end)
+{
+uint8 *p = rec;
+size_t len = (size_t)(end - rec);
+
+_dtrc_put8 (&p, SIM_DTRC_SYNC);
+_dtrc_put8 (&p, type);
+_dtrc_put8 (&p, (uint8)(len >> 8));
+_dtrc_put8 (&p, (uint8)len);
+return len;
+}
+
+/* Write a ring's records to the debug file (AIO_LOCK held) */
+
+static void _dtrc_ring_sync (DTRC_RING *r)
+{
+size_t head = r->head;
+size_t tail = r->tail;
+
+DTRC_BARRIER ();                                        /* data before head is complete */
+while (tail != head) {
+    size_t off = tail % DTRC_RING_SIZE;
+    size_t len = MIN (head - tail, DTRC_RING_SIZE - off);
+
+    fwrite (&r->data[off], 1, len, sim_deb);
+    tail += len;
+    }
+DTRC_BARRIER ();                                        /* data read before space is released */
+r->tail = tail;
+}
+
+/* Write all buffered trace records to the debug file */
+
+void sim_debug_trace_sync (void)
+{
+DTRC_RING *r;
+
+if (!(sim_deb_switches & SWMASK ('C')) || (sim_deb == NULL))
+    return;
+AIO_LOCK;
+for (r = dtrc_rings; r != NULL; r = r->next)
+    _dtrc_ring_sync (r);
+AIO_UNLOCK;
+}
+
+/* Write out and free a ring which is no longer in use */
+
+static void _dtrc_ring_free (void *arg)
+{
+DTRC_RING *r = (DTRC_RING *)arg;
+DTRC_RING **rp;
+
+AIO_LOCK;
+if ((sim_deb_switches & SWMASK ('C')) && (sim_deb != NULL))
+    _dtrc_ring_sync (r);
+for (rp = &dtrc_rings; *rp != NULL; rp = &(*rp)->next)
+    if (*rp == r) {
+        *rp = r->next;
+        break;
+        }
+AIO_UNLOCK;
+free (r);
+}
+
+/* Free the calling thread's ring when debug output is closed.  The rings
+   of other threads which are still running are freed as they exit. */
+
+void sim_debug_trace_close (void)
+{
+DTRC_RING *r = dtrc_ring;
+
+if (r == NULL)
+    return;
+dtrc_ring = NULL;
+#if defined (SIM_ASYNCH_IO)
+if (dtrc_ring_key_created)
+    pthread_setspecific (dtrc_ring_key, NULL);
+#endif
+_dtrc_ring_free (r);
+}
+
+static void _dtrc_write (const uint8 *rec, size_t len)
+{
+DTRC_RING *r = dtrc_ring;
+size_t head, off, first;
+
+if (r == NULL) {                                        /* first record from this thread? */
+    r = (DTRC_RING *)calloc (1, sizeof (*r));
+    if (r == NULL)
+        return;
+    AIO_LOCK;
+    r->next = dtrc_rings;
+    dtrc_rings = r;
+    AIO_UNLOCK;
+    dtrc_ring = r;
+#if defined (SIM_ASYNCH_IO)
+    if (dtrc_ring_key_created)
+        pthread_setspecific (dtrc_ring_key, r);
+#endif
+    }
+head = r->head;
+if ((DTRC_RING_SIZE - (head - r->tail)) < len)          /* no room? */
+    sim_debug_trace_sync ();
+off = head % DTRC_RING_SIZE;
+first = MIN (len, DTRC_RING_SIZE - off);
+memcpy (&r->data[off], rec, first);
+memcpy (r->data, rec + first, len - first);
+DTRC_BARRIER ();                                        /* data complete before it is visible */
+r->head = head + len;
+}
+
+/* Find (or assign) the id of a string.  Returns 0 if a format can't be
+   given an id; names (always) are given one whatever the table holds. */
+
+static uint32 _dtrc_string_id (const char *str, t_bool always)
+{
+size_t len = strlen (str);
+size_t hash = (((size_t)str) ^ (((size_t)str) >> 12)) % DTRC_STR_HASH;
+DTRC_STRING *s;
+t_bool seen = FALSE;
+
+for (s = dtrc_strings[hash]; s != NULL; s = s->next) {
+    if (s->ptr != str)
+        continue;
+    if ((s->len == len) && (0 == memcmp (s->text, str, len)))
+        break;
+    seen = TRUE;                                        /* same address, other text */
+    }
+if (s == NULL) {
+    if (!always &&
+        (seen || (dtrc_string_count >= DTRC_STR_MAX)))  /* a buffer or the table is full? */
+        return 0;
+    s = (DTRC_STRING *)malloc (sizeof (*s) + len);
+    if (s == NULL)
+        return 0;
+    s->ptr = str;
+    s->len = len;
+    memcpy (s->text, str, len + 1);
+    s->gen = 0;
+    AIO_LOCK;
+    s->id = ++dtrc_string_count;
+    s->next = dtrc_strings[hash];
+    DTRC_BARRIER ();                                    /* entry complete before it is visible */
+    dtrc_strings[hash] = s;
+    AIO_UNLOCK;
+    }
+if (s->gen != dtrc_gen) {                               /* not yet defined in this file? */
+    uint8 rec[SIM_DTRC_MAX_RECORD];
+    uint8 *p = rec + SIM_DTRC_HDR_SIZE;
+    size_t tlen = MIN (len, sizeof (rec) - (SIM_DTRC_HDR_SIZE + 4));
+
+    _dtrc_put32 (&p, s->id);
+    _dtrc_put_bytes (&p, s->text, tlen);
+    _dtrc_write (rec, _dtrc_record (rec, SIM_DTRC_STRING, p));
+    s->gen = dtrc_gen;
+    }
+return s->id;
+}
+
+/* Start a trace file which has just been opened as the debug file */
+
+void sim_debug_trace_open (void)
+{
+uint8 rec[SIM_DTRC_MAX_RECORD];
+uint8 *p = rec + SIM_DTRC_HDR_SIZE;
+const char *pc_name = sim_PC ? sim_PC->name : "";
+
+AIO_LOCK;
+++dtrc_gen;                                             /* all strings need defining again */
+#if defined (SIM_ASYNCH_IO)
+if (!dtrc_ring_key_created)
+    dtrc_ring_key_created = (0 == pthread_key_create (&dtrc_ring_key, _dtrc_ring_free));
+#endif
+AIO_UNLOCK;
+_dtrc_put32 (&p, SIM_DTRC_BYTE_ORDER);
+_dtrc_put32 (&p, SIM_DTRC_VERSION);
+_dtrc_put32 (&p, (uint32)sim_deb_switches);
+_dtrc_put64 (&p, (t_uint64)sim_deb_basetime.tv_sec);
+_dtrc_put32 (&p, (uint32)sim_deb_basetime.tv_nsec);
+_dtrc_put32 (&p, sim_PC ? sim_PC->radix : 0);
+_dtrc_put32 (&p, sim_PC ? sim_PC->width : 0);
+_dtrc_put32 (&p, sim_PC ? (sim_PC->flags & REG_FMT) : 0);
+_dtrc_put32 (&p, (uint32)sizeof (t_value));
+_dtrc_put_bytes (&p, pc_name, strlen (pc_name) + 1);
+_dtrc_put_bytes (&p, sim_name, strlen (sim_name) + 1);
+fwrite (rec, 1, _dtrc_record (rec, SIM_DTRC_HEADER, p), sim_deb);
+}
+
+/* Record the arguments consumed by a format.  Returns 1 if the output
+   would end with a newline, 0 if it wouldn't, -1 if it would be empty
+   and -2 if the arguments can't all be recorded */
+
+static int _dtrc_put_args (uint8 **pp, uint8 *end, const char *fmt, va_list arglist)
+{
+uint8 *p = *pp;
+SIM_DTRC_SPEC spec;
+const char *f, *next;
+int prec = -1;
+int eol = -1;
+
+for (f = fmt; (next = sim_debug_trace_spec (f, &spec)) != NULL; f = next) {
+    if ((size_t)(end - p) < 80)                         /* record full? */
+        return -2;
+    if (spec.cls == SIM_DTRC_ARG_TEXT)                  /* not recordable? */
+        return -2;
+    if (spec.start > f)                                 /* literal text before the conversion */
+        eol = (spec.start[-1] == '\n');
+    if (spec.width_star)
+        _dtrc_put32 (&p, (uint32)va_arg (arglist, int));
+    if (spec.prec_star) {
+        prec = va_arg (arglist, int);
+        _dtrc_put32 (&p, (uint32)prec);
+        }
+    else
+        prec = (spec.has_prec) ? atoi (spec.prec) : -1;
+    switch (spec.cls) {
+        case SIM_DTRC_ARG_INT: {
+            int val = va_arg (arglist, int);
+
+            _dtrc_put32 (&p, (uint32)val);
+            eol = ((spec.conv == 'c') && (val == '\n'));
+            }
+            break;
+        case SIM_DTRC_ARG_LONG:
+            if (spec.is_long == 1)
+                _dtrc_put64 (&p, spec.is_signed ? (t_uint64)(t_int64)va_arg (arglist, long) : (t_uint64)va_arg (arglist, unsigned long));
+            else if (spec.is_long == 3)
+                _dtrc_put64 (&p, (t_uint64)va_arg (arglist, size_t));
+            else
+                _dtrc_put64 (&p, (t_uint64)va_arg (arglist, t_uint64));
+            eol = 0;
+            break;
+        case SIM_DTRC_ARG_DOUBLE:
+            _dtrc_put_double (&p, va_arg (arglist, double));
+            eol = 0;
+            break;
+        case SIM_DTRC_ARG_POINTER:
+            _dtrc_put64 (&p, (t_uint64)(size_t)va_arg (arglist, void *));
+            eol = 0;
+            break;
+        case SIM_DTRC_ARG_SKIP:
+            (void)va_arg (arglist, void *);
+            break;
+        case SIM_DTRC_ARG_STRING: {
+            const char *s = va_arg (arglist, const char *);
+            size_t len = 0;
+            size_t room = (size_t)(end - p) - (2 + 64);     /* leave room for later arguments */
+
+            if (s == NULL)
+                s = "(null)";
+            while ((len < room) && ((prec < 0) || (len < (size_t)prec)) && s[len])
+                ++len;
+            if ((len == room) && ((prec < 0) || (len < (size_t)prec)) && s[len])
+                return -2;                              /* too long to record */
+            _dtrc_put16 (&p, (uint16)len);
+            _dtrc_put_bytes (&p, s, len);
+            if (len)
+                eol = (s[len - 1] == '\n');
+            }
+            break;
+        default:                                        /* %% */
+            eol = 0;
+            break;
+        }
+    }
+if (*f)                                                 /* literal text after the last conversion */
+    eol = (f[strlen (f) - 1] == '\n');
+*pp = p;
+return eol;
+}
+
+/* Start an event record with its format id and prefix values */
+
+static uint8 *_dtrc_event_start (uint8 *rec, uint32 fmt_id, uint32 dbits, DEVICE *dptr, UNIT *uptr)
+{
+uint8 *p = rec + SIM_DTRC_HDR_SIZE;
+uint32 flags = AIO_MAIN_THREAD ? 0 : SIM_DTRC_F_THREAD;
+uint8 *pflags;
+
+_dtrc_put32 (&p, fmt_id);
+_dtrc_put32 (&p, _dtrc_string_id (dptr->name, TRUE));
+_dtrc_put32 (&p, _dtrc_string_id (_get_dbg_verb (dbits, dptr, uptr), TRUE));
+pflags = p;
+_dtrc_put32 (&p, flags);
+_dtrc_put_double (&p, sim_gtime ());
+if (sim_deb_switches & (SWMASK ('T') | SWMASK ('R') | SWMASK ('A'))) {
+    struct timespec time_now;
+
+    clock_gettime (CLOCK_REALTIME, &time_now);
+    _dtrc_put64 (&p, (t_uint64)time_now.tv_sec);
+    _dtrc_put32 (&p, (uint32)time_now.tv_nsec);
+    flags |= SIM_DTRC_F_TIME;
+    }
+if (sim_deb_switches & SWMASK ('P')) {
+    _dtrc_put64 (&p, (t_uint64)(sim_vm_pc_value ? (*sim_vm_pc_value)() : get_rval (sim_PC, 0)));
+    flags |= SIM_DTRC_F_PC;
+    }
+memcpy (pflags, &flags, sizeof (flags));
+return p;
+}
+
+/* Record a single sim_debug call.  Returns FALSE, having recorded nothing,
+   if the call must be formatted and recorded with _sim_debug_trace_formatted */
+
+static t_bool _sim_debug_trace (uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *fmt, va_list arglist)
+{
+uint8 rec[SIM_DTRC_MAX_RECORD];
+uint32 fmt_id = _dtrc_string_id (fmt, FALSE);
+uint8 *p;
+int eol;
+
+if (fmt_id == 0)
+    return FALSE;
+p = _dtrc_event_start (rec, fmt_id, dbits, dptr, uptr);
+eol = _dtrc_put_args (&p, rec + sizeof (rec), fmt, arglist);
+if (eol == -2)
+    return FALSE;
+if (eol >= 0)
+    debug_unterm = !eol;
+_dtrc_write (rec, _dtrc_record (rec, SIM_DTRC_EVENT, p));
+return TRUE;
+}
+
+/* Record the formatted output of a sim_debug call.  Long output is split
+   over several events, never just after a newline, so the decoder starts
+   lines (and places prefixes) as the whole text would have. */
+
+static void _sim_debug_trace_formatted (uint32 dbits, DEVICE *dptr, UNIT *uptr, const char *buf, size_t len)
+{
+uint8 rec[SIM_DTRC_MAX_RECORD];
+
+do {
+    uint8 *p = _dtrc_event_start (rec, _dtrc_string_id (dtrc_text_fmt, TRUE), dbits, dptr, uptr);
+    size_t chunk = MIN (len, (size_t)((rec + sizeof (rec)) - p) - 2);
+
+    while ((chunk < len) && (chunk > 1) && (buf[chunk - 1] == '\n'))
+        --chunk;
+    _dtrc_put16 (&p, (uint16)chunk);
+    _dtrc_put_bytes (&p, buf, chunk);
+    _dtrc_write (rec, _dtrc_record (rec, SIM_DTRC_EVENT, p));
+    buf += chunk;
+    len -= chunk;
+    } while (len > 0);
+}
+
+/* Record already formatted text */
+
+static void _sim_debug_trace_buf (const char *buf, size_t len)
+{
+uint8 rec[SIM_DTRC_MAX_RECORD];
+
+while (len > 0) {
+    uint8 *p = rec + SIM_DTRC_HDR_SIZE;
+    size_t chunk = MIN (len, sizeof (rec) - (SIM_DTRC_HDR_SIZE + 4 + 2));
+
+    _dtrc_put32 (&p, _dtrc_string_id (dtrc_text_fmt, TRUE));
+    _dtrc_put16 (&p, (uint16)chunk);
+    _dtrc_put_bytes (&p, buf, chunk);
+    _dtrc_write (rec, _dtrc_record (rec, SIM_DTRC_TEXT, p));
+    buf += chunk;
+    len -= chunk;
+    }
+}
+
+/* Mark the point where text output would have been flushed */
+
+static void _sim_debug_trace_flush (void)
+{
+uint8 rec[SIM_DTRC_HDR_SIZE];
+
+_dtrc_write (rec, _dtrc_record (rec, SIM_DTRC_FLUSH, rec + SIM_DTRC_HDR_SIZE));
+sim_debug_trace_sync ();
+}
+
+/* Format the translation and transition of each field into buf.  Like
+   snprintf, returns the length of the whole text even if it didn't fit */
+
+static size_t sprint_fields (char *buf, size_t size, t_value before, t_value after, BITFIELD* bitdefs)
 {
 int32 i, fields, offset;
 uint32 value, beforevalue, mask;
+size_t len = 0;
 
+#define FIELD_CAT(s, n) do { size_t _n = (size_t)(n); if (len + 1 < size) memcpy (&buf[len], s, MIN (_n, size - 1 - len)); len += _n; } while (0)
+#define FIELD_STR(s) FIELD_CAT (s, strlen (s))
 for (fields=offset=0; bitdefs[fields].name; ++fields) {
     if (bitdefs[fields].offset == 0xffffffff)       /* fixup uninitialized offsets */
         bitdefs[fields].offset = offset;
@@ -12597,10 +14316,14 @@ for (i = fields-1; i >= 0; i--) {                   /* print xlation, transition
         continue;
     if ((bitdefs[i].width == 1) && (bitdefs[i].valuenames == NULL)) {
         int off = ((after >> bitdefs[i].offset) & 1) + (((before ^ after) >> bitdefs[i].offset) & 1) * 2;
-        fprintf(stream, "%s%c ", bitdefs[i].name, debug_bstates[off]);
+
+        FIELD_STR (bitdefs[i].name);
+        FIELD_CAT (&debug_bstates[off], 1);
+        FIELD_CAT (" ", 1);
         }
     else {
         const char *delta = "";
+        char numbuf[64];
 
         mask = 0xFFFFFFFF >> (32-bitdefs[i].width);
         value = (uint32)((after >> bitdefs[i].offset) & mask);
@@ -12609,18 +14332,49 @@ for (i = fields-1; i >= 0; i--) {                   /* print xlation, transition
             delta = "_";
         if (value > beforevalue)
             delta = "^";
+        FIELD_STR (bitdefs[i].name);
+        FIELD_CAT ("=", 1);
+        FIELD_STR (delta);
         if (bitdefs[i].valuenames)
-            fprintf(stream, "%s=%s%s ", bitdefs[i].name, delta, bitdefs[i].valuenames[value]);
-        else
-            if (bitdefs[i].format) {
-                fprintf(stream, "%s=%s", bitdefs[i].name, delta);
-                fprintf(stream, bitdefs[i].format, value);
-                fprintf(stream, " ");
-                }
-            else
-                fprintf(stream, "%s=%s0x%X ", bitdefs[i].name, delta, value);
+            FIELD_STR (bitdefs[i].valuenames[value]);
+        else {
+            snprintf (numbuf, sizeof (numbuf), bitdefs[i].format ? bitdefs[i].format : "0x%X", value);
+            FIELD_STR (numbuf);
+            }
+        FIELD_CAT (" ", 1);
         }
     }
+#undef FIELD_CAT
+#undef FIELD_STR
+buf[MIN (len, size - 1)] = '\0';
+return len;
+}
+
+/* Format the fields into stackbuf, or into allocated memory if they
+   don't fit.  The caller frees a result which isn't stackbuf. */
+
+static char *_sim_fields_text (char *stackbuf, size_t size, t_value before, t_value after, BITFIELD* bitdefs)
+{
+size_t len = sprint_fields (stackbuf, size, before, after, bitdefs);
+char *buf;
+
+if (len < size)
+    return stackbuf;
+buf = (char *)malloc (len + 1);
+if (buf == NULL)                                    /* out of memory - keep what fit */
+    return stackbuf;
+sprint_fields (buf, len + 1, before, after, bitdefs);
+return buf;
+}
+
+void fprint_fields (FILE *stream, t_value before, t_value after, BITFIELD* bitdefs)
+{
+char stackbuf[1024];
+char *buf = _sim_fields_text (stackbuf, sizeof (stackbuf), before, after, bitdefs);
+
+fprintf(stream, "%s", buf);
+if (buf != stackbuf)
+    free (buf);
 }
 
 /* Prints state of a register: bit translation + state (0,1,_,^)
@@ -12633,6 +14387,16 @@ void sim_debug_bits_hdr(uint32 dbits, DEVICE* dptr, const char *header,
 if (sim_deb && dptr && (dptr->dctrl & dbits)) {
     TMLN *saved_oline = sim_oline;
 
+    if (sim_deb_switches & SWMASK ('C')) {                              /* binary trace? */
+        char stackbuf[1024];
+        char *fields = _sim_fields_text (stackbuf, sizeof (stackbuf), (t_value)before, (t_value)after, bitdefs);
+
+        _sim_debug_device (dbits, dptr, "%s%s%s%s", header ? header : "", header ? ": " : "", 
+                           fields, terminate ? "\n" : "");
+        if (fields != stackbuf)
+            free (fields);
+        return;
+        }
     sim_oline = NULL;                                                   /* avoid potential debug to active socket */
     if (!debug_unterm)
         fprintf(sim_deb, "%s", sim_debug_prefix(dbits, dptr, NULL));    /* print prefix if required */
@@ -12818,17 +14582,32 @@ if (sim_deb && dptr && ((dptr->dctrl | (uptr ? uptr->dctrl : 0)) & dbits)) {
     int32 bufsize = sizeof(stackbuf);
     char *buf = stackbuf;
     int32 i, j, len;
-    const char* debug_prefix = sim_debug_prefix(dbits, dptr, uptr);   /* prefix to print if required */
+    const char* debug_prefix;
 
+    if (sim_deb_switches & SWMASK ('C')) {              /* binary trace? */
+        va_list args;
+        t_bool recorded;
+
+        va_copy (args, arglist);
+        recorded = _sim_debug_trace (dbits, dptr, uptr, fmt, args);
+        va_end (args);
+        if (recorded)
+            return;
+        }
+    debug_prefix = sim_debug_prefix(dbits, dptr, uptr); /* prefix to print if required */
     sim_oline = NULL;                                   /* avoid potential debug to active socket */
     buf[bufsize-1] = '\0';
 
     while (1) {                                         /* format passed string, args */
+        va_list args;
+
+        va_copy (args, arglist);                        /* a retry needs the arguments again */
 #if defined(NO_vsnprintf)
-        len = vsprintf (buf, fmt, arglist);
+        len = vsprintf (buf, fmt, args);
 #else                                                   /* !defined(NO_vsnprintf) */
-        len = vsnprintf (buf, bufsize-1, fmt, arglist);
+        len = vsnprintf (buf, bufsize-1, fmt, args);
 #endif                                                  /* NO_vsnprintf */
+        va_end (args);
 
 /* If the formatted result didn't fit into the buffer, then grow the buffer and try again */
 
@@ -12849,24 +14628,28 @@ if (sim_deb && dptr && ((dptr->dctrl | (uptr ? uptr->dctrl : 0)) & dbits)) {
 
 /* Output the formatted data expanding newlines where they exist */
 
-    for (i = j = 0; i < len; ++i) {
-        if ('\n' == buf[i]) {
-            if (i >= j) {
-                if ((i != j) || (i == 0)) {
-                    if (!debug_unterm)                  /* print prefix when required */
-                        _sim_debug_write (debug_prefix, strlen (debug_prefix));
-                    _sim_debug_write (&buf[j], i-j);
-                    _sim_debug_write ("\r\n", 2);
+    if (sim_deb_switches & SWMASK ('C'))                /* binary trace which couldn't record the arguments? */
+        _sim_debug_trace_formatted (dbits, dptr, uptr, buf, (size_t)len);
+    else {
+        for (i = j = 0; i < len; ++i) {
+            if ('\n' == buf[i]) {
+                if (i >= j) {
+                    if ((i != j) || (i == 0)) {
+                        if (!debug_unterm)              /* print prefix when required */
+                            _sim_debug_write (debug_prefix, strlen (debug_prefix));
+                        _sim_debug_write (&buf[j], i-j);
+                        _sim_debug_write ("\r\n", 2);
+                        }
+                    debug_unterm = 0;
                     }
-                debug_unterm = 0;
+                j = i + 1;
                 }
-            j = i + 1;
             }
-        }
-    if (i > j) {
-        if (!debug_unterm)                          /* print prefix when required */
-            _sim_debug_write (debug_prefix, strlen (debug_prefix));
-        _sim_debug_write (&buf[j], i-j);
+        if (i > j) {
+            if (!debug_unterm)                          /* print prefix when required */
+                _sim_debug_write (debug_prefix, strlen (debug_prefix));
+            _sim_debug_write (&buf[j], i-j);
+            }
         }
 
 /* Set unterminated flag for next time */
@@ -13062,8 +14845,9 @@ if (sim_mfile || (f == sim_deb)) {
         sim_mfile->pos += len;
         }
     else {
-        _sim_debug_write (buf, len);
+        _sim_debug_write (buf, len);                    /* binary trace records the text */
         }
+    ret = len;
 
     if (buf != stackbuf)
         free (buf);
@@ -14648,6 +16432,99 @@ if (sim_rand_seed < 0)
 return (sim_rand_seed - 1);
 }
 
+/* Memory snapshot test: a full snapshot, changes to memory, an incremental
+   snapshot and restores of each must reproduce memory byte for byte */
+
+static t_stat sim_snap_test_compare (const uint8 *mem, const uint8 *image, size_t size, const char *fname)
+{
+size_t i;
+
+for (i = 0; i < size; i++)
+    if (mem[i] != image[i])
+        return sim_messagef (SCPE_IERR, "Memory differs at byte %u after restoring %s: 0x%02X instead of 0x%02X\n", 
+                                        (uint32)i, fname, mem[i], image[i]);
+return SCPE_OK;
+}
+
+static t_stat sim_snap_test (void)
+{
+const char *full = "SnapTestFile1.sav";
+const char *incr = "SnapTestFile2.sav";
+char cmd[CBUFSIZE];
+DEVICE *dptr;
+UNIT *uptr = NULL;
+uint8 *mem = NULL, *saved, *image1, *image2;
+size_t size = 0, i;
+uint32 d, u, seed = 1;
+int32 saved_switches = sim_switches;
+t_stat r = SCPE_OK;
+
+for (d = 0; (sim_vm_mem_image != NULL) && (uptr == NULL) && ((dptr = sim_devices[d]) != NULL); d++)
+    for (u = 0; (uptr == NULL) && (u < dptr->numunits); u++)
+        if ((mem = (uint8 *)sim_vm_mem_image (&dptr->units[u], &size)) != NULL)
+            uptr = &dptr->units[u];
+if ((uptr == NULL) || (size < 8 * SIM_SNAP_PAGE))
+    return SCPE_OK;
+sim_printf ("Testing memory snapshots of %s\n", sim_uname (uptr));
+saved = (uint8 *)malloc (size);
+image1 = (uint8 *)malloc (size);
+image2 = (uint8 *)malloc (size);
+if ((saved == NULL) || (image1 == NULL) || (image2 == NULL)) {
+    free (saved);
+    free (image1);
+    free (image2);
+    return SCPE_MEM;
+    }
+memcpy (saved, mem, size);
+for (i = 0; i < size; i++) {                            /* every fourth page zero */
+    seed = seed * 1103515245 + 12345;
+    mem[i] = ((i / SIM_SNAP_PAGE) % 4) ? (uint8)(seed >> 16) : 0;
+    }
+memcpy (image1, mem, size);
+sim_switches = 0;
+snprintf (cmd, sizeof (cmd), "-B %s", full);
+r = save_cmd (0, cmd);
+if (r == SCPE_OK) {
+    mem[SIM_SNAP_PAGE + 17] ^= 0x01;                    /* one bit changed */
+    memset (mem + 2 * SIM_SNAP_PAGE, 0, SIM_SNAP_PAGE); /* now all zero */
+    memset (mem + 4 * SIM_SNAP_PAGE, 0xA5, 8);          /* no longer all zero */
+    mem[3 * SIM_SNAP_PAGE + 5] ^= 0x80;                 /* changed and changed back */
+    mem[3 * SIM_SNAP_PAGE + 5] ^= 0x80;
+    mem[size - 1] ^= 0xFF;                              /* last byte */
+    memcpy (image2, mem, size);
+    sim_switches = 0;
+    snprintf (cmd, sizeof (cmd), "-I %s", incr);
+    r = save_cmd (0, cmd);
+    }
+if ((r == SCPE_OK) && (sim_fsize_name (incr) >= sim_fsize_name (full) / 2))
+    r = sim_messagef (SCPE_IERR, "Incremental snapshot %s is %u bytes, full snapshot %s is %u bytes\n", 
+                                 incr, (uint32)sim_fsize_name (incr), full, (uint32)sim_fsize_name (full));
+if (r == SCPE_OK) {
+    memset (mem, 0x5A, size);
+    sim_switches = 0;
+    r = restore_cmd (0, incr);
+    }
+if (r == SCPE_OK)
+    r = sim_snap_test_compare (mem, image2, size, incr);
+if (r == SCPE_OK) {
+    memset (mem, 0x5A, size);
+    sim_switches = 0;
+    r = restore_cmd (0, full);
+    }
+if (r == SCPE_OK)
+    r = sim_snap_test_compare (mem, image1, size, full);
+memcpy (mem, saved, size);
+free (saved);
+free (image1);
+free (image2);
+free (sim_snap_last);                                   /* the test files aren't bases */
+sim_snap_last = NULL;
+(void)remove (full);
+(void)remove (incr);
+sim_switches = saved_switches;
+return r;
+}
+
 /*
  * Compiled in unit tests for the various device oriented library 
  * modules: sim_card, sim_disk, sim_tape, sim_ether, sim_tmxr, etc.
@@ -14665,6 +16542,7 @@ if (sim_switches & SWMASK ('D')) {
     sim_set_debon (0, "STDOUT");
     sim_switches = saved_switches;
     }
+stat = sim_snap_test ();
 for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
     t_stat tstat = SCPE_OK;
 
@@ -14681,6 +16559,9 @@ for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
         case DEV_ETHER:
             tstat = sim_ether_test (dptr);
             break;
+        case DEV_MUX:
+            tstat = sim_tmxr_test (dptr);
+            break;
         case DEV_TAPE:
             tstat = sim_tape_test (dptr);
             break;
@@ -287,6 +287,7 @@ t_stat get_aval (t_addr addr, DEVICE *dptr, UNIT *uptr);
 t_value get_rval (REG *rptr, uint32 idx);
 BRKTAB *sim_brk_fnd (t_addr loc);
 uint32 sim_brk_test (t_addr bloc, uint32 btyp);
+#define SIM_BRK_TEST(loc,btyp) (SIM_BRK_MAP_TEST (loc, btyp) ? sim_brk_test (loc, btyp) : 0)
 void sim_brk_clrspc (uint32 spc, uint32 btyp);
 void sim_brk_npc (uint32 cnt);
 void sim_brk_setact (const char *action);
@@ -321,6 +322,9 @@ void sim_debug_bits_hdr (uint32 dbits, DEVICE* dptr, const char *header,
     BITFIELD* bitdefs, uint32 before, uint32 after, int terminate);
 void sim_debug_bits (uint32 dbits, DEVICE* dptr, BITFIELD* bitdefs,
     uint32 before, uint32 after, int terminate);
+void sim_debug_trace_open (void);
+void sim_debug_trace_sync (void);
+void sim_debug_trace_close (void);
 #if defined (__DECC) && defined (__VMS) && (defined (__VAX) || (__DECC_VER < 60590001))
 #define CANT_USE_MACRO_VA_ARGS 1
 #endif
@@ -383,6 +387,7 @@ extern volatile t_bool stop_cpu;
 extern uint32 sim_brk_types;                            /* breakpoint info */
 extern uint32 sim_brk_dflt;
 extern uint32 sim_brk_summ;
+extern uint32 sim_brk_map[SIM_BRK_MAP_SIZE];            /* breakpoint page map */
 extern uint32 sim_brk_match_type;
 extern t_addr sim_brk_match_addr;
 extern BRKTYPTAB *sim_brk_type_desc;                      /* type descriptions */
@@ -420,6 +425,7 @@ extern t_addr (*sim_vm_parse_addr) (DEVICE *dptr, CONST char *cptr, CONST char *
 extern t_bool (*sim_vm_fprint_stopped) (FILE *st, t_stat reason);
 extern t_value (*sim_vm_pc_value) (void);
 extern t_bool (*sim_vm_is_subroutine_call) (t_addr **ret_addrs);
+extern void *(*sim_vm_mem_image) (UNIT *uptr, size_t *size);
 
 /* Core SCP libraries can potentially have unit test routines.
    These defines help implement consistent unit test functionality */
@@ -131,6 +131,7 @@
 #include "sim_tmxr.h"
 #include "sim_serial.h"
 #include "sim_timer.h"
+#include "sim_frontpanel_shmem.h"
 #include <ctype.h>
 #include <math.h>
 
@@ -442,17 +443,20 @@ t_stat sim_rem_con_poll_svc (UNIT *uptr);               /* remote console connec
 t_stat sim_rem_con_data_svc (UNIT *uptr);               /* remote console connection data routine */
 t_stat sim_rem_con_repeat_svc (UNIT *uptr);             /* remote auto repeat command console timing routine */
 t_stat sim_rem_con_smp_collect_svc (UNIT *uptr);        /* remote remote register data sampling routine */
+t_stat sim_rem_con_publish_svc (UNIT *uptr);            /* remote console register publishing routine */
 t_stat sim_rem_con_reset (DEVICE *dptr);                /* remote console reset routine */
 #define rem_con_poll_unit (&sim_remote_console.units[0])
 #define rem_con_data_unit (&sim_remote_console.units[1])
 #define REM_CON_BASE_UNITS 2
 #define rem_con_repeat_units (&sim_remote_console.units[REM_CON_BASE_UNITS])
 #define rem_con_smp_smpl_units (&sim_remote_console.units[REM_CON_BASE_UNITS+sim_rem_con_tmxr.lines])
+#define rem_con_publish_units (&sim_remote_console.units[REM_CON_BASE_UNITS+(2*sim_rem_con_tmxr.lines)])
 
 #define DBG_MOD  0x00000004                             /* Remote Console Mode activities */
 #define DBG_REP  0x00000008                             /* Remote Console Repeat activities */
 #define DBG_SAM  0x00000010                             /* Remote Console Sample activities */
 #define DBG_CMD  0x00000020                             /* Remote Console Command activities */
+#define DBG_PUB  0x00000040                             /* Remote Console Publish activities */
 
 DEBTAB sim_rem_con_debug[] = {
   {"TRC",    DBG_TRC, "routine calls"},
@@ -463,6 +467,7 @@ DEBTAB sim_rem_con_debug[] = {
   {"MODE",   DBG_MOD, "Remote Console Mode activity"},
   {"REPEAT", DBG_REP, "Remote Console Repeat activity"},
   {"SAMPLE", DBG_SAM, "Remote Console Sample activity"},
+  {"PUBLISH",DBG_PUB, "Remote Console Publish activity"},
   {0}
 };
 
@@ -499,6 +504,15 @@ struct BITSAMPLE_REG {
     uint32          width;          /* number of bits to sample */
     BITSAMPLE       *bits;
     };
+typedef struct PUBLISH_REG PUBLISH_REG;
+struct PUBLISH_REG {
+    REG             *reg;           /* Register to be published */
+    uint32          idx;            /* First element published */
+    uint32          count;          /* Number of elements published */
+    t_bool          indirect;       /* Register value points at memory */
+    DEVICE          *dptr;          /* Device register is part of */
+    UNIT            *uptr;          /* Unit Register is related to */
+    };
 typedef struct REMOTE REMOTE;
 struct REMOTE {
     int32           buf_size;
@@ -519,6 +533,12 @@ struct REMOTE {
     int             smp_sample_dither_pct;  /* dithering of cycles interval */
     uint32          smp_reg_count;          /* sample register count */
     BITSAMPLE_REG   *smp_regs;              /* registers being sampled */
+    uint32          pub_interval;           /* usecs between register publications */
+    uint32          pub_reg_count;          /* published register count */
+    PUBLISH_REG     *pub_regs;              /* registers being published */
+    uint32          pub_bit_count;          /* bit sample totals the block can hold */
+    SHMEM           *pub_shmem;             /* shared memory segment */
+    SIM_PANEL_SHMEM *pub_block;             /* published register block */
     };
 REMOTE *sim_rem_consoles = NULL;
 
@@ -651,6 +671,8 @@ for (i=connections=0; i<sim_rem_con_tmxr.lines; i++) {
         if (sim_switches & SWMASK ('D'))
             sim_rem_sample_output (st, rem->line);
         }
+    if (rem->pub_reg_count)
+        fprintf (st, "%d Register Value%s published every %s\n", (int)rem->pub_block->value_count, (rem->pub_block->value_count != 1) ? "s are" : " is", sim_fmt_secs (rem->pub_interval / 1000000.0));
     }
 return SCPE_OK;
 }
@@ -729,6 +751,11 @@ static t_stat x_run_cmd (int32 flag, CONST char *cptr)
 return 7+SCPE_IERR;         /* This routine should never be called */
 }
 
+static t_stat x_publish_cmd (int32 flag, CONST char *cptr)
+{
+return 8+SCPE_IERR;         /* This routine should never be called */
+}
+
 static t_stat x_help_cmd (int32 flag, CONST char *cptr);
 
 static CTAB allowed_remote_cmds[] = {
@@ -753,6 +780,7 @@ static CTAB allowed_remote_cmds[] = {
     { "SET",      &set_cmd,           0 },
     { "SHOW",     &show_cmd,          0 },
     { "HELP",     &x_help_cmd,        0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { NULL,       NULL }
     };
 
@@ -792,6 +820,7 @@ static CTAB allowed_master_remote_cmds[] = {
     { "DEBUG",    &debug_cmd,         1 },
     { "NODEBUG",  &debug_cmd,         0 },
     { "SEND",     &send_cmd,          0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { NULL,       NULL }
     };
 
@@ -813,6 +842,7 @@ static CTAB allowed_single_remote_cmds[] = {
     { "DEBUG",    &debug_cmd,         1 },
     { "NODEBUG",  &debug_cmd,         0 },
     { "HELP",     &x_help_cmd,        0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { NULL,       NULL }
     };
 
@@ -821,6 +851,7 @@ static CTAB remote_only_cmds[] = {
     { "COLLECT",  &x_collect_cmd,     0 },
     { "SAMPLEOUT",&x_sampleout_cmd,   0 },
     { "EXECUTE",  &x_execute_cmd,     0 },
+    { "PUBLISH",  &x_publish_cmd,     0 },
     { NULL,       NULL }
     };
 
@@ -1350,6 +1381,242 @@ if (rem->smp_sample_interval && (rem->smp_reg_count != 0)) {
 return SCPE_OK;
 }
 
+/* Remote console register publishing
+
+   The PUBLISH command makes register values available to a front panel
+   application in a shared memory block (the layout is in sim_frontpanel_shmem.h)
+   which is refreshed every interval while the simulator runs.  The panel
+   reads the block directly rather than issuing EXAMINE commands and
+   parsing the results, so the cost to the simulator is a get_rval per
+   value each interval.  Updates are bracketed by the block's sequence
+   count (odd while updating) so that a reader can detect and retry a copy
+   which overlapped an update.
+*/
+
+#if defined(_MSC_VER)
+#define PUB_BARRIER() MemoryBarrier ()
+#elif defined(__GNUC__)
+#define PUB_BARRIER() __sync_synchronize ()
+#else
+#define PUB_BARRIER()
+#endif
+
+static void sim_rem_publish_registers (REMOTE *rem)
+{
+SIM_PANEL_SHMEM *blk = rem->pub_block;
+uint32 i, j, bits = 0;
+unsigned long long *val = blk->values;
+
+for (i = 0; i < rem->smp_reg_count; i++)
+    bits += 1 + rem->smp_regs[i].width;
+blk->sequence = blk->sequence + 1;                  /* odd - update in progress */
+PUB_BARRIER ();
+blk->simulation_time = (unsigned long long)sim_gtime ();
+for (i = 0; i < rem->pub_reg_count; i++) {
+    PUBLISH_REG *preg = &rem->pub_regs[i];
+
+    for (j = 0; j < preg->count; j++) {
+        t_value rval = get_rval (preg->reg, preg->idx + j);
+
+        if (preg->indirect)
+            rval = (get_aval ((t_addr)rval, preg->dptr, preg->uptr) == SCPE_OK) ? sim_eval[0] : 0;
+        *val++ = (unsigned long long)rval;
+        }
+    }
+if (bits > rem->pub_bit_count)                      /* COLLECT changed since PUBLISH? */
+    bits = 0;                                       /* omit the sample totals */
+blk->bit_count = bits;
+for (i = 0; bits && (i < rem->smp_reg_count); i++) {
+    *val++ = (unsigned long long)rem->smp_regs[i].width;
+    for (j = 0; j < rem->smp_regs[i].width; j++)
+        *val++ = (unsigned long long)rem->smp_regs[i].bits[j].tot;
+    }
+blk->updates = blk->updates + 1;
+PUB_BARRIER ();
+blk->sequence = blk->sequence + 1;                  /* even - update complete */
+}
+
+t_stat sim_rem_con_publish_svc (UNIT *uptr)
+{
+int line = uptr - rem_con_publish_units;
+REMOTE *rem = &sim_rem_consoles[line];
+
+sim_debug (DBG_PUB, &sim_remote_console, "sim_rem_con_publish_svc(line=%d) - interval=%d usecs\n", line, rem->pub_interval);
+if (rem->pub_interval && rem->pub_block) {
+    sim_rem_publish_registers (rem);
+    sim_activate_after (uptr, rem->pub_interval);   /* reschedule */
+    }
+return SCPE_OK;
+}
+
+/* 
+    Parse and setup Remote Console PUBLISH command:
+       PUBLISH name EVERY nnn USECS reg{,reg...}
+       PUBLISH STOP {ALL}
+ */
+static t_stat sim_rem_publish_cmd_setup (int32 line, CONST char **iptr)
+{
+char gbuf[CBUFSIZE], name[CBUFSIZE];
+int32 usecs;
+uint32 i, value_count = 0, bit_count = 0, reg_count = 0;
+t_bool all_stop = FALSE;
+t_stat stat = SCPE_OK;
+CONST char *cptr = *iptr;
+REMOTE *rem = &sim_rem_consoles[line];
+PUBLISH_REG *pub_regs = NULL;
+void *addr;
+
+sim_debug (DBG_PUB, &sim_remote_console, "Publish Setup: %s\n", cptr);
+if (*cptr == 0)         /* required argument? */
+    return SCPE_2FARG;
+cptr = get_glyph_nc (cptr, name, 0);            /* get segment name */
+if (MATCH_CMD (name, "STOP") == 0) {
+    if (*cptr) {                                /* more command arguments? */
+        cptr = get_glyph (cptr, gbuf, 0);       /* get next glyph */
+        if ((MATCH_CMD (gbuf, "ALL") != 0) ||   /*  */
+            (*cptr != 0)                   ||   /*  */
+            (line != 0))                        /* master line? */
+            stat = SCPE_ARG;
+        else
+            all_stop = TRUE;
+        }
+    if (stat == SCPE_OK) {
+        for (line = all_stop ? 0 : rem->line; line < (all_stop ? sim_rem_con_tmxr.lines : (rem->line + 1)); line++) {
+            rem = &sim_rem_consoles[line];
+            sim_cancel (&rem_con_publish_units[rem->line]);
+            sim_shmem_close (rem->pub_shmem);
+            rem->pub_shmem = NULL;
+            rem->pub_block = NULL;
+            free (rem->pub_regs);
+            rem->pub_regs = NULL;
+            rem->pub_reg_count = 0;
+            rem->pub_bit_count = 0;
+            rem->pub_interval = 0;
+            }
+        }
+    *iptr = cptr;
+    return stat;
+    }
+cptr = get_glyph (cptr, gbuf, 0);               /* get next glyph */
+if (MATCH_CMD (gbuf, "EVERY") != 0) {
+    *iptr = cptr;
+    return sim_messagef (SCPE_ARG, "Expected EVERY found: %s\n", gbuf);
+    }
+cptr = get_glyph (cptr, gbuf, 0);               /* get next glyph */
+usecs = (int32) get_uint (gbuf, 10, INT_MAX, &stat);
+if ((stat != SCPE_OK) || (usecs <= 0)) {        /* error? */
+    *iptr = cptr;
+    return sim_messagef (SCPE_ARG, "Expected value found: %s\n", gbuf);
+    }
+cptr = get_glyph (cptr, gbuf, 0);               /* get next glyph */
+if ((MATCH_CMD (gbuf, "USECS") != 0) || (*cptr == 0)) {
+    *iptr = cptr;
+    return sim_messagef (SCPE_ARG, "Expected USECS found: %s\n", gbuf);
+    }
+while (cptr && *cptr) {
+    const char *comma = strchr (cptr, ',');
+    char tbuf[2*CBUFSIZE];
+    CONST char *tptr;
+    REG *reg;
+    uint32 lo = 0, hi = 0;
+    int32 saved_switches = sim_switches;
+    t_bool indirect;
+    PUBLISH_REG *tregs;
+
+    if (comma) {
+        size_t len = (size_t)(comma - cptr);
+
+        if (len >= sizeof (tbuf))
+            len = sizeof (tbuf) - 1;
+        memcpy (tbuf, cptr, len);
+        tbuf[len] = '\0';
+        cptr = comma + 1;
+        }
+    else {
+        strlcpy (tbuf, cptr, sizeof (tbuf));
+        cptr += strlen (cptr);
+        }
+    tptr = get_sim_opt (CMD_OPT_SW|CMD_OPT_DFT, tbuf, &stat); /* get switches and device */
+    indirect = ((sim_switches & SWMASK('I')) != 0);
+    sim_switches = saved_switches;
+    if (stat != SCPE_OK)
+        break;
+    tptr = get_glyph (tptr, gbuf, 0);           /* get register name */
+    reg = find_reg (gbuf, &tptr, sim_dfdev);
+    if (reg == NULL) {
+        stat = sim_messagef (SCPE_NXREG, "Nonexistent Register: %s\n", gbuf);
+        break;
+        }
+    if (*tptr == '[') {                         /* subscript or range? */
+        CONST char *tgptr = ++tptr;
+
+        if (reg->depth <= 1) {                  /* array register? */
+            stat = sim_messagef (SCPE_SUB, "Not Array Register: %s\n", reg->name);
+            break;
+            }
+        lo = hi = (uint32) strtotv (tgptr, &tptr, 10);
+        if ((tgptr != tptr) && (*tptr == ':')) {
+            tgptr = ++tptr;
+            hi = (uint32) strtotv (tgptr, &tptr, 10);
+            }
+        if ((tgptr == tptr) || (*tptr++ != ']')) {
+            stat = sim_messagef (SCPE_SUB, "Missing or Invalid Register Subscript: %s[%s\n", reg->name, tgptr);
+            break;
+            }
+        if ((hi < lo) || (hi >= reg->depth)) {  /* validate subscripts */
+            stat = sim_messagef (SCPE_SUB, "Invalid Register Subscript: %s[%d:%d]\n", reg->name, lo, hi);
+            break;
+            }
+        }
+    tregs = (PUBLISH_REG *)realloc (pub_regs, (reg_count + 1) * sizeof (*pub_regs));
+    if (tregs == NULL) {
+        stat = SCPE_MEM;
+        break;
+        }
+    pub_regs = tregs;
+    pub_regs[reg_count].reg = reg;
+    pub_regs[reg_count].idx = lo;
+    pub_regs[reg_count].count = hi - lo + 1;
+    pub_regs[reg_count].indirect = indirect;
+    pub_regs[reg_count].dptr = sim_dfdev;
+    pub_regs[reg_count].uptr = sim_dfunit;
+    value_count += hi - lo + 1;
+    ++reg_count;
+    }
+if (stat != SCPE_OK) {
+    free (pub_regs);
+    *iptr = cptr;
+    return stat;
+    }
+{
+CONST char *tptr = strcpy (gbuf, "STOP");       /* Start from a clean slate */
+
+sim_rem_publish_cmd_setup (rem->line, &tptr);
+}
+for (i = 0; i < rem->smp_reg_count; i++)
+    bit_count += 1 + rem->smp_regs[i].width;
+stat = sim_shmem_open (name, SIM_PANEL_SHMEM_SIZE (value_count + bit_count), &rem->pub_shmem, &addr);
+if (stat != SCPE_OK) {
+    free (pub_regs);
+    *iptr = cptr;
+    return stat;
+    }
+rem->pub_block = (SIM_PANEL_SHMEM *)addr;
+rem->pub_block->magic = SIM_PANEL_SHMEM_MAGIC;
+rem->pub_block->version = SIM_PANEL_SHMEM_VERSION;
+rem->pub_block->sequence = 0;
+rem->pub_block->value_count = value_count;
+rem->pub_block->bit_count = 0;
+rem->pub_block->updates = 0;
+rem->pub_regs = pub_regs;
+rem->pub_reg_count = reg_count;
+rem->pub_bit_count = bit_count;
+rem->pub_interval = usecs;
+sim_rem_publish_registers (rem);                /* initial contents */
+*iptr = cptr;
+return sim_activate_after (&rem_con_publish_units[rem->line], rem->pub_interval);
+}
+
 /* Unit service for remote console data polling */
 
 t_stat sim_rem_con_data_svc (UNIT *uptr)
@@ -1385,6 +1652,10 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
             cptr = strcpy (gbuf, "STOP");
             sim_rem_collect_cmd_setup (i, &cptr);   /* make sure it is now disabled */
             }
+        if (rem->pub_reg_count) {                   /* were registers being published? */
+            cptr = strcpy (gbuf, "STOP");
+            sim_rem_publish_cmd_setup (i, &cptr);   /* make sure it is now disabled */
+            }
         continue;
         }
     if (master_session && !sim_rem_master_was_connected) {
@@ -1746,16 +2017,22 @@ for (i=(was_active_command ? sim_rem_cmd_active_line : 0);
                                             stat = sim_rem_collect_cmd_setup (i, &cptr);
                                             }
                                         else {
-                                            if (sim_con_stable_registers && 
-                                                sim_rem_master_mode) {  /* can we process command now? */
-                                                sim_debug (DBG_CMD, &sim_remote_console, "Processing Command directly\n");
-                                                sim_oline = lp;         /* specify output socket */
-                                                sim_remote_process_command ();
-                                                stat = SCPE_OK;         /* any message has already been emitted */
+                                            if (cmdp->action == &x_publish_cmd) {
+                                                sim_debug (DBG_CMD, &sim_remote_console, "publish_cmd executing\n");
+                                                stat = sim_rem_publish_cmd_setup (i, &cptr);
                                                 }
                                             else {
-                                                sim_debug (DBG_CMD, &sim_remote_console, "Processing Command via SCPE_REMOTE\n");
-                                                stat = SCPE_REMOTE;     /* force processing outside of sim_instr() */
+                                                if (sim_con_stable_registers && 
+                                                    sim_rem_master_mode) {  /* can we process command now? */
+                                                    sim_debug (DBG_CMD, &sim_remote_console, "Processing Command directly\n");
+                                                    sim_oline = lp;         /* specify output socket */
+                                                    sim_remote_process_command ();
+                                                    stat = SCPE_OK;         /* any message has already been emitted */
+                                                    }
+                                                else {
+                                                    sim_debug (DBG_CMD, &sim_remote_console, "Processing Command via SCPE_REMOTE\n");
+                                                    stat = SCPE_REMOTE;     /* force processing outside of sim_instr() */
+                                                    }
                                                 }
                                             }
                                         }
@@ -1868,6 +2145,8 @@ if (sim_rem_con_tmxr.lines) {
             sim_activate_after (&rem_con_repeat_units[rem->line], rem->repeat_interval);    /* schedule */
         if (rem->smp_reg_count)
             sim_activate (&rem_con_smp_smpl_units[rem->line], rem->smp_sample_interval);    /* schedule */
+        if (rem->pub_interval)
+            sim_activate_after (&rem_con_publish_units[rem->line], rem->pub_interval);      /* schedule */
         }
     if (i != sim_rem_con_tmxr.lines)
         sim_activate_after (rem_con_data_unit, 100000);     /* continue polling for open sessions */
@@ -1940,13 +2219,16 @@ for (i=0; i<sim_rem_con_tmxr.lines; i++) {
     free (rem->repeat_action);
     sim_cancel (&rem_con_repeat_units[i]);
     sim_cancel (&rem_con_smp_smpl_units[i]);
+    sim_cancel (&rem_con_publish_units[i]);
+    free (rem->pub_regs);
+    sim_shmem_close (rem->pub_shmem);
     }
 sim_rem_con_tmxr.lines = lines;
 sim_rem_con_tmxr.ldsc = (TMLN *)realloc (sim_rem_con_tmxr.ldsc, sizeof(*sim_rem_con_tmxr.ldsc)*lines);
 memset (sim_rem_con_tmxr.ldsc, 0, sizeof(*sim_rem_con_tmxr.ldsc)*lines);
-sim_remote_console.units = (UNIT *)realloc (sim_remote_console.units, sizeof(*sim_remote_console.units)*((2 * lines) + REM_CON_BASE_UNITS));
-memset (sim_remote_console.units, 0, sizeof(*sim_remote_console.units)*((2 * lines) + REM_CON_BASE_UNITS));
-sim_remote_console.numunits = (2 * lines) + REM_CON_BASE_UNITS;
+sim_remote_console.units = (UNIT *)realloc (sim_remote_console.units, sizeof(*sim_remote_console.units)*((3 * lines) + REM_CON_BASE_UNITS));
+memset (sim_remote_console.units, 0, sizeof(*sim_remote_console.units)*((3 * lines) + REM_CON_BASE_UNITS));
+sim_remote_console.numunits = (3 * lines) + REM_CON_BASE_UNITS;
 rem_con_poll_unit->action = &sim_rem_con_poll_svc;/* remote console connection polling unit */
 rem_con_poll_unit->flags |= UNIT_IDLE;
 rem_con_data_unit->action = &sim_rem_con_data_svc;/* console data handling unit */
@@ -1960,6 +2242,8 @@ for (i=0; i<lines; i++) {
     rem_con_repeat_units[i].action = &sim_rem_con_repeat_svc;
     rem_con_smp_smpl_units[i].flags = UNIT_DIS;
     rem_con_smp_smpl_units[i].action = &sim_rem_con_smp_collect_svc;
+    rem_con_publish_units[i].flags = UNIT_DIS;
+    rem_con_publish_units[i].action = &sim_rem_con_publish_svc;
     rem = &sim_rem_consoles[i];
     rem->line = i;
     rem->lp = &sim_rem_con_tmxr.ldsc[i];
@@ -2253,7 +2537,7 @@ sim_deb_switches = switches &
                     SWMASK ('T') | SWMASK ('A') | 
                     SWMASK ('F') | SWMASK ('N') |
                     SWMASK ('B') | SWMASK ('E') |
-                    SWMASK ('D') );                 /* save debug switches */
+                    SWMASK ('D') | SWMASK ('C') );  /* save debug switches */
 return old_deb_switches;
 }
 
@@ -2268,6 +2552,8 @@ size_t buffer_size;
 
 if ((cptr == NULL) || (*cptr == 0))                     /* need arg */
     return SCPE_2FARG;
+if ((sim_switches & SWMASK ('B')) && (sim_switches & SWMASK ('C')))
+    return sim_messagef (SCPE_ARG, "Binary debug trace output can't be written to a memory buffer\n");
 if (sim_switches & SWMASK ('B')) {
     cptr = get_glyph_nc (cptr, gbuf, 0);                /* buffer size */
     buffer_size = (size_t)strtoul (gbuf, NULL, 10);
@@ -2277,10 +2563,19 @@ if (sim_switches & SWMASK ('B')) {
 cptr = get_glyph_nc (cptr, gbuf, 0);                    /* get file name */
 if (*cptr != 0)                                         /* now eol? */
     return SCPE_2MARG;
-r = sim_open_logfile (gbuf, FALSE, &sim_deb, &sim_deb_ref);
+sim_debug_trace_sync ();                                /* finish any active trace */
+if (sim_switches & SWMASK ('C'))                        /* binary trace? */
+    sim_switches |= SWMASK ('N');                       /*   always starts a new file */
+r = sim_open_logfile (gbuf, (sim_switches & SWMASK ('C')) != 0, &sim_deb, &sim_deb_ref);
 
 if (r != SCPE_OK)
     return r;
+if ((sim_switches & SWMASK ('C')) &&                    /* binary trace not to a file? */
+    ((sim_deb_ref == NULL) || (sim_deb == sim_log))) {
+    sim_close_logfile (&sim_deb_ref);
+    sim_deb = NULL;
+    return sim_messagef (SCPE_ARG, "Binary debug trace output must be written to a file\n");
+    }
 
 sim_set_deb_switches (sim_switches);
 
@@ -2297,6 +2592,8 @@ if (sim_deb_switches & SWMASK ('R')) {
     if (!(sim_deb_switches & (SWMASK ('A') | SWMASK ('T'))))
         sim_deb_switches |= SWMASK ('T');
     }
+if (sim_deb_switches & SWMASK ('C'))
+    sim_debug_trace_open ();
 sim_messagef (SCPE_OK, "Debug output to \"%s\"\n", sim_logfile_name (sim_deb, sim_deb_ref));
 if (sim_deb_switches & SWMASK ('P'))
     sim_messagef (SCPE_OK, "   Debug messages contain current PC value\n");
@@ -2311,6 +2608,8 @@ if (sim_deb_switches & SWMASK ('E'))
 if (sim_deb_switches & SWMASK ('B'))
     sim_messagef (SCPE_OK, "   Debug messages will be written to a %u MB circular memory buffer\n", 
                                 (unsigned int)buffer_size);
+if (sim_deb_switches & SWMASK ('C'))
+    sim_messagef (SCPE_OK, "   Debug messages will be recorded in binary form for debugtracedecode\n");
 time(&now);
 if (!sim_quiet) {
     fprintf (sim_deb, "Debug output to \"%s\" at %s", sim_logfile_name (sim_deb, sim_deb_ref), ctime(&now));
@@ -2337,6 +2636,8 @@ if (cptr && (*cptr != 0))                               /* now eol? */
     return SCPE_2MARG;
 if (sim_deb == NULL)                                    /* no debug? */
     return SCPE_OK;
+sim_debug_trace_sync ();                                /* write any buffered trace */
+sim_debug_trace_close ();                               /*   and free this thread's buffer */
 if (sim_deb_switches & SWMASK ('B')) {
     size_t offset = (sim_debug_buffer_inuse == sim_deb_buffer_size) ? sim_debug_buffer_offset : 0;
     const char *bufmsg = "Circular Buffer Contents follow here:\n\n";
@@ -2383,6 +2684,8 @@ if (sim_deb) {
         fprintf (st, "   Debug messages are not being filtered to summarize duplicate lines\n");
     if (sim_deb_switches & SWMASK ('E'))
         fprintf (st, "   Debug messages containing blob data in EBCDIC will display in readable form\n");
+    if (sim_deb_switches & SWMASK ('C'))
+        fprintf (st, "   Debug messages are being recorded in binary form for debugtracedecode\n");
     for (i = 0; (dptr = sim_devices[i]) != NULL; i++) {
         t_bool unit_debug = FALSE;
         uint32 unit;
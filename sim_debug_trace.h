@@ -0,0 +1,251 @@
+/* sim_debug_trace.h: binary debug trace file definitions
+
+   Copyright (c) 2026, The SIMH authors
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+   THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   This module defines the layout of the binary debug trace files written
+   by SET DEBUG -C and read by the debugtracedecode tool
+   (debugtrace/DebugTraceDecode.c).  It is included by both and so depends
+   only on the C library.
+
+   A trace file is a sequence of records, each starting with:
+
+        byte 0          SIM_DTRC_SYNC
+        byte 1          record type
+        bytes 2-3       record length, including these 4 bytes (most
+                        significant byte first)
+
+   The other multi-byte values are in the byte order of the host which
+   wrote the file (the header records it) and are unaligned.
+
+   SIM_DTRC_HEADER     begins the file
+        uint32          SIM_DTRC_BYTE_ORDER
+        uint32          SIM_DTRC_VERSION
+        uint32          debug switches (sim_deb_switches)
+        int64, int32    debug base time (seconds, nanoseconds)
+        uint32          PC register radix
+        uint32          PC register width
+        uint32          PC register print format (PV_xxx)
+        uint32          size of t_value in bytes
+        char[]          PC register name (NUL terminated)
+        char[]          simulator name (NUL terminated)
+
+   SIM_DTRC_STRING     defines the text of a string id
+        uint32          id
+        char[]          text (not NUL terminated)
+
+   SIM_DTRC_EVENT      one sim_debug call
+        uint32          format string id
+        uint32          device name string id
+        uint32          debug flag name string id
+        uint32          SIM_DTRC_F_xxx flags
+        double          sim_gtime ()
+        int64, int32    time of day (if SIM_DTRC_F_TIME)
+        uint64          PC value (if SIM_DTRC_F_PC)
+        ...             the arguments consumed by the format, in order,
+                        stored as described by sim_debug_trace_spec
+
+   SIM_DTRC_TEXT       output written with fprintf (sim_deb, ...)
+        uint32          format string id
+        ...             the arguments consumed by the format
+
+   SIM_DTRC_FLUSH      debug output was flushed (ends duplicate line
+                        summarization)
+
+   String ids are assigned as a string is first seen and its STRING
+   record may follow the first event which refers to it, so a reader
+   collects the strings before rendering events.  A sim_debug call whose
+   format can't be given an id, or whose arguments can't all be stored
+   (see SIM_DTRC_ARG_TEXT), is formatted when it is made and recorded as
+   one or more events with the format "%s".  fprintf (sim_deb, ...) output
+   is always formatted when it is written, so TEXT records hold "%s" and
+   the text.
+
+   Text written directly to the debug FILE by other means (fwrite) appears
+   between records and is passed through by the decoder.  SIM_DTRC_SYNC
+   (ASCII RS) doesn't occur in debug text.
+*/
+
+#ifndef SIM_DEBUG_TRACE_H_
+#define SIM_DEBUG_TRACE_H_    0
+
+#include <string.h>
+
+#define SIM_DTRC_SYNC           0x1E
+#define SIM_DTRC_HEADER         1
+#define SIM_DTRC_STRING         2
+#define SIM_DTRC_EVENT          3
+#define SIM_DTRC_FLUSH          4
+#define SIM_DTRC_TEXT           5
+#define SIM_DTRC_HDR_SIZE       4
+#define SIM_DTRC_MAX_RECORD     4096                    /* longest record written */
+#define SIM_DTRC_BYTE_ORDER     0x01020304
+#define SIM_DTRC_VERSION        1
+
+#define SIM_DTRC_F_THREAD       0x01                    /* not the main thread */
+#define SIM_DTRC_F_TIME         0x02                    /* time of day present */
+#define SIM_DTRC_F_PC           0x04                    /* PC value present */
+
+/* Argument classes, with their stored form */
+
+#define SIM_DTRC_ARG_NONE       0                       /* %% - nothing */
+#define SIM_DTRC_ARG_INT        1                       /* int - 4 bytes */
+#define SIM_DTRC_ARG_LONG       2                       /* long, long long, size_t - 8 bytes */
+#define SIM_DTRC_ARG_DOUBLE     3                       /* double - 8 bytes */
+#define SIM_DTRC_ARG_STRING     4                       /* char * - uint16 length + text */
+#define SIM_DTRC_ARG_POINTER    5                       /* void * - 8 bytes */
+#define SIM_DTRC_ARG_SKIP       6                       /* %n - consumed, not stored */
+#define SIM_DTRC_ARG_TEXT       7                       /* long double, wide character or string - */
+                                                        /*   the call is recorded as formatted text */
+
+typedef struct SIM_DTRC_SPEC {
+    const char  *start;                                 /* the '%' */
+    const char  *end;                                   /* past the conversion character */
+    const char  *flags;                                 /* flag characters */
+    size_t      flags_len;
+    int         width_star;                             /* width is an int argument */
+    const char  *width;                                 /* width digits */
+    size_t      width_len;
+    int         has_prec;                               /* precision present */
+    int         prec_star;                              /* precision is an int argument */
+    const char  *prec;                                  /* precision digits */
+    size_t      prec_len;
+    const char  *mods;                                  /* length modifier characters */
+    size_t      mods_len;
+    int         is_long;                                /* 1 - l, 2 - ll/q/j/I64, 3 - z/t */
+    int         is_signed;                              /* signed integer conversion */
+    char        conv;                                   /* conversion character */
+    int         cls;                                    /* SIM_DTRC_ARG_xxx */
+    } SIM_DTRC_SPEC;
+
+/* Find the next conversion in a printf format.  Returns NULL when there
+   are no more.  Unrecognized conversions are classified as NONE and are
+   rendered literally. */
+
+static const char *sim_debug_trace_spec (const char *fmt, SIM_DTRC_SPEC *spec)
+{
+const char *c = strchr (fmt, '%');
+int big = 0;
+
+if (c == NULL)
+    return NULL;
+memset (spec, 0, sizeof (*spec));
+spec->start = c++;
+spec->flags = c;
+while (*c && strchr ("-+ #0'", *c))
+    ++c;
+spec->flags_len = (size_t)(c - spec->flags);
+if (*c == '*') {
+    spec->width_star = 1;
+    ++c;
+    }
+else {
+    spec->width = c;
+    while ((*c >= '0') && (*c <= '9'))
+        ++c;
+    spec->width_len = (size_t)(c - spec->width);
+    }
+if (*c == '.') {
+    spec->has_prec = 1;
+    ++c;
+    if (*c == '*') {
+        spec->prec_star = 1;
+        ++c;
+        }
+    else {
+        spec->prec = c;
+        while ((*c >= '0') && (*c <= '9'))
+            ++c;
+        spec->prec_len = (size_t)(c - spec->prec);
+        }
+    }
+spec->mods = c;
+for (;;) {                                              /* length modifiers */
+    if (*c == 'h') {
+        ++c;
+        continue;
+        }
+    if (*c == 'L') {
+        big = 1;
+        ++c;
+        continue;
+        }
+    if (*c == 'l') {
+        spec->is_long = spec->is_long ? 2 : 1;
+        ++c;
+        continue;
+        }
+    if ((*c == 'q') || (*c == 'j')) {
+        spec->is_long = 2;
+        ++c;
+        continue;
+        }
+    if ((*c == 'z') || (*c == 't')) {
+        spec->is_long = 3;
+        ++c;
+        continue;
+        }
+    if ((c[0] == 'I') && (c[1] == '6') && (c[2] == '4')) {
+        spec->is_long = 2;
+        c += 3;
+        continue;
+        }
+    if ((c[0] == 'I') && (c[1] == '3') && (c[2] == '2')) {
+        c += 3;
+        continue;
+        }
+    break;
+    }
+spec->mods_len = (size_t)(c - spec->mods);
+spec->conv = *c;
+switch (*c) {
+    case 'd': case 'i':
+        spec->is_signed = 1;
+        /* fall through */
+    case 'o': case 'u': case 'x': case 'X':
+        spec->cls = spec->is_long ? SIM_DTRC_ARG_LONG : SIM_DTRC_ARG_INT;
+        break;
+    case 'c':
+        spec->cls = SIM_DTRC_ARG_INT;
+        break;
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+        spec->cls = SIM_DTRC_ARG_DOUBLE;
+        break;
+    case 's':
+        spec->cls = SIM_DTRC_ARG_STRING;
+        break;
+    case 'p':
+        spec->cls = SIM_DTRC_ARG_POINTER;
+        break;
+    case 'n':
+        spec->cls = SIM_DTRC_ARG_SKIP;
+        break;
+    default:                                            /* %% or unknown */
+        spec->cls = SIM_DTRC_ARG_NONE;
+        break;
+    }
+if (big ||                                              /* long double (or L integer)? */
+    (spec->is_long && ((*c == 'c') || (*c == 's'))))    /* wint_t or wchar_t string? */
+    spec->cls = SIM_DTRC_ARG_TEXT;
+spec->end = *c ? c + 1 : c;
+return spec->end;
+}
+
+#endif /* SIM_DEBUG_TRACE_H_ */
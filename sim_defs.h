@@ -600,6 +600,9 @@ struct UNIT {
     char                *uname;                         /* Unit name */
     DEVICE              *dptr;                          /* DEVICE linkage (backpointer) */
     uint32              dctrl;                          /* debug control */
+    double              event_due;                      /* absolute due time (heap event queue) */
+    t_uint64            event_seq;                      /* activation sequence (heap event queue) */
+    int32               event_slot;                     /* heap position (heap event queue) */
 #ifdef SIM_ASYNCH_IO
     void                (*a_check_completion)(UNIT *);
     t_bool              (*a_is_active)(UNIT *);
@@ -653,6 +656,7 @@ struct UNIT {
 #define UNIT_TM_POLL        0000002         /* TMXR Polling unit */
 #define UNIT_NO_FIO         0000004         /* fileref is NOT a FILE * */
 #define UNIT_DISK_CHK       0000010         /* disk data debug checking (sim_disk) */
+#define UNIT_DISK_CDK       0000020         /* disk is a CDK container (sim_disk) */
 #define UNIT_TMR_UNIT       0000200         /* Unit registered as a calibrated timer */
 #define UNIT_TAPE_MRK       0000400         /* Tape Unit AWS Tapemark */
 #define UNIT_TAPE_PNU       0001000         /* Tape Unit Position Not Updated */
@@ -795,6 +799,21 @@ struct BRKTAB {
     BRKTAB *next;                                       /* list with same address value */
     };
 
+/* Breakpoint page map
+
+   sim_brk_map is a hashed summary of the types of the breakpoints which
+   exist on each page of addresses.  A zero result from SIM_BRK_MAP_TEST
+   proves that no breakpoint of the requested types is set anywhere on 
+   the page containing loc.  A non zero result may be a hash collision
+   and requires a full sim_brk_test. */
+
+#define SIM_BRK_PAGE_SHIFT      8                       /* log2 addresses per page */
+#define SIM_BRK_MAP_SIZE        4096                    /* map slots (power of 2) */
+#define SIM_BRK_MAP_SLOT(loc)   (((uint32)((loc) >> SIM_BRK_PAGE_SHIFT) ^           \
+                                  (uint32)((loc) >> (SIM_BRK_PAGE_SHIFT + 12))) &   \
+                                 (SIM_BRK_MAP_SIZE - 1))
+#define SIM_BRK_MAP_TEST(loc,btyp) (sim_brk_map[SIM_BRK_MAP_SLOT (loc)] & ((btyp) | BRK_TYP_DYN_ALL))
+
 /* Breakpoint table */
 
 struct BRKTYPTAB {
@@ -819,6 +838,9 @@ struct EXPTAB {
 #define EXP_TYP_TIME            (SWMASK ('T'))      /* halt delay is in microseconds instead of instructions */
 #if defined(USE_REGEX)
     regex_t             regex;                          /* compiled regular expression */
+    regex_t             regex_nosub;                    /* compiled without sub expressions for match detection */
+    regmatch_t          *matches;                       /* sub expression match offsets */
+    uint32              window;                         /* longest text the expression can match (0 if unbounded) */
 #endif
     char                *act;                           /* action string */
     };
@@ -834,6 +856,15 @@ struct EXPECT {
     uint32              buf_ins;                        /* buffer insertion point for the next output data */
     uint32              buf_size;                       /* buffer size */
     uint32              buf_data;                       /* count of data in buffer */
+    t_bool              compiled;                       /* rules have been compiled into the match state below */
+    uint32              *lit_next;                      /* literal rule automaton transitions (256 per state) */
+    int32               *lit_rule;                      /* lowest numbered literal rule matched in each state (or -1) */
+    uint32              lit_state;                      /* current literal rule automaton state */
+    int32               regex_rules;                    /* count of RegEx rules */
+    char                *rbuf;                          /* NUL free output data for RegEx rules */
+    uint32              rbuf_ins;                       /* RegEx buffer insertion point */
+    uint32              rbuf_size;                      /* RegEx buffer size */
+    t_bool              regex_full;                     /* next check searches all of the RegEx buffer */
     };
 
 /* Send Context */
@@ -1083,6 +1114,7 @@ extern pthread_mutex_t sim_tmxr_poll_lock;
 extern pthread_t sim_asynch_main_threadid;
 extern UNIT * volatile sim_asynch_queue;
 extern volatile t_bool sim_idle_wait;
+extern volatile t_bool sim_asynch_pending;
 extern int32 sim_asynch_check;
 extern int32 sim_asynch_latency;
 extern int32 sim_asynch_inst_latency;
@@ -1168,10 +1200,11 @@ extern int32 sim_asynch_inst_latency;
 #undef USE_AIO_INTRINSICS
 #endif
 #ifdef USE_AIO_INTRINSICS
-/* This approach uses intrinsics to manage access to the link list head     */
-/* sim_asynch_queue.  This implementation is a completely lock free design  */
-/* which avoids the potential ABA issues.                                   */
-#define AIO_QUEUE_MODE "Lock free asynchronous event queue"
+/* This approach uses intrinsics to manage a multi-producer ring of pending */
+/* unit activations (with the sim_asynch_queue list head as overflow).      */
+/* This implementation is a completely lock free design which avoids the    */
+/* potential ABA issues.                                                    */
+#define AIO_QUEUE_MODE "Lock free asynchronous completion ring"
 #define AIO_INIT                                                  \
     do {                                                          \
       int tmr;                                                    \
@@ -1250,6 +1283,7 @@ extern int32 sim_asynch_inst_latency;
     if (!pthread_equal ( pthread_self(), sim_asynch_main_threadid )) { \
       sim_debug (SIM_DBG_AIO_QUEUE, sim_dflt_dev, "Queueing Asynch event for %s after %d instructions\n", sim_uname(uptr), event_time);\
       AIO_LOCK;                                                        \
+      sim_asynch_pending = TRUE;                                       \
       if (uptr->a_next) {                       /* already queued? */  \
         uptr->a_activate_call = sim_activate_abs;                      \
       } else {                                                         \
@@ -1274,7 +1308,7 @@ extern int32 sim_asynch_inst_latency;
       abort();                                                         \
       } else (void)0
 #define AIO_CHECK_EVENT                                                \
-    if (0 > --sim_asynch_check) {                                      \
+    if (sim_asynch_pending && (0 > --sim_asynch_check)) {              \
       AIO_UPDATE_QUEUE;                                                \
       sim_asynch_check = sim_asynch_inst_latency;                      \
       } else (void)0
@@ -85,6 +85,41 @@ Internal routines:
 #include <pthread.h>
 #endif
 
+/* Hosts on which the SimH and RAW formats use positional I/O (pread/pwrite).
+   Positional transfers don't share a file position, so several requests
+   for the same unit can safely be in flight at the same time.  They use
+   the container's descriptor directly, so anything stdio has buffered
+   for it is flushed once when the unit enters positional mode rather
+   than before each transfer (see _disk_positional_start). */
+#if defined (__linux) || defined (__linux__) || defined (__APPLE__)|| defined (__sun) || defined (__sun__) || defined (__hpux) || defined (_AIX)
+#include <unistd.h>
+#define DISK_POSITIONAL_IO 1
+#define DISK_MMAP_IO 1                      /* SimH format containers can be memory mapped */
+#endif
+
+#if defined SIM_ASYNCH_IO
+#define DISK_AIO_QUEUE_DEPTH    16          /* outstanding requests per unit */
+#define DISK_AIO_THREADS        4           /* I/O threads per unit */
+
+struct disk_aio_request {
+    int                 dop;                /* operation (DOP_xxx) */
+    int                 done;               /* I/O completed */
+    uint8               *buf;
+    t_seccnt            *rsects;
+    t_seccnt            sects;
+    t_lba               lba;
+    DISK_PCALLBACK      callback;
+    t_stat              io_status;
+    };
+#endif
+
+#define DISK_OVERLAY_CHUNK      64          /* sectors per overlay chunk (one valid bit each) */
+
+struct disk_overlay_chunk {
+    t_uint64            valid;              /* sectors which have been written */
+    uint8               data[1];            /* DISK_OVERLAY_CHUNK sectors */
+    };
+
 struct disk_context {
     DEVICE              *dptr;              /* Device for unit (access to debug flags) */
     uint32              dbit;               /* debugging bit */
@@ -96,6 +131,17 @@ struct disk_context {
     uint32              is_cdrom;           /* Host system CDROM Device */
     uint32              media_removed;      /* Media not available flag */
     uint32              auto_format;        /* Format determined dynamically */
+    SIM_FMAP            *mmap;              /* SimH format container mapping (or NULL) */
+    uint8               *mmap_base;         /* mapped container data */
+    t_offset            mmap_size;          /* bytes mapped */
+    t_bool              mmap_readonly;      /* mapping doesn't permit writes */
+    t_bool              overlay;            /* writes go to a private memory overlay */
+    t_bool              overlay_readonly;   /* overlay can't be committed to the container */
+    t_bool              overlay_writable;   /* container reopened read/write by a commit */
+    struct disk_overlay_chunk **overlay_chunk; /* overlay chunks (NULL until written) */
+    uint32              overlay_chunks;     /* entries in overlay_chunk */
+    uint32              overlay_sectors;    /* sectors present in the overlay */
+    int                 fd;                 /* descriptor for positional transfers */
 #if defined _WIN32
     HANDLE              disk_handle;        /* OS specific Raw device handle */
 #endif
@@ -103,18 +149,18 @@ struct disk_context {
     int                 asynch_io;          /* Asynchronous Interrupt scheduling enabled */
     int                 asynch_io_latency;  /* instructions to delay pending interrupt */
     pthread_mutex_t     lock;
-    pthread_t           io_thread;          /* I/O Thread Id */
+    pthread_t           io_thread[DISK_AIO_THREADS];    /* I/O Thread Ids */
+    int                 io_threads;         /* I/O threads running */
     pthread_mutex_t     io_lock;
-    pthread_cond_t      io_cond;
-    pthread_cond_t      io_done;
+    pthread_cond_t      io_cond;            /* request queued, completed or shutdown */
+    pthread_cond_t      io_done;            /* request completed */
     pthread_cond_t      startup_cond;
-    int                 io_dop;
-    uint8               *buf;
-    t_seccnt            *rsects;
-    t_seccnt            sects;
-    t_lba               lba;
-    DISK_PCALLBACK      callback;
-    t_stat              io_status;
+    pthread_mutex_t     io_serial_lock;     /* serializes transfers which share a file position */
+    struct disk_aio_request io_req[DISK_AIO_QUEUE_DEPTH];   /* request ring */
+    uint32              io_head;            /* sequence of oldest request (next to complete) */
+    uint32              io_next;            /* sequence of next request to start */
+    uint32              io_tail;            /* sequence of next request to queue */
+    uint32              io_busy;            /* requests queued or in progress */
 #endif
     };
 
@@ -127,27 +173,9 @@ struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;   \
 if ((!callback) || !ctx->asynch_io)
 
 #define AIO_CALL(op, _lba, _buf, _rsects, _sects,  _callback)   \
-    if (ctx->asynch_io) {                                       \
-        struct disk_context *ctx =                              \
-                      (struct disk_context *)uptr->disk_ctx;    \
-                                                                \
-        pthread_mutex_lock (&ctx->io_lock);                     \
-                                                                \
-        sim_debug_unit (ctx->dbit, uptr,                        \
-      "sim_disk AIO_CALL(op=%d, unit=%d, lba=0x%X, sects=%d)\n",\
-                op, (int)(uptr-ctx->dptr->units), _lba, _sects);\
-                                                                \
-        if (ctx->callback)                                      \
-            abort(); /* horrible mistake, stop */               \
-        ctx->io_dop = op;                                       \
-        ctx->lba = _lba;                                        \
-        ctx->buf = _buf;                                        \
-        ctx->sects = _sects;                                    \
-        ctx->rsects = _rsects;                                  \
-        ctx->callback = _callback;                              \
-        pthread_cond_signal (&ctx->io_cond);                    \
-        pthread_mutex_unlock (&ctx->io_lock);                   \
-        }                                                       \
+    if (ctx->asynch_io)                                         \
+        _disk_aio_queue (uptr, op, _lba, _buf,                  \
+                         _rsects, _sects, _callback);           \
     else                                                        \
         if (_callback)                                          \
             (_callback) (uptr, r);
@@ -158,11 +186,97 @@ if ((!callback) || !ctx->asynch_io)
 #define DOP_WSEC  2             /* sim_disk_wrsect_a */
 #define DOP_IAVL  3             /* sim_disk_isavailable_a */
 
+#define AIO_REQ(ctx, seq) (&(ctx)->io_req[(seq) % DISK_AIO_QUEUE_DEPTH])
+
+static void _disk_completion_dispatch (UNIT *uptr);
+
+/* Determine if a request can be started concurrently with the
+   requests which are already in progress.  Positional transfers
+   may overlap unless they touch the same sectors and one of them
+   is a write.  Everything else is serialized on io_serial_lock. */
+static t_bool _disk_aio_positional (UNIT *uptr, struct disk_aio_request *req)
+{
+#if defined (DISK_POSITIONAL_IO)
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+if ((req->dop == DOP_IAVL) ||
+    ctx->overlay)                                       /* overlay tables are shared */
+    return FALSE;
+switch (DK_GET_FMT (uptr)) {                            /* case on format */
+    case DKUF_F_STD:                                    /* SIMH format */
+        return TRUE;
+    case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
+        return (0 == (ctx->sector_size & (ctx->storage_sector_size - 1))); /* no read-modify-write */
+    default:
+        break;
+    }
+#endif
+return FALSE;
+}
+
+static t_bool _disk_aio_conflict (struct disk_context *ctx, struct disk_aio_request *req)
+{
+uint32 seq;
+
+for (seq = ctx->io_head; seq != ctx->io_next; seq++) {
+    struct disk_aio_request *act = AIO_REQ (ctx, seq);
+
+    if (act->done ||
+        (act->dop == DOP_IAVL) || (req->dop == DOP_IAVL) ||
+        ((act->dop == DOP_RSEC) && (req->dop == DOP_RSEC)))
+        continue;
+    if ((req->lba < act->lba + act->sects) &&
+        (act->lba < req->lba + req->sects))
+        return TRUE;
+    }
+return FALSE;
+}
+
+static void _disk_aio_queue (UNIT *uptr, int op, t_lba lba, uint8 *buf, t_seccnt *rsects, t_seccnt sects, DISK_PCALLBACK callback)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+struct disk_aio_request *req;
+
+pthread_mutex_lock (&ctx->io_lock);
+
+sim_debug_unit (ctx->dbit, uptr, "sim_disk AIO_CALL(op=%d, unit=%d, lba=0x%X, sects=%d, queued=%d)\n",
+                op, (int)(uptr-ctx->dptr->units), lba, sects, (int)(ctx->io_tail - ctx->io_head));
+
+while ((ctx->io_tail - ctx->io_head) == DISK_AIO_QUEUE_DEPTH) {
+    /* Queue is full, retire the oldest request to make room */
+    while (!AIO_REQ (ctx, ctx->io_head)->done)
+        pthread_cond_wait (&ctx->io_done, &ctx->io_lock);
+    pthread_mutex_unlock (&ctx->io_lock);
+    _disk_completion_dispatch (uptr);
+    pthread_mutex_lock (&ctx->io_lock);
+    }
+req = AIO_REQ (ctx, ctx->io_tail);
+req->dop = op;
+req->done = FALSE;
+req->lba = lba;
+req->buf = buf;
+req->sects = sects;
+req->rsects = rsects;
+req->callback = callback;
+++ctx->io_tail;
+++ctx->io_busy;
+pthread_cond_signal (&ctx->io_cond);
+pthread_mutex_unlock (&ctx->io_lock);
+}
+
+/* I/O worker thread.  Several of these run for each unit, each one
+   takes the next queued request (in submission order) and performs it
+   concurrently with the others.  Completions are reported to the
+   simulator thread by activating the unit, which will then dispatch
+   the completion callbacks in submission order. */
 static void *
 _disk_io(void *arg)
 {
 UNIT* volatile uptr = (UNIT*)arg;
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+struct disk_aio_request *req;
+t_bool serial;
+t_stat status;
 
 /* Boost Priority for this I/O thread vs the CPU instruction execution
    thread which in general won't be readily yielding the processor when
@@ -173,25 +287,45 @@ sim_debug_unit (ctx->dbit, uptr, "_disk_io(unit=%d) starting\n", (int)(uptr-ctx-
 
 pthread_mutex_lock (&ctx->io_lock);
 pthread_cond_signal (&ctx->startup_cond);   /* Signal we're ready to go */
-while (ctx->asynch_io) {
-    pthread_cond_wait (&ctx->io_cond, &ctx->io_lock);
-    if (ctx->io_dop == DOP_DONE)
+while (1) {
+    while ((ctx->io_next == ctx->io_tail) ||
+           _disk_aio_conflict (ctx, AIO_REQ (ctx, ctx->io_next))) {
+        if ((!ctx->asynch_io) && (ctx->io_next == ctx->io_tail))
+            break;
+        pthread_cond_wait (&ctx->io_cond, &ctx->io_lock);
+        }
+    if (ctx->io_next == ctx->io_tail)       /* shutting down and nothing left to do */
         break;
+    req = AIO_REQ (ctx, ctx->io_next);
+    ++ctx->io_next;
+    if (ctx->io_next != ctx->io_tail)       /* let another thread look at the next one */
+        pthread_cond_signal (&ctx->io_cond);
     pthread_mutex_unlock (&ctx->io_lock);
-    switch (ctx->io_dop) {
+    serial = !_disk_aio_positional (uptr, req);
+    if (serial)
+        pthread_mutex_lock (&ctx->io_serial_lock);
+    switch (req->dop) {
         case DOP_RSEC:
-            ctx->io_status = sim_disk_rdsect (uptr, ctx->lba, ctx->buf, ctx->rsects, ctx->sects);
+            status = sim_disk_rdsect (uptr, req->lba, req->buf, req->rsects, req->sects);
             break;
         case DOP_WSEC:
-            ctx->io_status = sim_disk_wrsect (uptr, ctx->lba, ctx->buf, ctx->rsects, ctx->sects);
+            status = sim_disk_wrsect (uptr, req->lba, req->buf, req->rsects, req->sects);
             break;
         case DOP_IAVL:
-            ctx->io_status = sim_disk_isavailable (uptr);
+            status = sim_disk_isavailable (uptr);
+            break;
+        default:
+            status = SCPE_IERR;
             break;
         }
+    if (serial)
+        pthread_mutex_unlock (&ctx->io_serial_lock);
     pthread_mutex_lock (&ctx->io_lock);
-    ctx->io_dop = DOP_DONE;
-    pthread_cond_signal (&ctx->io_done);
+    req->io_status = status;
+    req->done = TRUE;
+    --ctx->io_busy;
+    pthread_cond_broadcast (&ctx->io_done);
+    pthread_cond_broadcast (&ctx->io_cond); /* overlapping requests may now start */
     sim_activate (uptr, ctx->asynch_io_latency);
     }
 pthread_mutex_unlock (&ctx->io_lock);
@@ -207,25 +341,39 @@ return NULL;
    routine is to put the unit in proper condition to digest what may have
    occurred in the asynchrconous thread.
   
-   Since disk processing only handles a single I/O at a time to a
-   particular disk device (due to using stdio for the SimH Disk format
-   and stdio doesn't have an atomic seek+(read|write) operation),
-   we have the opportunity to possibly detect improper attempts to
-   issue multiple concurrent I/O requests. */
+   Requests may complete out of order in the I/O threads, but callbacks
+   are always delivered in the order the requests were submitted, so
+   this delivers every completed request at the head of the queue and
+   leaves the rest for the activation which the I/O thread completing
+   the oldest outstanding request will make. */
 static void _disk_completion_dispatch (UNIT *uptr)
 {
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
-DISK_PCALLBACK callback = ctx->callback;
-
-sim_debug_unit (ctx->dbit, uptr, "_disk_completion_dispatch(unit=%d, dop=%d, callback=%p)\n", (int)(uptr-ctx->dptr->units), ctx->io_dop, (void *)(ctx->callback));
+int threads = ctx->io_threads;              /* no locking needed once threads are gone */
+struct disk_aio_request *req;
+DISK_PCALLBACK callback;
+t_stat status;
 
-if (ctx->io_dop != DOP_DONE)
-    abort();                                            /* horribly wrong, stop */
+sim_debug_unit (ctx->dbit, uptr, "_disk_completion_dispatch(unit=%d, queued=%d, busy=%d)\n", (int)(uptr-ctx->dptr->units), (int)(ctx->io_tail - ctx->io_head), (int)ctx->io_busy);
 
-if (ctx->callback && ctx->io_dop == DOP_DONE) {
-    ctx->callback = NULL;
-    callback (uptr, ctx->io_status);
+if (threads)
+    pthread_mutex_lock (&ctx->io_lock);
+while ((ctx->io_head != ctx->io_tail) &&
+       (AIO_REQ (ctx, ctx->io_head)->done)) {
+    req = AIO_REQ (ctx, ctx->io_head);
+    callback = req->callback;
+    status = req->io_status;
+    req->callback = NULL;
+    ++ctx->io_head;
+    if (threads)
+        pthread_mutex_unlock (&ctx->io_lock);
+    if (callback)
+        callback (uptr, status);
+    if (threads)
+        pthread_mutex_lock (&ctx->io_lock);
     }
+if (threads)
+    pthread_mutex_unlock (&ctx->io_lock);
 }
 
 static t_bool _disk_is_active (UNIT *uptr)
@@ -233,8 +381,8 @@ static t_bool _disk_is_active (UNIT *uptr)
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 if (ctx) {
-    sim_debug_unit (ctx->dbit, uptr, "_disk_is_active(unit=%d, dop=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_dop);
-    return (ctx->io_dop != DOP_DONE);
+    sim_debug_unit (ctx->dbit, uptr, "_disk_is_active(unit=%d, busy=%d)\n", (int)(uptr-ctx->dptr->units), (int)ctx->io_busy);
+    return (ctx->io_busy != 0);
     }
 return FALSE;
 }
@@ -244,10 +392,10 @@ static t_bool _disk_cancel (UNIT *uptr)
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 if (ctx) {
-    sim_debug_unit (ctx->dbit, uptr, "_disk_cancel(unit=%d, dop=%d)\n", (int)(uptr-ctx->dptr->units), ctx->io_dop);
+    sim_debug_unit (ctx->dbit, uptr, "_disk_cancel(unit=%d, busy=%d)\n", (int)(uptr-ctx->dptr->units), (int)ctx->io_busy);
     if (ctx->asynch_io) {
         pthread_mutex_lock (&ctx->io_lock);
-        while (ctx->io_dop != DOP_DONE)
+        while (ctx->io_busy != 0)
             pthread_cond_wait (&ctx->io_done, &ctx->io_lock);
         pthread_mutex_unlock (&ctx->io_lock);
         }
@@ -276,6 +424,17 @@ static t_stat sim_vhd_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *
 static t_stat sim_vhd_disk_clearerr (UNIT *uptr);
 static t_stat sim_vhd_disk_set_dtype (FILE *f, const char *dtype);
 static const char *sim_vhd_disk_get_dtype (FILE *f);
+static t_stat sim_cdk_disk_implemented (void);
+static t_bool sim_cdk_disk_check (const char *szCDKPath);
+static FILE *sim_cdk_disk_open (const char *szCDKPath, const char *DesiredAccess);
+static FILE *sim_cdk_disk_create (const char *szCDKPath, t_offset desiredsize);
+static int sim_cdk_disk_close (FILE *f);
+static void sim_cdk_disk_flush (FILE *f);
+static t_offset sim_cdk_disk_size (FILE *f);
+static t_stat sim_cdk_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects);
+static t_stat sim_cdk_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects);
+static t_stat sim_cdk_disk_set_dtype (FILE *f, const char *dtype);
+static const char *sim_cdk_disk_get_dtype (FILE *f);
 static t_stat sim_os_disk_implemented_raw (void);
 static FILE *sim_os_disk_open_raw (const char *rawdevicename, const char *openmode);
 static int sim_os_disk_close_raw (FILE *f);
@@ -284,6 +443,9 @@ static t_offset sim_os_disk_size_raw (FILE *f);
 static t_stat sim_os_disk_unload_raw (FILE *f);
 static t_bool sim_os_disk_isavailable_raw (FILE *f);
 static t_stat sim_os_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects);
+static t_stat _disk_overlay_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects);
+static t_stat _disk_overlay_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects);
+static void _sim_disk_io_flush (UNIT *uptr);
 static t_stat sim_os_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects);
 static t_stat sim_os_disk_info_raw (FILE *f, uint32 *sector_size, uint32 *removable, uint32 *is_cdrom);
 static char *HostPathToVhdPath (const char *szHostPath, char *szVhdPath, size_t VhdPathSize);
@@ -302,6 +464,7 @@ static struct sim_disk_fmt fmts[] = {
     { "SIMH", 0, DKUF_F_STD,  NULL},
     { "RAW",  0, DKUF_F_RAW,  sim_os_disk_implemented_raw},
     { "VHD",  0, DKUF_F_VHD,  sim_vhd_disk_implemented},
+    { "CDK",  0, DKUF_F_CDK,  sim_cdk_disk_implemented},
     { NULL,   0, 0,           NULL}
     };
 
@@ -319,8 +482,15 @@ for (f = 0; fmts[f].name; f++) {
     if (fmts[f].name && (strcmp (cptr, fmts[f].name) == 0)) {
         if ((fmts[f].impl_fnc) && (fmts[f].impl_fnc() != SCPE_OK))
             return SCPE_NOFNC;
-        uptr->flags = (uptr->flags & ~DKUF_FMT) |
-            (fmts[f].fmtval << DKUF_V_FMT) | fmts[f].uflags;
+        if (fmts[f].fmtval == DKUF_F_CDK) {
+            uptr->flags = (uptr->flags & ~DKUF_FMT) | fmts[f].uflags;
+            uptr->dynflags |= UNIT_DISK_CDK;
+            }
+        else {
+            uptr->flags = (uptr->flags & ~DKUF_FMT) |
+                (fmts[f].fmtval << DKUF_V_FMT) | fmts[f].uflags;
+            uptr->dynflags &= ~UNIT_DISK_CDK;
+            }
         return SCPE_OK;
         }
     }
@@ -337,6 +507,9 @@ size_t i;
 for (i = 0; fmts[i].name; i++)
     if (fmts[i].fmtval == f) {
         fprintf (st, "%s format", fmts[i].name);
+        if ((uptr->flags & UNIT_ATT) && uptr->disk_ctx &&
+            ((struct disk_context *)uptr->disk_ctx)->overlay)
+            fprintf (st, ", write overlay (%u sectors modified)", ((struct disk_context *)uptr->disk_ctx)->overlay_sectors);
         return SCPE_OK;
         }
 fprintf (st, "invalid format");
@@ -400,6 +573,9 @@ switch (DK_GET_FMT (uptr)) {                            /* case on format */
     case DKUF_F_VHD:                                    /* VHD format */
         is_available = TRUE;
         break;
+    case DKUF_F_CDK:                                    /* CDK format */
+        is_available = TRUE;
+        break;
     case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
         if (sim_os_disk_isavailable_raw (uptr->fileref)) {
             if (ctx->media_removed) {
@@ -460,6 +636,9 @@ switch (DK_GET_FMT (uptr)) {                            /* case on format */
     case DKUF_F_VHD:                                    /* VHD format */
         physical_size = sim_vhd_disk_size (uptr->fileref);
         break;
+    case DKUF_F_CDK:                                    /* CDK format */
+        physical_size = sim_cdk_disk_size (uptr->fileref);
+        break;
     case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
         physical_size = sim_os_disk_size_raw (uptr->fileref);
         break;
@@ -475,6 +654,23 @@ if ((filesystem_size == (t_offset)-1) ||
 return filesystem_size;
 }
 
+/* Enter positional mode: write back whatever stdio holds for a SimH
+   format container and record its descriptor.  Called at attach, when
+   asynchronous operation starts and when COMMIT reopens the container,
+   so the transfer routines (and the I/O threads) never touch the FILE. */
+
+static void _disk_positional_start (UNIT *uptr)
+{
+#if defined (DISK_POSITIONAL_IO)
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+if (DK_GET_FMT (uptr) != DKUF_F_STD)
+    return;
+fflush (uptr->fileref);
+ctx->fd = fileno (uptr->fileref);
+#endif
+}
+
 /* Enable asynchronous operation */
 
 t_stat sim_disk_set_async (UNIT *uptr, int latency)
@@ -489,19 +685,23 @@ pthread_attr_t attr;
 
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_set_async(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 
+_disk_positional_start (uptr);
 ctx->asynch_io = sim_asynch_enabled;
 ctx->asynch_io_latency = latency;
 if (ctx->asynch_io) {
     pthread_mutex_init (&ctx->io_lock, NULL);
+    pthread_mutex_init (&ctx->io_serial_lock, NULL);
     pthread_cond_init (&ctx->io_cond, NULL);
     pthread_cond_init (&ctx->io_done, NULL);
     pthread_cond_init (&ctx->startup_cond, NULL);
     pthread_attr_init(&attr);
     pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
     pthread_mutex_lock (&ctx->io_lock);
-    pthread_create (&ctx->io_thread, &attr, _disk_io, (void *)uptr);
+    for (ctx->io_threads = 0; ctx->io_threads < DISK_AIO_THREADS; ctx->io_threads++) {
+        pthread_create (&ctx->io_thread[ctx->io_threads], &attr, _disk_io, (void *)uptr);
+        pthread_cond_wait (&ctx->startup_cond, &ctx->io_lock); /* Wait for thread to stabilize */
+        }
     pthread_attr_destroy(&attr);
-    pthread_cond_wait (&ctx->startup_cond, &ctx->io_lock); /* Wait for thread to stabilize */
     pthread_mutex_unlock (&ctx->io_lock);
     pthread_cond_destroy (&ctx->startup_cond);
     }
@@ -527,12 +727,17 @@ if (!ctx) return SCPE_UNATT;
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_clr_async(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 
 if (ctx->asynch_io) {
+    int i;
+
     pthread_mutex_lock (&ctx->io_lock);
     ctx->asynch_io = 0;
-    pthread_cond_signal (&ctx->io_cond);
+    pthread_cond_broadcast (&ctx->io_cond);
     pthread_mutex_unlock (&ctx->io_lock);
-    pthread_join (ctx->io_thread, NULL);
+    for (i = 0; i < ctx->io_threads; i++)           /* threads finish any queued requests */
+        pthread_join (ctx->io_thread[i], NULL);
+    ctx->io_threads = 0;
     pthread_mutex_destroy (&ctx->io_lock);
+    pthread_mutex_destroy (&ctx->io_serial_lock);
     pthread_cond_destroy (&ctx->io_cond);
     pthread_cond_destroy (&ctx->io_done);
     }
@@ -547,6 +752,9 @@ static t_stat _sim_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sec
 t_offset da;
 uint32 err, tbc;
 size_t i;
+#if defined (DISK_POSITIONAL_IO)
+ssize_t bytesread = 0;
+#endif
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 sim_debug_unit (ctx->dbit, uptr, "_sim_disk_rdsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
@@ -555,23 +763,42 @@ da = ((t_offset)lba) * ctx->sector_size;
 tbc = sects * ctx->sector_size;
 if (sectsread)
     *sectsread = 0;
-err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
-if (!err) {
-    i = sim_fread (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
-    if (i < tbc/ctx->xfer_element_size)                 /* fill */
-        memset (&buf[i*ctx->xfer_element_size], 0, tbc-(i*ctx->xfer_element_size));
-    err = ferror (uptr->fileref);
-    if ((!err) && (sectsread))
-        *sectsread = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
+if ((ctx->mmap_base) && (da + tbc <= ctx->mmap_size)) { /* memory mapped? */
+    sim_buf_copy_swapped (buf, ctx->mmap_base + da, ctx->xfer_element_size, tbc/ctx->xfer_element_size);
+    if (sectsread)
+        *sectsread = sects;
+    return SCPE_OK;
+    }
+#if defined (DISK_POSITIONAL_IO)
+err = 0;
+for (i = 0; i < tbc; i += (size_t)bytesread) {          /* positional read */
+    bytesread = pread (ctx->fd, buf + i, tbc - i, (off_t)(da + i));
+    if (bytesread <= 0)
+        break;
     }
+if (bytesread < 0)
+    return SCPE_IOERR;
+i = i / ctx->xfer_element_size;                         /* elements read */
+sim_buf_swap_data (buf, ctx->xfer_element_size, i);
+#else
+err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
+if (err)
+    return err;
+i = sim_fread (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
+err = ferror (uptr->fileref);
+#endif
+if (i < tbc/ctx->xfer_element_size)                     /* fill */
+    memset (&buf[i*ctx->xfer_element_size], 0, tbc-(i*ctx->xfer_element_size));
+if ((!err) && (sectsread))
+    *sectsread = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
 return err;
 }
 
+static t_stat _sim_disk_rdsect_container (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects);
+
 t_stat sim_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
 {
-t_stat r;
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
-t_seccnt sread = 0;
 
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_rdsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
@@ -582,6 +809,18 @@ if ((sects == 1) &&                                     /* Single sector reads *
         *sectsread = 1;
     return SCPE_OK;                                     /* return success */
     }
+if (ctx->overlay)
+    return _disk_overlay_rdsect (uptr, lba, buf, sectsread, sects);
+return _sim_disk_rdsect_container (uptr, lba, buf, sectsread, sects);
+}
+
+/* Read sectors from the container, whatever its format */
+
+static t_stat _sim_disk_rdsect_container (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
+{
+t_stat r;
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_seccnt sread = 0;
 
 if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Aligned & whole sector transfers */
     ((0 == ((lba*ctx->sector_size) & (ctx->storage_sector_size - 1))) &&
@@ -592,6 +831,9 @@ if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Al
         case DKUF_F_VHD:                                /* VHD format */
             r = sim_vhd_disk_rdsect (uptr, lba, buf, &sread, sects);
             break;
+        case DKUF_F_CDK:                                /* CDK format */
+            r = sim_cdk_disk_rdsect (uptr, lba, buf, &sread, sects);
+            break;
         case DKUF_F_RAW:                                /* Raw Physical Disk Access */
             r = sim_os_disk_rdsect (uptr, lba, buf, &sread, sects);
             break;
@@ -625,6 +867,11 @@ else { /* Unaligned and/or partial sector transfers */
             if (r == SCPE_OK)
                 sim_buf_swap_data (tbuf, ctx->xfer_element_size, (sread * ctx->sector_size) / ctx->xfer_element_size);
             break;
+        case DKUF_F_CDK:                                /* CDK format */
+            r = sim_cdk_disk_rdsect (uptr, tlba, tbuf, &sread, tsects);
+            if (r == SCPE_OK)
+                sim_buf_swap_data (tbuf, ctx->xfer_element_size, (sread * ctx->sector_size) / ctx->xfer_element_size);
+            break;
         case DKUF_F_RAW:                                /* Raw Physical Disk Access */
             r = sim_os_disk_rdsect (uptr, tlba, tbuf, &sread, tsects);
             if (r == SCPE_OK)
@@ -663,6 +910,10 @@ static t_stat _sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sec
 t_offset da;
 uint32 err, tbc;
 size_t i;
+#if defined (DISK_POSITIONAL_IO)
+ssize_t byteswritten = 0;
+uint8 *tbuf = NULL;
+#endif
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
 sim_debug_unit (ctx->dbit, uptr, "_sim_disk_wrsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
@@ -671,22 +922,47 @@ da = ((t_offset)lba) * ctx->sector_size;
 tbc = sects * ctx->sector_size;
 if (sectswritten)
     *sectswritten = 0;
-err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
-if (!err) {
-    i = sim_fwrite (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
-    err = ferror (uptr->fileref);
-    if ((!err) && (sectswritten))
-        *sectswritten = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
+if ((ctx->mmap_base) && (da + tbc <= ctx->mmap_size) && /* memory mapped and writable? */
+    (!ctx->mmap_readonly)) {
+    sim_buf_copy_swapped (ctx->mmap_base + da, buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size);
+    if (sectswritten)
+        *sectswritten = sects;
+    return SCPE_OK;
+    }
+#if defined (DISK_POSITIONAL_IO)
+err = 0;
+if ((!sim_end) && (ctx->xfer_element_size != sizeof (char))) {
+    if (NULL == (tbuf = (uint8 *)malloc (tbc)))
+        return SCPE_MEM;
+    sim_buf_copy_swapped (tbuf, buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size);
+    buf = tbuf;
+    }
+for (i = 0; i < tbc; i += (size_t)byteswritten) {       /* positional write */
+    byteswritten = pwrite (ctx->fd, buf + i, tbc - i, (off_t)(da + i));
+    if (byteswritten <= 0)
+        break;
     }
+free (tbuf);
+if (byteswritten < 0)
+    return SCPE_IOERR;
+i = i / ctx->xfer_element_size;                         /* elements written */
+#else
+err = sim_fseeko (uptr->fileref, da, SEEK_SET);          /* set pos */
+if (err)
+    return err;
+i = sim_fwrite (buf, ctx->xfer_element_size, tbc/ctx->xfer_element_size, uptr->fileref);
+err = ferror (uptr->fileref);
+#endif
+if ((!err) && (sectswritten))
+    *sectswritten = (t_seccnt)((i*ctx->xfer_element_size+ctx->sector_size-1)/ctx->sector_size);
 return err;
 }
 
+static t_stat _sim_disk_wrsect_container (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects);
+
 t_stat sim_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
 {
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
-uint32 f = DK_GET_FMT (uptr);
-t_stat r;
-uint8 *tbuf = NULL;
 
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_wrsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
 
@@ -719,6 +995,20 @@ if (uptr->dynflags & UNIT_DISK_CHK) {
             }
         }
     }
+if (ctx->overlay)
+    return _disk_overlay_wrsect (uptr, lba, buf, sectswritten, sects);
+return _sim_disk_wrsect_container (uptr, lba, buf, sectswritten, sects);
+}
+
+/* Write sectors to the container, whatever its format */
+
+static t_stat _sim_disk_wrsect_container (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+uint32 f = DK_GET_FMT (uptr);
+t_stat r;
+uint8 *tbuf = NULL;
+
 if (f == DKUF_F_STD)
     return _sim_disk_wrsect (uptr, lba, buf, sectswritten, sects);
 if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Aligned & whole sector transfers */
@@ -729,6 +1019,8 @@ if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Al
         switch (DK_GET_FMT (uptr)) {                            /* case on format */
             case DKUF_F_VHD:                                    /* VHD format */
                 return sim_vhd_disk_wrsect  (uptr, lba, buf, sectswritten, sects);
+            case DKUF_F_CDK:                                    /* CDK format */
+                return sim_cdk_disk_wrsect  (uptr, lba, buf, sectswritten, sects);
             case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
                 return sim_os_disk_wrsect  (uptr, lba, buf, sectswritten, sects);
             default:
@@ -744,6 +1036,9 @@ if ((0 == (ctx->sector_size & (ctx->storage_sector_size - 1))) ||   /* Sector Al
         case DKUF_F_VHD:                                    /* VHD format */
             r = sim_vhd_disk_wrsect (uptr, lba, tbuf, sectswritten, sects);
             break;
+        case DKUF_F_CDK:                                    /* CDK format */
+            r = sim_cdk_disk_wrsect (uptr, lba, tbuf, sectswritten, sects);
+            break;
         case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
             r = sim_os_disk_wrsect (uptr, lba, tbuf, sectswritten, sects);
             break;
@@ -770,6 +1065,9 @@ else { /* Unaligned and/or partial sector transfers */
             case DKUF_F_VHD:                                    /* VHD format */
                 sim_vhd_disk_rdsect (uptr, tlba, tbuf, NULL, sspsts);
                 break;
+            case DKUF_F_CDK:                                    /* CDK format */
+                sim_cdk_disk_rdsect (uptr, tlba, tbuf, NULL, sspsts);
+                break;
             case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
                 sim_os_disk_rdsect (uptr, tlba, tbuf, NULL, sspsts);
                 break;
@@ -785,6 +1083,11 @@ else { /* Unaligned and/or partial sector transfers */
                                      tbuf + (tsects - sspsts) * ctx->sector_size,
                                      NULL, sspsts);
                 break;
+            case DKUF_F_CDK:                                    /* CDK format */
+                sim_cdk_disk_rdsect (uptr, tlba + tsects - sspsts,
+                                     tbuf + (tsects - sspsts) * ctx->sector_size,
+                                     NULL, sspsts);
+                break;
             case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
                 sim_os_disk_rdsect (uptr, tlba + tsects - sspsts,
                                     tbuf + (tsects - sspsts) * ctx->sector_size,
@@ -800,6 +1103,9 @@ else { /* Unaligned and/or partial sector transfers */
         case DKUF_F_VHD:                                    /* VHD format */
             r = sim_vhd_disk_wrsect (uptr, tlba, tbuf, sectswritten, tsects);
             break;
+        case DKUF_F_CDK:                                    /* CDK format */
+            r = sim_cdk_disk_wrsect (uptr, tlba, tbuf, sectswritten, tsects);
+            break;
         case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
             r = sim_os_disk_wrsect (uptr, tlba, tbuf, sectswritten, tsects);
             break;
@@ -826,62 +1132,385 @@ AIO_CALL(DOP_WSEC, lba, buf, sectswritten, sects, callback);
 return r;
 }
 
-t_stat sim_disk_unload (UNIT *uptr)
+/* Copy-on-write memory overlay
+
+   A unit attached with -S never writes to its container.  Written sectors
+   are kept in memory in chunks of DISK_OVERLAY_CHUNK sectors, each with a
+   bitmap of the sectors it holds.  Reads are satisfied from the overlay
+   where possible and from the container otherwise.  Devices list the
+   sim_disk_set_overlay COMMIT and DISCARD modifiers: SET <unit> COMMIT
+   writes the overlay to the container and SET <unit> DISCARD drops it.
+*/
+
+static uint8 *_disk_overlay_sector (struct disk_context *ctx, t_lba lba)
+{
+struct disk_overlay_chunk *chunk;
+uint32 c = (uint32)(lba / DISK_OVERLAY_CHUNK);
+uint32 s = (uint32)(lba % DISK_OVERLAY_CHUNK);
+
+if ((c >= ctx->overlay_chunks) ||
+    (NULL == (chunk = ctx->overlay_chunk[c])) ||
+    (0 == (chunk->valid & (((t_uint64)1) << s))))
+    return NULL;
+return chunk->data + s * ctx->sector_size;
+}
+
+static t_stat _disk_overlay_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
 {
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_seccnt i, sread = 0, present = 0;
+uint8 *sector;
+t_stat r;
 
-switch (DK_GET_FMT (uptr)) {                            /* case on format */
-    case DKUF_F_STD:                                    /* Simh */
-    case DKUF_F_VHD:                                    /* VHD format */
-        ctx->media_removed = 1;
-        return sim_disk_detach (uptr);
-    case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
-        ctx->media_removed = 1;
-        return sim_os_disk_unload_raw (uptr->fileref);  /* remove/eject disk */
-        break;
-    default:
-        return SCPE_NOFNC;
+for (i = 0; i < sects; i++)
+    if (_disk_overlay_sector (ctx, lba + i))
+        ++present;
+if (present == 0)                                       /* nothing written yet? */
+    return _sim_disk_rdsect_container (uptr, lba, buf, sectsread, sects);
+if (present < sects) {                                  /* some from the container */
+    r = _sim_disk_rdsect_container (uptr, lba, buf, &sread, sects);
+    if (r != SCPE_OK)
+        return r;
+    if (sread < sects)
+        memset (buf + sread * ctx->sector_size, 0, (sects - sread) * ctx->sector_size);
+    }
+for (i = 0; i < sects; i++) {
+    if (NULL == (sector = _disk_overlay_sector (ctx, lba + i)))
+        continue;
+    memcpy (buf + i * ctx->sector_size, sector, ctx->sector_size);
+    if (sread < i + 1)
+        sread = i + 1;
     }
+if (sectsread)
+    *sectsread = sread;
+return SCPE_OK;
 }
 
-/*
-   This routine is called when the simulator stops and any time
-   the asynch mode is changed (enabled or disabled)
-*/
-static void _sim_disk_io_flush (UNIT *uptr)
+static t_stat _disk_overlay_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
 {
-uint32 f = DK_GET_FMT (uptr);
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_seccnt i;
 
-#if defined (SIM_ASYNCH_IO)
+if (sectswritten)
+    *sectswritten = 0;
+for (i = 0; i < sects; i++) {
+    uint32 c = (uint32)((lba + i) / DISK_OVERLAY_CHUNK);
+    uint32 s = (uint32)((lba + i) % DISK_OVERLAY_CHUNK);
+    struct disk_overlay_chunk *chunk;
+
+    if (c >= ctx->overlay_chunks) {                     /* grow the chunk table */
+        uint32 chunks = ctx->overlay_chunks ? ctx->overlay_chunks : 64;
+        struct disk_overlay_chunk **table;
+
+        while (chunks <= c)
+            chunks *= 2;
+        table = (struct disk_overlay_chunk **)realloc (ctx->overlay_chunk, chunks * sizeof (*table));
+        if (table == NULL)
+            return SCPE_MEM;
+        memset (table + ctx->overlay_chunks, 0, (chunks - ctx->overlay_chunks) * sizeof (*table));
+        ctx->overlay_chunk = table;
+        ctx->overlay_chunks = chunks;
+        }
+    chunk = ctx->overlay_chunk[c];
+    if (chunk == NULL) {
+        chunk = (struct disk_overlay_chunk *)malloc (sizeof (*chunk) + DISK_OVERLAY_CHUNK * ctx->sector_size);
+        if (chunk == NULL)
+            return SCPE_MEM;
+        chunk->valid = 0;
+        ctx->overlay_chunk[c] = chunk;
+        }
+    memcpy (chunk->data + s * ctx->sector_size, buf + i * ctx->sector_size, ctx->sector_size);
+    if (0 == (chunk->valid & (((t_uint64)1) << s))) {
+        chunk->valid |= ((t_uint64)1) << s;
+        ++ctx->overlay_sectors;
+        }
+    if (sectswritten)
+        *sectswritten = i + 1;
+    }
+return SCPE_OK;
+}
+
+static void _disk_overlay_free (struct disk_context *ctx)
+{
+uint32 c;
+
+for (c = 0; c < ctx->overlay_chunks; c++)
+    free (ctx->overlay_chunk[c]);
+free (ctx->overlay_chunk);
+ctx->overlay_chunk = NULL;
+ctx->overlay_chunks = 0;
+ctx->overlay_sectors = 0;
+}
+
+static t_stat _disk_overlay_check (UNIT *uptr)
+{
 struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
 
-sim_disk_clr_async (uptr);
-if (sim_asynch_enabled)
-    sim_disk_set_async (uptr, ctx->asynch_io_latency);
-#endif
-switch (f) {                                            /* case on format */
+if ((!(uptr->flags & UNIT_ATT)) || (ctx == NULL) || (!ctx->overlay))
+    return sim_messagef (SCPE_NOFNC, "%s: no write overlay is active\n", sim_uname (uptr));
+return SCPE_OK;
+}
+
+/* The container of an overlaid unit is opened read only, so that nothing
+   (including CDK dirty container recovery) alters it until the first
+   commit.  Reopen it read/write once all transfers using it are done. */
+
+static t_stat _disk_overlay_reopen (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+FILE *(*open_function)(const char *filename, const char *mode);
+int (*close_function)(FILE *f);
+FILE *fileref;
+
+if (ctx->overlay_writable)
+    return SCPE_OK;
+switch (DK_GET_FMT (uptr)) {                            /* case on format */
     case DKUF_F_STD:                                    /* Simh */
-        fflush (uptr->fileref);
+        open_function = sim_fopen;
+        close_function = fclose;
         break;
     case DKUF_F_VHD:                                    /* Virtual Disk */
-        sim_vhd_disk_flush (uptr->fileref);
+        open_function = sim_vhd_disk_open;
+        close_function = sim_vhd_disk_close;
+        break;
+    case DKUF_F_CDK:                                    /* Clustered Disk */
+        open_function = sim_cdk_disk_open;
+        close_function = sim_cdk_disk_close;
         break;
     case DKUF_F_RAW:                                    /* Physical */
-        sim_os_disk_flush_raw (uptr->fileref);
+        open_function = sim_os_disk_open_raw;
+        close_function = sim_os_disk_close_raw;
         break;
+    default:
+        return SCPE_IERR;
         }
+#if defined (SIM_ASYNCH_IO)
+_disk_cancel (uptr);                                    /* wait for transfers using the old handle */
+#endif
+fileref = open_function (uptr->filename, "rb+");
+if (fileref == NULL)
+    return sim_messagef (SCPE_OPENERR, "%s: %s can't be opened for writing: %s\n", sim_uname (uptr), uptr->filename, strerror (errno));
+close_function (uptr->fileref);
+uptr->fileref = fileref;
+_disk_positional_start (uptr);
+ctx->overlay_writable = TRUE;
+return SCPE_OK;
 }
 
-static t_stat _err_return (UNIT *uptr, t_stat stat)
+/* Write the overlay's sectors to the container, then empty the overlay */
+
+t_stat sim_disk_overlay_commit (UNIT *uptr)
 {
-free (uptr->filename);
-uptr->filename = NULL;
-free (uptr->disk_ctx);
-uptr->disk_ctx = NULL;
-return stat;
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+uint32 c, committed = 0;
+t_stat r = _disk_overlay_check (uptr);
+
+if (r != SCPE_OK)
+    return r;
+if (ctx->overlay_readonly)
+    return sim_messagef (SCPE_RO, "%s: %s was opened read only and can't be committed\n", sim_uname (uptr), uptr->filename);
+r = _disk_overlay_reopen (uptr);
+if (r != SCPE_OK)
+    return r;
+#if defined (SIM_ASYNCH_IO)
+if (ctx->io_threads)
+    pthread_mutex_lock (&ctx->io_serial_lock);
+#endif
+for (c = 0; (r == SCPE_OK) && (c < ctx->overlay_chunks); c++) {
+    struct disk_overlay_chunk *chunk = ctx->overlay_chunk[c];
+    uint32 s = 0, e;
+
+    while ((r == SCPE_OK) && chunk && (s < DISK_OVERLAY_CHUNK)) {
+        if (0 == (chunk->valid & (((t_uint64)1) << s))) {
+            ++s;
+            continue;
+            }
+        for (e = s + 1; (e < DISK_OVERLAY_CHUNK) && (chunk->valid & (((t_uint64)1) << e)); e++)
+            ;
+        r = _sim_disk_wrsect_container (uptr, (t_lba)c * DISK_OVERLAY_CHUNK + s, chunk->data + s * ctx->sector_size, NULL, e - s);
+        if (r == SCPE_OK) {
+            committed += e - s;
+            chunk->valid &= ~((e - s == 64) ? ~((t_uint64)0) : (((((t_uint64)1) << (e - s)) - 1) << s));
+            ctx->overlay_sectors -= e - s;
+            }
+        s = e;
+        }
+    }
+if (r == SCPE_OK) {
+    _sim_disk_io_flush (uptr);
+    _disk_overlay_free (ctx);
+    }
+#if defined (SIM_ASYNCH_IO)
+if (ctx->io_threads)
+    pthread_mutex_unlock (&ctx->io_serial_lock);
+#endif
+if (r != SCPE_OK)
+    return sim_messagef (r, "%s: overlay commit to %s failed after %u sectors: %s\n", sim_uname (uptr), uptr->filename, committed, sim_error_text (r));
+return sim_messagef (SCPE_OK, "%s: %u sectors committed to %s\n", sim_uname (uptr), committed, uptr->filename);
 }
 
-#pragma pack(push,1)
+/* Drop the overlay's sectors, restoring the container's contents */
+
+t_stat sim_disk_overlay_discard (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+uint32 discarded;
+t_stat r = _disk_overlay_check (uptr);
+
+if (r != SCPE_OK)
+    return r;
+#if defined (SIM_ASYNCH_IO)
+if (ctx->io_threads)
+    pthread_mutex_lock (&ctx->io_serial_lock);
+#endif
+discarded = ctx->overlay_sectors;
+_disk_overlay_free (ctx);
+#if defined (SIM_ASYNCH_IO)
+if (ctx->io_threads)
+    pthread_mutex_unlock (&ctx->io_serial_lock);
+#endif
+return sim_messagef (SCPE_OK, "%s: %u modified sectors discarded\n", sim_uname (uptr), discarded);
+}
+
+/* Set overlay commit (val = 1) or discard (val = 0) */
+
+t_stat sim_disk_set_overlay (UNIT *uptr, int32 val, CONST char *cptr, void *desc)
+{
+if (uptr == NULL)
+    return SCPE_IERR;
+if (cptr)
+    return SCPE_ARG;
+if (val)
+    return sim_disk_overlay_commit (uptr);
+return sim_disk_overlay_discard (uptr);
+}
+
+/* An overlay can only be committed or discarded through the device's
+   COMMIT and DISCARD modifiers, so ATTACH -S requires them. */
+
+static t_bool _disk_overlay_supported (DEVICE *dptr)
+{
+MTAB *mptr;
+
+for (mptr = dptr->modifiers; (mptr != NULL) && (mptr->mask != 0); mptr++)
+    if ((mptr->valid == &sim_disk_set_overlay) && (mptr->match == 1))
+        return TRUE;
+return FALSE;
+}
+
+t_stat sim_disk_unload (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+switch (DK_GET_FMT (uptr)) {                            /* case on format */
+    case DKUF_F_STD:                                    /* Simh */
+    case DKUF_F_VHD:                                    /* VHD format */
+    case DKUF_F_CDK:                                    /* CDK format */
+        ctx->media_removed = 1;
+        return sim_disk_detach (uptr);
+    case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
+        ctx->media_removed = 1;
+        return sim_os_disk_unload_raw (uptr->fileref);  /* remove/eject disk */
+        break;
+    default:
+        return SCPE_NOFNC;
+    }
+}
+
+/*
+   This routine is called when the simulator stops and any time
+   the asynch mode is changed (enabled or disabled)
+*/
+static void _sim_disk_io_flush (UNIT *uptr)
+{
+uint32 f = DK_GET_FMT (uptr);
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+#if defined (SIM_ASYNCH_IO)
+sim_disk_clr_async (uptr);
+if (sim_asynch_enabled)
+    sim_disk_set_async (uptr, ctx->asynch_io_latency);
+#endif
+switch (f) {                                            /* case on format */
+    case DKUF_F_STD:                                    /* Simh */
+#if defined (DISK_MMAP_IO)
+        sim_fmap_sync (ctx->mmap, FALSE);               /* start writeback of mapped data */
+#endif
+        fflush (uptr->fileref);
+        break;
+    case DKUF_F_VHD:                                    /* Virtual Disk */
+        sim_vhd_disk_flush (uptr->fileref);
+        break;
+    case DKUF_F_CDK:                                    /* Clustered Disk */
+        sim_cdk_disk_flush (uptr->fileref);
+        break;
+    case DKUF_F_RAW:                                    /* Physical */
+        sim_os_disk_flush_raw (uptr->fileref);
+        break;
+        }
+}
+
+/* Map a SimH format container into memory.  A writable container
+   is first extended to the full device size so every sector which
+   the device can address is backed by the mapping.  Transfers which
+   fall outside the mapping use ordinary file I/O. */
+static t_stat _sim_disk_mmap (UNIT *uptr)
+{
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+#if defined (DISK_MMAP_IO)
+t_offset size;
+t_offset unit_size = ((t_offset)uptr->capac)*ctx->capac_factor*((ctx->dptr->flags & DEV_SECTORS) ? 512 : 1);
+t_bool readonly = ((uptr->flags & UNIT_RO) != 0) || ctx->overlay; /* never alter an overlaid container */
+size_t map_size;
+void *base;
+t_stat r;
+
+if (DK_GET_FMT (uptr) != DKUF_F_STD)
+    return sim_messagef (SCPE_NOFNC, "%s: Only SIMH format disks can be memory mapped\n", sim_uname (uptr));
+fflush (uptr->fileref);
+size = sim_fsize_ex (uptr->fileref);
+if ((!readonly) && (size < unit_size))                  /* extended when mapped */
+    size = unit_size;
+if ((size == 0) || (size != (t_offset)((size_t)size)))
+    return sim_messagef (SCPE_NOFNC, "%s: %s can't be memory mapped\n", sim_uname (uptr), uptr->filename);
+map_size = (size_t)size;
+r = sim_fmap_open (uptr->filename, &map_size, readonly, &ctx->mmap, &base);
+if (r != SCPE_OK)
+    return r;
+ctx->mmap_base = (uint8 *)base;
+ctx->mmap_size = (t_offset)map_size;
+ctx->mmap_readonly = readonly;
+sim_debug_unit (ctx->dbit, uptr, "_sim_disk_mmap(unit=%d) mapped %s bytes\n", (int)(uptr-ctx->dptr->units), sim_fmt_numeric ((double)size));
+return SCPE_OK;
+#else
+return sim_messagef (SCPE_NOFNC, "%s: Memory mapped disks aren't available on this host\n", sim_uname (uptr));
+#endif
+}
+
+static void _sim_disk_munmap (UNIT *uptr)
+{
+#if defined (DISK_MMAP_IO)
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+
+if (ctx->mmap == NULL)
+    return;
+sim_fmap_close (ctx->mmap);                             /* writes back, then unmaps */
+ctx->mmap = NULL;
+ctx->mmap_base = NULL;
+ctx->mmap_size = 0;
+#endif
+}
+
+static t_stat _err_return (UNIT *uptr, t_stat stat)
+{
+free (uptr->filename);
+uptr->filename = NULL;
+free (uptr->disk_ctx);
+uptr->disk_ctx = NULL;
+return stat;
+}
+
+#pragma pack(push,1)
 typedef struct _ODS1_HomeBlock
     {
     uint16  hm1_w_ibmapsize;
@@ -1560,6 +2189,8 @@ t_offset (*size_function)(FILE *file);
 t_stat (*storage_function)(FILE *file, uint32 *sector_size, uint32 *removable, uint32 *is_cdrom) = NULL;
 t_bool created = FALSE, copied = FALSE;
 t_bool auto_format = FALSE;
+t_bool map_container = ((sim_switches & SWMASK ('P')) != 0);
+t_bool overlay = ((sim_switches & SWMASK ('S')) != 0);
 t_offset container_size, filesystem_size, current_unit_size;
 
 if (uptr->flags & UNIT_DIS)                             /* disabled? */
@@ -1568,6 +2199,8 @@ if (!(uptr->flags & UNIT_ATTABLE))                      /* not attachable? */
     return SCPE_NOATT;
 if ((dptr = find_dev_from_unit (uptr)) == NULL)
     return SCPE_NOATT;
+if (overlay && !_disk_overlay_supported (dptr))         /* overlay couldn't be committed? */
+    return sim_messagef (SCPE_NOFNC, "%s: -S requires the COMMIT and DISCARD modifiers, which %s doesn't have\n", sim_uname (uptr), sim_dname (dptr));
 if (sim_switches & SWMASK ('F')) {                      /* format spec? */
     char gbuf[CBUFSIZE];
     cptr = get_glyph (cptr, gbuf, 0);                   /* get spec */
@@ -1601,8 +2234,14 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
     int32 saved_sim_quiet = sim_quiet;
     uint32 capac_factor;
     t_stat r;
+    t_bool copy_cdk = (DK_GET_FMT (uptr) == DKUF_F_CDK);/* -F CDK copies to a CDK rather than a VHD */
+    const char *copy_fmt = copy_cdk ? "CDK" : "VHD";
+    FILE *(*copy_create)(const char *filename, t_offset desiredsize) = copy_cdk ? sim_cdk_disk_create : sim_vhd_disk_create;
+    int (*copy_close)(FILE *f) = copy_cdk ? sim_cdk_disk_close : sim_vhd_disk_close;
 
     sim_switches = sim_switches & ~(SWMASK ('C'));
+    if (copy_cdk)
+        sim_disk_set_fmt (uptr, 0, "AUTO", NULL);       /* detect the source format */
     cptr = get_glyph_nc (cptr, gbuf, 0);                /* get spec */
     if (*cptr == 0)                                     /* must be more */
         return SCPE_2FARG;
@@ -1613,11 +2252,13 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
     sim_quiet = saved_sim_quiet;
     if (r != SCPE_OK) {
         sim_switches = saved_sim_switches;
+        if (copy_cdk)
+            sim_disk_set_fmt (uptr, 0, "CDK", NULL);
         return sim_messagef (r, "Can't open source VHD: %s\n", cptr);
         }
     sim_messagef (SCPE_OK, "%s%d: creating new virtual disk '%s'\n", sim_dname (dptr), (int)(uptr-dptr->units), gbuf);
     capac_factor = ((dptr->dwidth / dptr->aincr) == 16) ? 2 : 1; /* capacity units (word: 2, byte: 1) */
-    vhd = sim_vhd_disk_create (gbuf, ((t_offset)uptr->capac)*capac_factor*((dptr->flags & DEV_SECTORS) ? 512 : 1));
+    vhd = copy_create (gbuf, ((t_offset)uptr->capac)*capac_factor*((dptr->flags & DEV_SECTORS) ? 512 : 1));
     if (!vhd) {
         return sim_messagef (r, "%s%d: can't create virtual disk '%s'\n", sim_dname (dptr), (int)(uptr-dptr->units), gbuf);
         }
@@ -1629,7 +2270,7 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
         t_seccnt sects = sectors_per_buffer;
 
         if (!copy_buf) {
-            sim_vhd_disk_close(vhd);
+            copy_close (vhd);
             (void)remove (gbuf);
             return SCPE_MEM;
             }
@@ -1646,7 +2287,7 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
                 FILE *save_unit_fileref = uptr->fileref;
                 t_seccnt sects_written;
 
-                sim_disk_set_fmt (uptr, 0, "VHD", NULL);
+                sim_disk_set_fmt (uptr, 0, copy_fmt, NULL);
                 uptr->fileref = vhd;
                 r = sim_disk_wrsect (uptr, lba, copy_buf, &sects_written, sects_read);
                 uptr->fileref = save_unit_fileref;
@@ -1663,7 +2304,7 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
             uint8 *verify_buf = (uint8*) malloc (1024*1024);
 
             if (!verify_buf) {
-                sim_vhd_disk_close(vhd);
+                copy_close (vhd);
                 (void)remove (gbuf);
                 free (copy_buf);
                 return SCPE_MEM;
@@ -1678,7 +2319,7 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
                     uint32 saved_unit_flags = uptr->flags;
                     FILE *save_unit_fileref = uptr->fileref;
 
-                    sim_disk_set_fmt (uptr, 0, "VHD", NULL);
+                    sim_disk_set_fmt (uptr, 0, copy_fmt, NULL);
                     uptr->fileref = vhd;
                     r = sim_disk_rdsect (uptr, lba, verify_buf, NULL, sects);
                     uptr->fileref = save_unit_fileref;
@@ -1712,14 +2353,14 @@ if (sim_switches & SWMASK ('C')) {                      /* create vhd disk & cop
             free (verify_buf);
             }
         free (copy_buf);
-        sim_vhd_disk_close (vhd);
+        copy_close (vhd);
         sim_disk_detach (uptr);
         if (r == SCPE_OK) {
             created = TRUE;
             copied = TRUE;
             strlcpy (tbuf, gbuf, sizeof(tbuf)-1);
             cptr = tbuf;
-            sim_disk_set_fmt (uptr, 0, "VHD", NULL);
+            sim_disk_set_fmt (uptr, 0, copy_fmt, NULL);
             sim_switches = saved_sim_switches;
             }
         else
@@ -1749,6 +2390,12 @@ else
 switch (DK_GET_FMT (uptr)) {                            /* case on format */
     case DKUF_F_AUTO:                                   /* SIMH format */
         auto_format = TRUE;
+        if (sim_cdk_disk_check (cptr)) {                /* Try CDK */
+            sim_disk_set_fmt (uptr, 0, "CDK", NULL);    /* set file format to CDK */
+            open_function = sim_cdk_disk_open;
+            size_function = sim_cdk_disk_size;
+            break;
+            }
         if (NULL != (uptr->fileref = sim_vhd_disk_open (cptr, "rb"))) { /* Try VHD */
             sim_disk_set_fmt (uptr, 0, "VHD", NULL);    /* set file format to VHD */
             sim_vhd_disk_close (uptr->fileref);         /* close vhd file*/
@@ -1779,6 +2426,11 @@ switch (DK_GET_FMT (uptr)) {                            /* case on format */
         create_function = sim_vhd_disk_create;
         size_function = sim_vhd_disk_size;
         break;
+    case DKUF_F_CDK:                                    /* CDK format */
+        open_function = sim_cdk_disk_open;
+        create_function = sim_cdk_disk_create;
+        size_function = sim_cdk_disk_size;
+        break;
     case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
         open_function = sim_os_disk_open_raw;
         size_function = sim_os_disk_size_raw;
@@ -1801,7 +2453,15 @@ ctx->media_removed = 0;                                 /* default present */
 sim_debug_unit (ctx->dbit, uptr, "sim_disk_attach(unit=%d,filename='%s')\n", (int)(uptr-ctx->dptr->units), uptr->filename);
 ctx->auto_format = auto_format;                         /* save that we auto selected format */
 ctx->storage_sector_size = (uint32)sector_size;         /* Default */
-if ((sim_switches & SWMASK ('R')) ||                    /* read only? */
+if (overlay && ((uptr->flags & UNIT_RO) == 0)) {        /* private write overlay? */
+    ctx->overlay = TRUE;
+    ctx->overlay_readonly = ((sim_switches & SWMASK ('R')) != 0);
+    uptr->fileref = open_function (cptr, "rb");         /* COMMIT reopens it r/w */
+    if (uptr->fileref == NULL)
+        return _err_return (uptr, SCPE_OPENERR);
+    sim_messagef (SCPE_OK, "%s%d: writes are kept in a private overlay\n", sim_dname (dptr), (int)(uptr-dptr->units));
+    }
+else if ((sim_switches & SWMASK ('R')) ||               /* read only? */
     ((uptr->flags & UNIT_RO) != 0)) {
     if (((uptr->flags & UNIT_ROABLE) == 0) &&           /* allowed? */
         ((uptr->flags & UNIT_RO) == 0))
@@ -1848,8 +2508,20 @@ if (DK_GET_FMT (uptr) == DKUF_F_VHD) {
         set_cmd (0, cmd);
         }
     }
+if (DK_GET_FMT (uptr) == DKUF_F_CDK) {
+    if ((created) && dtype)
+        sim_cdk_disk_set_dtype (uptr->fileref, dtype);
+    if (dtype && *sim_cdk_disk_get_dtype (uptr->fileref) &&
+        strcmp (dtype, sim_cdk_disk_get_dtype (uptr->fileref))) {
+        char cmd[32];
+
+        sprintf (cmd, "%s%d %s", dptr->name, (int)(uptr-dptr->units), sim_cdk_disk_get_dtype (uptr->fileref));
+        set_cmd (0, cmd);
+        }
+    }
 uptr->flags = uptr->flags | UNIT_ATT;
 uptr->pos = 0;
+_disk_positional_start (uptr);
 
 /* Get Device attributes if they are available */
 if (storage_function)
@@ -2039,6 +2711,15 @@ if (container_size && (container_size != (t_offset)-1)) {
         }
     }
 
+if (map_container) {
+    t_stat r = _sim_disk_mmap (uptr);
+
+    if (r != SCPE_OK) {
+        sim_disk_detach (uptr);
+        return r;
+        }
+    }
+
 #if defined (SIM_ASYNCH_IO)
 sim_disk_set_async (uptr, completion_delay);
 #endif
@@ -2071,6 +2752,9 @@ switch (DK_GET_FMT (uptr)) {                            /* case on format */
     case DKUF_F_VHD:                                    /* Virtual Disk */
         close_function = sim_vhd_disk_close;
         break;
+    case DKUF_F_CDK:                                    /* Clustered Disk */
+        close_function = sim_cdk_disk_close;
+        break;
     case DKUF_F_RAW:                                    /* Physical */
         close_function = sim_os_disk_close_raw;
         break;
@@ -2090,6 +2774,12 @@ if (uptr->io_flush)
 
 sim_disk_clr_async (uptr);
 
+_sim_disk_munmap (uptr);
+
+if (ctx->overlay_sectors)
+    sim_debug_unit (ctx->dbit, uptr, "sim_disk_detach(unit=%d) discarding %u overlay sectors\n", (int)(uptr-ctx->dptr->units), ctx->overlay_sectors);
+_disk_overlay_free (ctx);
+
 uptr->flags &= ~(UNIT_ATT | UNIT_RO);
 uptr->dynflags &= ~(UNIT_NO_FIO | UNIT_DISK_CHK);
 free (uptr->filename);
@@ -2109,13 +2799,16 @@ t_stat sim_disk_attach_help(FILE *st, DEVICE *dptr, UNIT *uptr, int32 flag, cons
 {
 fprintf (st, "%s Disk Attach Help\n\n", dptr->name);
 
-fprintf (st, "Disk container files can be one of 3 different types:\n\n");
+fprintf (st, "Disk container files can be one of 4 different types:\n\n");
 fprintf (st, "    SIMH   A disk is an unstructured binary file of the size appropriate\n");
 fprintf (st, "           for the disk drive being simulated\n");
 fprintf (st, "    VHD    Virtual Disk format which is described in the \"Microsoft\n");
 fprintf (st, "           Virtual Hard Disk (VHD) Image Format Specification\".  The\n");
 fprintf (st, "           VHD implementation includes support for 1) Fixed (Preallocated)\n");
 fprintf (st, "           disks, 2) Dynamically Expanding disks, and 3) Differencing disks.\n");
+fprintf (st, "    CDK    Clustered Disk format, a simh native container which only stores\n");
+fprintf (st, "           clusters which have been written, shares the storage of identical\n");
+fprintf (st, "           clusters and compresses cluster contents where that saves space.\n");
 fprintf (st, "    RAW    platform specific access to physical disk or CDROM drives\n\n");
 fprintf (st, "Virtual (VHD) Disks  supported conform to \"Virtual Hard Disk Image Format\n");
 fprintf (st, "Specification\", Version 1.0 October 11, 2006.\n");
@@ -2128,6 +2821,12 @@ fprintf (st, "which describes the drive size and the simh device type in use whe
 fprintf (st, "was created.  This metadata is therefore available whenever that VHD is\n");
 fprintf (st, "attached to an emulated disk device in the future so the device type and\n");
 fprintf (st, "size can be automatically be configured.\n\n");
+fprintf (st, "Clustered (CDK) Disks are created when the -F CDK switch is specified and are\n");
+fprintf (st, "subsequently autodetected.  Like dynamically expanding VHDs they record the\n");
+fprintf (st, "simh device type and only grow as data is written.  Clusters containing only\n");
+fprintf (st, "zeros occupy no space and clusters with identical contents are stored once.\n");
+fprintf (st, "An existing disk can be converted with:\n\n");
+fprintf (st, "  sim> ATTACH -F -C %s CDK newdisk.cdk olddisk\n\n", dptr->name);
 
 if (0 == (uptr-dptr->units)) {
     if (dptr->numunits > 1) {
@@ -2147,8 +2846,8 @@ fprintf (st, "    -R          Attach Read Only.\n");
 fprintf (st, "    -E          Must Exist (if not specified an attempt to create the indicated\n");
 fprintf (st, "                disk container will be attempted).\n");
 fprintf (st, "    -F          Open the indicated disk container in a specific format (default\n");
-fprintf (st, "                is to autodetect VHD defaulting to simh if the indicated\n");
-fprintf (st, "                container is not a VHD).\n");
+fprintf (st, "                is to autodetect VHD or CDK defaulting to simh if the indicated\n");
+fprintf (st, "                container is neither).\n");
 fprintf (st, "    -I          Initialize newly created disk so that each sector contains its\n");
 fprintf (st, "                sector address\n");
 fprintf (st, "    -K          Verify that the disk contents contain the sector address in each\n");
@@ -2156,6 +2855,7 @@ fprintf (st, "                sector.  Whole disk checked at attach time and eac
 fprintf (st, "                checked when written.\n");
 fprintf (st, "    -C          Create a VHD and copy its contents from another disk (simh, VHD,\n");
 fprintf (st, "                or RAW format). Add a -V switch to verify a copy operation.\n");
+fprintf (st, "                Combined with -F CDK a CDK container is created instead.\n");
 fprintf (st, "    -V          Perform a verification pass to confirm successful data copy\n");
 fprintf (st, "                operation.\n");
 fprintf (st, "    -X          When creating a VHD, create a fixed sized VHD (vs a Dynamically\n");
@@ -2166,6 +2866,15 @@ fprintf (st, "    -M          Merge a Differencing VHD into its parent VHD disk\
 fprintf (st, "    -O          Override consistency checks when attaching differencing disks\n");
 fprintf (st, "                which have unexpected parent disk GUID or timestamps\n\n");
 fprintf (st, "    -U          Fix inconsistencies which are overridden by the -O switch\n");
+fprintf (st, "    -P          Memory map a SIMH format disk container.  Transfers are\n");
+fprintf (st, "                performed directly against the host's page cache.  A writable\n");
+fprintf (st, "                container is extended to the full size of the simulated drive.\n");
+fprintf (st, "    -S          Keep all writes in a private in memory overlay rather than the\n");
+fprintf (st, "                disk container, which must already exist and is opened read only.\n");
+fprintf (st, "                Only drives with the COMMIT and DISCARD modifiers accept -S.\n");
+fprintf (st, "                SET %s COMMIT reopens the container for writing and writes\n", dptr->name);
+fprintf (st, "                the overlay to it, and SET %s DISCARD drops it.  The overlay\n", dptr->name);
+fprintf (st, "                is discarded on detach.  With -R the container can't be committed.\n");
 fprintf (st, "    -Y          Answer Yes to prompt to overwrite last track (on disk create)\n");
 fprintf (st, "    -N          Answer No to prompt to overwrite last track (on disk create)\n");
 fprintf (st, "Examples:\n");
@@ -2255,6 +2964,7 @@ if (!(uptr->flags & UNIT_ATTABLE))                      /* not attachable? */
 switch (DK_GET_FMT (uptr)) {                            /* case on format */
     case DKUF_F_STD:                                    /* SIMH format */
     case DKUF_F_VHD:                                    /* VHD format */
+    case DKUF_F_CDK:                                    /* CDK format */
     case DKUF_F_RAW:                                    /* Raw Physical Disk Access */
 #if defined(_WIN32)
         saved_errno = GetLastError ();
@@ -4919,7 +5629,1283 @@ return WriteVirtualDiskSectors(hVHD, buf, sects, sectswritten, ctx->sector_size,
 }
 #endif
 
+/* Clustered disk (CDK) container support
+
+   A CDK container holds a disk as fixed size clusters.  Clusters which
+   have never been written, or which only contain zeros, occupy no space.
+   Clusters with identical contents share a single stored chunk, found by
+   a 64 bit content hash and confirmed by comparing the data, and each
+   stored chunk is LZSS compressed when that saves space.
+
+   File layout (all fields little endian):
+
+       Header     CDK_HEADER_SIZE bytes
+       Data       stored chunks, each a whole number of CDK_UNIT bytes
+       Metadata   cluster map (a chunk id for each cluster, 0 = zeros)
+                  followed by the chunk table, written after the data
+                  when the container is flushed or closed
+
+   The cluster map and chunk table live in memory while the container
+   is open.  Chunks no longer referenced by any cluster are kept on
+   free lists by size and reused.
+
+   The last saved metadata is a consistent checkpoint of the disk: it
+   is never overwritten while it is current, and chunks freed after it
+   was written only become reusable once the next save has replaced it.
+   The header dirty flag is set before the first data write following
+   a save and cleared by the next save.  A container which wasn't closed
+   cleanly can be opened read only, presenting the disk as of its last
+   save, or opened read/write, which rolls it back to that save.  Each
+   save goes into the space left by the save before last when it fits
+   there (metadata space is allocated with some slack for that), and
+   otherwise after the data. */
+
+#define CDK_MAGIC           "SIMH-CDK"
+#define CDK_VERSION         1
+#define CDK_HEADER_SIZE     512
+#define CDK_UNIT            512                 /* data area allocation unit */
+#define CDK_CLUSTER_SIZE    4096                /* cluster size of new containers */
+#define CDK_CHUNK_RECORD    32                  /* size of an on disk chunk table entry */
+#define CDK_F_COMPRESSED    1                   /* chunk is stored compressed */
+#define CDK_LZ_HASH_SIZE    4096                /* LZSS match finder table entries */
+#define CDK_UNITS(len)      (((len) + CDK_UNIT - 1) / CDK_UNIT)
+#define CDK_ROUND(pos)      (CDK_UNITS (pos) * CDK_UNIT)
+
+typedef struct {
+    t_offset            offset;                 /* file offset of stored data */
+    uint32              length;                 /* stored length in bytes */
+    uint32              flags;                  /* CDK_F_xxx */
+    uint32              refs;                   /* clusters referencing (0 = free) */
+    uint32              next;                   /* hash chain or free list link */
+    t_uint64            hash;                   /* hash of uncompressed contents */
+    } CDK_CHUNK;
+
+typedef struct {
+    FILE                *File;
+    t_bool              readonly;
+    t_bool              dirty;                  /* metadata on disk is stale */
+    char                dtype[16];              /* simulated drive type */
+    uint32              cluster_size;
+    uint32              clusters;               /* cluster map entries */
+    t_offset            disk_size;              /* virtual disk size in bytes */
+    t_offset            data_end;               /* end of the data area */
+    t_offset            meta_offset;            /* last saved metadata */
+    t_offset            meta_end;
+    t_offset            spare_offset;           /* metadata saved before that */
+    t_offset            spare_end;
+    uint8               header[CDK_HEADER_SIZE];/* header of the last save */
+    uint32              *map;                   /* chunk id for each cluster */
+    CDK_CHUNK           *chunks;                /* chunk table (entry 0 unused) */
+    uint32              chunk_count;            /* chunk table entries in use */
+    uint32              chunk_alloc;            /* chunk table entries allocated */
+    uint32              *hash_heads;            /* dedup hash buckets */
+    uint32              hash_size;              /* bucket count (power of 2) */
+    uint32              *free_heads;            /* free chunk lists by size in units */
+    uint32              pending_free;           /* chunks freed since the last save */
+    uint32              cached_chunk;           /* chunk currently in cbuf */
+    uint8               *cbuf;                  /* read cache */
+    uint8               *wbuf;                  /* partial cluster write merge */
+    uint8               *tbuf;                  /* dedup comparison */
+    uint8               *zbuf;                  /* compressed data */
+    } CDK_DISK, *CDKHANDLE;
+
+static void _cdk_put32 (uint8 *p, uint32 val)
+{
+p[0] = (uint8)val;
+p[1] = (uint8)(val >> 8);
+p[2] = (uint8)(val >> 16);
+p[3] = (uint8)(val >> 24);
+}
+
+static void _cdk_put64 (uint8 *p, t_uint64 val)
+{
+_cdk_put32 (p, (uint32)val);
+_cdk_put32 (p + 4, (uint32)(val >> 32));
+}
+
+static uint32 _cdk_get32 (const uint8 *p)
+{
+return ((uint32)p[0]) | (((uint32)p[1]) << 8) | (((uint32)p[2]) << 16) | (((uint32)p[3]) << 24);
+}
+
+static t_uint64 _cdk_get64 (const uint8 *p)
+{
+return ((t_uint64)_cdk_get32 (p)) | (((t_uint64)_cdk_get32 (p + 4)) << 32);
+}
+
+/* FNV-1a hash of a cluster's contents */
+
+static t_uint64 _cdk_hash (const uint8 *data, uint32 len)
+{
+t_uint64 hash = 0xCBF29CE484222325ULL;
+uint32 i;
+
+for (i = 0; i < len; i++) {
+    hash ^= data[i];
+    hash *= 0x100000001B3ULL;
+    }
+return hash;
+}
+
+/* LZSS compression.  Each flag byte describes the next 8 items, a set bit
+   is a 2 byte match (12 bit distance, 4 bit length - 3) and a clear bit
+   is a literal byte.  Returns 0 when the result wouldn't fit in dst_max. */
+
+static uint32 _cdk_compress (const uint8 *src, uint32 len, uint8 *dst, uint32 dst_max)
+{
+uint16 table[CDK_LZ_HASH_SIZE];
+uint32 ip = 0, op = 0, flag_pos = 0;
+int bit = 8;
+
+memset (table, 0, sizeof (table));
+while (ip < len) {
+    uint32 match_len = 0, match_off = 0;
+
+    if (bit == 8) {
+        if (op >= dst_max)
+            return 0;
+        flag_pos = op++;
+        dst[flag_pos] = 0;
+        bit = 0;
+        }
+    if (ip + 3 <= len) {
+        uint32 h = ((src[ip] << 4) ^ (src[ip + 1] << 2) ^ src[ip + 2] ^ (src[ip] >> 4)) & (CDK_LZ_HASH_SIZE - 1);
+        uint32 cand = table[h];
+
+        table[h] = (uint16)(ip + 1);
+        if (cand && ((ip - (cand - 1)) <= 0xFFF)) {
+            uint32 max = len - ip;
+
+            if (max > 18)
+                max = 18;
+            while ((match_len < max) && (src[cand - 1 + match_len] == src[ip + match_len]))
+                ++match_len;
+            match_off = ip - (cand - 1);
+            }
+        }
+    if (match_len >= 3) {
+        if (op + 2 > dst_max)
+            return 0;
+        dst[flag_pos] |= (uint8)(1 << bit);
+        dst[op++] = (uint8)(match_off >> 4);
+        dst[op++] = (uint8)(((match_off & 0xF) << 4) | (match_len - 3));
+        ip += match_len;
+        }
+    else {
+        if (op >= dst_max)
+            return 0;
+        dst[op++] = src[ip++];
+        }
+    ++bit;
+    }
+return op;
+}
+
+static t_bool _cdk_decompress (const uint8 *src, uint32 len, uint8 *dst, uint32 dst_len)
+{
+uint32 ip = 0, op = 0;
+uint8 flags = 0;
+int bit = 8;
+
+while (op < dst_len) {
+    if (bit == 8) {
+        if (ip >= len)
+            return FALSE;
+        flags = src[ip++];
+        bit = 0;
+        }
+    if (flags & (1 << bit)) {
+        uint32 off, mlen;
+
+        if (ip + 2 > len)
+            return FALSE;
+        off = (((uint32)src[ip]) << 4) | (src[ip + 1] >> 4);
+        mlen = (src[ip + 1] & 0xF) + 3;
+        ip += 2;
+        if ((off == 0) || (off > op) || (op + mlen > dst_len))
+            return FALSE;
+        while (mlen--) {
+            dst[op] = dst[op - off];
+            ++op;
+            }
+        }
+    else {
+        if (ip >= len)
+            return FALSE;
+        dst[op++] = src[ip++];
+        }
+    ++bit;
+    }
+return TRUE;
+}
+
+static t_stat _cdk_write_header (CDKHANDLE hCDK, const uint8 *header)
+{
+if (sim_fseeko (hCDK->File, 0, SEEK_SET) ||
+    (CDK_HEADER_SIZE != fwrite (header, 1, CDK_HEADER_SIZE, hCDK->File)) ||
+    fflush (hCDK->File))
+    return SCPE_IOERR;
+return SCPE_OK;
+}
+
+/* Write the cluster map and chunk table and point the header at them */
+
+static t_stat _cdk_save (CDKHANDLE hCDK)
+{
+uint8 rec[CDK_CHUNK_RECORD];
+uint8 *header = hCDK->header;
+t_offset size = (t_offset)hCDK->clusters * 4 + (t_offset)hCDK->chunk_count * CDK_CHUNK_RECORD;
+t_offset offset, end;
+uint32 i;
+t_stat r;
+
+if ((!hCDK->dirty) || hCDK->readonly)
+    return SCPE_OK;
+if (hCDK->spare_end - hCDK->spare_offset >= size) {    /* fits where the save before last was? */
+    offset = hCDK->spare_offset;
+    end = hCDK->spare_end;
+    }
+else {                                          /* no, after the data and the last save */
+    offset = hCDK->data_end;
+    if (offset < CDK_ROUND (hCDK->meta_end))
+        offset = CDK_ROUND (hCDK->meta_end);
+    if (offset < CDK_ROUND (hCDK->spare_end))
+        offset = CDK_ROUND (hCDK->spare_end);
+    end = offset + CDK_ROUND (size + size / 4);
+    }
+if (sim_fseeko (hCDK->File, offset, SEEK_SET))
+    return SCPE_IOERR;
+for (i = 0; i < hCDK->clusters; i++) {
+    _cdk_put32 (rec, hCDK->map[i]);
+    if (4 != fwrite (rec, 1, 4, hCDK->File))
+        return SCPE_IOERR;
+    }
+for (i = 0; i < hCDK->chunk_count; i++) {
+    CDK_CHUNK *chunk = &hCDK->chunks[i];
+
+    memset (rec, 0, sizeof (rec));
+    _cdk_put64 (&rec[0], (t_uint64)chunk->offset);
+    _cdk_put32 (&rec[8], chunk->length);
+    _cdk_put32 (&rec[12], chunk->flags);
+    _cdk_put32 (&rec[16], chunk->refs);
+    _cdk_put64 (&rec[24], chunk->hash);
+    if (sizeof (rec) != fwrite (rec, 1, sizeof (rec), hCDK->File))
+        return SCPE_IOERR;
+    }
+memset (header, 0, CDK_HEADER_SIZE);
+memcpy (header, CDK_MAGIC, 8);
+_cdk_put32 (&header[8], CDK_VERSION);
+_cdk_put32 (&header[12], hCDK->cluster_size);
+_cdk_put32 (&header[16], hCDK->clusters);
+_cdk_put32 (&header[20], hCDK->chunk_count);
+_cdk_put64 (&header[24], (t_uint64)hCDK->disk_size);
+_cdk_put64 (&header[32], (t_uint64)hCDK->data_end);
+_cdk_put64 (&header[40], (t_uint64)offset);
+memcpy (&header[56], hCDK->dtype, sizeof (hCDK->dtype));
+_cdk_put64 (&header[72], (t_uint64)end);
+if (offset == hCDK->spare_offset) {             /* last save becomes the spare */
+    _cdk_put64 (&header[80], (t_uint64)hCDK->meta_offset);
+    _cdk_put64 (&header[88], (t_uint64)hCDK->meta_end);
+    }
+else if (hCDK->spare_end - hCDK->spare_offset > hCDK->meta_end - hCDK->meta_offset) {
+    _cdk_put64 (&header[80], (t_uint64)hCDK->spare_offset);
+    _cdk_put64 (&header[88], (t_uint64)hCDK->spare_end);
+    }
+else {
+    _cdk_put64 (&header[80], (t_uint64)hCDK->meta_offset);
+    _cdk_put64 (&header[88], (t_uint64)hCDK->meta_end);
+    }
+if (fflush (hCDK->File))                        /* metadata before the header */
+    return SCPE_IOERR;
+r = _cdk_write_header (hCDK, header);
+if (r != SCPE_OK)
+    return r;
+hCDK->meta_offset = offset;
+hCDK->meta_end = end;
+hCDK->spare_offset = (t_offset)_cdk_get64 (&header[80]);
+hCDK->spare_end = (t_offset)_cdk_get64 (&header[88]);
+while (hCDK->pending_free) {                    /* no longer part of a checkpoint */
+    CDK_CHUNK *chunk = &hCDK->chunks[hCDK->pending_free];
+    uint32 id = hCDK->pending_free;
+
+    hCDK->pending_free = chunk->next;
+    chunk->next = hCDK->free_heads[CDK_UNITS (chunk->length)];
+    hCDK->free_heads[CDK_UNITS (chunk->length)] = id;
+    }
+hCDK->dirty = FALSE;
+return SCPE_OK;
+}
+
+/* Mark the container dirty before data written after the last save.
+   The header still describes that save, and the data area moves past
+   its metadata (and the spare) so they aren't overwritten */
+
+static t_stat _cdk_set_dirty (CDKHANDLE hCDK)
+{
+uint8 header[CDK_HEADER_SIZE];
+
+if (hCDK->dirty)
+    return SCPE_OK;
+if (hCDK->data_end < CDK_ROUND (hCDK->meta_end))
+    hCDK->data_end = CDK_ROUND (hCDK->meta_end);
+if (hCDK->data_end < CDK_ROUND (hCDK->spare_end))
+    hCDK->data_end = CDK_ROUND (hCDK->spare_end);
+memcpy (header, hCDK->header, sizeof (header));
+_cdk_put32 (&header[48], TRUE);
+hCDK->dirty = TRUE;
+return _cdk_write_header (hCDK, header);
+}
+
+static void _cdk_rehash (CDKHANDLE hCDK)
+{
+uint32 size = 1024;
+uint32 i;
+
+while (size < 2 * hCDK->chunk_count)
+    size <<= 1;
+if (size != hCDK->hash_size) {
+    uint32 *heads = (uint32 *)calloc (size, sizeof (*heads));
+
+    if (heads == NULL)                          /* keep longer chains */
+        return;
+    free (hCDK->hash_heads);
+    hCDK->hash_heads = heads;
+    hCDK->hash_size = size;
+    }
+else
+    memset (hCDK->hash_heads, 0, size * sizeof (*hCDK->hash_heads));
+for (i = 1; i < hCDK->chunk_count; i++) {
+    CDK_CHUNK *chunk = &hCDK->chunks[i];
+
+    if (chunk->refs) {
+        chunk->next = hCDK->hash_heads[chunk->hash & (hCDK->hash_size - 1)];
+        hCDK->hash_heads[chunk->hash & (hCDK->hash_size - 1)] = i;
+        }
+    }
+}
+
+/* Load a chunk's uncompressed contents */
+
+static t_stat _cdk_load_chunk (CDKHANDLE hCDK, uint32 id, uint8 *buf)
+{
+CDK_CHUNK *chunk = &hCDK->chunks[id];
+uint8 *dest = (chunk->flags & CDK_F_COMPRESSED) ? hCDK->zbuf : buf;
+
+if (sim_fseeko (hCDK->File, chunk->offset, SEEK_SET) ||
+    (chunk->length != fread (dest, 1, chunk->length, hCDK->File)))
+    return SCPE_IOERR;
+if ((chunk->flags & CDK_F_COMPRESSED) &&
+    (!_cdk_decompress (hCDK->zbuf, chunk->length, buf, hCDK->cluster_size)))
+    return SCPE_IOERR;
+return SCPE_OK;
+}
+
+static t_stat _cdk_read_cluster (CDKHANDLE hCDK, uint32 cluster, uint8 *buf)
+{
+uint32 id = (cluster < hCDK->clusters) ? hCDK->map[cluster] : 0;
+t_stat r;
+
+if (id == 0) {
+    memset (buf, 0, hCDK->cluster_size);
+    return SCPE_OK;
+    }
+if (id != hCDK->cached_chunk) {
+    hCDK->cached_chunk = 0;
+    r = _cdk_load_chunk (hCDK, id, hCDK->cbuf);
+    if (r != SCPE_OK)
+        return r;
+    hCDK->cached_chunk = id;
+    }
+if (buf != hCDK->cbuf)
+    memcpy (buf, hCDK->cbuf, hCDK->cluster_size);
+return SCPE_OK;
+}
+
+static void _cdk_release_chunk (CDKHANDLE hCDK, uint32 id)
+{
+CDK_CHUNK *chunk = &hCDK->chunks[id];
+uint32 *link;
+
+if ((id == 0) || (--chunk->refs != 0))
+    return;
+for (link = &hCDK->hash_heads[chunk->hash & (hCDK->hash_size - 1)]; *link; link = &hCDK->chunks[*link].next)
+    if (*link == id) {
+        *link = chunk->next;
+        break;
+        }
+chunk->next = hCDK->pending_free;               /* reusable after the next save */
+hCDK->pending_free = id;
+if (hCDK->cached_chunk == id)
+    hCDK->cached_chunk = 0;
+}
+
+/* Find a chunk with the given contents, or store a new one */
+
+static t_stat _cdk_find_or_store (CDKHANDLE hCDK, const uint8 *data, uint32 *pid)
+{
+t_uint64 hash = _cdk_hash (data, hCDK->cluster_size);
+uint32 id, length, flags = 0;
+const uint8 *stored = data;
+CDK_CHUNK *chunk;
+
+for (id = hCDK->hash_heads[hash & (hCDK->hash_size - 1)]; id; id = hCDK->chunks[id].next) {
+    if ((hCDK->chunks[id].hash == hash) &&
+        (SCPE_OK == _cdk_load_chunk (hCDK, id, hCDK->tbuf)) &&
+        (0 == memcmp (hCDK->tbuf, data, hCDK->cluster_size))) {
+        ++hCDK->chunks[id].refs;
+        *pid = id;
+        return SCPE_OK;
+        }
+    }
+length = _cdk_compress (data, hCDK->cluster_size, hCDK->zbuf, hCDK->cluster_size - CDK_UNIT);
+if (length) {
+    flags = CDK_F_COMPRESSED;
+    stored = hCDK->zbuf;
+    }
+else
+    length = hCDK->cluster_size;
+id = hCDK->free_heads[CDK_UNITS (length)];
+if (id)                                         /* reuse a free chunk of the same size */
+    hCDK->free_heads[CDK_UNITS (length)] = hCDK->chunks[id].next;
+else {
+    if (hCDK->chunk_count == hCDK->chunk_alloc) {
+        uint32 alloc = hCDK->chunk_alloc ? 2 * hCDK->chunk_alloc : 1024;
+        CDK_CHUNK *chunks = (CDK_CHUNK *)realloc (hCDK->chunks, alloc * sizeof (*chunks));
+
+        if (chunks == NULL)
+            return SCPE_MEM;
+        hCDK->chunks = chunks;
+        hCDK->chunk_alloc = alloc;
+        }
+    id = hCDK->chunk_count++;
+    hCDK->chunks[id].offset = hCDK->data_end;
+    hCDK->data_end += CDK_UNITS (length) * CDK_UNIT;
+    }
+chunk = &hCDK->chunks[id];
+chunk->length = length;
+chunk->flags = flags;
+chunk->refs = 1;
+chunk->hash = hash;
+if (hCDK->cached_chunk == id)
+    hCDK->cached_chunk = 0;
+if (sim_fseeko (hCDK->File, chunk->offset, SEEK_SET) ||
+    (length != fwrite (stored, 1, length, hCDK->File))) {
+    chunk->refs = 0;                            /* return it to the free list */
+    chunk->next = hCDK->free_heads[CDK_UNITS (length)];
+    hCDK->free_heads[CDK_UNITS (length)] = id;
+    return SCPE_IOERR;
+    }
+chunk->next = hCDK->hash_heads[hash & (hCDK->hash_size - 1)];
+hCDK->hash_heads[hash & (hCDK->hash_size - 1)] = id;
+if (hCDK->chunk_count > 2 * hCDK->hash_size)
+    _cdk_rehash (hCDK);
+*pid = id;
+return SCPE_OK;
+}
+
+static t_stat _cdk_write_cluster (CDKHANDLE hCDK, uint32 cluster, const uint8 *data)
+{
+uint32 old_id, new_id = 0;
+uint32 i;
+t_stat r;
+
+if (cluster >= hCDK->clusters) {                /* extend the disk */
+    uint32 clusters = cluster + 1;
+    uint32 *map = (uint32 *)realloc (hCDK->map, clusters * sizeof (*map));
+
+    if (map == NULL)
+        return SCPE_MEM;
+    memset (map + hCDK->clusters, 0, (clusters - hCDK->clusters) * sizeof (*map));
+    hCDK->map = map;
+    hCDK->clusters = clusters;
+    }
+for (i = 0; (i < hCDK->cluster_size) && (data[i] == 0); i++)
+    ;
+if (i < hCDK->cluster_size) {                   /* not all zeros? */
+    r = _cdk_find_or_store (hCDK, data, &new_id);
+    if (r != SCPE_OK)
+        return r;
+    }
+old_id = hCDK->map[cluster];
+hCDK->map[cluster] = new_id;
+_cdk_release_chunk (hCDK, old_id);
+return SCPE_OK;
+}
+
+static void _cdk_free (CDKHANDLE hCDK)
+{
+if (hCDK->File)
+    fclose (hCDK->File);
+free (hCDK->map);
+free (hCDK->chunks);
+free (hCDK->hash_heads);
+free (hCDK->free_heads);
+free (hCDK->cbuf);
+free (hCDK->wbuf);
+free (hCDK->tbuf);
+free (hCDK->zbuf);
+free (hCDK);
+}
+
+static CDKHANDLE _cdk_alloc (FILE *File, uint32 cluster_size)
+{
+CDKHANDLE hCDK = (CDKHANDLE)calloc (1, sizeof (*hCDK));
+
+if (hCDK == NULL)
+    return NULL;
+hCDK->File = File;
+hCDK->cluster_size = cluster_size;
+hCDK->free_heads = (uint32 *)calloc (CDK_UNITS (cluster_size) + 1, sizeof (*hCDK->free_heads));
+hCDK->cbuf = (uint8 *)malloc (cluster_size);
+hCDK->wbuf = (uint8 *)malloc (cluster_size);
+hCDK->tbuf = (uint8 *)malloc (cluster_size);
+hCDK->zbuf = (uint8 *)malloc (cluster_size);
+if ((hCDK->free_heads == NULL) || (hCDK->cbuf == NULL) || (hCDK->wbuf == NULL) ||
+    (hCDK->tbuf == NULL) || (hCDK->zbuf == NULL)) {
+    hCDK->File = NULL;
+    _cdk_free (hCDK);
+    return NULL;
+    }
+return hCDK;
+}
+
+static t_bool sim_cdk_disk_check (const char *szCDKPath)
+{
+FILE *File = sim_fopen (szCDKPath, "rb");
+char magic[8];
+t_bool is_cdk;
+
+if (File == NULL)
+    return FALSE;
+is_cdk = ((sizeof (magic) == fread (magic, 1, sizeof (magic), File)) &&
+          (0 == memcmp (magic, CDK_MAGIC, sizeof (magic))));
+fclose (File);
+return is_cdk;
+}
+
+static t_stat sim_cdk_disk_implemented (void)
+{
+return SCPE_OK;
+}
+
+static FILE *sim_cdk_disk_open (const char *szCDKPath, const char *DesiredAccess)
+{
+uint8 header[CDK_HEADER_SIZE];
+uint8 rec[CDK_CHUNK_RECORD];
+FILE *File = sim_fopen (szCDKPath, DesiredAccess);
+CDKHANDLE hCDK;
+uint32 cluster_size, chunk_count, i;
+t_offset meta_offset;
+t_bool dirty;
+
+if (File == NULL)
+    return NULL;
+if ((sizeof (header) != fread (header, 1, sizeof (header), File)) ||
+    (0 != memcmp (header, CDK_MAGIC, 8)) ||
+    (_cdk_get32 (&header[8]) != CDK_VERSION)) {
+    fclose (File);
+    return NULL;
+    }
+cluster_size = _cdk_get32 (&header[12]);
+chunk_count = _cdk_get32 (&header[20]);
+if ((cluster_size < CDK_UNIT) || (cluster_size > 65536) ||
+    (cluster_size & (cluster_size - 1)) || (chunk_count == 0)) {
+    fclose (File);
+    return NULL;
+    }
+dirty = (_cdk_get32 (&header[48]) != 0);
+hCDK = _cdk_alloc (File, cluster_size);
+if (hCDK == NULL) {
+    fclose (File);
+    return NULL;
+    }
+hCDK->readonly = (strchr (DesiredAccess, '+') == NULL);
+hCDK->clusters = _cdk_get32 (&header[16]);
+hCDK->disk_size = (t_offset)_cdk_get64 (&header[24]);
+hCDK->data_end = (t_offset)_cdk_get64 (&header[32]);
+meta_offset = (t_offset)_cdk_get64 (&header[40]);
+hCDK->meta_offset = meta_offset;
+hCDK->meta_end = (t_offset)_cdk_get64 (&header[72]);
+if (hCDK->meta_end == 0)
+    hCDK->meta_end = meta_offset + (t_offset)hCDK->clusters * 4 + (t_offset)chunk_count * CDK_CHUNK_RECORD;
+hCDK->spare_offset = (t_offset)_cdk_get64 (&header[80]);
+hCDK->spare_end = (t_offset)_cdk_get64 (&header[88]);
+_cdk_put32 (&header[48], FALSE);
+memcpy (hCDK->header, header, sizeof (header));
+memcpy (hCDK->dtype, &header[56], sizeof (hCDK->dtype));
+hCDK->dtype[sizeof (hCDK->dtype) - 1] = '\0';
+hCDK->map = (uint32 *)calloc (hCDK->clusters + 1, sizeof (*hCDK->map));
+hCDK->chunks = (CDK_CHUNK *)calloc (chunk_count, sizeof (*hCDK->chunks));
+hCDK->chunk_alloc = chunk_count;
+hCDK->chunk_count = chunk_count;
+if ((hCDK->map == NULL) || (hCDK->chunks == NULL) ||
+    sim_fseeko (File, meta_offset, SEEK_SET))
+    goto Error;
+for (i = 0; i < hCDK->clusters; i++) {
+    if (4 != fread (rec, 1, 4, File))
+        goto Error;
+    hCDK->map[i] = _cdk_get32 (rec);
+    if (hCDK->map[i] >= chunk_count)
+        goto Error;
+    }
+for (i = 0; i < chunk_count; i++) {
+    CDK_CHUNK *chunk = &hCDK->chunks[i];
+
+    if (sizeof (rec) != fread (rec, 1, sizeof (rec), File))
+        goto Error;
+    chunk->offset = (t_offset)_cdk_get64 (&rec[0]);
+    chunk->length = _cdk_get32 (&rec[8]);
+    chunk->flags = _cdk_get32 (&rec[12]);
+    chunk->hash = _cdk_get64 (&rec[24]);
+    if ((i != 0) &&
+        ((chunk->length == 0) || (chunk->length > cluster_size) ||
+         (chunk->offset < CDK_HEADER_SIZE) ||
+         (chunk->offset + chunk->length > hCDK->data_end)))
+        goto Error;
+    }
+for (i = 0; i < hCDK->clusters; i++)            /* reference counts come from the map */
+    if (hCDK->map[i])
+        ++hCDK->chunks[hCDK->map[i]].refs;
+for (i = chunk_count - 1; i > 0; i--) {
+    CDK_CHUNK *chunk = &hCDK->chunks[i];
+
+    if (chunk->refs == 0) {
+        chunk->next = hCDK->free_heads[CDK_UNITS (chunk->length)];
+        hCDK->free_heads[CDK_UNITS (chunk->length)] = i;
+        }
+    }
+_cdk_rehash (hCDK);
+if (hCDK->hash_heads == NULL)
+    goto Error;
+if (dirty) {                                    /* last session didn't close it? */
+    if (hCDK->readonly)
+        sim_printf ("CDK container %s was not closed cleanly, its contents are those of its last save\n", szCDKPath);
+    else {                                      /* roll back to the last save */
+        t_offset size = sim_fsize_ex (File);
+
+        if (hCDK->data_end < CDK_ROUND (size))  /* the rest of the file is garbage */
+            hCDK->data_end = CDK_ROUND (size);
+        hCDK->dirty = TRUE;
+        if (SCPE_OK != _cdk_save (hCDK))
+            goto Error;
+        sim_printf ("CDK container %s was not closed cleanly, recovered its contents as of its last save\n", szCDKPath);
+        }
+    }
+return (FILE *)hCDK;
+
+Error:
+_cdk_free (hCDK);
+errno = EINVAL;
+return NULL;
+}
+
+static FILE *sim_cdk_disk_create (const char *szCDKPath, t_offset desiredsize)
+{
+FILE *File;
+CDKHANDLE hCDK;
+
+File = sim_fopen (szCDKPath, "rb");
+if (File) {
+    fclose (File);
+    errno = EEXIST;
+    return NULL;
+    }
+File = sim_fopen (szCDKPath, "wb+");
+if (File == NULL)
+    return NULL;
+hCDK = _cdk_alloc (File, CDK_CLUSTER_SIZE);
+if (hCDK == NULL) {
+    fclose (File);
+    (void)remove (szCDKPath);
+    return NULL;
+    }
+hCDK->disk_size = desiredsize;
+hCDK->clusters = (uint32)((desiredsize + CDK_CLUSTER_SIZE - 1) / CDK_CLUSTER_SIZE);
+hCDK->map = (uint32 *)calloc (hCDK->clusters + 1, sizeof (*hCDK->map));
+hCDK->chunk_alloc = 1024;
+hCDK->chunks = (CDK_CHUNK *)calloc (hCDK->chunk_alloc, sizeof (*hCDK->chunks));
+hCDK->chunk_count = 1;                          /* chunk id 0 means all zeros */
+hCDK->data_end = CDK_HEADER_SIZE;
+hCDK->dirty = TRUE;                             /* force the initial save */
+_cdk_rehash (hCDK);
+if ((hCDK->map == NULL) || (hCDK->chunks == NULL) || (hCDK->hash_heads == NULL) ||
+    (SCPE_OK != _cdk_save (hCDK))) {
+    _cdk_free (hCDK);
+    (void)remove (szCDKPath);
+    return NULL;
+    }
+return (FILE *)hCDK;
+}
+
+static int sim_cdk_disk_close (FILE *f)
+{
+CDKHANDLE hCDK = (CDKHANDLE)f;
+t_stat r;
+
+if (hCDK == NULL)
+    return -1;
+r = _cdk_save (hCDK);
+_cdk_free (hCDK);
+return (r == SCPE_OK) ? 0 : EOF;
+}
+
+static void sim_cdk_disk_flush (FILE *f)
+{
+CDKHANDLE hCDK = (CDKHANDLE)f;
+
+if (hCDK)
+    _cdk_save (hCDK);
+}
+
+static t_offset sim_cdk_disk_size (FILE *f)
+{
+CDKHANDLE hCDK = (CDKHANDLE)f;
+
+return hCDK ? hCDK->disk_size : (t_offset)-1;
+}
+
+static t_stat sim_cdk_disk_set_dtype (FILE *f, const char *dtype)
+{
+CDKHANDLE hCDK = (CDKHANDLE)f;
+
+memset (hCDK->dtype, 0, sizeof (hCDK->dtype));
+strlcpy (hCDK->dtype, dtype, sizeof (hCDK->dtype));
+if (!hCDK->readonly)
+    return _cdk_set_dirty (hCDK);               /* saved with the metadata */
+return SCPE_OK;
+}
+
+static const char *sim_cdk_disk_get_dtype (FILE *f)
+{
+CDKHANDLE hCDK = (CDKHANDLE)f;
+
+return hCDK->dtype;
+}
+
+static t_stat sim_cdk_disk_rdsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectsread, t_seccnt sects)
+{
+CDKHANDLE hCDK = (CDKHANDLE)uptr->fileref;
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_offset pos = ((t_offset)lba) * ctx->sector_size;
+uint32 len = sects * ctx->sector_size;
+t_stat r;
+
+sim_debug_unit (ctx->dbit, uptr, "sim_cdk_disk_rdsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
+
+if (sectsread)
+    *sectsread = 0;
+while (len) {
+    uint32 cluster = (uint32)(pos / hCDK->cluster_size);
+    uint32 offset = (uint32)(pos % hCDK->cluster_size);
+    uint32 count = hCDK->cluster_size - offset;
+
+    if (count > len)
+        count = len;
+    if ((cluster >= hCDK->clusters) || (hCDK->map[cluster] == 0))
+        memset (buf, 0, count);
+    else {
+        r = _cdk_read_cluster (hCDK, cluster, hCDK->cbuf);
+        if (r != SCPE_OK)
+            return r;
+        memcpy (buf, hCDK->cbuf + offset, count);
+        }
+    buf += count;
+    pos += count;
+    len -= count;
+    }
+if (sectsread)
+    *sectsread = sects;
+return SCPE_OK;
+}
+
+static t_stat sim_cdk_disk_wrsect (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswritten, t_seccnt sects)
+{
+CDKHANDLE hCDK = (CDKHANDLE)uptr->fileref;
+struct disk_context *ctx = (struct disk_context *)uptr->disk_ctx;
+t_offset pos = ((t_offset)lba) * ctx->sector_size;
+uint32 len = sects * ctx->sector_size;
+t_seccnt written = 0;
+t_stat r;
+
+sim_debug_unit (ctx->dbit, uptr, "sim_cdk_disk_wrsect(unit=%d, lba=0x%X, sects=%d)\n", (int)(uptr-ctx->dptr->units), lba, sects);
+
+if (sectswritten)
+    *sectswritten = 0;
+if (hCDK->readonly)
+    return SCPE_RO;
+r = _cdk_set_dirty (hCDK);
+while ((r == SCPE_OK) && len) {
+    uint32 cluster = (uint32)(pos / hCDK->cluster_size);
+    uint32 offset = (uint32)(pos % hCDK->cluster_size);
+    uint32 count = hCDK->cluster_size - offset;
+    const uint8 *data = buf;
+
+    if (count > len)
+        count = len;
+    if (count != hCDK->cluster_size) {          /* partial cluster? */
+        r = _cdk_read_cluster (hCDK, cluster, hCDK->wbuf);
+        if (r != SCPE_OK)
+            break;
+        memcpy (hCDK->wbuf + offset, buf, count);
+        data = hCDK->wbuf;
+        }
+    r = _cdk_write_cluster (hCDK, cluster, data);
+    buf += count;
+    pos += count;
+    len -= count;
+    written = (t_seccnt)((sects * ctx->sector_size - len) / ctx->sector_size);
+    }
+if (pos > hCDK->disk_size)
+    hCDK->disk_size = pos;
+if (sectswritten)
+    *sectswritten = written;
+return r;
+}
+
+#include <setjmp.h>
+
+/* Scratch container used by the self tests: the unit settings a test
+   changes and a pair of transfer buffers */
+
+struct disk_test {
+    UNIT        *uptr;
+    const char  *filename;
+    t_addr      saved_capac;
+    uint32      saved_fmt;
+    uint32      saved_cdk;
+    size_t      dtype;                                  /* element size passed to attach */
+    t_bool      cdk;                                    /* container is CDK format */
+    uint8       *buf;                                   /* data written */
+    uint8       *rbuf;                                  /* data read back */
+    };
+
+/* Allocate size byte buffers and size the unit for capac bytes, counted
+   in sectors on devices whose capacity is in sectors */
+
+static t_stat sim_disk_test_setup (struct disk_test *t, UNIT *uptr, const char *filename, uint32 size, t_offset capac, t_bool cdk)
+{
+memset (t, 0, sizeof (*t));
+t->buf = (uint8 *)calloc (size, 1);
+t->rbuf = (uint8 *)calloc (size, 1);
+if ((t->buf == NULL) || (t->rbuf == NULL)) {
+    free (t->buf);
+    free (t->rbuf);
+    return SCPE_MEM;
+    }
+t->uptr = uptr;
+t->filename = filename;
+t->saved_capac = uptr->capac;
+t->saved_fmt = uptr->flags & DKUF_FMT;
+t->saved_cdk = uptr->dynflags & UNIT_DISK_CDK;
+t->dtype = sizeof (uint16);
+t->cdk = cdk;
+(void)remove (filename);
+if (find_dev_from_unit (uptr)->flags & DEV_SECTORS)
+    capac /= 512;
+uptr->capac = (t_addr)capac;
+if (cdk)
+    sim_disk_set_fmt (uptr, 0, "CDK", NULL);
+return SCPE_OK;
+}
+
+/* Restore the unit, remove the container and return the test's status */
+
+static t_stat sim_disk_test_done (struct disk_test *t, t_stat r)
+{
+UNIT *uptr = t->uptr;
+
+if (t->cdk)
+    sim_disk_set_fmt (uptr, 0, "AUTO", NULL);
+uptr->capac = t->saved_capac;
+uptr->flags = (uptr->flags & ~DKUF_FMT) | t->saved_fmt;
+uptr->dynflags = (uptr->dynflags & ~UNIT_DISK_CDK) | t->saved_cdk;
+(void)remove (t->filename);
+free (t->buf);
+free (t->rbuf);
+return r;
+}
+
+static t_stat sim_disk_test_attach (struct disk_test *t, const char *filename, int32 switches)
+{
+sim_switches = switches;
+return sim_disk_attach (t->uptr, filename, 512, t->dtype, TRUE, 0, "TEST", 0, 0);
+}
+
+/* Attach filename, write sects sectors of data at lba and detach */
+
+static t_stat sim_disk_test_write (struct disk_test *t, const char *filename, int32 switches, t_lba lba, uint8 *data, t_seccnt sects)
+{
+t_stat r = sim_disk_test_attach (t, filename, switches);
+
+if (r == SCPE_OK) {
+    r = sim_disk_wrsect (t->uptr, lba, data, NULL, sects);
+    sim_disk_detach (t->uptr);
+    }
+return r;
+}
+
+/* Reattach filename and check that the sects sectors at lba hold expect.
+   A CDK container must be recognized without its format being set */
+
+static t_stat sim_disk_test_verify (struct disk_test *t, const char *filename, int32 switches, t_lba lba, t_seccnt sects, const uint8 *expect)
+{
+t_seccnt sectsread = 0;
+uint32 j;
+t_stat r;
+
+if (t->cdk)
+    sim_disk_set_fmt (t->uptr, 0, "AUTO", NULL);
+memset (t->rbuf, 0xFF, sects * 512);
+r = sim_disk_test_attach (t, filename, switches);
+if (r != SCPE_OK)
+    return r;
+if (t->cdk && (DK_GET_FMT (t->uptr) != DKUF_F_CDK))
+    r = sim_messagef (SCPE_IERR, "%s not detected as a CDK container\n", filename);
+else
+    r = sim_disk_rdsect (t->uptr, lba, t->rbuf, &sectsread, sects);
+sim_disk_detach (t->uptr);
+if ((r == SCPE_OK) && (sectsread != sects))
+    r = sim_messagef (SCPE_IERR, "Read %d sectors, expected %d\n", (int)sectsread, (int)sects);
+for (j = 0; (r == SCPE_OK) && (j < sects * 512); j++)
+    if (t->rbuf[j] != expect[j])
+        r = sim_messagef (SCPE_IERR, "Data mismatch at offset %d of %s\n", (int)(lba * 512 + j), filename);
+return r;
+}
+
+#if defined (SIM_ASYNCH_IO)
+static int sim_disk_test_completions;
+static t_stat sim_disk_test_status;
+
+static void sim_disk_test_callback (UNIT *uptr, t_stat status)
+{
+++sim_disk_test_completions;
+if (status != SCPE_OK)
+    sim_disk_test_status = status;
+}
+
+static t_stat sim_disk_test_wait (UNIT *uptr, int expected)
+{
+_disk_cancel (uptr);                                    /* wait for the I/O threads */
+_disk_completion_dispatch (uptr);                       /* deliver completions */
+if (sim_disk_test_status != SCPE_OK)
+    return sim_disk_test_status;
+if (sim_disk_test_completions != expected)
+    return sim_messagef (SCPE_IERR, "%d completions delivered, expected %d\n", sim_disk_test_completions, expected);
+return SCPE_OK;
+}
+
+/* Keep more requests than the queue holds in flight, with later writes
+   overlapping earlier ones, and verify that every completion is
+   delivered and that overlapping writes land in submission order */
+static t_stat sim_disk_test_async_queue (UNIT *uptr, const char *filename, int32 switches)
+{
+t_bool saved_asynch_enabled = sim_asynch_enabled;
+struct disk_test t;
+const t_seccnt sects = 4;
+const uint32 xfer_size = sects * 512;
+const int requests = 3 * DISK_AIO_QUEUE_DEPTH;
+uint8 *buf;
+int i;
+uint32 j;
+t_stat r;
+
+r = sim_disk_test_setup (&t, uptr, filename, requests * xfer_size, (t_offset)DISK_AIO_QUEUE_DEPTH * xfer_size, FALSE);
+if (r != SCPE_OK)
+    return r;
+buf = t.buf;
+t.dtype = sizeof (char);
+r = sim_disk_test_attach (&t, filename, switches);
+if (r != SCPE_OK)
+    return sim_disk_test_done (&t, r);
+sim_disk_clr_async (uptr);
+sim_asynch_enabled = TRUE;
+sim_disk_set_async (uptr, 0);
+sim_disk_test_completions = 0;
+sim_disk_test_status = SCPE_OK;
+for (i = 0; i < requests; i++) {
+    for (j = 0; j < xfer_size; j++)
+        buf[i * xfer_size + j] = (uint8)(i + j);
+    sim_disk_wrsect_a (uptr, (t_lba)((i % DISK_AIO_QUEUE_DEPTH) * sects), buf + i * xfer_size, NULL, sects, sim_disk_test_callback);
+    }
+r = sim_disk_test_wait (uptr, requests);
+if (r == SCPE_OK) {
+    memset (buf, 0, requests * xfer_size);
+    for (i = 0; i < DISK_AIO_QUEUE_DEPTH; i++)
+        sim_disk_rdsect_a (uptr, (t_lba)(i * sects), buf + i * xfer_size, NULL, sects, sim_disk_test_callback);
+    r = sim_disk_test_wait (uptr, requests + DISK_AIO_QUEUE_DEPTH);
+    }
+for (i = 0; (r == SCPE_OK) && (i < DISK_AIO_QUEUE_DEPTH); i++) {
+    int writer = i + (requests - DISK_AIO_QUEUE_DEPTH);  /* last request which wrote these sectors */
+
+    for (j = 0; j < xfer_size; j++)
+        if (buf[i * xfer_size + j] != (uint8)(writer + j)) {
+            r = sim_messagef (SCPE_IERR, "Data mismatch at lbn %d offset %d\n", (int)(i * sects), (int)j);
+            break;
+            }
+    }
+sim_disk_clr_async (uptr);
+sim_asynch_enabled = saved_asynch_enabled;
+AIO_UPDATE_QUEUE;                                       /* collect activations from the I/O threads */
+sim_cancel (uptr);
+sim_disk_detach (uptr);
+return sim_disk_test_done (&t, r);
+}
+#endif
+
+#if defined (DISK_MMAP_IO)
+/* Write through a memory mapped container and confirm that the data
+   is in the file once the unit is detached */
+static t_stat sim_disk_test_mmap (UNIT *uptr, const char *filename)
+{
+struct disk_test t;
+const t_seccnt sects = 64;
+const uint32 xfer_size = sects * 512;
+uint32 j;
+t_stat r;
+
+r = sim_disk_test_setup (&t, uptr, filename, xfer_size, 2 * (t_offset)xfer_size, FALSE);
+if (r != SCPE_OK)
+    return r;
+for (j = 0; j < xfer_size; j++)
+    t.buf[j] = (uint8)(j * 3);
+r = sim_disk_test_attach (&t, filename, SWMASK ('P'));
+if (r == SCPE_OK) {
+    if (((struct disk_context *)uptr->disk_ctx)->mmap_base == NULL)
+        r = sim_messagef (SCPE_IERR, "%s not memory mapped\n", filename);
+    else
+        r = sim_disk_wrsect (uptr, sects, t.buf, NULL, sects);
+    sim_disk_detach (uptr);
+    }
+if (r == SCPE_OK)
+    r = sim_disk_test_verify (&t, filename, SWMASK ('E'), sects, sects, t.buf);
+return sim_disk_test_done (&t, r);
+}
+#endif
+
+/* Writes to a unit attached with -S reach the container only on COMMIT */
+
+static t_stat sim_disk_test_overlay (UNIT *uptr, const char *filename)
+{
+struct disk_test t;
+const t_seccnt sects = 3 * DISK_OVERLAY_CHUNK / 2;      /* spans a chunk boundary */
+const uint32 xfer_size = sects * 512;
+uint8 *buf, *rbuf;
+t_seccnt sectsread = 0;
+uint32 j;
+t_stat r;
+
+r = sim_disk_test_setup (&t, uptr, filename, xfer_size, 4 * (t_offset)xfer_size, FALSE);
+if (r != SCPE_OK)
+    return r;
+buf = t.buf;
+rbuf = t.rbuf;
+for (j = 0; j < xfer_size; j++)
+    buf[j] = (uint8)j;
+r = sim_disk_test_write (&t, filename, 0, 1, buf, sects);   /* original contents */
+if ((r == SCPE_OK) && !_disk_overlay_supported (find_dev_from_unit (uptr))) {
+    if (SCPE_OK == sim_disk_test_attach (&t, filename, SWMASK ('S'))) { /* refused without COMMIT */
+        sim_disk_detach (uptr);
+        r = sim_messagef (SCPE_IERR, "ATTACH -S accepted without a COMMIT modifier\n");
+        }
+    return sim_disk_test_done (&t, r);
+    }
+if (r == SCPE_OK)
+    r = sim_disk_test_attach (&t, filename, SWMASK ('S'));
+if (r == SCPE_OK) {
+    for (j = 0; j < xfer_size; j++)
+        rbuf[j] = (uint8)~j;
+    r = sim_disk_wrsect (uptr, 1 + sects / 2, rbuf, NULL, sects / 2);   /* half overlaid */
+    if (r == SCPE_OK)
+        r = sim_disk_rdsect (uptr, 1, rbuf, &sectsread, sects);
+    for (j = 0; (r == SCPE_OK) && (j < xfer_size); j++)
+        if (rbuf[j] != ((j < xfer_size / 2) ? (uint8)j : (uint8)~(j - xfer_size / 2)))
+            r = sim_messagef (SCPE_IERR, "Overlay read mismatch at offset %d\n", (int)j);
+    if (r == SCPE_OK)
+        r = sim_disk_overlay_discard (uptr);
+    if (r == SCPE_OK)
+        r = sim_disk_rdsect (uptr, 1, rbuf, &sectsread, sects);
+    if ((r == SCPE_OK) && (0 != memcmp (buf, rbuf, xfer_size)))
+        r = sim_messagef (SCPE_IERR, "Discarded overlay still visible\n");
+    if (r == SCPE_OK) {
+        memset (rbuf, 0xA5, xfer_size);
+        r = sim_disk_wrsect (uptr, 1, rbuf, NULL, sects);
+        }
+    if (r == SCPE_OK) {                                 /* container is untouched */
+        FILE *f = sim_fopen (filename, "rb");
+
+        memset (rbuf, 0, xfer_size);
+        if ((f == NULL) || sim_fseeko (f, 512, SEEK_SET) ||
+            (xfer_size != fread (rbuf, 1, xfer_size, f)))
+            r = sim_messagef (SCPE_IERR, "Can't read %s directly\n", filename);
+        if (f)
+            fclose (f);
+        for (j = 0; (r == SCPE_OK) && (j < xfer_size); j += 2)  /* stored as little endian words */
+            if (((uint16 *)buf)[j / 2] != (uint16)(rbuf[j] | (rbuf[j + 1] << 8)))
+                r = sim_messagef (SCPE_IERR, "Overlay write reached the container at offset %d\n", (int)j);
+        }
+    if (r == SCPE_OK)
+        r = sim_disk_overlay_commit (uptr);
+    sim_disk_detach (uptr);
+    }
+if (r == SCPE_OK) {                                     /* committed data */
+    memset (buf, 0xA5, xfer_size);
+    r = sim_disk_test_verify (&t, filename, SWMASK ('E'), 1, sects, buf);
+    }
+return sim_disk_test_done (&t, r);
+}
+
+/* Exercise the CDK container: identical clusters are stored once, zero
+   clusters occupy no space, compressible clusters shrink and a cluster
+   overwritten after being shared doesn't disturb its former twin */
+
+static t_stat sim_disk_test_cdk (UNIT *uptr, const char *filename)
+{
+struct disk_test t;
+const t_seccnt sects = CDK_CLUSTER_SIZE / 512;
+const uint32 clusters = 8;
+uint8 *buf;
+t_offset container_size = 0;
+uint32 j, seed = 1;
+t_stat r;
+
+r = sim_disk_test_setup (&t, uptr, filename, clusters * CDK_CLUSTER_SIZE, (t_offset)clusters * CDK_CLUSTER_SIZE, TRUE);
+if (r != SCPE_OK)
+    return r;
+buf = t.buf;
+for (j = 0; j < CDK_CLUSTER_SIZE; j++) {                /* cluster 0: incompressible */
+    seed = seed * 1103515245 + 12345;
+    buf[j] = (uint8)(seed >> 16);
+    }
+memcpy (buf + 1 * CDK_CLUSTER_SIZE, buf, CDK_CLUSTER_SIZE);    /* cluster 1: duplicate of 0 */
+memset (buf + 3 * CDK_CLUSTER_SIZE, 0x55, CDK_CLUSTER_SIZE);   /* cluster 3: compressible */
+memcpy (buf + 5 * CDK_CLUSTER_SIZE, buf, CDK_CLUSTER_SIZE);    /* cluster 5: another duplicate */
+r = sim_disk_test_attach (&t, filename, 0);
+if (r == SCPE_OK) {
+    r = sim_disk_wrsect (uptr, 0, buf, NULL, clusters * sects);
+    if (r == SCPE_OK) {                                 /* unshare cluster 5 again */
+        memset (buf + 5 * CDK_CLUSTER_SIZE, 0xAA, 512);
+        r = sim_disk_wrsect (uptr, 5 * sects, buf + 5 * CDK_CLUSTER_SIZE, NULL, 1);
+        }
+    sim_disk_detach (uptr);
+    }
+if (r == SCPE_OK) {
+    FILE *f = sim_fopen (filename, "rb");
+
+    if (f) {
+        container_size = sim_fsize_ex (f);
+        fclose (f);
+        }
+    /* Cluster 0 and the modified cluster 5 are the only ones stored in full */
+    if ((container_size == 0) || (container_size >= 3 * CDK_CLUSTER_SIZE))
+        r = sim_messagef (SCPE_IERR, "CDK container is %d bytes, expected less than %d\n", (int)container_size, 3 * CDK_CLUSTER_SIZE);
+    }
+if (r == SCPE_OK)
+    r = sim_disk_test_verify (&t, filename, SWMASK ('E'), 0, clusters * sects, buf);
+return sim_disk_test_done (&t, r);
+}
+
+/* A CDK container copied while it was being written looks like one whose
+   simulator crashed.  It reads back as of its last save, both when
+   attached read only and after being rolled back by a read/write attach */
+
+static t_stat sim_disk_test_cdk_recover (UNIT *uptr, const char *filename, const char *crashname)
+{
+struct disk_test t;
+const t_seccnt sects = CDK_CLUSTER_SIZE / 512;
+const uint32 clusters = 4;
+uint8 *buf, *rbuf;
+uint32 j, pass, seed = 1;
+t_stat r;
+
+r = sim_disk_test_setup (&t, uptr, filename, clusters * CDK_CLUSTER_SIZE, (t_offset)clusters * CDK_CLUSTER_SIZE, TRUE);
+if (r != SCPE_OK)
+    return r;
+buf = t.buf;
+rbuf = t.rbuf;
+(void)remove (crashname);
+for (j = 0; j < CDK_CLUSTER_SIZE; j++) {                /* cluster 0: incompressible */
+    seed = seed * 1103515245 + 12345;
+    buf[j] = (uint8)(seed >> 16);
+    }
+memset (buf + CDK_CLUSTER_SIZE, 0x11, CDK_CLUSTER_SIZE);
+r = sim_disk_test_write (&t, filename, 0, 0, buf, clusters * sects);  /* the last save */
+sim_disk_set_fmt (uptr, 0, "AUTO", NULL);
+if (r == SCPE_OK) {                                     /* lost writes */
+    r = sim_disk_test_attach (&t, filename, SWMASK ('E'));
+    if (r == SCPE_OK) {
+        memset (rbuf, 0x22, 2 * CDK_CLUSTER_SIZE);
+        r = sim_disk_wrsect (uptr, sects, rbuf, NULL, 2 * sects);
+        if (r == SCPE_OK)
+            r = sim_copyfile (filename, crashname, TRUE);
+        sim_disk_detach (uptr);
+        }
+    }
+if (r == SCPE_OK)                                       /* keep the crashed image */
+    r = sim_copyfile (crashname, filename, TRUE);
+if ((r == SCPE_OK) &&                                   /* an overlay doesn't recover it */
+    _disk_overlay_supported (find_dev_from_unit (uptr))) {
+    memset (rbuf, 0x44, CDK_CLUSTER_SIZE);
+    r = sim_disk_test_write (&t, crashname, SWMASK ('E') | SWMASK ('S'), 0, rbuf, sects);
+    if (r == SCPE_OK) {
+        FILE *f1 = sim_fopen (filename, "rb");
+        FILE *f2 = sim_fopen (crashname, "rb");
+        size_t n1, n2;
+
+        if ((f1 == NULL) || (f2 == NULL))
+            r = sim_messagef (SCPE_IERR, "Can't read %s directly\n", crashname);
+        while (r == SCPE_OK) {
+            n1 = fread (buf + 2 * CDK_CLUSTER_SIZE, 1, CDK_CLUSTER_SIZE, f1);
+            n2 = fread (rbuf, 1, CDK_CLUSTER_SIZE, f2);
+            if ((n1 != n2) || (0 != memcmp (buf + 2 * CDK_CLUSTER_SIZE, rbuf, n1)))
+                r = sim_messagef (SCPE_IERR, "Overlay attach modified %s\n", crashname);
+            if (n1 < CDK_CLUSTER_SIZE)
+                break;
+            }
+        if (f1)
+            fclose (f1);
+        if (f2)
+            fclose (f2);
+        memset (buf + 2 * CDK_CLUSTER_SIZE, 0, CDK_CLUSTER_SIZE);
+        }
+    }
+for (pass = 0; (r == SCPE_OK) && (pass < 2); pass++) {  /* read only, then rolled back */
+    if ((pass == 0) && ((uptr->flags & UNIT_ROABLE) == 0))
+        continue;
+    r = sim_disk_test_verify (&t, crashname, SWMASK ('E') | ((pass == 0) ? SWMASK ('R') : 0), 0, clusters * sects, buf);
+    }
+if (r == SCPE_OK) {                                     /* recovered container is writable */
+    memset (buf + 3 * CDK_CLUSTER_SIZE, 0x33, CDK_CLUSTER_SIZE);
+    r = sim_disk_test_write (&t, crashname, SWMASK ('E'), 3 * sects, buf + 3 * CDK_CLUSTER_SIZE, sects);
+    }
+if (r == SCPE_OK)
+    r = sim_disk_test_verify (&t, crashname, SWMASK ('E'), 0, clusters * sects, buf);
+(void)remove (crashname);
+return sim_disk_test_done (&t, r);
+}
+
 t_stat sim_disk_test (DEVICE *dptr)
 {
+int32 saved_switches = sim_switches;
+SIM_TEST_INIT;
+
+if (!(dptr->units->flags & UNIT_ATTABLE) ||
+    (dptr->units->flags & (UNIT_ATT | UNIT_DIS)))
+    return SCPE_OK;
+sim_printf ("\nTesting %s device sim_disk APIs\n", sim_uname(dptr->units));
+
+#if defined (SIM_ASYNCH_IO)
+SIM_TEST(sim_disk_test_async_queue (dptr->units, "DiskTestFile1.dsk", 0));
+#if defined (DISK_MMAP_IO)
+SIM_TEST(sim_disk_test_async_queue (dptr->units, "DiskTestFile1.dsk", SWMASK ('P')));
+#endif
+#endif
+#if defined (DISK_MMAP_IO)
+SIM_TEST(sim_disk_test_mmap (dptr->units, "DiskTestFile1.dsk"));
+#endif
+SIM_TEST(sim_disk_test_cdk (dptr->units, "DiskTestFile1.cdk"));
+SIM_TEST(sim_disk_test_cdk_recover (dptr->units, "DiskTestFile1.cdk", "DiskTestFile2.cdk"));
+SIM_TEST(sim_disk_test_overlay (dptr->units, "DiskTestFile1.dsk"));
+
+sim_switches = saved_switches;
 return SCPE_OK;
 }
@@ -58,7 +58,14 @@ typedef uint32          t_lba;                          /* disk logical block ad
 #define DK_F_RAW        (DKUF_F_RAW << DKUF_V_FMT)
 #define DK_F_VHD        (DKUF_F_VHD << DKUF_V_FMT)
 
-#define DK_GET_FMT(u)   (((u)->flags >> DKUF_V_FMT) & DKUF_M_FMT)
+/* The CDK format doesn't fit in the unit flags format field, whose width
+   is fixed by the unit flags recorded in SAVE files.  It is kept in the
+   unit's dynamic flags with the format field left as AUTO. */
+
+#define DKUF_F_CDK       4                              /* Clustered (sparse, deduplicated, compressed) format */
+
+#define DK_GET_FMT(u)   (((u)->dynflags & UNIT_DISK_CDK) ? DKUF_F_CDK : \
+                         (((u)->flags >> DKUF_V_FMT) & DKUF_M_FMT))
 
 /* Return status codes */
 
@@ -81,11 +88,14 @@ t_stat sim_disk_wrsect_a (UNIT *uptr, t_lba lba, uint8 *buf, t_seccnt *sectswrit
 t_stat sim_disk_unload (UNIT *uptr);
 t_stat sim_disk_set_fmt (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat sim_disk_show_fmt (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
+t_stat sim_disk_set_overlay (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat sim_disk_set_capac (UNIT *uptr, int32 val, CONST char *cptr, void *desc);
 t_stat sim_disk_show_capac (FILE *st, UNIT *uptr, int32 val, CONST void *desc);
 t_stat sim_disk_set_asynch (UNIT *uptr, int latency);
 t_stat sim_disk_clr_asynch (UNIT *uptr);
 t_stat sim_disk_reset (UNIT *uptr);
+t_stat sim_disk_overlay_commit (UNIT *uptr);
+t_stat sim_disk_overlay_discard (UNIT *uptr);
 t_stat sim_disk_perror (UNIT *uptr, const char *msg);
 t_stat sim_disk_clearerr (UNIT *uptr);
 t_bool sim_disk_isavailable (UNIT *uptr);
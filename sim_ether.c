@@ -153,6 +153,14 @@
   HAVE_SLIRP_NETWORK- Specifies that support for SLiRP networking should be 
                       included.  This can be leveraged to provide User Mode 
                       IP NAT connectivity for simulators.
+  HAVE_PACKET_RING  - Defined automatically on Linux hosts when the reader 
+                      thread is in use and the kernel headers provide 
+                      TPACKET_V3.  This allows device names of the form 
+                      pkt:eth0 to be specified at open time, which move 
+                      frames to and from the named interface through memory 
+                      mapped AF_PACKET receive and transmit rings rather 
+                      than with a system call per frame.  Defining 
+                      DONT_USE_PACKET_RING suppresses this support.
 
   NEED_PCAP_SENDPACKET
                     - Specifies that you are using an older version of libpcap
@@ -546,26 +554,170 @@ static const uint32 crcTable[256] = {
   0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
 };
 
-uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len)
+/* CRC-32 implementations
+
+   eth_crc32 dispatches to the fastest implementation the host supports,
+   selected on first use: folding with carry-less multiplies on x86 hosts
+   with PCLMULQDQ, otherwise slicing-by-8 (eight derived tables consuming
+   8 bytes per step).  The byte at a time table walk finishes odd lengths.
+   All of them operate on the inverted CRC register.
+*/
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || (__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 9)))
+#define ETH_CRC32_CLMUL 1
+#include <immintrin.h>
+#include <cpuid.h>
+#endif
+
+static uint32 crcTable8[8][256];
+
+static uint32 _eth_crc32_bytes (uint32 crc, const uint8 *buf, size_t len)
+{
+while (0 != len--)
+  crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
+return crc;
+}
+
+static uint32 _eth_crc32_slice8 (uint32 crc, const uint8 *buf, size_t len)
+{
+while (len >= 8) {
+  uint32 one = crc ^ ((uint32)buf[0] | ((uint32)buf[1] << 8) | ((uint32)buf[2] << 16) | ((uint32)buf[3] << 24));
+  uint32 two = (uint32)buf[4] | ((uint32)buf[5] << 8) | ((uint32)buf[6] << 16) | ((uint32)buf[7] << 24);
+
+  crc = crcTable8[7][one & 0xFF]         ^ crcTable8[6][(one >> 8) & 0xFF] ^
+        crcTable8[5][(one >> 16) & 0xFF] ^ crcTable8[4][one >> 24]         ^
+        crcTable8[3][two & 0xFF]         ^ crcTable8[2][(two >> 8) & 0xFF] ^
+        crcTable8[1][(two >> 16) & 0xFF] ^ crcTable8[0][two >> 24];
+  buf += 8;
+  len -= 8;
+  }
+return _eth_crc32_bytes (crc, buf, len);
+}
+
+#if defined (ETH_CRC32_CLMUL)
+/* Fold 64 byte blocks with PCLMULQDQ, then Barrett reduce to 32 bits.
+   The constants are the bit reflected x^n mod P(x) values from Intel's
+   "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ".
+   len must be at least 64 and a multiple of 16. */
+
+__attribute__((target("pclmul,sse4.1")))
+static uint32 _eth_crc32_fold (uint32 crc, const uint8 *buf, size_t len)
+{
+const __m128i k1k2 = _mm_set_epi32 (0x00000001, (int)0xC6E41596, 0x00000001, 0x54442BD4);
+const __m128i k3k4 = _mm_set_epi32 (0x00000000, (int)0xCCAA009E, 0x00000001, 0x751997D0);
+const __m128i k5k0 = _mm_set_epi32 (0x00000000, 0x00000000, 0x00000001, 0x63CD6124);
+const __m128i poly = _mm_set_epi32 (0x00000001, (int)0xF7011641, 0x00000001, (int)0xDB710641);
+const __m128i mask = _mm_setr_epi32 (~0, 0, ~0, 0);
+__m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+x1 = _mm_xor_si128 (_mm_loadu_si128 ((const __m128i *)(buf + 0x00)), _mm_cvtsi32_si128 ((int)crc));
+x2 = _mm_loadu_si128 ((const __m128i *)(buf + 0x10));
+x3 = _mm_loadu_si128 ((const __m128i *)(buf + 0x20));
+x4 = _mm_loadu_si128 ((const __m128i *)(buf + 0x30));
+buf += 64;
+len -= 64;
+while (len >= 64) {                         /* fold 4 lanes in parallel */
+  x5 = _mm_clmulepi64_si128 (x1, k1k2, 0x00);
+  x6 = _mm_clmulepi64_si128 (x2, k1k2, 0x00);
+  x7 = _mm_clmulepi64_si128 (x3, k1k2, 0x00);
+  x8 = _mm_clmulepi64_si128 (x4, k1k2, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k1k2, 0x11);
+  x2 = _mm_clmulepi64_si128 (x2, k1k2, 0x11);
+  x3 = _mm_clmulepi64_si128 (x3, k1k2, 0x11);
+  x4 = _mm_clmulepi64_si128 (x4, k1k2, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x5), _mm_loadu_si128 ((const __m128i *)(buf + 0x00)));
+  x2 = _mm_xor_si128 (_mm_xor_si128 (x2, x6), _mm_loadu_si128 ((const __m128i *)(buf + 0x10)));
+  x3 = _mm_xor_si128 (_mm_xor_si128 (x3, x7), _mm_loadu_si128 ((const __m128i *)(buf + 0x20)));
+  x4 = _mm_xor_si128 (_mm_xor_si128 (x4, x8), _mm_loadu_si128 ((const __m128i *)(buf + 0x30)));
+  buf += 64;
+  len -= 64;
+  }
+/* fold the 4 lanes into one */
+x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x2), x5);
+x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x3), x5);
+x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+x1 = _mm_xor_si128 (_mm_xor_si128 (x1, x4), x5);
+while (len >= 16) {                         /* remaining 16 byte blocks */
+  x5 = _mm_clmulepi64_si128 (x1, k3k4, 0x00);
+  x1 = _mm_clmulepi64_si128 (x1, k3k4, 0x11);
+  x1 = _mm_xor_si128 (_mm_xor_si128 (x1, _mm_loadu_si128 ((const __m128i *)buf)), x5);
+  buf += 16;
+  len -= 16;
+  }
+/* 128 bits to 64 bits */
+x2 = _mm_clmulepi64_si128 (x1, k3k4, 0x10);
+x1 = _mm_xor_si128 (_mm_srli_si128 (x1, 8), x2);
+x2 = _mm_srli_si128 (x1, 4);
+x1 = _mm_and_si128 (x1, mask);
+x1 = _mm_xor_si128 (_mm_clmulepi64_si128 (x1, k5k0, 0x00), x2);
+/* Barrett reduction to 32 bits */
+x2 = _mm_and_si128 (x1, mask);
+x2 = _mm_clmulepi64_si128 (x2, poly, 0x10);
+x2 = _mm_and_si128 (x2, mask);
+x2 = _mm_clmulepi64_si128 (x2, poly, 0x00);
+x1 = _mm_xor_si128 (x1, x2);
+return (uint32)_mm_extract_epi32 (x1, 1);
+}
+
+static uint32 _eth_crc32_clmul (uint32 crc, const uint8 *buf, size_t len)
+{
+if (len >= 64) {
+  size_t chunk = len & ~(size_t)15;
+
+  crc = _eth_crc32_fold (crc, buf, chunk);
+  buf += chunk;
+  len -= chunk;
+  }
+return _eth_crc32_slice8 (crc, buf, len);
+}
+
+static int _eth_crc32_have_clmul (void)
 {
-  const uint32 mask = 0xFFFFFFFF;
-  const unsigned char* buf = (const unsigned char*)vbuf;
-
-  crc ^= mask;
-  while (len > 8) {
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-    len -= 8;
+unsigned int eax, ebx, ecx, edx;
+
+if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+  return 0;
+return ((ecx & bit_PCLMUL) && (ecx & bit_SSE4_1));
+}
+#endif /* ETH_CRC32_CLMUL */
+
+static uint32 _eth_crc32_select (uint32 crc, const uint8 *buf, size_t len);
+static uint32 (*_eth_crc32_impl) (uint32 crc, const uint8 *buf, size_t len) = &_eth_crc32_select;
+static const char *_eth_crc32_name = "";
+
+/* Build the slicing tables and choose an implementation.  Runs on the
+   first eth_crc32 call and again (harmlessly) from eth_open before any
+   reader or writer thread can exist. */
+
+static uint32 _eth_crc32_select (uint32 crc, const uint8 *buf, size_t len)
+{
+int i, j;
+
+for (i = 0; i < 256; i++) {
+  crcTable8[0][i] = crcTable[i];
+  for (j = 1; j < 8; j++)
+    crcTable8[j][i] = (crcTable8[j-1][i] >> 8) ^ crcTable[crcTable8[j-1][i] & 0xFF];
+  }
+_eth_crc32_impl = &_eth_crc32_slice8;
+_eth_crc32_name = "slicing-by-8";
+#if defined (ETH_CRC32_CLMUL)
+if (_eth_crc32_have_clmul ()) {
+  _eth_crc32_impl = &_eth_crc32_clmul;
+  _eth_crc32_name = "PCLMULQDQ folding";
   }
-  while (0 != len--)
-    crc = (crc >> 8) ^ crcTable[ (crc ^ (*buf++)) & 0xFF ];
-  return(crc ^ mask);
+#endif
+return _eth_crc32_impl (crc, buf, len);
+}
+
+uint32 eth_crc32(uint32 crc, const void* vbuf, size_t len)
+{
+return ~_eth_crc32_impl (~crc, (const uint8 *)vbuf, len);
 }
 
 int eth_get_packet_crc32_data(const uint8 *msg, int len, uint8 *crcdata)
@@ -956,6 +1108,10 @@ t_stat eth_write (ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
   {return SCPE_NOFNC;}
 int eth_read (ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine)
   {return SCPE_NOFNC;}
+const uint8 *eth_read_ref (ETH_DEV* dev, uint32 *len, uint32 *crc_len)
+  {return NULL;}
+void eth_read_done (ETH_DEV* dev)
+  {}
 t_stat eth_filter (ETH_DEV* dev, int addr_count, ETH_MAC* const addresses,
                    ETH_BOOL all_multicast, ETH_BOOL promiscuous)
   {return SCPE_NOFNC;}
@@ -983,6 +1139,9 @@ const char *eth_capabilities(void)
 #if defined (HAVE_PCAP_NETWORK)
      ":PCAP"
 #endif
+#if defined (HAVE_PACKET_RING)
+     ":PKT"
+#endif
 #if defined (HAVE_TAP_NETWORK)
      ":TAP"
 #endif
@@ -1046,6 +1205,21 @@ extern "C" {
 #include "sim_slirp.h"
 #endif /* HAVE_SLIRP_NETWORK */
 
+#if (defined(__linux) || defined(__linux__)) && defined(USE_READER_THREAD) && !defined(DONT_USE_PACKET_RING)
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/if_packet.h>
+#if defined(TPACKET3_HDRLEN)
+#define HAVE_PACKET_RING 1
+#endif
+#endif /* __linux && USE_READER_THREAD */
+
+#if (defined(__linux) || defined(__linux__)) && defined(USE_READER_THREAD) && defined(_GNU_SOURCE) && defined(MSG_WAITFORONE)
+#define HAVE_UDP_MMSG 1                 /* recvmmsg/sendmmsg available */
+#endif
+
 /* Allows windows to look up user-defined adapter names */
 #if defined(_WIN32)
 #include <winreg.h>
@@ -1553,6 +1727,19 @@ static void eth_get_nic_hw_addr(ETH_DEV* dev, const char *devname)
 {
   memset(&dev->host_nic_phy_hw_addr, 0, sizeof(dev->host_nic_phy_hw_addr));
   dev->have_host_nic_phy_addr = 0;
+#if defined (HAVE_PACKET_RING)
+  if (dev->eth_api == ETH_API_PKT) {
+    struct ifreq ifr;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strlcpy(ifr.ifr_name, devname + 4, sizeof(ifr.ifr_name));
+    if (0 == ioctl(dev->fd_handle, SIOCGIFHWADDR, &ifr)) {
+      memcpy(dev->host_nic_phy_hw_addr, ifr.ifr_hwaddr.sa_data, sizeof(dev->host_nic_phy_hw_addr));
+      dev->have_host_nic_phy_addr = 1;
+      }
+    return;
+    }
+#endif
   if (dev->eth_api != ETH_API_PCAP)
     return;
 #if defined(_WIN32) || defined(__CYGWIN__)
@@ -1688,6 +1875,120 @@ _eth_write(ETH_DEV* dev, ETH_PACK* packet, ETH_PCALLBACK routine);
 static void
 _eth_error(ETH_DEV* dev, const char* where);
 
+#if defined (USE_READER_THREAD)
+/* Receive ring
+
+   The reader thread stores received packets in a preallocated ring of
+   variable length slots.  A slot is a header followed by the packet (runts
+   padded, CRC appended when needed) rounded up to whole cache lines.  The
+   reader thread is the only producer and only it moves tail; the simulator
+   thread is the only consumer and only it moves head.  dev->lock covers the
+   offsets and count, but packet data is written and read outside the lock
+   since a slot belongs to one side at a time.  A slot size of zero marks
+   the unused end of the storage where the producer wrapped.  When the ring
+   is full new packets are dropped, so a packet the consumer is looking at
+   by reference is never overwritten.
+*/
+
+#define ETH_RING_SIZE   (512*1024)                      /* bytes of slot storage */
+#define ETH_RING_ALIGN  64                              /* slot alignment (cache line) */
+#define ETH_RING_FULL   0xFFFFFFFF                      /* no room for slot */
+
+struct eth_ring_slot {
+  uint32  size;                                         /* slot bytes including header, 0 = wrapped */
+  uint32  len;                                          /* packet length without CRC */
+  uint32  crc_len;                                      /* packet length with CRC */
+  uint32  reserved;                                     /* pads header to 16 bytes */
+};
+
+#define ETH_RING_SLOT_SIZE(bytes) \
+    (((uint32)sizeof (struct eth_ring_slot) + (uint32)(bytes) + ETH_RING_ALIGN - 1) & ~(ETH_RING_ALIGN - 1))
+
+static t_stat _eth_ring_init (ETH_RING *ring, uint32 size)
+{
+memset (ring, 0, sizeof (*ring));
+ring->alloc = calloc (1, size + ETH_RING_ALIGN);
+if (ring->alloc == NULL)
+  return SCPE_MEM;
+ring->base = (uint8 *)(((size_t)ring->alloc + ETH_RING_ALIGN - 1) & ~((size_t)ETH_RING_ALIGN - 1));
+ring->size = size;
+return SCPE_OK;
+}
+
+static void _eth_ring_destroy (ETH_RING *ring)
+{
+free (ring->alloc);
+memset (ring, 0, sizeof (*ring));
+}
+
+/* Producer: find room for a slot of size bytes - caller holds dev->lock */
+
+static uint32 _eth_ring_reserve (ETH_RING *ring, uint32 size)
+{
+if (ring->count == 0)                                   /* empty? */
+  ring->head = ring->tail = 0;                          /* start over at the beginning */
+if ((ring->count == 0) || (ring->tail > ring->head)) {  /* free at end and before head */
+  if (ring->size - ring->tail >= size)
+    return ring->tail;
+  if (ring->head >= size)                               /* wrap */
+    return 0;
+  }
+else {
+  if ((ring->tail < ring->head) &&                      /* free between tail and head */
+      (ring->head - ring->tail >= size))
+    return ring->tail;
+  }
+ring->loss++;
+return ETH_RING_FULL;
+}
+
+/* Producer: make a filled slot visible - caller holds dev->lock */
+
+static void _eth_ring_publish (ETH_RING *ring, uint32 offset, uint32 size)
+{
+if ((offset != ring->tail) && (ring->tail < ring->size))/* wrapped? */
+  ((struct eth_ring_slot *)(ring->base + ring->tail))->size = 0;
+((struct eth_ring_slot *)(ring->base + offset))->size = size;
+ring->tail = offset + size;
+if (++ring->count > ring->high)
+  ring->high = ring->count;
+}
+
+/* Consumer: oldest slot or NULL - caller holds dev->lock */
+
+static struct eth_ring_slot *_eth_ring_peek (ETH_RING *ring)
+{
+if (ring->count == 0)
+  return NULL;
+if ((ring->head == ring->size) ||                       /* at end or wrap mark? */
+    (((struct eth_ring_slot *)(ring->base + ring->head))->size == 0))
+  ring->head = 0;
+return (struct eth_ring_slot *)(ring->base + ring->head);
+}
+
+/* Consumer: release oldest slot - caller holds dev->lock */
+
+static void _eth_ring_remove (ETH_RING *ring)
+{
+struct eth_ring_slot *slot = _eth_ring_peek (ring);
+
+if (slot) {
+  ring->head += slot->size;
+  ring->count--;
+  }
+}
+
+#if defined (USE_BPF)
+/* Consumer: discard all slots - caller holds dev->lock */
+
+static void _eth_ring_clear (ETH_RING *ring)
+{
+ring->head = ring->tail;
+ring->count = 0;
+}
+#endif
+#endif /* USE_READER_THREAD */
+
 #if defined(HAVE_SLIRP_NETWORK)
 static void _slirp_callback (void *opaque, const unsigned char *buf, int len)
 {
@@ -1699,7 +2000,252 @@ _eth_callback((u_char *)opaque, &header, buf);
 }
 #endif
 
+#if defined (HAVE_PACKET_RING)
+/* Linux AF_PACKET transport (pkt:ifname)
+
+   The socket is switched to TPACKET_V3 and given a memory mapped receive
+   ring and, where the kernel supports it, a memory mapped transmit ring.
+   The kernel fills whole receive blocks which the reader thread walks and
+   hands back without a system call per frame.  The writer thread copies
+   frames into transmit slots and only asks the kernel to send them (one
+   send() for the whole batch) once it has drained its queue of pending
+   write requests.  Kernels without TPACKET_V3 transmit rings fall back to
+   a send() per frame.
+*/
+
+#define ETH_PKT_BLOCK_SIZE  (1 << 16)       /* ring block size */
+#define ETH_PKT_FRAME_SIZE  2048            /* transmit slot size */
+#define ETH_PKT_RX_BLOCKS   64              /* 4MB of receive buffering */
+#define ETH_PKT_TX_BLOCKS   16              /* 512 transmit slots */
+#define ETH_PKT_RETIRE_MS   1               /* ms before a partly filled block is delivered */
+#define ETH_PKT_TX_DATA     (TPACKET3_HDRLEN - sizeof (struct sockaddr_ll))
+#ifndef ETH_P_ALL
+#define ETH_P_ALL           0x0003          /* every protocol (linux/if_ether.h) */
+#endif
+
+struct eth_pkt_ring {
+  int           fd;
+  uint8         *map;                       /* receive ring followed by transmit ring */
+  size_t        map_size;
+  uint8         *tx;                        /* transmit ring (NULL when unavailable) */
+  uint32        rx_block;                   /* next receive block to inspect */
+  uint32        tx_frame;                   /* next transmit slot to fill */
+  uint32        tx_pending;                 /* slots filled since the last send() */
+  };
+typedef struct eth_pkt_ring ETH_PKT_RING;
+
+static void _eth_pkt_close (ETH_PKT_RING *r)
+{
+if (r->map)
+  munmap (r->map, r->map_size);
+if (r->fd >= 0)
+  close (r->fd);
+free (r);
+}
+
+static ETH_PKT_RING *_eth_pkt_open (const char *ifname, char errbuf[PCAP_ERRBUF_SIZE])
+{
+ETH_PKT_RING *r = (ETH_PKT_RING *)calloc (1, sizeof (*r));
+struct tpacket_req3 req;
+struct sockaddr_ll sll;
+struct packet_mreq mr;
+int version = TPACKET_V3;
+int loss = 1;
+size_t rx_size = ETH_PKT_BLOCK_SIZE * ETH_PKT_RX_BLOCKS;
+size_t tx_size = 0;
+unsigned int ifindex;
+
+if (r == NULL) {
+  strlcpy (errbuf, "Out of memory", PCAP_ERRBUF_SIZE);
+  return NULL;
+  }
+r->fd = -1;
+if (0 == (ifindex = if_nametoindex (ifname)))
+  goto Error;
+/* Protocol 0 until bound, so nothing queues outside the rings */
+if ((r->fd = socket (AF_PACKET, SOCK_RAW, 0)) < 0)
+  goto Error;
+if (setsockopt (r->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof (version)))
+  goto Error;
+memset (&req, 0, sizeof (req));
+req.tp_block_size = ETH_PKT_BLOCK_SIZE;
+req.tp_block_nr = ETH_PKT_RX_BLOCKS;
+req.tp_frame_size = ETH_PKT_FRAME_SIZE;
+req.tp_frame_nr = (ETH_PKT_BLOCK_SIZE / ETH_PKT_FRAME_SIZE) * ETH_PKT_RX_BLOCKS;
+req.tp_retire_blk_tov = ETH_PKT_RETIRE_MS;
+if (setsockopt (r->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof (req)))
+  goto Error;
+memset (&req, 0, sizeof (req));
+req.tp_block_size = ETH_PKT_BLOCK_SIZE;
+req.tp_block_nr = ETH_PKT_TX_BLOCKS;
+req.tp_frame_size = ETH_PKT_FRAME_SIZE;
+req.tp_frame_nr = (ETH_PKT_BLOCK_SIZE / ETH_PKT_FRAME_SIZE) * ETH_PKT_TX_BLOCKS;
+(void)setsockopt (r->fd, SOL_PACKET, PACKET_LOSS, &loss, sizeof (loss));
+if (0 == setsockopt (r->fd, SOL_PACKET, PACKET_TX_RING, &req, sizeof (req)))
+  tx_size = ETH_PKT_BLOCK_SIZE * ETH_PKT_TX_BLOCKS;
+r->map_size = rx_size + tx_size;
+r->map = (uint8 *)mmap (NULL, r->map_size, PROT_READ|PROT_WRITE, MAP_SHARED, r->fd, 0);
+if (r->map == (uint8 *)MAP_FAILED) {
+  r->map = NULL;
+  goto Error;
+  }
+if (tx_size)
+  r->tx = r->map + rx_size;
+memset (&sll, 0, sizeof (sll));
+sll.sll_family = AF_PACKET;
+sll.sll_protocol = htons (ETH_P_ALL);
+sll.sll_ifindex = ifindex;
+if (bind (r->fd, (struct sockaddr *)&sll, sizeof (sll)))
+  goto Error;
+memset (&mr, 0, sizeof (mr));
+mr.mr_ifindex = ifindex;
+mr.mr_type = PACKET_MR_PROMISC;
+if (setsockopt (r->fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof (mr)))
+  goto Error;
+return r;
+
+Error:
+strlcpy (errbuf, strerror (errno), PCAP_ERRBUF_SIZE);
+_eth_pkt_close (r);
+return NULL;
+}
+
+/* Reader: deliver every frame in the blocks the kernel has handed over */
+
+static int _eth_pkt_dispatch (ETH_DEV *dev, ETH_PKT_RING *r)
+{
+int frames = 0;
+
+while (1) {
+  struct tpacket_block_desc *bd = (struct tpacket_block_desc *)(r->map + r->rx_block * ETH_PKT_BLOCK_SIZE);
+  struct tpacket3_hdr *hdr;
+  uint32 i;
+
+  if (0 == (bd->hdr.bh1.block_status & TP_STATUS_USER))
+    break;
+  __sync_synchronize ();                    /* block contents after its status */
+  hdr = (struct tpacket3_hdr *)((uint8 *)bd + bd->hdr.bh1.offset_to_first_pkt);
+  for (i = 0; i < bd->hdr.bh1.num_pkts; i++) {
+    struct pcap_pkthdr header;
+
+    memset (&header, 0, sizeof (header));
+    header.caplen = hdr->tp_snaplen;
+    header.len = hdr->tp_len;
+    _eth_callback ((u_char *)dev, &header, (u_char *)hdr + hdr->tp_mac);
+    hdr = (struct tpacket3_hdr *)((uint8 *)hdr + hdr->tp_next_offset);
+    }
+  frames += i;
+  __sync_synchronize ();
+  bd->hdr.bh1.block_status = TP_STATUS_KERNEL;  /* give block back */
+  r->rx_block = (r->rx_block + 1) % ETH_PKT_RX_BLOCKS;
+  }
+return frames;
+}
+
+/* Writer: ask the kernel to transmit the slots filled so far */
+
+static int _eth_pkt_flush (ETH_PKT_RING *r, int flags)
+{
+r->tx_pending = 0;
+if ((send (r->fd, NULL, 0, flags) < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+  return -1;
+return 0;
+}
+
+#define ETH_PKT_TX_BUSY (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)
+
+static int _eth_pkt_send (ETH_PKT_RING *r, const uint8 *msg, size_t len, int more)
+{
+struct tpacket3_hdr *hdr;
+
+if ((r->tx == NULL) || (len > ETH_PKT_FRAME_SIZE - ETH_PKT_TX_DATA))
+  return (((ssize_t)len == send (r->fd, msg, len, 0)) ? 0 : -1);
+hdr = (struct tpacket3_hdr *)(r->tx + r->tx_frame * ETH_PKT_FRAME_SIZE);
+if (hdr->tp_status & ETH_PKT_TX_BUSY) {     /* ring full? */
+  _eth_pkt_flush (r, 0);                    /* wait for the kernel to drain it */
+  if (hdr->tp_status & ETH_PKT_TX_BUSY)
+    return -1;
+  }
+memcpy ((uint8 *)hdr + ETH_PKT_TX_DATA, msg, len);
+hdr->tp_len = hdr->tp_snaplen = (uint32)len;
+hdr->tp_next_offset = 0;
+__sync_synchronize ();                      /* frame contents before its status */
+hdr->tp_status = TP_STATUS_SEND_REQUEST;
+r->tx_frame = (r->tx_frame + 1) % ((ETH_PKT_BLOCK_SIZE / ETH_PKT_FRAME_SIZE) * ETH_PKT_TX_BLOCKS);
+++r->tx_pending;
+if (more)
+  return 0;                                 /* more frames are queued behind this one */
+return _eth_pkt_flush (r, MSG_DONTWAIT);
+}
+#endif /* HAVE_PACKET_RING */
+
+#if defined (HAVE_UDP_MMSG)
+/* UDP transport batches
+
+   The reader thread collects up to ETH_UDP_BATCH datagrams per recvmmsg()
+   and the writer thread stages frames while more write requests are queued
+   and sends them with a single sendmmsg().
+*/
+
+#define ETH_UDP_BATCH 32
+
+struct eth_udp_batch {
+  int           count;                      /* frames staged for transmit */
+  struct mmsghdr msgs[ETH_UDP_BATCH];
+  struct iovec  iov[ETH_UDP_BATCH];
+  uint8         *buf;
+  };
+
+static struct eth_udp_batch *_eth_udp_batch_alloc (size_t frame_size)
+{
+struct eth_udp_batch *b = (struct eth_udp_batch *)calloc (1, sizeof (*b) + ETH_UDP_BATCH * frame_size);
+int i;
+
+if (b == NULL)
+  return NULL;
+b->buf = (uint8 *)(b + 1);
+for (i = 0; i < ETH_UDP_BATCH; i++) {
+  b->iov[i].iov_base = b->buf + i * frame_size;
+  b->iov[i].iov_len = frame_size;
+  b->msgs[i].msg_hdr.msg_iov = &b->iov[i];
+  b->msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+return b;
+}
+
+static int _eth_udp_batch_write (ETH_DEV *dev, ETH_PACK *packet)
+{
+struct eth_udp_batch *b = (struct eth_udp_batch *)dev->write_batch;
+int sent = 0;
+
+if ((b == NULL) && dev->write_more)
+  b = (struct eth_udp_batch *)(dev->write_batch = _eth_udp_batch_alloc (ETH_MAX_PACKET));
+if (b == NULL)
+  return (((int32)packet->len == sim_write_sock (dev->fd_handle, (char *)packet->msg, (int32)packet->len)) ? 0 : -1);
+memcpy (b->iov[b->count].iov_base, packet->msg, packet->len);
+b->iov[b->count].iov_len = packet->len;
+++b->count;
+if (dev->write_more && (b->count < ETH_UDP_BATCH))
+  return 0;                                 /* more frames are queued behind this one */
+while (sent < b->count) {
+  int n = sendmmsg (dev->fd_handle, &b->msgs[sent], b->count - sent, 0);
+
+  if (n <= 0)
+    break;
+  sent += n;
+  }
+if (sent < b->count) {                      /* report a failed batch once */
+  b->count = 0;
+  return -1;
+  }
+b->count = 0;
+return 0;
+}
+#endif /* HAVE_UDP_MMSG */
+
 #if defined (USE_READER_THREAD)
+#define ETH_TAP_READ_BATCH 64           /* frames read per select() wakeup */
+
 static void *
 _eth_reader(void *arg)
 {
@@ -1711,6 +2257,9 @@ SOCKET select_fd = 0;
 #if defined (_WIN32)
 HANDLE hWait = (dev->eth_api == ETH_API_PCAP) ? pcap_getevent ((pcap_t*)dev->handle) : NULL;
 #endif
+#if defined (HAVE_UDP_MMSG)
+struct eth_udp_batch *udp_batch = (dev->eth_api == ETH_API_UDP) ? _eth_udp_batch_alloc (ETH_MAX_JUMBO_FRAME) : NULL;
+#endif
 
 switch (dev->eth_api) {
   case ETH_API_PCAP:
@@ -1725,6 +2274,7 @@ switch (dev->eth_api) {
   case ETH_API_VDE:
   case ETH_API_UDP:
   case ETH_API_NAT:
+  case ETH_API_PKT:
     do_select = 1;
     select_fd = dev->fd_handle;
     break;
@@ -1784,24 +2334,33 @@ while (dev->handle) {
         if (1) {
           struct pcap_pkthdr header;
           int len;
+          int frames = 0;
           u_char buf[ETH_MAX_JUMBO_FRAME];
 
+          /* drain what has arrived (up to a limit) before selecting again */
           memset(&header, 0, sizeof(header));
-          len = read(dev->fd_handle, buf, sizeof(buf));
-          if (len > 0) {
-            status = 1;
+          status = 0;
+          while (frames < ETH_TAP_READ_BATCH) {
+            len = read(dev->fd_handle, buf, sizeof(buf));
+            if (len <= 0) {
+              if ((len < 0) && (frames == 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+                status = -1;
+              break;
+              }
+            ++frames;
             header.caplen = header.len = len;
             _eth_callback((u_char *)dev, &header, buf);
             }
-          else {
-            if (len < 0)
-              status = -1;
-            else
-              status = 0;
-            }
+          if (frames)
+            status = 1;
           }
         break;
 #endif /* HAVE_TAP_NETWORK */
+#if defined (HAVE_PACKET_RING)
+      case ETH_API_PKT:
+        status = (_eth_pkt_dispatch (dev, (ETH_PKT_RING *)dev->handle) > 0) ? 1 : 0;
+        break;
+#endif /* HAVE_PACKET_RING */
 #ifdef HAVE_VDE_NETWORK
       case ETH_API_VDE:
         if (1) {
@@ -1832,6 +2391,24 @@ while (dev->handle) {
         break;
 #endif /* HAVE_SLIRP_NETWORK */
       case ETH_API_UDP:
+#if defined (HAVE_UDP_MMSG)
+        if (udp_batch) {
+          struct pcap_pkthdr header;
+          int i, n;
+
+          memset(&header, 0, sizeof(header));
+          n = recvmmsg (select_fd, udp_batch->msgs, ETH_UDP_BATCH, MSG_DONTWAIT, NULL);
+          for (i = 0; i < n; i++) {
+            header.caplen = header.len = udp_batch->msgs[i].msg_len;
+            _eth_callback((u_char *)dev, &header, (u_char *)udp_batch->iov[i].iov_base);
+            }
+          if (n > 0)
+            status = 1;
+          else
+            status = ((n < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK)) ? -1 : 0;
+          break;
+          }
+#endif /* HAVE_UDP_MMSG */
         if (1) {
           struct pcap_pkthdr header;
           int len;
@@ -1857,7 +2434,7 @@ while (dev->handle) {
       int wakeup_needed;
 
       pthread_mutex_lock (&dev->lock);
-      wakeup_needed = (dev->read_queue.count != 0);
+      wakeup_needed = (dev->read_ring.count != 0);
       pthread_mutex_unlock (&dev->lock);
       if (wakeup_needed) {
         sim_debug(dev->dbit, dev->dptr, "Queueing automatic poll\n");
@@ -1883,6 +2460,9 @@ while (dev->handle) {
     }
   }
 
+#if defined (HAVE_UDP_MMSG)
+free (udp_batch);
+#endif
 sim_debug(dev->dbit, dev->dptr, "Reader Thread Exiting\n");
 return NULL;
 }
@@ -1906,6 +2486,9 @@ while (dev->handle) {
   while (NULL != (request = dev->write_requests)) {
     /* Pull buffer off request list */
     dev->write_requests = request->next;
+    /* Transports which batch may hold this frame back while more are queued */
+    dev->write_more = (dev->write_requests != NULL) && 
+                      (dev->throttle_delay == ETH_THROT_DISABLED_DELAY);
     pthread_mutex_unlock (&dev->writer_lock);
 
     if (dev->throttle_delay != ETH_THROT_DISABLED_DELAY) {
@@ -1944,7 +2527,7 @@ int wakeup_needed;
 dev->asynch_io = 1;
 dev->asynch_io_latency = latency;
 pthread_mutex_lock (&dev->lock);
-wakeup_needed = (dev->read_queue.count != 0);
+wakeup_needed = (dev->read_ring.count != 0);
 pthread_mutex_unlock (&dev->lock);
 if (wakeup_needed) {
   sim_debug(dev->dbit, dev->dptr, "Queueing automatic poll\n");
@@ -2128,6 +2711,23 @@ else { /* !tap: */
 #endif /* defined(HAVE_SLIRP_NETWORK) */
       }
     else { /* not nat: */
+      if (0 == strncmp("pkt:", savname, 4)) {
+#if defined(HAVE_PACKET_RING)
+        const char *devname = savname + 4;
+
+        while (isspace(*devname))
+          ++devname;
+        if (!strcmp(devname, "ifname"))
+          return sim_messagef (SCPE_OPENERR, "Eth: Must specify actual interface name (i.e. pkt:eth0)\n");
+        if ((*handle = (void *)_eth_pkt_open (devname, errbuf))) {
+          *eth_api = ETH_API_PKT;
+          *fd_handle = ((ETH_PKT_RING *)*handle)->fd;
+          }
+#else
+        strlcpy(errbuf, "No support for pkt: network devices", PCAP_ERRBUF_SIZE);
+#endif /* defined(HAVE_PACKET_RING) */
+        }
+      else /* not pkt: */
       if (0 == strncmp("udp:", savname, 4)) {
         char localport[CBUFSIZE], host[CBUFSIZE], port[CBUFSIZE];
         char hostport[2*CBUFSIZE];
@@ -2328,7 +2928,9 @@ dev->dbit = dbit;
 if (1) {
   pthread_attr_t attr;
 
-  ethq_init (&dev->read_queue, 200);         /* initialize FIFO queue */
+  if (_eth_crc32_impl == &_eth_crc32_select)    /* choose CRC implementation */
+    _eth_crc32_select (0, NULL, 0);             /* before threads share it */
+  _eth_ring_init (&dev->read_ring, ETH_RING_SIZE);/* allocate receive ring */
   pthread_mutex_init (&dev->lock, NULL);
   pthread_mutex_init (&dev->writer_lock, NULL);
   pthread_mutex_init (&dev->self_lock, NULL);
@@ -2385,6 +2987,11 @@ switch (eth_api) {
   case ETH_API_UDP:
     sim_close_sock(pcap_fd);
     break;
+#ifdef HAVE_PACKET_RING
+  case ETH_API_PKT:
+    _eth_pkt_close((ETH_PKT_RING *)pcap);
+    break;
+#endif
   }
 return SCPE_OK;
 }
@@ -2423,8 +3030,12 @@ if (1) {
     free(buffer);
     }
   }
-ethq_destroy (&dev->read_queue);         /* release FIFO queue */
+_eth_ring_destroy (&dev->read_ring);     /* release receive ring */
+free (dev->write_batch);
+dev->write_batch = NULL;
 #endif
+free (dev->read_ref_packet);
+dev->read_ref_packet = NULL;
 
 _eth_close_port (dev->eth_api, pcap, pcap_fd);
 sim_messagef (SCPE_OK, "Eth: closed %s\n", dev->name);
@@ -2454,6 +3065,9 @@ fprintf (st, "    eth2   vde:device{:switch-port-number}      (Integrated VDE su
 fprintf (st, "    eth3   nat:{optional-nat-parameters}        (Integrated NAT (SLiRP) support)\n");
 #endif
 fprintf (st, "    eth4   udp:sourceport:remotehost:remoteport (Integrated UDP bridge support)\n");
+#if defined(HAVE_PACKET_RING)
+fprintf (st, "    eth5   pkt:ifname                           (Integrated Linux packet ring support)\n");
+#endif
 fprintf (st, "   sim> ATTACH %s eth0\n\n", dptr->name);
 fprintf (st, "or equivalently:\n\n");
 fprintf (st, "   sim> ATTACH %s en0\n\n", dptr->name);
@@ -2671,6 +3285,9 @@ switch (dev->eth_api) {
   case ETH_API_NAT:
       netname = "nat";
       break;
+  case ETH_API_PKT:
+      netname = "pkt";
+      break;
   }
 sprintf(msg, "%s(%s): ", where, netname);
 switch (dev->eth_api) {
@@ -2801,8 +3418,17 @@ if ((packet->len >= ETH_MIN_PACKET) && (packet->len <= ETH_MAX_PACKET)) {
       break;
 #endif
     case ETH_API_UDP:
+#if defined (HAVE_UDP_MMSG)
+      status = _eth_udp_batch_write (dev, packet);
+#else
       status = (((int32)packet->len == sim_write_sock (dev->fd_handle, (char *)packet->msg, (int32)packet->len)) ? 0 : -1);
+#endif
       break;
+#if defined (HAVE_PACKET_RING)
+    case ETH_API_PKT:
+      status = _eth_pkt_send ((ETH_PKT_RING *)dev->handle, packet->msg, packet->len, dev->write_more);
+      break;
+#endif
     }
   ++dev->packets_sent;              /* basic bookkeeping */
   /* On error, correct loopback bookkeeping */
@@ -2886,13 +3512,79 @@ return _eth_write(dev, packet, routine);
 #endif
 }
 
+/* Address matching for transports without BPF
+
+   The filter addresses are kept in a small open addressed hash table so
+   a frame's destination and source are each checked with a probe or two
+   instead of comparing every filter address.  The AUTODIN II multicast
+   hash key (6 bits of the address CRC) only depends on the address, so
+   multicast destinations remember their key in a direct mapped cache and
+   the CRC is computed once per address rather than once per frame.
+*/
+
+#define ETH_MAC_KEY_VALID  (((t_uint64)1) << 63)
+#define ETH_HASH_KEY_SHIFT 48
+#define ETH_HASH_KEY_MASK  (((t_uint64)0x3F) << ETH_HASH_KEY_SHIFT)
+
+static t_uint64 _eth_mac_key (const uint8 *mac)
+{
+return ETH_MAC_KEY_VALID | ((t_uint64)mac[0] << 40) | ((t_uint64)mac[1] << 32) | 
+       ((t_uint64)mac[2] << 24) | ((t_uint64)mac[3] << 16) | ((t_uint64)mac[4] << 8) | mac[5];
+}
+
+static uint32 _eth_mac_slot (t_uint64 key, int bits)
+{
+uint32 h = (uint32)(key ^ (key >> 24)) * 0x9E3779B1;
+
+return h >> (32 - bits);
+}
+
+static void
+_eth_filter_table_load (ETH_DEV* dev)
+{
+int i;
+
+memset (dev->filter_table, 0, sizeof (dev->filter_table));
+for (i = 0; i < dev->addr_count; i++) {
+  t_uint64 key = _eth_mac_key (dev->filter_address[i]);
+  uint32 slot = _eth_mac_slot (key, ETH_FILTER_TABLE_BITS);
+
+  while (dev->filter_table[slot] && (dev->filter_table[slot] != key))
+    slot = (slot + 1) & (ETH_FILTER_TABLE_SIZE - 1);
+  dev->filter_table[slot] = key;
+  }
+}
+
 static int
-_eth_hash_lookup(ETH_MULTIHASH hash, const u_char* data)
+_eth_filter_match (ETH_DEV* dev, const u_char* mac)
 {
-int key = 0x3f & (eth_crc32(0, data, 6) >> 26);
+t_uint64 key = _eth_mac_key (mac);
+uint32 slot = _eth_mac_slot (key, ETH_FILTER_TABLE_BITS);
 
-key ^= 0x3f;
-return (hash[key>>3] & (1 << (key&0x7)));
+while (dev->filter_table[slot]) {
+  if (dev->filter_table[slot] == key)
+    return 1;
+  slot = (slot + 1) & (ETH_FILTER_TABLE_SIZE - 1);
+  }
+return 0;
+}
+
+static int
+_eth_hash_lookup(ETH_DEV* dev, const u_char* data)
+{
+t_uint64 key = _eth_mac_key (data);
+uint32 slot = _eth_mac_slot (key, ETH_HASH_CACHE_BITS);
+t_uint64 entry = dev->hash_key_cache[slot];
+int hkey;
+
+if ((entry & ~ETH_HASH_KEY_MASK) == key)
+  hkey = (int)((entry & ETH_HASH_KEY_MASK) >> ETH_HASH_KEY_SHIFT);
+else {
+  hkey = 0x3f & (eth_crc32(0, data, 6) >> 26);
+  hkey ^= 0x3f;
+  dev->hash_key_cache[slot] = key | ((t_uint64)hkey << ETH_HASH_KEY_SHIFT);
+  }
+return (dev->hash[hkey>>3] & (1 << (hkey&0x7)));
 }
 
 #if 0
@@ -3383,7 +4075,6 @@ _eth_callback(u_char* info, const struct pcap_pkthdr* header, const u_char* data
 ETH_DEV*  dev = (ETH_DEV*) info;
 int to_me;
 int from_me = 0;
-int i;
 int bpf_used;
 
 if (LOOPBACK_PHYSICAL_RESPONSE(dev, data)) {
@@ -3406,21 +4097,20 @@ switch (dev->eth_api) {
     to_me = 1;
     /* AUTODIN II hash mode? */
     if ((dev->hash_filter) && (data[0] & 0x01) && (!dev->promiscuous) && (!dev->all_multicast))
-      to_me = _eth_hash_lookup(dev->hash, data);
+      to_me = _eth_hash_lookup(dev, data);
     break;
 #endif /* USE_BPF */
   case ETH_API_TAP:
   case ETH_API_VDE:
   case ETH_API_UDP:
   case ETH_API_NAT:
+  case ETH_API_PKT:
     bpf_used = 0;
     to_me = 0;
     eth_packet_trace (dev, data, header->len, "received");
 
-    for (i = 0; i < dev->addr_count; i++) {
-      if (memcmp(data, dev->filter_address[i], 6) == 0) to_me = 1;
-      if (memcmp(&data[6], dev->filter_address[i], 6) == 0) from_me = 1;
-    }
+    to_me = _eth_filter_match (dev, data);
+    from_me = _eth_filter_match (dev, &data[6]);
 
     /* all multicast mode? */
     if (dev->all_multicast && (data[0] & 0x01)) to_me = 1;
@@ -3430,7 +4120,7 @@ switch (dev->eth_api) {
 
     /* AUTODIN II hash mode? */
     if ((dev->hash_filter) && (!to_me) && (data[0] & 0x01))
-      to_me = _eth_hash_lookup(dev->hash, data);
+      to_me = _eth_hash_lookup(dev, data);
     break;
   default:
     bpf_used = to_me = 0;                           /* Should NEVER happen */
@@ -3475,34 +4165,43 @@ if (bpf_used ? to_me : (to_me && !from_me)) {
     return;  
 #if defined (USE_READER_THREAD)
   if (1) {
-    int crc_len = 0;
-    uint8 crc_data[4];
-    uint32 len = header->len;
-    u_char *moved_data = NULL;
-
-    if (header->len < ETH_MIN_PACKET) {   /* Pad runt packets before CRC append */
-      moved_data = (u_char *)malloc(ETH_MIN_PACKET);
-      memcpy(moved_data, data, len);
-      memset(moved_data + len, 0, ETH_MIN_PACKET-len);
-      len = ETH_MIN_PACKET;
-      data = moved_data;
+    struct eth_ring_slot *slot;
+    uint8 *msg;
+    uint32 len = MAX (header->len, ETH_MIN_PACKET);
+    uint32 size = ETH_RING_SLOT_SIZE (len + ETH_CRC_SIZE);
+    uint32 offset;
+
+    pthread_mutex_lock (&dev->lock);
+    ++dev->packets_received;
+    offset = _eth_ring_reserve (&dev->read_ring, size);
+    pthread_mutex_unlock (&dev->lock);
+    if (offset == ETH_RING_FULL) {
+      eth_packet_trace (dev, data, header->len, "dropped");
+      return;
       }
 
+    /* build the packet directly in its slot */
+    slot = (struct eth_ring_slot *)(dev->read_ring.base + offset);
+    msg = (uint8 *)(slot + 1);
+    memcpy(msg, data, header->len);
+    if (header->len < ETH_MIN_PACKET)     /* Pad runt packets before CRC append */
+      memset(msg + header->len, 0, ETH_MIN_PACKET-header->len);
+
     /* If necessary, fix IP header checksums for packets originated locally */
     /* but were presumed to be traversing a NIC which was going to handle that task */
     /* This must be done before any needed CRC calculation */
-    _eth_fix_ip_xsum_offload(dev, (const u_char*)data, len);
+    _eth_fix_ip_xsum_offload(dev, msg, len);
     
+    slot->len = len;
+    slot->crc_len = 0;
     if (dev->need_crc)
-      crc_len = eth_get_packet_crc32_data(data, len, crc_data);
+      slot->crc_len = eth_get_packet_crc32_data(msg, len, &msg[len]);
 
-    eth_packet_trace (dev, data, len, "rcvqd");
+    eth_packet_trace (dev, msg, len, "rcvqd");
 
     pthread_mutex_lock (&dev->lock);
-    ethq_insert_data(&dev->read_queue, ETH_ITM_NORMAL, data, 0, len, crc_len, crc_data, 0);
-    ++dev->packets_received;
+    _eth_ring_publish (&dev->read_ring, offset, size);
     pthread_mutex_unlock (&dev->lock);
-    free(moved_data);
     }
 #else /* !USE_READER_THREAD */
   /* set data in passed read packet */
@@ -3640,16 +4339,18 @@ if (status < 0) {
 #else /* USE_READER_THREAD */
 
   status = 0;
-  pthread_mutex_lock (&dev->lock);
-  if (dev->read_queue.count > 0) {
-    ETH_ITEM* item = &dev->read_queue.item[dev->read_queue.head];
-    packet->len = item->packet.len;
-    packet->crc_len = item->packet.crc_len;
-    memcpy(packet->msg, item->packet.msg, ((packet->len > packet->crc_len) ? packet->len : packet->crc_len));
-    status = 1;
-    ethq_remove(&dev->read_queue);
-  }
-  pthread_mutex_unlock (&dev->lock);  
+  if (1) {
+    uint32 len, crc_len;
+    const uint8 *msg = eth_read_ref (dev, &len, &crc_len);
+
+    if (msg) {
+      packet->len = len;
+      packet->crc_len = crc_len;
+      memcpy(packet->msg, msg, ((len > crc_len) ? len : crc_len));
+      status = 1;
+      eth_read_done (dev);
+      }
+    }
   if ((status) && (routine))
     routine(0);
 #endif
@@ -3657,6 +4358,59 @@ if (status < 0) {
 return status;
 }
 
+/* Reference the oldest received packet without copying it.  The packet
+   data stays valid until eth_read_done, eth_read, eth_filter or eth_close
+   is called for the device. */
+
+const uint8 *eth_read_ref (ETH_DEV* dev, uint32 *len, uint32 *crc_len)
+{
+#if defined (USE_READER_THREAD)
+struct eth_ring_slot *slot;
+
+if ((!dev) || (dev->eth_api == ETH_API_NONE))
+  return NULL;
+pthread_mutex_lock (&dev->lock);
+slot = _eth_ring_peek (&dev->read_ring);
+pthread_mutex_unlock (&dev->lock);
+if (!slot)
+  return NULL;
+*len = slot->len;
+*crc_len = slot->crc_len;
+return (const uint8 *)(slot + 1);
+#else
+ETH_PACK *packet;
+
+if ((!dev) || (dev->eth_api == ETH_API_NONE))
+  return NULL;
+if (!dev->read_ref_packet) {
+  dev->read_ref_packet = (ETH_PACK *)calloc (1, sizeof (*dev->read_ref_packet));
+  if (!dev->read_ref_packet)
+    return NULL;
+  }
+packet = dev->read_ref_packet;
+if ((packet->len == 0) &&                               /* nothing held? */
+    (!eth_read (dev, packet, NULL)))                    /* and nothing arrived? */
+  return NULL;
+*len = packet->len;
+*crc_len = packet->crc_len;
+return packet->msg;
+#endif
+}
+
+void eth_read_done (ETH_DEV* dev)
+{
+if ((!dev) || (dev->eth_api == ETH_API_NONE))
+  return;
+#if defined (USE_READER_THREAD)
+pthread_mutex_lock (&dev->lock);
+_eth_ring_remove (&dev->read_ring);
+pthread_mutex_unlock (&dev->lock);
+#else
+if (dev->read_ref_packet)
+  dev->read_ref_packet->len = 0;
+#endif
+}
+
 t_stat eth_bpf_filter (ETH_DEV* dev, int addr_count, ETH_MAC* const filter_address,
                        ETH_BOOL all_multicast, ETH_BOOL promiscuous, 
                        int reflections,
@@ -3788,6 +4542,7 @@ if (dev->reflections == -1)
 for (i = 0; i < addr_count; i++)
   memcpy(dev->filter_address[i], addresses[i], sizeof(ETH_MAC));
 dev->addr_count = addr_count;
+_eth_filter_table_load (dev);
 
 /* store other flags */
 dev->all_multicast = all_multicast;
@@ -3896,7 +4651,7 @@ if (dev->eth_api == ETH_API_PCAP) {
     }
 #ifdef USE_READER_THREAD
   pthread_mutex_lock (&dev->lock);
-  ethq_clear (&dev->read_queue); /* Empty FIFO Queue when filter list changes */
+  _eth_ring_clear (&dev->read_ring); /* Empty receive ring when filter list changes */
   pthread_mutex_unlock (&dev->lock);
 #endif
   }
@@ -4023,6 +4778,14 @@ if (used < max) {
   list[used].eth_api = ETH_API_UDP;
   ++used;
   }
+#ifdef HAVE_PACKET_RING
+if (used < max) {
+  sprintf(list[used].name, "%s", "pkt:ifname");
+  sprintf(list[used].desc, "%s", "Integrated Linux packet ring support");
+  list[used].eth_api = ETH_API_PKT;
+  ++used;
+  }
+#endif
 
 return used;
 }
@@ -4110,9 +4873,9 @@ if (dev->asynch_io)
   fprintf(st, "  Interrupt Latency:       %d uSec\n", dev->asynch_io_latency);
 if (dev->throttle_count)
   fprintf(st, "  Throttle Delays:         %d\n", dev->throttle_count);
-fprintf(st, "  Read Queue: Count:       %d\n", dev->read_queue.count);
-fprintf(st, "  Read Queue: High:        %d\n", dev->read_queue.high);
-fprintf(st, "  Read Queue: Loss:        %d\n", dev->read_queue.loss);
+fprintf(st, "  Read Queue: Count:       %d\n", dev->read_ring.count);
+fprintf(st, "  Read Queue: High:        %d\n", dev->read_ring.high);
+fprintf(st, "  Read Queue: Loss:        %d\n", dev->read_ring.loss);
 fprintf(st, "  Peak Write Queue Size:   %d\n", dev->write_queue_peak);
 #endif
 if (dev->bpf_filter)
@@ -4171,6 +4934,92 @@ for (val=0; val <= 0xFF; val++) {
     ++errors;
     }
   }
+/* Every implementation must agree with the byte at a time table walk
+   for all lengths and alignments */
+if (1) {
+  static uint8 buf[ETH_MAX_JUMBO_FRAME/16];
+  size_t i, len, off;
+
+  for (i = 0; i < sizeof (buf); i++)
+    buf[i] = (uint8)((i * 131) ^ (i >> 5));
+  for (len = 0; len < sizeof (buf) - 8; len += (len < 300) ? 1 : 61) {
+    for (off = 0; off < 8; off++) {
+      uint32 ref = _eth_crc32_bytes (0xFFFFFFFF, buf + off, len);
+
+      if (_eth_crc32_slice8 (0xFFFFFFFF, buf + off, len) != ref) {
+        sim_printf ("Eth: slicing-by-8 CRC mismatch for %d bytes at offset %d\n", (int)len, (int)off);
+        ++errors;
+        }
+#if defined (ETH_CRC32_CLMUL)
+      if (_eth_crc32_have_clmul () && (_eth_crc32_clmul (0xFFFFFFFF, buf + off, len) != ref)) {
+        sim_printf ("Eth: PCLMULQDQ CRC mismatch for %d bytes at offset %d\n", (int)len, (int)off);
+        ++errors;
+        }
+#endif
+      }
+    }
+  }
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+/* Address filter test - the hashed filter table and the cached multicast
+   hash keys must give the same answers as a linear search and a fresh
+   CRC for every address */
+
+static
+t_stat eth_test_filter (DEVICE *dptr)
+{
+int errors = 0;
+ETH_DEV dev;
+ETH_MAC mac;
+int i, j, pass;
+
+memset (&dev, 0, sizeof (dev));
+for (i = 0; i < ETH_FILTER_MAX; i++) {
+  dev.filter_address[i][0] = (i & 1) ? 0x09 : 0x08;
+  dev.filter_address[i][1] = 0x00;
+  dev.filter_address[i][2] = 0x2B;
+  dev.filter_address[i][3] = (uint8)(i * 3);
+  dev.filter_address[i][4] = 0x00;
+  dev.filter_address[i][5] = (uint8)(i * 7);
+  }
+dev.addr_count = ETH_FILTER_MAX;
+_eth_filter_table_load (&dev);
+for (i = 0; i < (int)sizeof (dev.hash); i++)
+  dev.hash[i] = (uint8)(0x5A ^ (i * 0x11));
+for (pass = 0; pass < 2; pass++) {              /* second pass hits the key cache */
+  for (i = 0; i < 4096; i++) {
+    int found = 0;
+    int key;
+
+    mac[0] = (i & 1) ? 0x09 : 0x08;
+    mac[1] = 0x00;
+    mac[2] = 0x2B;
+    mac[3] = (uint8)(i >> 4);
+    mac[4] = 0x00;
+    mac[5] = (uint8)((i >> 1) * 7);
+    for (j = 0; j < dev.addr_count; j++)
+      if (memcmp (mac, dev.filter_address[j], sizeof (mac)) == 0)
+        found = 1;
+    if (found != _eth_filter_match (&dev, mac)) {
+      sim_printf ("Eth: Filter table %s %02X:%02X:%02X:%02X:%02X:%02X\n", found ? "missed" : "wrongly matched", 
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+      ++errors;
+      }
+    key = 0x3F ^ (0x3F & (eth_crc32 (0, mac, 6) >> 26));
+    if ((0 != (dev.hash[key>>3] & (1 << (key&0x7)))) != (0 != _eth_hash_lookup (&dev, mac))) {
+      sim_printf ("Eth: Multicast hash lookup wrong for %02X:%02X:%02X:%02X:%02X:%02X\n", 
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+      ++errors;
+      }
+    }
+  }
+dev.addr_count = 0;                             /* emptied table matches nothing */
+_eth_filter_table_load (&dev);
+if (_eth_filter_match (&dev, dev.filter_address[0])) {
+  sim_printf ("Eth: Empty filter table matched\n");
+  ++errors;
+  }
 return (errors == 0) ? SCPE_OK : SCPE_IERR;
 }
 
@@ -4239,7 +5088,8 @@ for (eth_num=0; eth_num<eth_device_count; eth_num++) {
   if ((0 == memcmp (eth_list[eth_num].name, "nat:", 4)) ||
       (0 == memcmp (eth_list[eth_num].name, "tap:", 4)) ||
       (0 == memcmp (eth_list[eth_num].name, "vde:", 4)) ||
-      (0 == memcmp (eth_list[eth_num].name, "udp:", 4)))
+      (0 == memcmp (eth_list[eth_num].name, "udp:", 4)) ||
+      (0 == memcmp (eth_list[eth_num].name, "pkt:", 4)))
       continue;
   eth_name[sizeof (eth_name)-1] = '\0';
   snprintf (eth_name, sizeof (eth_name)-1, "eth%d", eth_num);
@@ -4318,6 +5168,240 @@ if (bpf_compile_skip_count)
 return (errors == 0) ? SCPE_OK : SCPE_IERR;
 }
 
+/* Receive ring test - feed synthetic packets through _eth_callback into a
+   small ring and confirm that they come back in order, intact, padded and
+   with a CRC, across wraps, overflow and eth_read_ref access */
+
+static
+t_stat eth_test_ring (DEVICE *dptr)
+{
+int errors = 0;
+#if defined (USE_READER_THREAD)
+DEVICE eth_tst;
+ETH_DEV dev;
+ETH_PACK packet;
+struct pcap_pkthdr header;
+uint8 frame[ETH_MAX_PACKET];
+uint8 crc[ETH_CRC_SIZE];
+uint32 sent = 0, rcvd = 0, dropped = 0;
+uint32 len, crc_len;
+const uint8 *msg;
+int i, pass;
+
+memset (&eth_tst, 0, sizeof (eth_tst));
+memset (&dev, 0, sizeof (dev));
+dev.dptr = &eth_tst;
+dev.eth_api = ETH_API_UDP;
+dev.promiscuous = TRUE;
+dev.need_crc = TRUE;
+pthread_mutex_init (&dev.lock, NULL);
+if (_eth_ring_init (&dev.read_ring, 16*1024) != SCPE_OK)
+  return SCPE_MEM;
+memset (frame, 0, sizeof (frame));
+memset (&header, 0, sizeof (header));
+frame[0] = 0x09;                                        /* LAT multicast */
+frame[1] = 0x00; frame[2] = 0x2B; frame[3] = 0x00; frame[4] = 0x00; frame[5] = 0x0F;
+frame[6] = 0x08;                                        /* some sender */
+frame[12] = 0x60; frame[13] = 0x04;                     /* LAT */
+for (pass = 0; pass < 64; pass++) {
+  int burst = 1 + (pass * 7) % 23;                      /* packets before draining */
+
+  for (i = 0; i < burst; i++) {
+    header.caplen = header.len = 42 + ((sent * 97) % (ETH_MAX_PACKET - 41));
+    memcpy (&frame[14], &sent, sizeof (sent));          /* sequence */
+    memset (&frame[18], sent & 0xFF, header.len - 18);
+    _eth_callback ((u_char *)&dev, &header, frame);
+    ++sent;
+    }
+  while (1) {
+    uint32 seq;
+
+    if (pass & 1) {                                     /* alternate copy and reference reads */
+      msg = eth_read_ref (&dev, &len, &crc_len);
+      if (msg == NULL)
+        break;
+      }
+    else {
+      if (!eth_read (&dev, &packet, NULL))
+        break;
+      msg = packet.msg;
+      len = packet.len;
+      crc_len = packet.crc_len;
+      }
+    memcpy (&seq, &msg[14], sizeof (seq));
+    while ((rcvd + dropped < seq) && (dropped < (uint32)dev.read_ring.loss))
+      ++dropped;                                        /* account for packets lost while full */
+    if (seq != rcvd + dropped) {
+      sim_printf ("Eth: Ring packet %u arrived when %u expected\n", seq, rcvd + dropped);
+      ++errors;
+      break;
+      }
+    header.len = 42 + ((seq * 97) % (ETH_MAX_PACKET - 41));
+    if ((len != MAX (header.len, ETH_MIN_PACKET)) || (crc_len != len + ETH_CRC_SIZE)) {
+      sim_printf ("Eth: Ring packet %u has length %u/%u\n", seq, len, crc_len);
+      ++errors;
+      }
+    else {
+      memcpy (&frame[14], &seq, sizeof (seq));
+      memset (&frame[18], seq & 0xFF, header.len - 18);
+      if (header.len < ETH_MIN_PACKET)
+        memset (&frame[header.len], 0, ETH_MIN_PACKET - header.len);
+      eth_get_packet_crc32_data (frame, len, crc);
+      if ((memcmp (msg, frame, len) != 0) || (memcmp (&msg[len], crc, sizeof (crc)) != 0)) {
+        sim_printf ("Eth: Ring packet %u data or CRC mismatch\n", seq);
+        ++errors;
+        }
+      }
+    if (pass & 1)
+      eth_read_done (&dev);
+    ++rcvd;
+    }
+  }
+if (rcvd + (uint32)dev.read_ring.loss != sent) {
+  sim_printf ("Eth: Ring delivered %u and dropped %d of %u packets\n", rcvd, dev.read_ring.loss, sent);
+  ++errors;
+  }
+if ((dev.read_ring.loss == 0) || (dev.read_ring.count != 0)) {
+  sim_printf ("Eth: Ring never filled (loss %d) or isn't empty (count %d)\n", dev.read_ring.loss, dev.read_ring.count);
+  ++errors;
+  }
+_eth_ring_destroy (&dev.read_ring);
+pthread_mutex_destroy (&dev.lock);
+#endif /* USE_READER_THREAD */
+return (errors == 0) ? SCPE_OK : SCPE_IERR;
+}
+
+
+/* Receive path benchmark - frames/second through _eth_callback (address
+   filtering, padding, CRC and queueing) with a synthetic traffic mix, and
+   the throughput of each CRC implementation.  Only runs when the
+   SIM_ETHER_BENCHMARK environment variable gives a frame count (see the
+   ether-benchmark make target) */
+
+static
+t_stat eth_test_benchmark (DEVICE *dptr)
+{
+static t_bool done = FALSE;
+const char *count = getenv ("SIM_ETHER_BENCHMARK");
+DEVICE eth_tst;
+ETH_DEV dev;
+#if !defined (USE_READER_THREAD)
+ETH_PACK packet;
+#endif
+struct pcap_pkthdr header;
+static const ETH_MAC station = {0x08, 0x00, 0x2B, 0x12, 0x34, 0x56};
+static const ETH_MAC dests[8] = {
+  {0x08, 0x00, 0x2B, 0x12, 0x34, 0x56},         /* to us */
+  {0x08, 0x00, 0x2B, 0x12, 0x34, 0x56},
+  {0x08, 0x00, 0x2B, 0x65, 0x43, 0x21},         /* to another station */
+  {0x08, 0x00, 0x2B, 0x12, 0x34, 0x56},
+  {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},         /* broadcast */
+  {0x09, 0x00, 0x2B, 0x00, 0x00, 0x0F},         /* LAT multicast (in hash) */
+  {0x33, 0x33, 0x00, 0x00, 0x00, 0x01},         /* IPv6 multicast (not in hash) */
+  {0x08, 0x00, 0x2B, 0x12, 0x34, 0x56}};
+static const uint32 lens[8] = {1514, 590, 1514, 64, 60, 1514, 86, 1514};
+static uint8 frames[8][ETH_MAX_PACKET];
+uint32 n, i, start, ms, frame_bytes = 0;
+int need_crc, key;
+
+if ((count == NULL) || done)
+  return SCPE_OK;
+done = TRUE;
+n = (uint32)strtoul (count, NULL, 10);
+if (n == 0)
+  n = 1000000;
+memset (&eth_tst, 0, sizeof (eth_tst));
+memset (&dev, 0, sizeof (dev));
+dev.dptr = &eth_tst;
+dev.eth_api = ETH_API_UDP;                      /* non-BPF filtering */
+memcpy (dev.filter_address[0], station, sizeof (ETH_MAC));
+memset (dev.filter_address[1], 0xFF, sizeof (ETH_MAC));
+dev.addr_count = 2;
+_eth_filter_table_load (&dev);
+key = 0x3F ^ (0x3F & (eth_crc32 (0, dests[5], 6) >> 26));
+dev.hash[key>>3] |= (1 << (key&0x7));
+dev.hash_filter = TRUE;
+#if defined (USE_READER_THREAD)
+pthread_mutex_init (&dev.lock, NULL);
+pthread_mutex_init (&dev.self_lock, NULL);
+if (_eth_ring_init (&dev.read_ring, ETH_RING_SIZE) != SCPE_OK)
+  return SCPE_MEM;
+#else
+dev.read_packet = &packet;
+#endif
+for (i = 0; i < 8; i++) {
+  uint32 j;
+
+  memcpy (frames[i], dests[i], sizeof (ETH_MAC));
+  frames[i][6] = 0xAA;                          /* some other sender */
+  frames[i][12] = 0x60; frames[i][13] = 0x04;
+  for (j = 14; j < lens[i]; j++)
+    frames[i][j] = (uint8)(i + j);
+  frame_bytes += lens[i];
+  }
+memset (&header, 0, sizeof (header));
+for (need_crc = 0; need_crc < 2; need_crc++) {
+  dev.need_crc = need_crc;
+  dev.packets_received = 0;
+  start = sim_os_msec ();
+  for (i = 0; i < n; i++) {
+    header.caplen = header.len = lens[i & 7];
+    _eth_callback ((u_char *)&dev, &header, frames[i & 7]);
+#if defined (USE_READER_THREAD)
+    if ((i & 7) == 7) {                         /* consumer drains as it goes */
+      uint32 len, crc_len;
+
+      while (eth_read_ref (&dev, &len, &crc_len))
+        eth_read_done (&dev);
+      }
+#endif
+    }
+  ms = sim_os_msec () - start;
+  if (ms == 0)
+    ms = 1;
+  sim_printf ("Eth: _eth_callback %s CRC: %u frames (%u accepted) in %u ms, %.0f frames/sec, %.1f MB/sec\n",
+              need_crc ? "with" : "without", n, dev.packets_received, ms,
+              (1000.0 * n) / ms, (((double)frame_bytes / 8) * n) / (ms * 1000.0));
+  }
+if (1) {
+  static const struct {
+    const char *name;
+    uint32 (*crc) (uint32 crc, const uint8 *buf, size_t len);
+    } impl[] = {
+      {"byte at a time",    &_eth_crc32_bytes},
+      {"slicing-by-8",      &_eth_crc32_slice8},
+#if defined (ETH_CRC32_CLMUL)
+      {"PCLMULQDQ folding", &_eth_crc32_clmul},
+#endif
+      {NULL, NULL}};
+  uint32 crc = 0;
+
+  for (i = 0; impl[i].name; i++) {
+    uint32 j;
+
+#if defined (ETH_CRC32_CLMUL)
+    if ((impl[i].crc == &_eth_crc32_clmul) && !_eth_crc32_have_clmul ())
+      continue;
+#endif
+    start = sim_os_msec ();
+    for (j = 0; j < n; j++)
+      crc ^= impl[i].crc (crc, frames[0], ETH_MAX_PACKET);
+    ms = sim_os_msec () - start;
+    if (ms == 0)
+      ms = 1;
+    sim_printf ("Eth: CRC32 %-18s %.1f MB/sec%s\n", impl[i].name, 
+                (((double)ETH_MAX_PACKET) * n) / (ms * 1000.0), 
+                (0 == strcmp (impl[i].name, _eth_crc32_name)) ? " (selected)" : "");
+    }
+  }
+#if defined (USE_READER_THREAD)
+_eth_ring_destroy (&dev.read_ring);
+pthread_mutex_destroy (&dev.self_lock);
+pthread_mutex_destroy (&dev.lock);
+#endif
+return SCPE_OK;
+}
+
 #include <setjmp.h>
 
 t_stat sim_ether_test (DEVICE *dptr)
@@ -4329,6 +5413,9 @@ sim_printf ("Testing %s device sim_ether APIs\n", dptr->name);
 
 SIM_TEST(eth_test_crc32 (dptr));
 SIM_TEST(eth_test_bpf (dptr));
+SIM_TEST(eth_test_ring (dptr));
+SIM_TEST(eth_test_filter (dptr));
+SIM_TEST(eth_test_benchmark (dptr));
 return stat;
 }
 #endif /* USE_NETWORK */
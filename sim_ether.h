@@ -232,6 +232,17 @@ struct eth_queue {
   struct eth_item*    item;
 };
 
+struct eth_ring {                                       /* receive ring (see sim_ether.c) */
+  uint8*              base;                             /* slot storage (cache line aligned) */
+  void*               alloc;                            /* allocation containing base */
+  uint32              size;                             /* bytes of slot storage */
+  uint32              head;                             /* offset of oldest slot (consumer) */
+  uint32              tail;                             /* offset of next slot (producer) */
+  int                 count;                            /* packets in ring */
+  int                 high;                             /* high water mark */
+  int                 loss;                             /* packets dropped while full */
+};
+
 struct eth_list {
   char    name[ETH_DEV_NAME_MAX];
   char    desc[ETH_DEV_DESC_MAX];
@@ -246,6 +257,7 @@ typedef void (*ETH_PCALLBACK)(int status);
 typedef struct eth_list ETH_LIST;
 typedef struct eth_queue ETH_QUE;
 typedef struct eth_item ETH_ITEM;
+typedef struct eth_ring ETH_RING;
 struct eth_write_request {
   struct eth_write_request *next;
   ETH_PACK packet;
@@ -264,15 +276,23 @@ struct eth_device {
 #define ETH_API_VDE  3                                  /* VDE API in use */
 #define ETH_API_UDP  4                                  /* UDP API in use */
 #define ETH_API_NAT  5                                  /* NAT (SLiRP) API in use */
+#define ETH_API_PKT  6                                  /* Linux AF_PACKET ring API in use */
   ETH_PCALLBACK read_callback;                          /* read callback function */
   ETH_PCALLBACK write_callback;                         /* write callback function */
   ETH_PACK*     read_packet;                            /* read packet */
+  ETH_PACK*     read_ref_packet;                        /* packet held for eth_read_ref (no reader thread) */
   ETH_MAC       filter_address[ETH_FILTER_MAX];         /* filtering addresses */
   int           addr_count;                             /* count of filtering addresses */
   ETH_BOOL      promiscuous;                            /* promiscuous mode flag */
   ETH_BOOL      all_multicast;                          /* receive all multicast messages */
   ETH_BOOL      hash_filter;                            /* filter using AUTODIN II multicast hash */
   ETH_MULTIHASH hash;                                   /* AUTODIN II multicast hash */
+#define ETH_FILTER_TABLE_BITS 6
+#define ETH_FILTER_TABLE_SIZE (1 << ETH_FILTER_TABLE_BITS)  /* > 2 * ETH_FILTER_MAX */
+  t_uint64      filter_table[ETH_FILTER_TABLE_SIZE];    /* filter_address hash table */
+#define ETH_HASH_CACHE_BITS 8
+#define ETH_HASH_CACHE_SIZE (1 << ETH_HASH_CACHE_BITS)
+  t_uint64      hash_key_cache[ETH_HASH_CACHE_SIZE];    /* multicast address -> AUTODIN II hash key */
   int32         loopback_self_sent;                     /* loopback packets sent but not seen */
   int32         loopback_self_sent_total;               /* total loopback packets sent */
   int32         loopback_self_rcvd_total;               /* total loopback packets seen */
@@ -312,7 +332,7 @@ struct eth_device {
 #if defined (USE_READER_THREAD)
   int           asynch_io;                              /* Asynchronous Interrupt scheduling enabled */
   int           asynch_io_latency;                      /* instructions to delay pending interrupt */
-  ETH_QUE       read_queue;
+  ETH_RING      read_ring;                              /* received packets */
   pthread_mutex_t     lock;
   pthread_t     reader_thread;                          /* Reader Thread Id */
   pthread_t     writer_thread;                          /* Writer Thread Id */
@@ -323,6 +343,8 @@ struct eth_device {
   int write_queue_peak;
   ETH_WRITE_REQUEST *write_buffers;
   t_stat write_status;
+  int write_more;                                       /* more write requests queued behind current */
+  void *write_batch;                                    /* transport staging for batched writes */
 #endif
 };
 
@@ -338,6 +360,9 @@ t_stat eth_write  (ETH_DEV* dev, ETH_PACK* packet,      /* write sychronous pack
                    ETH_PCALLBACK routine);              /*  callback when done */
 int eth_read      (ETH_DEV* dev, ETH_PACK* packet,      /* read single packet; */
                    ETH_PCALLBACK routine);              /*  callback when done*/
+const uint8 *eth_read_ref (ETH_DEV* dev, uint32 *len,   /* reference oldest received packet; */
+                           uint32 *crc_len);            /*  NULL if none */
+void eth_read_done (ETH_DEV* dev);                      /* release packet from eth_read_ref */
 t_stat eth_filter (ETH_DEV* dev, int addr_count,        /* set filter on incoming packets */
                    ETH_MAC* const addresses,
                    ETH_BOOL all_multicast,
@@ -52,6 +52,9 @@
    sim_buf_swap_data -       swap data elements inplace in buffer
    sim_shmem_open            create or attach to a shared memory region
    sim_shmem_close           close a shared memory region
+   sim_fmap_open             map a file into memory
+   sim_fmap_sync             write back a file mapping
+   sim_fmap_close            unmap a mapped file
 
 
    sim_fopen and sim_fseek are OS-dependent.  The other routines are not.
@@ -478,6 +481,87 @@ t_bool sim_shmem_atomic_cas (int32 *ptr, int32 oldv, int32 newv)
 return (InterlockedCompareExchange ((LONG volatile *) ptr, newv, oldv) == oldv);
 }
 
+struct SIM_FMAP {
+    HANDLE hFile;
+    HANDLE hMapping;
+    size_t size;
+    void *base;
+    };
+
+t_stat sim_fmap_open (const char *name, size_t *size, t_bool readonly, SIM_FMAP **fmap, void **addr)
+{
+LARGE_INTEGER FileSize;
+
+*addr = NULL;
+*fmap = (SIM_FMAP *)calloc (1, sizeof(**fmap));
+if (*fmap == NULL)
+    return SCPE_MEM;
+(*fmap)->hMapping = NULL;
+(*fmap)->hFile = CreateFileA (name, readonly ? GENERIC_READ : (GENERIC_READ | GENERIC_WRITE), FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, readonly ? OPEN_EXISTING : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+if ((*fmap)->hFile == INVALID_HANDLE_VALUE) {
+    DWORD LastError = GetLastError();
+
+    sim_fmap_close (*fmap);
+    *fmap = NULL;
+    return sim_messagef (SCPE_OPENERR, "Can't open '%s': %s\n", name, sim_get_os_error_text (LastError));
+    }
+if (readonly) {
+    GetFileSizeEx ((*fmap)->hFile, &FileSize);
+    *size = (size_t)FileSize.QuadPart;
+    }
+else {
+    FileSize.QuadPart = (LONGLONG)*size;
+    if ((!SetFilePointerEx ((*fmap)->hFile, FileSize, NULL, FILE_BEGIN)) ||
+        (!SetEndOfFile ((*fmap)->hFile))) {
+        DWORD LastError = GetLastError();
+
+        sim_fmap_close (*fmap);
+        *fmap = NULL;
+        return sim_messagef (SCPE_OPENERR, "Can't size '%s' to %u bytes: %s\n", name, (unsigned int)*size, sim_get_os_error_text (LastError));
+        }
+    }
+(*fmap)->size = *size;
+if (*size == 0) {
+    sim_fmap_close (*fmap);
+    *fmap = NULL;
+    return sim_messagef (SCPE_OPENERR, "Can't map the empty file '%s'\n", name);
+    }
+(*fmap)->hMapping = CreateFileMappingA ((*fmap)->hFile, NULL, readonly ? PAGE_READONLY : PAGE_READWRITE, 0, 0, NULL);
+if ((*fmap)->hMapping != NULL)
+    (*fmap)->base = MapViewOfFile ((*fmap)->hMapping, readonly ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, 0);
+if ((*fmap)->base == NULL) {
+    DWORD LastError = GetLastError();
+
+    sim_fmap_close (*fmap);
+    *fmap = NULL;
+    return sim_messagef (SCPE_OPENERR, "Can't map '%s': %s\n", name, sim_get_os_error_text (LastError));
+    }
+*addr = (*fmap)->base;
+return SCPE_OK;
+}
+
+void sim_fmap_sync (SIM_FMAP *fmap, t_bool wait)
+{
+if ((fmap == NULL) || (fmap->base == NULL))
+    return;
+FlushViewOfFile (fmap->base, 0);
+if (wait)
+    FlushFileBuffers (fmap->hFile);
+}
+
+void sim_fmap_close (SIM_FMAP *fmap)
+{
+if (fmap == NULL)
+    return;
+if (fmap->base != NULL)
+    UnmapViewOfFile (fmap->base);
+if (fmap->hMapping != NULL)
+    CloseHandle (fmap->hMapping);
+if (fmap->hFile != INVALID_HANDLE_VALUE)
+    CloseHandle (fmap->hFile);
+free (fmap);
+}
+
 #else /* !defined(_WIN32) */
 #include <unistd.h>
 int sim_set_fsize (FILE *fptr, t_addr size)
@@ -687,6 +771,104 @@ return FALSE;
 }
 
 #endif /* defined (__linux__) || defined (__APPLE__) */
+
+#if defined (__linux) || defined (__linux__) || defined (__APPLE__) || defined (__FreeBSD__) || defined (__NetBSD__) || defined (__OpenBSD__) || defined (__sun) || defined (__sun__) || defined (__hpux) || defined (_AIX)
+#include <sys/mman.h>
+
+struct SIM_FMAP {
+    int fd;
+    size_t size;
+    void *base;
+    };
+
+t_stat sim_fmap_open (const char *name, size_t *size, t_bool readonly, SIM_FMAP **fmap, void **addr)
+{
+struct stat statb;
+
+*addr = NULL;
+*fmap = (SIM_FMAP *)calloc (1, sizeof(**fmap));
+if (*fmap == NULL)
+    return SCPE_MEM;
+(*fmap)->base = MAP_FAILED;
+(*fmap)->fd = open (name, readonly ? O_RDONLY : (O_RDWR | O_CREAT), 0666);
+if ((*fmap)->fd == -1) {
+    int last_errno = errno;
+
+    sim_fmap_close (*fmap);
+    *fmap = NULL;
+    return sim_messagef (SCPE_OPENERR, "Can't open '%s': %s\n", name, strerror (last_errno));
+    }
+if (readonly) {
+    if (fstat ((*fmap)->fd, &statb) == 0)
+        *size = (size_t)statb.st_size;
+    else
+        *size = 0;
+    }
+else {
+    if (ftruncate ((*fmap)->fd, (off_t)*size)) {
+        int last_errno = errno;
+
+        sim_fmap_close (*fmap);
+        *fmap = NULL;
+        return sim_messagef (SCPE_OPENERR, "Can't size '%s' to %.0f bytes: %s\n", name, (double)*size, strerror (last_errno));
+        }
+    }
+(*fmap)->size = *size;
+if (*size == 0) {
+    sim_fmap_close (*fmap);
+    *fmap = NULL;
+    return sim_messagef (SCPE_OPENERR, "Can't map the empty file '%s'\n", name);
+    }
+(*fmap)->base = mmap (NULL, *size, readonly ? PROT_READ : (PROT_READ | PROT_WRITE), MAP_SHARED, (*fmap)->fd, 0);
+if ((*fmap)->base == MAP_FAILED) {
+    int last_errno = errno;
+
+    sim_fmap_close (*fmap);
+    *fmap = NULL;
+    return sim_messagef (SCPE_OPENERR, "Can't map '%s': %s\n", name, strerror (last_errno));
+    }
+*addr = (*fmap)->base;
+return SCPE_OK;
+}
+
+void sim_fmap_sync (SIM_FMAP *fmap, t_bool wait)
+{
+if ((fmap == NULL) || (fmap->base == MAP_FAILED))
+    return;
+msync (fmap->base, fmap->size, wait ? MS_SYNC : MS_ASYNC);
+}
+
+void sim_fmap_close (SIM_FMAP *fmap)
+{
+if (fmap == NULL)
+    return;
+if (fmap->base != MAP_FAILED) {
+    msync (fmap->base, fmap->size, MS_SYNC);
+    munmap (fmap->base, fmap->size);
+    }
+if (fmap->fd != -1)
+    close (fmap->fd);
+free (fmap);
+}
+
+#else /* no mmap */
+
+t_stat sim_fmap_open (const char *name, size_t *size, t_bool readonly, SIM_FMAP **fmap, void **addr)
+{
+*fmap = NULL;
+*addr = NULL;
+return SCPE_NOFNC;
+}
+
+void sim_fmap_sync (SIM_FMAP *fmap, t_bool wait)
+{
+}
+
+void sim_fmap_close (SIM_FMAP *fmap)
+{
+}
+
+#endif /* mmap available */
 #endif /* defined (_WIN32) */
 
 #if defined(__VAX)
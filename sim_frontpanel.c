@@ -47,6 +47,7 @@ extern "C" {
 #endif
 
 #include "sim_frontpanel.h"
+#include "sim_frontpanel_shmem.h"
 
 #include <stdio.h>
 #include <stdarg.h>
@@ -84,6 +85,9 @@ return 0;
 #include <unistd.h>
 #define msleep(n) usleep(1000*n)
 #include <sys/wait.h>
+#if defined(HAVE_SHM_OPEN)
+#include <sys/mman.h>
+#endif
 #if defined (__APPLE__)
 #define HAVE_STRUCT_TIMESPEC 1   /* OSX defined the structure but doesn't tell us */
 #endif
@@ -176,7 +180,16 @@ struct PANEL {
     char                    *simulator_version;
     int                     radix;
     FILE                    *Debug;
+    unsigned int            shm_serial;     /* published register blocks requested */
+    char                    shm_name[64];   /* published register block name */
+    SIM_PANEL_SHMEM         *shm_block;     /* published register block */
+    size_t                  shm_count;      /* values the block can hold */
+    unsigned int            shm_updates;    /* last update delivered */
+    unsigned long long      *shm_values;    /* consistent copy of block values */
+    void                    *shm_base;      /* mapped segment */
+    size_t                  shm_size;
 #if defined(_WIN32)
+    HANDLE                  hShmMapping;
     HANDLE                  hProcess;
     DWORD                   dwProcessId;
 #else
@@ -215,6 +228,9 @@ static const char *register_repeat_prefix = "repeat every ";
 static const char *register_repeat_stop = "repeat stop";
 static const char *register_repeat_stop_all = "repeat stop all";
 static const char *register_repeat_units = " usecs ";
+static const char *register_publish_prefix = "publish ";
+static const char *register_publish_stop = "publish stop";
+static const char *register_publish_stop_all = "publish stop all";
 static const char *register_get_prefix = "show time";
 static const char *register_collect_prefix = "collect ";
 static const char *register_collect_mid1 = " samples every ";
@@ -634,6 +650,225 @@ free (buf);
 return 0;
 }
 
+/*
+ * Shared memory register delivery
+ *
+ * While callbacks are active, the callback thread asks the simulator to
+ * PUBLISH the non bit sampled registers into a shared memory block (see
+ * sim_frontpanel_shmem.h) every callback interval.  While the simulator
+ * runs, each callback then copies the block into the register buffers
+ * without any command exchange.  If the block can't be established, the
+ * REPEAT command output is parsed by _panel_reader as before.
+ */
+
+#if defined(_MSC_VER)
+#define _panel_barrier() MemoryBarrier ()
+#elif defined(__GNUC__)
+#define _panel_barrier() __sync_synchronize ()
+#else
+#define _panel_barrier()
+#endif
+
+static void
+_panel_shmem_close (PANEL *p)
+{
+p->shm_block = NULL;
+p->shm_count = 0;
+free (p->shm_values);
+p->shm_values = NULL;
+#if defined(_WIN32)
+if (p->shm_base)
+    UnmapViewOfFile (p->shm_base);
+if (p->hShmMapping)
+    CloseHandle (p->hShmMapping);
+p->hShmMapping = NULL;
+#elif defined(HAVE_SHM_OPEN)
+if (p->shm_base)
+    munmap (p->shm_base, p->shm_size);
+#endif
+p->shm_base = NULL;
+p->shm_size = 0;
+}
+
+static int
+_panel_shmem_open (PANEL *p, size_t value_count)
+{
+SIM_PANEL_SHMEM *blk;
+
+#if defined(_WIN32)
+SYSTEM_INFO SysInfo;
+
+GetSystemInfo (&SysInfo);
+p->hShmMapping = OpenFileMappingA (FILE_MAP_READ, FALSE, p->shm_name);
+if (p->hShmMapping == NULL)
+    return -1;
+p->shm_base = MapViewOfFile (p->hShmMapping, FILE_MAP_READ, 0, 0, 0);
+if (p->shm_base == NULL) {
+    _panel_shmem_close (p);
+    return -1;
+    }
+/* sim_shmem_open() records the size in the first page and the data follows */
+p->shm_size = *((DWORD *)p->shm_base);
+blk = (SIM_PANEL_SHMEM *)((char *)p->shm_base + SysInfo.dwPageSize);
+#elif defined(HAVE_SHM_OPEN)
+char name[sizeof (p->shm_name) + 1];
+struct stat statb;
+int fd;
+
+sprintf (name, "/%s", p->shm_name);
+fd = shm_open (name, O_RDONLY, 0);
+if (fd == -1)
+    return -1;
+shm_unlink (name);                      /* gone once both sides unmap it */
+if (fstat (fd, &statb)) {
+    close (fd);
+    return -1;
+    }
+p->shm_size = (size_t)statb.st_size;
+p->shm_base = mmap (NULL, p->shm_size, PROT_READ, MAP_SHARED, fd, 0);
+close (fd);
+if (p->shm_base == MAP_FAILED) {
+    p->shm_base = NULL;
+    return -1;
+    }
+blk = (SIM_PANEL_SHMEM *)p->shm_base;
+#else
+return -1;
+#endif
+if ((p->shm_size < SIM_PANEL_SHMEM_SIZE (value_count)) ||
+    (blk->magic != SIM_PANEL_SHMEM_MAGIC) ||
+    (blk->version != SIM_PANEL_SHMEM_VERSION) ||
+    (blk->value_count != value_count)) {
+    _panel_shmem_close (p);
+    return -1;
+    }
+p->shm_count = 1 + (p->shm_size - sizeof (*blk)) / sizeof (blk->values[0]);
+p->shm_values = (unsigned long long *)_panel_malloc (p->shm_count * sizeof (*p->shm_values));
+if (p->shm_values == NULL) {
+    _panel_shmem_close (p);
+    return -1;
+    }
+p->shm_updates = blk->updates - 1;      /* deliver the current contents */
+p->shm_block = blk;
+return 0;
+}
+
+static int
+_panel_publish_registers (PANEL *p)
+{
+size_t i, buf_data, buf_needed = 0, value_count = 0;
+char *buf, *response = NULL;
+const char *sep = "";
+int cmd_stat;
+
+_panel_shmem_close (p);
+pthread_mutex_lock (&p->io_lock);
+for (i=0; i<p->reg_count; i++)
+    buf_needed += 20 + strlen (p->regs[i].name) + (p->regs[i].device_name ? strlen (p->regs[i].device_name) : 0);
+buf = (char *)_panel_malloc (buf_needed + 1);
+if (!buf) {
+    pthread_mutex_unlock (&p->io_lock);
+    return -1;
+    }
+buf_data = 0;
+for (i=0; i<p->reg_count; i++) {
+    REG *r = &p->regs[i];
+
+    if (r->bits)                        /* bit samples come from COLLECT */
+        continue;
+    sprintf (buf + buf_data, "%s%s%s%s%s", sep, r->indirect ? "-I " : "", r->device_name ? r->device_name : "", r->device_name ? " " : "", r->name);
+    buf_data += strlen (buf + buf_data);
+    if (r->element_count > 0) {
+        sprintf (buf + buf_data, "[0:%d]", (int)(r->element_count-1));
+        buf_data += strlen (buf + buf_data);
+        }
+    value_count += (r->element_count > 0) ? r->element_count : 1;
+    sep = ",";
+    }
+sprintf (p->shm_name, "simh-panel-%d-%lx-%u", (int)getpid (), (unsigned long)(size_t)p, ++p->shm_serial);
+pthread_mutex_unlock (&p->io_lock);
+if ((value_count == 0) ||
+    _panel_sendf (p, &cmd_stat, &response, "%s%s every %d%s%s\r", register_publish_prefix, p->shm_name, 
+                                                                  p->usecs_between_callbacks, 
+                                                                  register_repeat_units, buf) ||
+    _panel_shmem_open (p, value_count)) {
+    _panel_debug (p, DBG_THR, "Shared memory register delivery unavailable: %s", NULL, 0, response ? response : "");
+    free (response);
+    free (buf);
+    return -1;
+    }
+_panel_debug (p, DBG_THR, "Registers delivered through shared memory '%s'", NULL, 0, p->shm_name);
+free (response);
+free (buf);
+return 0;
+}
+
+/* Copy a consistent snapshot of the published block into the register 
+   buffers.  Returns 1 if new data was delivered, 0 if there was none and
+   -1 if the block is unusable. */
+
+static int
+_panel_shmem_read (PANEL *p)
+{
+SIM_PANEL_SHMEM *blk = p->shm_block;
+unsigned long long simulation_time = 0;
+unsigned int updates = 0, value_count = 0, bit_count = 0;
+size_t i, j, k;
+int seq, tries;
+
+for (tries = 0; tries < 1000; tries++) {
+    seq = blk->sequence;
+    _panel_barrier ();
+    if (seq & 1)                        /* update in progress? */
+        continue;
+    updates = blk->updates;
+    if (updates == p->shm_updates)      /* nothing new? */
+        return 0;
+    value_count = blk->value_count;
+    bit_count = blk->bit_count;
+    if ((size_t)value_count + bit_count > p->shm_count)
+        return -1;
+    simulation_time = blk->simulation_time;
+    memcpy (p->shm_values, (void *)blk->values, ((size_t)value_count + bit_count) * sizeof (*p->shm_values));
+    _panel_barrier ();
+    if (seq == blk->sequence)
+        break;
+    }
+if (tries == 1000)
+    return 0;
+pthread_mutex_lock (&p->io_lock);
+p->shm_updates = updates;
+p->simulation_time = simulation_time;
+for (i=k=0; i<p->reg_count; i++) {
+    REG *r = &p->regs[i];
+    size_t elements = (r->element_count > 0) ? r->element_count : 1;
+
+    if (r->bits)
+        continue;
+    for (j=0; (j < elements) && (k < value_count); j++, k++) {
+        if (little_endian)
+            memcpy ((char *)(r->addr) + (j * r->size), &p->shm_values[k], r->size);
+        else
+            memcpy ((char *)(r->addr) + (j * r->size), ((char *)&p->shm_values[k]) + sizeof(p->shm_values[k])-r->size, r->size);
+        }
+    }
+/* each COLLECT register contributes its width and then that many totals */
+for (i=0, k=value_count; (i<p->reg_count) && (k < (size_t)value_count + bit_count); i++) {
+    REG *r = &p->regs[i];
+    size_t width;
+
+    if (!r->bits)
+        continue;
+    width = (size_t)p->shm_values[k++];
+    for (j=0; (j < width) && (k < (size_t)value_count + bit_count); j++, k++) {
+        if (j < r->bit_count)
+            r->bits[j] = (int)p->shm_values[k];
+        }
+    }
+pthread_mutex_unlock (&p->io_lock);
+return 1;
+}
+
 static PANEL **panels = NULL;
 static int panel_count = 0;
 static char *sim_panel_error_buf = NULL;
@@ -1396,6 +1631,7 @@ if (usecs_between_callbacks && (0 == panel->usecs_between_callbacks)) { /* Need
 
     _panel_debug (panel, DBG_THR, "Starting callback thread, Interval: %d usecs", NULL, 0, usecs_between_callbacks);
     panel->usecs_between_callbacks = usecs_between_callbacks;
+    panel->new_register = 1;                                        /* (re)establish register delivery */
     pthread_cond_init (&panel->startup_done, NULL);
     pthread_attr_init(&attr);
     pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
@@ -2447,6 +2683,8 @@ char *buf = NULL;
 size_t buf_data = 0;
 unsigned int callback_count = 0;
 int cmd_stat;
+int halted_usecs = 0;
+int publishing = 0, repeating = 0;
 
 /* 
    Boost Priority for timer thread so it doesn't compete 
@@ -2476,13 +2714,44 @@ while ((p->sock != INVALID_SOCKET) &&
     if (new_register)           /* need to get and send updated register info */
         _panel_register_query_string (p, &buf, &buf_data);
 
-    /* twice a second activities:                                               */
-    /*  1) update the query string if it has changed                            */
-    /*     (only really happens at startup)                                     */
-    /*  2) update register state by polling if the simulator is halted          */
-    msleep (500);
-    pthread_mutex_lock (&p->io_lock);
+    if (publishing && (!new_register)) {
+        /* registers published in shared memory are delivered every interval */
+        /* while the simulator runs, the halted state is polled as below     */
+        int msecs = (interval + 999) / 1000;
+
+        msleep (msecs);
+        pthread_mutex_lock (&p->io_lock);
+        if (p->State == Run) {
+            halted_usecs = 0;
+            pthread_mutex_unlock (&p->io_lock);
+            if ((_panel_shmem_read (p) > 0) && (p->callback))
+                p->callback (p, p->simulation_time_base + p->simulation_time, p->callback_context);
+            pthread_mutex_lock (&p->io_lock);
+            continue;
+            }
+        halted_usecs += interval;
+        if (halted_usecs < 500000)
+            continue;
+        halted_usecs = 0;
+        }
+    else {
+        /* twice a second activities:                                           */
+        /*  1) update the query string if it has changed                        */
+        /*     (only really happens at startup)                                 */
+        /*  2) update register state by polling if the simulator is halted      */
+        msleep (500);
+        pthread_mutex_lock (&p->io_lock);
+        }
     if (new_register) {
+        pthread_mutex_unlock (&p->io_lock);
+        publishing = (0 == _panel_publish_registers (p));
+        if (publishing && repeating) {  /* REPEAT output was delivering registers */
+            _panel_sendf (p, &cmd_stat, NULL, "%s", register_repeat_stop);
+            repeating = 0;
+            }
+        pthread_mutex_lock (&p->io_lock);
+        }
+    if (new_register && (!publishing)) {    /* fall back to REPEAT command output */
         size_t repeat_data = strlen (register_repeat_prefix) +  /* prefix */
                              20                              +  /* max int width */
                              strlen (register_repeat_units)  +  /* units and spacing */
@@ -2517,6 +2786,7 @@ while ((p->sock != INVALID_SOCKET) &&
             }
         pthread_mutex_lock (&p->io_lock);
         free (repeat);
+        repeating = 1;
         }
     /* when halted, we directly poll the halted system to get updated */
     /* register state which may have changed due to panel activities */
@@ -2536,11 +2806,14 @@ pthread_mutex_unlock (&p->io_lock);
 if (p->parent == NULL) {        /* Top level panel? */
     _panel_debug (p, DBG_THR, "Stopping All Repeats before exiting", NULL, 0);
     _panel_sendf (p, &cmd_stat, NULL, "%s", register_repeat_stop_all);
+    _panel_sendf (p, &cmd_stat, NULL, "%s", register_publish_stop_all);
     }
 else {
     _panel_debug (p, DBG_THR, "Stopping Repeats before exiting", NULL, 0);
     _panel_sendf (p, &cmd_stat, NULL, "%s", register_repeat_stop);
+    _panel_sendf (p, &cmd_stat, NULL, "%s", register_publish_stop);
     }
+_panel_shmem_close (p);
 pthread_mutex_lock (&p->io_lock);
 _panel_debug (p, DBG_THR, "Exiting", NULL, 0);
 pthread_setspecific (panel_thread_id, NULL);
@@ -56,7 +56,7 @@ extern "C" {
 
 #if !defined(__VAX)         /* Unsupported platform */
 
-#define SIM_FRONTPANEL_VERSION   12
+#define SIM_FRONTPANEL_VERSION   13
 
 /**
 
@@ -210,6 +210,13 @@ sim_panel_add_register_indirect_bits (PANEL *panel,
            or frontpanel interactions with the simulator may be disrupted.  
            Setting a flag, signaling an event or posting a message are 
            reasonable activities to perform in a callback routine.
+   Note 3: While the simulator is running, callback register data is 
+           delivered through a shared memory block which the simulator 
+           refreshes at the callback interval, so no commands are 
+           exchanged with the simulator to gather it.  If the shared 
+           memory block can't be established (the platform lacks shared 
+           memory or the simulator is on another host) the register data 
+           is gathered with commands on the remote console connection.
  */
 
 int
@@ -0,0 +1,67 @@
+/* sim_frontpanel_shmem.h: front panel shared memory register block
+
+   Copyright (c) 2026, The SIMH authors
+
+   Permission is hereby granted, free of charge, to any person obtaining a
+   copy of this software and associated documentation files (the "Software"),
+   to deal in the Software without restriction, including without limitation
+   the rights to use, copy, modify, merge, publish, distribute, sublicense,
+   and/or sell copies of the Software, and to permit persons to whom the
+   Software is furnished to do so, subject to the following conditions:
+
+   The above copyright notice and this permission notice shall be included in
+   all copies or substantial portions of the Software.
+
+   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+   THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+   This module defines the shared memory block through which a simulator's
+   remote console publishes register values to the front panel API
+   (sim_frontpanel.c).  It is included by both and so depends only on the
+   C library.  The block is internal to the two; panel applications use
+   the sim_panel_ APIs described in sim_frontpanel.h.
+
+   The remote console command:
+
+        PUBLISH name EVERY nnn USECS reg{,reg...}
+        PUBLISH STOP {ALL}
+
+   creates the shared memory segment 'name' and refreshes it every nnn
+   usecs while the simulator runs.  Registers are specified as they are
+   for the COLLECT command, and an array register may be given an element
+   range (REG[lo:hi]).  values[] has one value for each register (the
+   memory value for an indirect register) or array element, in the order
+   specified.  Those are followed, for each register COLLECT is sampling on
+   the same connection, by its bit width and then that many bit sample
+   totals.  bit_count counts these and is zero if the COLLECT register set
+   grew after the PUBLISH command.
+
+   sequence is odd while the simulator updates the block.  A reader copies
+   the block and uses the copy if sequence was even and unchanged across
+   the copy.
+*/
+
+#ifndef SIM_FRONTPANEL_SHMEM_H_
+#define SIM_FRONTPANEL_SHMEM_H_     0
+
+#define SIM_PANEL_SHMEM_MAGIC   0x53504D42              /* "SPMB" */
+#define SIM_PANEL_SHMEM_VERSION 1
+
+typedef struct SIM_PANEL_SHMEM {
+    unsigned int        magic;                          /* SIM_PANEL_SHMEM_MAGIC */
+    unsigned int        version;                        /* SIM_PANEL_SHMEM_VERSION */
+    volatile int        sequence;                       /* odd while updating */
+    unsigned int        value_count;                    /* register values */
+    unsigned int        bit_count;                      /* bit widths and sample totals */
+    unsigned int        updates;                        /* updates published */
+    unsigned long long  simulation_time;
+    unsigned long long  values[1];                      /* value_count + bit_count */
+    } SIM_PANEL_SHMEM;
+
+#define SIM_PANEL_SHMEM_SIZE(count) (sizeof (SIM_PANEL_SHMEM) + (((count) ? (count) : 1) - 1) * sizeof (unsigned long long))
+
+#endif /* SIM_FRONTPANEL_SHMEM_H_ */
@@ -79,6 +79,7 @@ extern "C" {
    sim_accept_conn      accept connection
    sim_read_sock        read from socket
    sim_write_sock       write from socket
+   sim_writev_sock      write two buffers to socket in one operation
    sim_close_sock       close socket
    sim_setnonblock      set socket non-blocking
 */
@@ -120,6 +121,11 @@ int sim_write_sock (SOCKET sock, char *msg, int nbytes)
 return 0;
 }
 
+int sim_writev_sock (SOCKET sock, const char *msg, int nbytes, const char *msg2, int nbytes2)
+{
+return 0;
+}
+
 void sim_close_sock (SOCKET sock)
 {
 return;
@@ -1257,6 +1263,60 @@ if (sbytes == SOCKET_ERROR) {
 return sbytes;
 }
 
+/* Write the contents of two buffers (typically the two pieces of a wrapped
+   circular buffer) with a single gather operation where available.  The
+   return value is as for sim_write_sock. */
+
+int sim_writev_sock (SOCKET sock, const char *msg, int nbytes, const char *msg2, int nbytes2)
+{
+int err, sbytes;
+#if defined(_WIN32)
+WSABUF bufs[2];
+DWORD sent;
+
+bufs[0].buf = (char *)msg;
+bufs[0].len = (ULONG)nbytes;
+bufs[1].buf = (char *)msg2;
+bufs[1].len = (ULONG)nbytes2;
+if (WSASend (sock, bufs, (nbytes2 > 0) ? 2 : 1, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+    sbytes = SOCKET_ERROR;
+else
+    sbytes = (int)sent;
+#elif !defined(VMS)
+struct iovec iov[2];
+struct msghdr msgh;
+
+iov[0].iov_base = (void *)msg;
+iov[0].iov_len = (size_t)nbytes;
+iov[1].iov_base = (void *)msg2;
+iov[1].iov_len = (size_t)nbytes2;
+memset (&msgh, 0, sizeof (msgh));
+msgh.msg_iov = iov;
+msgh.msg_iovlen = (nbytes2 > 0) ? 2 : 1;
+sbytes = (int)sendmsg (sock, &msgh, 0);
+#else
+sbytes = sim_write_sock (sock, msg, nbytes);
+if ((sbytes == nbytes) && (nbytes2 > 0)) {
+    int sbytes2 = sim_write_sock (sock, msg2, nbytes2);
+
+    if (sbytes2 > 0)
+        sbytes += sbytes2;
+    }
+return sbytes;
+#endif
+
+if (sbytes == SOCKET_ERROR) {
+    err = WSAGetLastError ();
+    if (err == WSAEWOULDBLOCK)                          /* no data */
+        return 0;
+#if defined(EAGAIN)
+    if (err == EAGAIN)                                  /* no data */
+        return 0;
+#endif
+    }
+return sbytes;
+}
+
 void sim_close_sock (SOCKET sock)
 {
 shutdown(sock, SD_BOTH);
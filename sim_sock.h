@@ -126,6 +126,7 @@ SOCKET sim_accept_conn_ex (SOCKET master, char **connectaddr, int opt_flags);
 int sim_check_conn (SOCKET sock, int rd);
 int sim_read_sock (SOCKET sock, char *buf, int nbytes);
 int sim_write_sock (SOCKET sock, const char *msg, int nbytes);
+int sim_writev_sock (SOCKET sock, const char *msg, int nbytes, const char *msg2, int nbytes2);
 void sim_close_sock (SOCKET sock);
 const char *sim_get_err_sock (const char *emsg);
 SOCKET sim_err_sock (SOCKET sock, const char *emsg);
@@ -136,11 +136,68 @@ static t_addr sim_tape_tpc_fnd (UNIT *uptr, t_addr *map);
 static void sim_tape_data_trace (UNIT *uptr, const uint8 *data, size_t len, const char* txt, int detail, uint32 reason);
 static t_stat tape_erase_fwd (UNIT *uptr, t_mtrlnt gap_size);
 static t_stat tape_erase_rev (UNIT *uptr, t_mtrlnt gap_size);
+static t_bool sim_tape_index_fmt (UNIT *uptr);
+static void sim_tape_index_note (UNIT *uptr, t_addr pos, t_mtrlnt bc, t_stat status);
+static void sim_tape_index_truncate (UNIT *uptr, t_addr pos);
+static t_bool sim_tape_index_load (UNIT *uptr);
+static void sim_tape_index_save (UNIT *uptr);
+
+/* Record index
+
+   The record index remembers the extent of every tape object (data record
+   or tape mark) which has been read forward in a SIMH, E11 or AWS format
+   tape image.  Entries are kept ordered by position and only describe
+   objects which are contiguous with no intervening erase gaps, so spacing
+   over a known object doesn't need to touch the container file.  The
+   attach time validation pass normally populates the complete index.
+   Any write invalidates the entries at and beyond the write position.
+*/
+
+#define TIX_F_TMK       0x00000001              /* object is a tape mark */
+#define TIX_F_INMRK     0x00000002              /* AWS: positioned within a tape mark after object */
+
+struct tape_index_entry {
+    t_addr              pos;                    /* object starting position */
+    t_addr              end;                    /* position following object */
+    t_mtrlnt            bc;                     /* record length (as read) */
+    uint32              flags;                  /* TIX_F_* flags */
+    };
+
+#if defined SIM_ASYNCH_IO
+/* Read-ahead
+
+   Once the I/O thread has serviced TAPE_RA_DETECT consecutive forward
+   record reads, each starting where the previous one ended, it keeps
+   reading up to TAPE_RA_RECORDS records beyond the current position into
+   a ring while it is otherwise idle.  Forward record reads which start at
+   the oldest prefetched record are then satisfied from memory.  The ring
+   is discarded by any write or erase, a rewind, and by a read at any
+   other position.
+*/
+
+#define TAPE_RA_DETECT  2                       /* sequential reads before reading ahead */
+#define TAPE_RA_RECORDS 16                      /* records held in the read-ahead ring */
+#define TAPE_RA_MAXREC  65536                   /* largest record read ahead */
+
+struct tape_readahead {
+    t_addr              pos;                    /* record starting position */
+    t_addr              end;                    /* position following record */
+    t_stat              status;                 /* read status */
+    t_mtrlnt            bc;                     /* record length */
+    t_bool              inmrk;                  /* AWS/TAR: within a tape mark after record */
+    uint8               *buf;                   /* record data (TAPE_RA_MAXREC bytes) */
+    };
+#endif
 
 struct tape_context {
     DEVICE              *dptr;              /* Device for unit (access to debug flags) */
     uint32              dbit;               /* debugging bit for trace */
     uint32              auto_format;        /* Format determined dynamically */
+    struct tape_index_entry *index;         /* Known objects ordered by position */
+    uint32              index_count;        /* Number of index entries */
+    uint32              index_alloc;        /* Allocated index entries */
+    uint32              index_cursor;       /* Most recently referenced entry */
+    char                *index_file;        /* Index sidecar file (ATTACH -I) */
 #if defined SIM_ASYNCH_IO
     int                 asynch_io;          /* Asynchronous Interrupt scheduling enabled */
     int                 asynch_io_latency;  /* instructions to delay pending interrupt */
@@ -161,6 +218,15 @@ struct tape_context {
     uint32              *objupdate;
     TAPE_PCALLBACK      callback;
     t_stat              io_status;
+    pthread_mutex_t     ra_lock;            /* read-ahead ring lock */
+    struct tape_readahead *ra_ring;         /* read-ahead ring */
+    uint32              ra_head;            /* oldest prefetched record */
+    uint32              ra_count;           /* number of prefetched records */
+    uint32              ra_gen;             /* bumped whenever the ring is discarded */
+    uint32              ra_seq;             /* consecutive sequential forward reads */
+    t_addr              ra_next;            /* position following the last forward read */
+    FILE                *ra_file;           /* separate handle for reading ahead */
+    t_bool              ra_shadow;          /* context of a read-ahead pass */
 #endif
     };
 #define tape_ctx up8                        /* Field in Unit structure which points to the tape_context */
@@ -220,6 +286,184 @@ if ((!callback) || !ctx->asynch_io)
 #define TOP_RWND 16             /* sim_tape_rewind_a */
 #define TOP_POSN 17             /* sim_tape_position_a */
 
+/* Read-ahead ring maintenance */
+
+static void _tape_ra_flush (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if ((ctx == NULL) || !ctx->asynch_io || (ctx->ra_ring == NULL))
+    return;
+pthread_mutex_lock (&ctx->ra_lock);
+ctx->ra_count = 0;
+ctx->ra_seq = 0;
+++ctx->ra_gen;
+pthread_mutex_unlock (&ctx->ra_lock);
+}
+
+static void _tape_ra_free (struct tape_context *ctx)
+{
+uint32 i;
+
+if (ctx->ra_ring) {
+    for (i = 0; i < TAPE_RA_RECORDS; i++)
+        free (ctx->ra_ring[i].buf);
+    free (ctx->ra_ring);
+    ctx->ra_ring = NULL;
+    }
+if (ctx->ra_file) {
+    fclose (ctx->ra_file);
+    ctx->ra_file = NULL;
+    }
+ctx->ra_head = ctx->ra_count = ctx->ra_seq = 0;
+ctx->ra_next = 0;
+}
+
+/* Satisfy a forward record read from the ring if the oldest prefetched
+   record starts at the current position */
+
+static t_bool _tape_ra_read (UNIT *uptr, uint8 *buf, t_mtrlnt *bc, t_mtrlnt max, t_stat *status)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+struct tape_readahead *ra;
+t_addr pos = uptr->pos;
+t_bool hit = FALSE;
+
+if (!ctx->asynch_io || (ctx->ra_ring == NULL))
+    return FALSE;
+pthread_mutex_lock (&ctx->ra_lock);
+if (ctx->ra_count > 0) {
+    ra = &ctx->ra_ring[ctx->ra_head];
+    if ((ra->pos == pos) && (ra->bc <= max)) {
+        memcpy (buf, ra->buf, ra->bc);
+        *bc = ra->bc;
+        *status = ra->status;
+        uptr->pos = ra->end;
+        MT_CLR_PNU (uptr);
+        if (ra->inmrk)
+            MT_SET_INMRK (uptr);
+        else
+            MT_CLR_INMRK (uptr);
+        ctx->ra_head = (ctx->ra_head + 1) % TAPE_RA_RECORDS;
+        --ctx->ra_count;
+        hit = TRUE;
+        }
+    else {                                              /* tape was repositioned */
+        ctx->ra_count = 0;
+        ++ctx->ra_gen;
+        }
+    }
+pthread_mutex_unlock (&ctx->ra_lock);
+if (hit) {
+    sim_debug_unit (MTSE_DBG_STR, uptr, "rd_ahead: st: %d, lnt: %d, pos: %" T_ADDR_FMT "u\n", *status, *bc, uptr->pos);
+    if ((*status == MTSE_OK) || (*status == MTSE_TMK) || (*status == MTSE_RECE))
+        sim_tape_index_note (uptr, pos, *bc, *status);  /* the shadow unit didn't */
+    }
+return hit;
+}
+
+/* Track forward reads serviced by the I/O thread and report streaming */
+
+static t_bool _tape_ra_sequential (UNIT *uptr, t_addr opos, t_stat status)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if ((status != MTSE_OK) && (status != MTSE_RECE) && (status != MTSE_TMK)) {
+    ctx->ra_seq = 0;
+    return FALSE;
+    }
+ctx->ra_seq = (opos == ctx->ra_next) ? ctx->ra_seq + 1 : 1;
+ctx->ra_next = uptr->pos;
+return (ctx->ra_seq >= TAPE_RA_DETECT) && (MT_GET_FMT (uptr) < MTUF_F_ANSI);
+}
+
+/* Read ahead on the I/O thread until the ring is full, a new request
+   arrives, a tape mark or anything other than a record is read, or the
+   ring is discarded.
+
+   The records are read with a copy of the unit which uses a separate
+   file handle, so the unit's position and its file handle are never
+   disturbed by reading ahead.  The unit's stdio buffer is flushed first
+   so that handle sees everything written through the unit.
+*/
+
+static void _tape_ra_fill (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+struct tape_context sctx;
+struct tape_readahead *ra;
+UNIT shadow;
+uint32 gen, slot;
+uint8 *buf;
+t_mtrlnt bc;
+t_addr pos;
+t_stat st;
+t_bool done = FALSE;
+
+if (ctx->ra_ring == NULL) {
+    ctx->ra_ring = (struct tape_readahead *)calloc (TAPE_RA_RECORDS, sizeof (*ctx->ra_ring));
+    if (ctx->ra_ring == NULL)
+        return;
+    }
+if (ctx->ra_file == NULL) {
+    ctx->ra_file = sim_fopen (uptr->filename, "rb");
+    if (ctx->ra_file == NULL)
+        return;
+    }
+(void)fflush (uptr->fileref);                           /* let the read ahead handle see written records */
+shadow = *uptr;
+memset (&sctx, 0, sizeof (sctx));
+sctx.dptr = ctx->dptr;
+sctx.ra_shadow = TRUE;
+shadow.tape_ctx = &sctx;
+shadow.fileref = ctx->ra_file;
+shadow.dctrl = 0;
+pthread_mutex_lock (&ctx->ra_lock);
+gen = ctx->ra_gen;
+if (ctx->ra_count > 0) {                                /* continue after the newest record */
+    ra = &ctx->ra_ring[(ctx->ra_head + ctx->ra_count - 1) % TAPE_RA_RECORDS];
+    shadow.pos = ra->end;
+    if (ra->inmrk)
+        MT_SET_INMRK (&shadow);
+    else
+        MT_CLR_INMRK (&shadow);
+    }
+pthread_mutex_unlock (&ctx->ra_lock);
+while (!done && (ctx->io_top == TOP_DONE) && ctx->asynch_io) {
+    pthread_mutex_lock (&ctx->ra_lock);
+    slot = (ctx->ra_head + ctx->ra_count) % TAPE_RA_RECORDS;
+    if ((ctx->ra_gen != gen) || (ctx->ra_count == TAPE_RA_RECORDS))
+        done = TRUE;
+    else {
+        if (ctx->ra_ring[slot].buf == NULL)
+            ctx->ra_ring[slot].buf = (uint8 *)malloc (TAPE_RA_MAXREC);
+        buf = ctx->ra_ring[slot].buf;
+        done = (buf == NULL);
+        }
+    pthread_mutex_unlock (&ctx->ra_lock);
+    if (done)
+        break;
+    pos = shadow.pos;
+    st = sim_tape_rdrecf (&shadow, buf, &bc, TAPE_RA_MAXREC);
+    if ((st != MTSE_OK) && (st != MTSE_RECE) && (st != MTSE_TMK))
+        break;
+    pthread_mutex_lock (&ctx->ra_lock);
+    if ((ctx->ra_gen != gen) || (slot != (ctx->ra_head + ctx->ra_count) % TAPE_RA_RECORDS))
+        done = TRUE;                                    /* discarded while reading */
+    else {
+        ra = &ctx->ra_ring[slot];
+        ra->pos = pos;
+        ra->end = shadow.pos;
+        ra->status = st;
+        ra->bc = bc;
+        ra->inmrk = MT_TST_INMRK (&shadow) ? TRUE : FALSE;
+        ++ctx->ra_count;
+        done = (st == MTSE_TMK);
+        }
+    pthread_mutex_unlock (&ctx->ra_lock);
+    }
+}
+
 static void *
 _tape_io(void *arg)
 {
@@ -236,13 +480,22 @@ struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
     pthread_mutex_lock (&ctx->io_lock);
     pthread_cond_signal (&ctx->startup_cond);   /* Signal we're ready to go */
     while (1) {
-        pthread_cond_wait (&ctx->io_cond, &ctx->io_lock);
-        if (ctx->io_top == TOP_DONE)
-            break;
+        t_bool readahead = FALSE;
+        t_addr opos;
+
+        if (ctx->io_top == TOP_DONE) {          /* nothing arrived while reading ahead? */
+            if (!ctx->asynch_io)                /* shut down while reading ahead? */
+                break;
+            pthread_cond_wait (&ctx->io_cond, &ctx->io_lock);
+            if (ctx->io_top == TOP_DONE)
+                break;
+            }
         pthread_mutex_unlock (&ctx->io_lock);
         switch (ctx->io_top) {
             case TOP_RDRF:
+                opos = uptr->pos;
                 ctx->io_status = sim_tape_rdrecf (uptr, ctx->buf, ctx->bc, ctx->max);
+                readahead = _tape_ra_sequential (uptr, opos, ctx->io_status);
                 break;
             case TOP_RDRR:
                 ctx->io_status = sim_tape_rdrecr (uptr, ctx->buf, ctx->bc, ctx->max);
@@ -297,6 +550,11 @@ struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
         ctx->io_top = TOP_DONE;
         pthread_cond_signal (&ctx->io_done);
         sim_activate (uptr, ctx->asynch_io_latency);
+        if (readahead) {                        /* streaming? */
+            pthread_mutex_unlock (&ctx->io_lock);
+            _tape_ra_fill (uptr);               /*   read ahead until the next request */
+            pthread_mutex_lock (&ctx->io_lock);
+            }
     }
     pthread_mutex_unlock (&ctx->io_lock);
 
@@ -372,6 +630,8 @@ return FALSE;
 #define AIO_CALL(op, _buf, _fc, _bc, _max, _vbc, _gaplen, _bpi, _obj, _callback) \
     if (_callback)                                                    \
         (_callback) (uptr, r);
+#define _tape_ra_flush(uptr)
+#define _tape_ra_read(uptr, buf, bc, max, status) FALSE
 #endif
 
 typedef struct VOL1 {
@@ -531,6 +791,7 @@ ctx->asynch_io = sim_asynch_enabled;
 ctx->asynch_io_latency = latency;
 if (ctx->asynch_io) {
     pthread_mutex_init (&ctx->io_lock, NULL);
+    pthread_mutex_init (&ctx->ra_lock, NULL);
     pthread_cond_init (&ctx->io_cond, NULL);
     pthread_cond_init (&ctx->io_done, NULL);
     pthread_cond_init (&ctx->startup_cond, NULL);
@@ -568,6 +829,8 @@ if (ctx->asynch_io) {
     pthread_cond_signal (&ctx->io_cond);
     pthread_mutex_unlock (&ctx->io_lock);
     pthread_join (ctx->io_thread, NULL);
+    _tape_ra_free (ctx);
+    pthread_mutex_destroy (&ctx->ra_lock);
     pthread_mutex_destroy (&ctx->io_lock);
     pthread_cond_destroy (&ctx->io_cond);
     pthread_cond_destroy (&ctx->io_done);
@@ -723,9 +986,18 @@ switch (MT_GET_FMT (uptr)) {                            /* case on format */
         break;
         }
 
+if ((r == SCPE_OK) && (sim_switches & SWMASK ('I')) && sim_tape_index_fmt (uptr)) {
+    ctx->index_file = (char *)malloc (strlen (uptr->filename) + 5);
+    if (ctx->index_file != NULL)
+        sprintf (ctx->index_file, "%s.idx", uptr->filename);
+    }
+
 if (r == SCPE_OK) {
 
-    sim_tape_validate_tape (uptr);
+    if ((ctx->index_file == NULL) ||                    /* no index sidecar, */
+        (sim_switches & (SWMASK ('V') | SWMASK ('L'))) || /* scan summary wanted */
+        !sim_tape_index_load (uptr))                    /* or sidecar not usable? */
+        sim_tape_validate_tape (uptr);                  /*   then scan the whole tape */
 
     sim_tape_rewind (uptr);
 
@@ -766,6 +1038,9 @@ if (ctx)
 
 sim_tape_clr_async (uptr);
 
+if (ctx && ctx->index_file)
+    sim_tape_index_save (uptr);                         /* record index in sidecar */
+
 MT_CLR_INMRK (uptr);                                    /* Not within an AWS or TAR tapemark */
 if (MT_GET_FMT (uptr) == MTUF_F_ANSI) {
     r = ansi_free_tape ((void *)uptr->fileref);
@@ -792,6 +1067,10 @@ uptr->recsize = 0;
 uptr->tape_eom = 0;
 
 sim_tape_rewind (uptr);
+if (ctx) {
+    free (ctx->index);
+    free (ctx->index_file);
+    }
 free (uptr->tape_ctx);
 uptr->tape_ctx = NULL;
 uptr->io_flush = NULL;
@@ -833,7 +1112,11 @@ fprintf (st, "    -L          Display detailed record size counts observed durin
 fprintf (st, "                validation pass\n");
 fprintf (st, "                contained in the tape image scan performed when it is attached.\n");
 fprintf (st, "    -D          Causes the internal tape structure information to be displayed\n");
-fprintf (st, "                while the tape image is scanned.\n\n");
+fprintf (st, "                while the tape image is scanned.\n");
+fprintf (st, "    -I          For SIMH, E11 and AWS format tapes, keep the record index in\n");
+fprintf (st, "                a file named tapefile.idx when the tape is detached.  A\n");
+fprintf (st, "                subsequent ATTACH -I of the unchanged tape image uses it\n");
+fprintf (st, "                instead of scanning the whole tape image.\n\n");
 fprintf (st, "Notes:  ANSI-VMS, ANSI-RT11, ANSI-RSTS, ANSI-RSX11 formats allows one or several\n");
 fprintf (st, "        files to be presented to as a read only ANSI Level 3 labeled tape with\n");
 fprintf (st, "        file labels that make each individual file accessible directly as files\n");
@@ -870,6 +1153,329 @@ if (MT_GET_FMT (uptr) < MTUF_F_ANSI)
 return uptr->tape_eom;
 }
 
+/* Record index maintenance (internal routines) */
+
+static t_bool sim_tape_index_fmt (UNIT *uptr)
+{
+switch (MT_GET_FMT (uptr)) {
+    case MTUF_F_STD:
+    case MTUF_F_E11:
+    case MTUF_F_AWS:
+        return TRUE;
+    default:
+        return FALSE;
+    }
+}
+
+/* Locate the entry starting at pos, or return -1 */
+
+static int32 sim_tape_index_find (struct tape_context *ctx, t_addr pos)
+{
+int32 lo = 0, hi = (int32)ctx->index_count - 1, mid;
+
+if (ctx->index_count == 0)
+    return -1;
+if (ctx->index_cursor < ctx->index_count) {             /* try the neighborhood of the last reference */
+    if (ctx->index[ctx->index_cursor].pos == pos)
+        return (int32)ctx->index_cursor;
+    if ((ctx->index_cursor + 1 < ctx->index_count) &&
+        (ctx->index[ctx->index_cursor + 1].pos == pos))
+        return (int32)ctx->index_cursor + 1;
+    }
+while (lo <= hi) {
+    mid = lo + (hi - lo) / 2;
+    if (ctx->index[mid].pos == pos)
+        return mid;
+    if (ctx->index[mid].pos < pos)
+        lo = mid + 1;
+    else
+        hi = mid - 1;
+    }
+return -1;
+}
+
+/* Locate the entry ending at pos, or return -1 */
+
+static int32 sim_tape_index_find_end (struct tape_context *ctx, t_addr pos)
+{
+int32 lo = 0, hi = (int32)ctx->index_count - 1, mid;
+
+if (ctx->index_count == 0)
+    return -1;
+if (ctx->index_cursor < ctx->index_count) {             /* try the neighborhood of the last reference */
+    if (ctx->index[ctx->index_cursor].end == pos)
+        return (int32)ctx->index_cursor;
+    if ((ctx->index_cursor > 0) &&
+        (ctx->index[ctx->index_cursor - 1].end == pos))
+        return (int32)ctx->index_cursor - 1;
+    }
+while (lo <= hi) {
+    mid = lo + (hi - lo) / 2;
+    if (ctx->index[mid].end == pos)
+        return mid;
+    if (ctx->index[mid].end < pos)
+        lo = mid + 1;
+    else
+        hi = mid - 1;
+    }
+return -1;
+}
+
+/* Record an object which was just read forward from pos to uptr->pos */
+
+static void sim_tape_index_note (UNIT *uptr, t_addr pos, t_mtrlnt bc, t_stat status)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+t_addr size;
+uint32 flags = (status == MTSE_TMK) ? TIX_F_TMK : 0;
+uint32 i;
+
+if ((ctx == NULL) || !sim_tape_index_fmt (uptr))
+    return;
+#if defined SIM_ASYNCH_IO
+if (ctx->ra_shadow)                                     /* reading ahead? */
+    return;                                             /*   the unit's index isn't ours to change */
+#endif
+switch (MT_GET_FMT (uptr)) {
+    case MTUF_F_STD:
+        size = (status == MTSE_TMK) ? sizeof (t_mtrlnt) : (2 * sizeof (t_mtrlnt)) + ((MTR_L (bc) + 1) & ~1);
+        break;
+    case MTUF_F_E11:
+        size = (status == MTSE_TMK) ? sizeof (t_mtrlnt) : (2 * sizeof (t_mtrlnt)) + MTR_L (bc);
+        break;
+    default:                                            /* AWS */
+        size = sizeof (t_awshdr) + bc;
+        if (MT_TST_INMRK (uptr))
+            flags |= TIX_F_INMRK;
+        break;
+    }
+if (uptr->pos != pos + size)                            /* skipped gaps or other oddities? */
+    return;                                             /*   then don't remember this object */
+if (sim_tape_index_find (ctx, pos) >= 0)                /* already known? */
+    return;
+for (i = ctx->index_count; (i > 0) && (ctx->index[i - 1].pos > pos); --i)
+    ;                                                   /* find insertion point (normally the end) */
+if (((i > 0) && (ctx->index[i - 1].end > pos)) ||       /* overlaps a known object? */
+    ((i < ctx->index_count) && (ctx->index[i].pos < uptr->pos)))
+    return;
+if (ctx->index_count == ctx->index_alloc) {
+    uint32 alloc = (ctx->index_alloc == 0) ? 1024 : 2 * ctx->index_alloc;
+    struct tape_index_entry *index = (struct tape_index_entry *)realloc (ctx->index, alloc * sizeof (*index));
+
+    if (index == NULL)
+        return;
+    ctx->index = index;
+    ctx->index_alloc = alloc;
+    }
+if (i < ctx->index_count)
+    memmove (&ctx->index[i + 1], &ctx->index[i], (ctx->index_count - i) * sizeof (*ctx->index));
+ctx->index[i].pos = pos;
+ctx->index[i].end = uptr->pos;
+ctx->index[i].bc = bc;
+ctx->index[i].flags = flags;
+++ctx->index_count;
+ctx->index_cursor = i;
+}
+
+/* Discard everything which a write at pos could have changed */
+
+static void sim_tape_index_truncate (UNIT *uptr, t_addr pos)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+
+if (ctx == NULL)
+    return;
+while ((ctx->index_count > 0) && (ctx->index[ctx->index_count - 1].end >= pos))
+    --ctx->index_count;
+if (ctx->index_cursor >= ctx->index_count)
+    ctx->index_cursor = 0;
+}
+
+/* Space one object forward or reverse using the index.
+
+   Returns TRUE with the unit positioned past the object and the status and
+   record length which reading the object's metadata would have produced, or
+   FALSE with nothing changed if the object at the current position isn't known.
+   Reverse spacing of AWS tapes depends on the tape mark state, so it is
+   always done by reading the container.
+*/
+
+static t_bool sim_tape_index_space (UNIT *uptr, t_bool reverse, t_mtrlnt *bc, t_stat *status)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+struct tape_index_entry *e;
+int32 i;
+
+if ((ctx == NULL) || (ctx->index_count == 0) ||
+    ((uptr->flags & UNIT_ATT) == 0) || !sim_tape_index_fmt (uptr))
+    return FALSE;
+if (reverse) {
+    if (MT_GET_FMT (uptr) == MTUF_F_AWS)
+        return FALSE;
+    i = sim_tape_index_find_end (ctx, uptr->pos);
+    }
+else {
+    if ((uptr->tape_eom) && (uptr->pos >= uptr->tape_eom))
+        return FALSE;
+    i = sim_tape_index_find (ctx, uptr->pos);
+    }
+if (i < 0)
+    return FALSE;
+e = &ctx->index[i];
+ctx->index_cursor = (uint32)i;
+MT_CLR_PNU (uptr);
+if (reverse)
+    uptr->pos = e->pos;
+else {
+    uptr->pos = e->end;
+    if (MT_GET_FMT (uptr) == MTUF_F_AWS) {
+        if (e->flags & TIX_F_INMRK)
+            MT_SET_INMRK (uptr);
+        else
+            MT_CLR_INMRK (uptr);
+        }
+    }
+*bc = e->bc;
+*status = (e->flags & TIX_F_TMK) ? MTSE_TMK : MTSE_OK;
+sim_debug_unit (MTSE_DBG_STR, uptr, "rd_lnt%s: indexed st: %d, lnt: %d, pos: %" T_ADDR_FMT "u\n", reverse ? "r" : "f", *status, *bc, uptr->pos);
+return TRUE;
+}
+
+/* Index sidecar files
+
+   With ATTACH -I the index is kept in a file alongside the tape image
+   (the tape image name with ".idx" appended).  When the sidecar matches
+   the image's format, size and modification time and describes the whole
+   tape up to its end of medium, the attach time validation scan is skipped.
+*/
+
+#define TIX_MAGIC       "SIMHTIX1"
+
+/* The sidecar holds little endian fixed width fields, written and read
+   with sim_fwrite and sim_fread:
+
+       header   magic[8], uint32 format, count,
+                t_uint64 size (tape image size), mtime (tape image
+                modification time), eom (end of medium position)
+       record   t_uint64 pos, end, uint32 bc, flags (count of them)
+*/
+
+#define TIX_HDR_FORMAT  0                       /* header uint32 fields */
+#define TIX_HDR_COUNT   1
+#define TIX_HDR_SIZE    0                       /* header t_uint64 fields */
+#define TIX_HDR_MTIME   1
+#define TIX_HDR_EOM     2
+#define TIX_REC_POS     0                       /* record t_uint64 fields */
+#define TIX_REC_END     1
+#define TIX_REC_BC      0                       /* record uint32 fields */
+#define TIX_REC_FLAGS   1
+#define TIX_HDR_BYTES   (8 + 2*4 + 3*8)         /* header size in the file */
+#define TIX_REC_BYTES   (2*8 + 2*4)             /* record size in the file */
+
+static t_bool sim_tape_index_complete (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 i;
+
+if (ctx->index_count == 0)
+    return (uptr->tape_eom == 0);
+if ((ctx->index[0].pos != 0) ||
+    (ctx->index[ctx->index_count - 1].end != uptr->tape_eom))
+    return FALSE;
+for (i = 1; i < ctx->index_count; i++)
+    if (ctx->index[i].pos != ctx->index[i - 1].end)
+        return FALSE;
+return TRUE;
+}
+
+static t_bool sim_tape_index_load (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+char magic[8];
+uint32 hdr32[2], rec32[2];
+t_uint64 hdr64[3], rec64[2];
+struct stat statb;
+t_offset fsize;
+FILE *f;
+uint32 i;
+
+if ((stat (uptr->filename, &statb) != 0) ||
+    ((f = sim_fopen (ctx->index_file, "rb")) == NULL))
+    return FALSE;
+if ((sim_fread (magic, 1, sizeof (magic), f) != sizeof (magic)) ||
+    (sim_fread (hdr32, sizeof (hdr32[0]), 2, f) != 2) ||
+    (sim_fread (hdr64, sizeof (hdr64[0]), 3, f) != 3) ||
+    (memcmp (magic, TIX_MAGIC, sizeof (magic)) != 0) ||
+    (hdr32[TIX_HDR_FORMAT] != MT_GET_FMT (uptr)) ||
+    (hdr64[TIX_HDR_SIZE] != (t_uint64)sim_tape_size (uptr)) ||
+    (hdr64[TIX_HDR_MTIME] != (t_uint64)statb.st_mtime) ||
+    ((fsize = sim_fsize_ex (f)) < TIX_HDR_BYTES) ||     /* count must fit the file */
+    ((t_offset)hdr32[TIX_HDR_COUNT] != (fsize - TIX_HDR_BYTES) / TIX_REC_BYTES) ||
+    ((ctx->index = (struct tape_index_entry *)calloc (hdr32[TIX_HDR_COUNT] + 1, sizeof (*ctx->index))) == NULL)) {
+    fclose (f);
+    return FALSE;
+    }
+ctx->index_alloc = hdr32[TIX_HDR_COUNT] + 1;
+for (i = 0; i < hdr32[TIX_HDR_COUNT]; i++) {
+    if ((sim_fread (rec64, sizeof (rec64[0]), 2, f) != 2) ||
+        (sim_fread (rec32, sizeof (rec32[0]), 2, f) != 2))
+        break;
+    ctx->index[i].pos = (t_addr)rec64[TIX_REC_POS];
+    ctx->index[i].end = (t_addr)rec64[TIX_REC_END];
+    ctx->index[i].bc = rec32[TIX_REC_BC];
+    ctx->index[i].flags = rec32[TIX_REC_FLAGS];
+    }
+fclose (f);
+ctx->index_count = i;
+uptr->tape_eom = (t_addr)hdr64[TIX_HDR_EOM];
+if ((i == hdr32[TIX_HDR_COUNT]) && sim_tape_index_complete (uptr))
+    return TRUE;
+ctx->index_count = 0;                                   /* discard partial content */
+uptr->tape_eom = 0;
+return FALSE;
+}
+
+static void sim_tape_index_save (UNIT *uptr)
+{
+struct tape_context *ctx = (struct tape_context *)uptr->tape_ctx;
+uint32 hdr32[2], rec32[2];
+t_uint64 hdr64[3], rec64[2];
+struct stat statb;
+FILE *f;
+uint32 i;
+
+(void)fflush (uptr->fileref);                           /* settle the image's modification time */
+if (!sim_tape_index_complete (uptr) ||                  /* index doesn't describe the whole tape? */
+    (stat (uptr->filename, &statb) != 0)) {
+    (void)remove (ctx->index_file);                     /*   then a stale sidecar is useless */
+    return;
+    }
+if ((f = sim_fopen (ctx->index_file, "wb")) == NULL)
+    return;
+hdr32[TIX_HDR_FORMAT] = MT_GET_FMT (uptr);
+hdr32[TIX_HDR_COUNT] = ctx->index_count;
+hdr64[TIX_HDR_SIZE] = (t_uint64)sim_tape_size (uptr);
+hdr64[TIX_HDR_MTIME] = (t_uint64)statb.st_mtime;
+hdr64[TIX_HDR_EOM] = (t_uint64)uptr->tape_eom;
+(void)sim_fwrite (TIX_MAGIC, 1, 8, f);
+(void)sim_fwrite (hdr32, sizeof (hdr32[0]), 2, f);
+(void)sim_fwrite (hdr64, sizeof (hdr64[0]), 3, f);
+for (i = 0; i < ctx->index_count; i++) {
+    rec64[TIX_REC_POS] = (t_uint64)ctx->index[i].pos;
+    rec64[TIX_REC_END] = (t_uint64)ctx->index[i].end;
+    rec32[TIX_REC_BC] = ctx->index[i].bc;
+    rec32[TIX_REC_FLAGS] = ctx->index[i].flags;
+    (void)sim_fwrite (rec64, sizeof (rec64[0]), 2, f);
+    (void)sim_fwrite (rec32, sizeof (rec32[0]), 2, f);
+    }
+if (ferror (f)) {
+    fclose (f);
+    (void)remove (ctx->index_file);
+    return;
+    }
+fclose (f);
+}
+
 /* Read record length forward (internal routine).
 
    Inputs:
@@ -975,6 +1581,7 @@ t_addr saved_pos;
 uint32   bufcntr, bufcap;                               /* buffer counter and capacity */
 int32    runaway_counter, sizeof_gap;                   /* bytes remaining before runaway and bytes per gap */
 t_stat   status = MTSE_OK;
+t_addr   start_pos = uptr->pos;
 
 MT_CLR_PNU (uptr);                                      /* clear the position-not-updated flag */
 *bc = 0;
@@ -1278,6 +1885,8 @@ switch (f) {                                       /* otherwise the read method
         status = MTSE_FMT;
     }
 
+if ((status == MTSE_OK) || (status == MTSE_TMK))
+    sim_tape_index_note (uptr, start_pos, *bc, status);
 return status;
 }
 
@@ -1659,6 +2268,10 @@ if (ctx == NULL)                                        /* if not properly attac
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 sim_debug_unit (ctx->dbit, uptr, "sim_tape_rdrecf(unit=%d, buf=%p, max=%d)\n", (int)(uptr-ctx->dptr->units), buf, max);
 
+if (_tape_ra_read (uptr, buf, bc, max, &st)) {          /* already read ahead? */
+    sim_tape_data_trace(uptr, buf, *bc, "Record Read", (uptr->dctrl | ctx->dptr->dctrl) & MTSE_DBG_DAT, MTSE_DBG_STR);
+    return st;
+    }
 opos = uptr->pos;                                       /* old position */
 st = sim_tape_rdrlfwd (uptr, &tbc);                     /* read rec lnt */
 if (st != MTSE_OK) {
@@ -1811,6 +2424,8 @@ if (sbc == 0)                                           /* nothing to do? */
     return MTSE_OK;
 if (sim_tape_seek (uptr, uptr->pos))                    /* set pos */
     return MTSE_IOERR;
+sim_tape_index_truncate (uptr, uptr->pos);              /* forget overwritten objects */
+_tape_ra_flush (uptr);
 switch (f) {                                            /* case on format */
 
     case MTUF_F_STD:                                    /* standard */
@@ -1869,6 +2484,8 @@ t_bool   replacing_record;
 memset (&awshdr, 0, sizeof (t_awshdr));
 if (sim_tape_seek (uptr, uptr->pos))        /* set pos */
     return MTSE_IOERR;
+sim_tape_index_truncate (uptr, uptr->pos);  /* forget overwritten objects */
+_tape_ra_flush (uptr);
 rdcnt = sim_fread (&awshdr, sizeof (t_awslnt), 3, uptr->fileref);
 if (ferror (uptr->fileref)) {               /* error? */
     MT_SET_PNU (uptr);                      /* pos not upd */
@@ -1916,6 +2533,8 @@ if (ctx == NULL)                                        /* if not properly attac
 if (sim_tape_wrp (uptr))                                /* write prot? */
     return MTSE_WRP;
 (void)sim_tape_seek (uptr, uptr->pos);                  /* set pos */
+sim_tape_index_truncate (uptr, uptr->pos);              /* forget overwritten objects */
+_tape_ra_flush (uptr);
 (void)sim_fwrite (&dat, sizeof (t_mtrlnt), 1, uptr->fileref);
 if (ferror (uptr->fileref)) {                           /* error? */
     MT_SET_PNU (uptr);
@@ -1970,6 +2589,8 @@ if (sim_tape_wrp (uptr))                                /* write prot? */
 if (MT_GET_FMT (uptr) == MTUF_F_P7B)                    /* cant do P7B */
     return MTSE_FMT;
 if (MT_GET_FMT (uptr) == MTUF_F_AWS) {
+    sim_tape_index_truncate (uptr, uptr->pos);
+    _tape_ra_flush (uptr);
     sim_set_fsize (uptr->fileref, uptr->pos);
     result = MTSE_OK;
     }
@@ -2135,6 +2756,8 @@ else if (sim_tape_wrp (uptr))                           /* otherwise if the unit
 else if (gap_size == 0 || format != MTUF_F_STD)         /* otherwise if zero length or gaps aren't supported */
     return MTSE_OK;                                     /*   then take no action */
 
+sim_tape_index_truncate (uptr, gap_pos);                /* forget the objects being erased */
+_tape_ra_flush (uptr);
 file_size = sim_fsize (uptr->fileref);                  /* get the file size */
 
 if (sim_tape_seek (uptr, uptr->pos)) {                  /* position the tape; if it fails */
@@ -2336,6 +2959,8 @@ else if (gap_size == 0 || format != MTUF_F_STD)         /* otherwise if the gap
     return MTSE_OK;                                     /*   then take no action */
 
 gap_pos = uptr->pos;                                    /* save the starting position */
+sim_tape_index_truncate (uptr, 0);                      /* forget everything (the erased extent isn't known yet) */
+_tape_ra_flush (uptr);
 
 if (gap_size == meta_size) {                            /* if the request is for a single metadatum */
     if (sim_tape_bot (uptr))                            /*   then if the unit is positioned at the BOT */
@@ -2531,7 +3156,8 @@ if (ctx == NULL)                                        /* if not properly attac
     return sim_messagef (SCPE_IERR, "Bad Attach\n");    /*   that's a problem */
 sim_debug_unit (ctx->dbit, uptr, "sim_tape_sprecf(unit=%d)\n", (int)(uptr-ctx->dptr->units));
 
-st = sim_tape_rdrlfwd (uptr, bc);                       /* get record length */
+if (!sim_tape_index_space (uptr, FALSE, bc, &st))       /* not a known object? */
+    st = sim_tape_rdrlfwd (uptr, bc);                   /*   get record length */
 *bc = MTR_L (*bc);
 return st;
 }
@@ -2626,7 +3252,8 @@ if (MT_TST_PNU (uptr)) {
     *bc = 0;
     return MTSE_OK;
     }
-st = sim_tape_rdrlrev (uptr, bc);                       /* get record length */
+if (!sim_tape_index_space (uptr, TRUE, bc, &st))        /* not a known object? */
+    st = sim_tape_rdrlrev (uptr, bc);                   /*   get record length */
 *bc = MTR_L (*bc);
 return st;
 }
@@ -2912,6 +3539,7 @@ if (uptr->flags & UNIT_ATT) {
         return sim_messagef (SCPE_IERR, "Bad Attach\n");/*   that's a problem */
     sim_debug_unit (ctx->dbit, uptr, "sim_tape_rewind(unit=%d)\n", (int)(uptr-ctx->dptr->units));
     }
+_tape_ra_flush (uptr);
 uptr->pos = 0;
 if (uptr->flags & UNIT_ATT) {
     (void)sim_tape_seek (uptr, uptr->pos);
@@ -3750,20 +4378,318 @@ sim_switches = 0;
 return SCPE_OK;
 }
 
+#define TIX_TEST_MAX 256
+
+static t_stat sim_tape_test_index_walk (UNIT *uptr, t_bool reverse, t_addr *pos, t_stat *st, t_mtrlnt *bc, uint32 *count)
+{
+t_mtrlnt tbc;
+t_stat r;
+
+*count = 0;
+while (*count < TIX_TEST_MAX) {
+    r = reverse ? sim_tape_sprecr (uptr, &tbc) : sim_tape_sprecf (uptr, &tbc);
+    if ((r != MTSE_OK) && (r != MTSE_TMK))
+        return SCPE_OK;
+    pos[*count] = uptr->pos;
+    st[*count] = r;
+    bc[*count] = tbc;
+    ++*count;
+    }
+return sim_messagef (SCPE_IERR, "Runaway index walk\n");
+}
+
+static t_stat sim_tape_test_index_compare (UNIT *uptr, t_bool reverse, t_addr *pos, t_stat *st, t_mtrlnt *bc, uint32 count, const char *what)
+{
+t_addr ipos[TIX_TEST_MAX];
+t_stat ist[TIX_TEST_MAX];
+t_mtrlnt ibc[TIX_TEST_MAX];
+uint32 icount, i;
+t_stat r;
+
+r = sim_tape_test_index_walk (uptr, reverse, ipos, ist, ibc, &icount);
+if (r != SCPE_OK)
+    return r;
+if (icount != count)
+    return sim_messagef (SCPE_IERR, "%s %s walk found %u objects instead of %u\n", what, reverse ? "reverse" : "forward", icount, count);
+for (i = 0; i < count; i++)
+    if ((ipos[i] != pos[i]) || (ist[i] != st[i]) || (ibc[i] != bc[i]))
+        return sim_messagef (SCPE_IERR, "%s %s walk object %u mismatch: pos %" T_ADDR_FMT "u/%" T_ADDR_FMT "u, status %d/%d, length %u/%u\n",
+                                        what, reverse ? "reverse" : "forward", i, ipos[i], pos[i], ist[i], st[i], ibc[i], bc[i]);
+return SCPE_OK;
+}
+
+static t_stat sim_tape_test_index (UNIT *uptr, const char *filename, const char *format)
+{
+struct tape_context *ctx;
+char args[256];
+char sidecar[256];
+t_addr fpos[TIX_TEST_MAX], rpos[TIX_TEST_MAX];
+t_stat fst[TIX_TEST_MAX], rst[TIX_TEST_MAX];
+t_mtrlnt fbc[TIX_TEST_MAX], rbc[TIX_TEST_MAX];
+uint32 fcount, rcount = 0;
+t_addr eom;
+t_bool reverse;
+uint8 rec[10] = {0};
+uint32 bad_count = 0xFFFFFFFF;
+FILE *f;
+t_stat r;
+
+sprintf (args, "%s %s.%s", format, filename, format);
+sprintf (sidecar, "%s.%s.idx", filename, format);
+(void)remove (sidecar);
+sim_tape_detach (uptr);
+sim_switches = SWMASK ('F') | SWMASK ('I');
+r = sim_tape_attach_ex (uptr, args, 0, 0);
+if (r != SCPE_OK)
+    return r;
+ctx = (struct tape_context *)uptr->tape_ctx;
+if (ctx->index_count == 0)
+    return sim_messagef (SCPE_IERR, "%s: attach validation didn't build a record index\n", format);
+reverse = (MT_GET_FMT (uptr) != MTUF_F_AWS);        /* AWS reverse spacing doesn't use the index */
+eom = uptr->tape_eom;
+ctx->index_count = 0;                               /* walk the container itself */
+r = sim_tape_test_index_walk (uptr, FALSE, fpos, fst, fbc, &fcount);
+if ((r == SCPE_OK) && reverse)
+    r = sim_tape_test_index_walk (uptr, TRUE, rpos, rst, rbc, &rcount);
+if (r != SCPE_OK)
+    return r;
+if ((fcount == 0) || (reverse && (uptr->pos != 0)))
+    return sim_messagef (SCPE_IERR, "%s: unexpected walk result: %u objects, final position %" T_ADDR_FMT "u\n", format, fcount, uptr->pos);
+if (reverse && !sim_tape_index_complete (uptr))
+    return sim_messagef (SCPE_IERR, "%s: forward walk didn't rebuild a complete record index\n", format);
+sim_tape_rewind (uptr);
+r = sim_tape_test_index_compare (uptr, FALSE, fpos, fst, fbc, fcount, format);
+if ((r == SCPE_OK) && reverse)
+    r = sim_tape_test_index_compare (uptr, TRUE, rpos, rst, rbc, rcount, format);
+if (r != SCPE_OK)
+    return r;
+if (!reverse) {                                     /* the AWS test tape ends in garbage, */
+    sim_tape_detach (uptr);                         /*   so it never has a complete index */
+    if (sim_fsize_name (sidecar) != 0)
+        return sim_messagef (SCPE_IERR, "%s: index sidecar written for an incomplete index\n", format);
+    sim_switches = 0;
+    return SCPE_OK;
+    }
+sim_tape_detach (uptr);                             /* write the sidecar */
+if (sim_fsize_name (sidecar) == 0)
+    return sim_messagef (SCPE_IERR, "%s: no index sidecar written\n", format);
+sim_switches = SWMASK ('F') | SWMASK ('I');
+r = sim_tape_attach_ex (uptr, args, 0, 0);
+if (r != SCPE_OK)
+    return r;
+ctx = (struct tape_context *)uptr->tape_ctx;
+if ((uptr->tape_eom != eom) || !sim_tape_index_complete (uptr))
+    return sim_messagef (SCPE_IERR, "%s: index sidecar not loaded\n", format);
+r = sim_tape_test_index_compare (uptr, FALSE, fpos, fst, fbc, fcount, format);
+if ((r == SCPE_OK) && reverse)
+    r = sim_tape_test_index_compare (uptr, TRUE, rpos, rst, rbc, rcount, format);
+if (r != SCPE_OK)
+    return r;
+sim_tape_detach (uptr);                             /* rewrite the sidecar */
+f = sim_fopen (sidecar, "r+b");                     /* with a record count */
+if (f == NULL)                                      /*   larger than the file */
+    return sim_messagef (SCPE_IERR, "%s: can't reopen index sidecar\n", format);
+if ((sim_fseeko (f, 8 + TIX_HDR_COUNT*4, SEEK_SET) != 0) ||
+    (sim_fwrite (&bad_count, sizeof (bad_count), 1, f) != 1)) {
+    fclose (f);
+    return sim_messagef (SCPE_IERR, "%s: can't alter index sidecar\n", format);
+    }
+fclose (f);
+sim_switches = SWMASK ('F') | SWMASK ('I');
+r = sim_tape_attach_ex (uptr, args, 0, 0);
+if (r != SCPE_OK)
+    return r;
+ctx = (struct tape_context *)uptr->tape_ctx;
+if ((uptr->tape_eom != eom) || !sim_tape_index_complete (uptr))
+    return sim_messagef (SCPE_IERR, "%s: record index not rebuilt after a bad sidecar\n", format);
+r = sim_tape_test_index_compare (uptr, FALSE, fpos, fst, fbc, fcount, format);
+if (r != SCPE_OK)
+    return r;
+uptr->pos = fpos[1];                                /* overwrite the third object */
+if (sim_tape_wrrecf (uptr, rec, sizeof (rec)) != MTSE_OK)
+    return sim_messagef (SCPE_IERR, "%s: record write failed\n", format);
+if ((ctx->index_count > 2) || sim_tape_index_complete (uptr))
+    return sim_messagef (SCPE_IERR, "%s: record write didn't invalidate the record index\n", format);
+sim_tape_detach (uptr);                             /* remove the stale sidecar */
+if (sim_fsize_name (sidecar) != 0)
+    return sim_messagef (SCPE_IERR, "%s: stale index sidecar remains\n", format);
+sim_switches = 0;
+return SCPE_OK;
+}
+
+#if defined (SIM_ASYNCH_IO)
+static t_stat sim_tape_test_readahead (UNIT *uptr, const char *filename, const char *format)
+{
+struct tape_context *ctx;
+char args[256];
+t_addr rpos[TIX_TEST_MAX];
+t_stat rst[TIX_TEST_MAX];
+t_mtrlnt rbc[TIX_TEST_MAX];
+uint32 rsum[TIX_TEST_MAX];
+uint32 count, i, j, sum, hits = 0;
+int had_async;
+uint8 *buf;
+t_mtrlnt bc;
+t_stat r = SCPE_OK;
+t_stat st;
+
+sprintf (args, "%s %s.%s", format, filename, format);
+sim_tape_detach (uptr);
+sim_switches = SWMASK ('F');
+r = sim_tape_attach_ex (uptr, args, 0, 0);
+if (r != SCPE_OK)
+    return r;
+ctx = (struct tape_context *)uptr->tape_ctx;
+buf = (uint8 *)malloc (MTR_MAXLEN);
+for (count = 0; count < TIX_TEST_MAX; count++) {    /* reference pass without read-ahead */
+    st = sim_tape_rdrecf (uptr, buf, &bc, MTR_MAXLEN);
+    if ((st != MTSE_OK) && (st != MTSE_RECE) && (st != MTSE_TMK))
+        break;
+    for (j = sum = 0; j < bc; j++)
+        sum = (sum << 1) + buf[j];
+    rpos[count] = uptr->pos;
+    rst[count] = st;
+    rbc[count] = bc;
+    rsum[count] = sum;
+    }
+had_async = ctx->asynch_io;                         /* the idle I/O thread, if any, doesn't interfere */
+if (!had_async) {
+    pthread_mutex_init (&ctx->ra_lock, NULL);
+    ctx->asynch_io = 1;                             /* read ahead without an I/O thread */
+    }
+sim_tape_rewind (uptr);
+for (i = 0; i < count; i++) {
+    if (ctx->ra_count == 0)
+        _tape_ra_fill (uptr);
+    else
+        ++hits;
+    st = sim_tape_rdrecf (uptr, buf, &bc, MTR_MAXLEN);
+    for (j = sum = 0; j < bc; j++)
+        sum = (sum << 1) + buf[j];
+    if ((st != rst[i]) || (bc != rbc[i]) || (uptr->pos != rpos[i]) || (sum != rsum[i])) {
+        r = sim_messagef (SCPE_IERR, "%s: read-ahead record %u mismatch: status %d/%d, length %u/%u, pos %" T_ADDR_FMT "u/%" T_ADDR_FMT "u\n",
+                                     format, i, st, rst[i], bc, rbc[i], uptr->pos, rpos[i]);
+        break;
+        }
+    }
+if ((r == SCPE_OK) && (hits == 0))
+    r = sim_messagef (SCPE_IERR, "%s: no records were satisfied by reading ahead\n", format);
+if (r == SCPE_OK) {                                 /* a rewind discards the ring */
+    sim_tape_rewind (uptr);
+    _tape_ra_fill (uptr);
+    if (ctx->ra_count == 0)
+        r = sim_messagef (SCPE_IERR, "%s: nothing was read ahead\n", format);
+    else {
+        sim_tape_rewind (uptr);
+        if (ctx->ra_count != 0)
+            r = sim_messagef (SCPE_IERR, "%s: rewind didn't discard read-ahead records\n", format);
+        }
+    }
+if (r == SCPE_OK) {                                 /* a read elsewhere discards the ring and still works */
+    _tape_ra_fill (uptr);
+    uptr->pos = rpos[2];
+    st = sim_tape_rdrecf (uptr, buf, &bc, MTR_MAXLEN);
+    if ((ctx->ra_count != 0) || (st != rst[3]) || (bc != rbc[3]) || (uptr->pos != rpos[3]))
+        r = sim_messagef (SCPE_IERR, "%s: repositioned read returned the wrong record\n", format);
+    }
+if (r == SCPE_OK) {                                 /* a write discards the ring */
+    _tape_ra_fill (uptr);
+    if ((ctx->ra_count == 0) ||
+        (sim_tape_wrrecf (uptr, buf, rbc[4]) != MTSE_OK) ||     /* rewrite the next record in place */
+        (ctx->ra_count != 0))
+        r = sim_messagef (SCPE_IERR, "%s: record write didn't discard read-ahead records\n", format);
+    }
+_tape_ra_free (ctx);
+if (!had_async) {
+    ctx->asynch_io = 0;
+    pthread_mutex_destroy (&ctx->ra_lock);
+    }
+free (buf);
+sim_tape_detach (uptr);
+sim_switches = 0;
+return r;
+}
+
+/* Records still in the unit's stdio buffer are read ahead correctly */
+
+static t_stat sim_tape_test_readahead_written (UNIT *uptr, const char *filename, const char *format)
+{
+struct tape_context *ctx;
+char name[256], args[sizeof (name) + 16];       /* format, blank and name */
+uint32 i, j, hits = 0;
+int had_async;
+uint8 buf[64];
+t_mtrlnt bc;
+t_stat r = SCPE_OK;
+t_stat st;
+
+snprintf (name, sizeof (name), "%s-written.%s", filename, format);
+snprintf (args, sizeof (args), "%s %s", format, name);
+(void)remove (name);
+sim_tape_detach (uptr);
+sim_switches = SWMASK ('F');
+r = sim_tape_attach_ex (uptr, args, 0, 0);
+if (r != SCPE_OK)
+    return r;
+ctx = (struct tape_context *)uptr->tape_ctx;
+for (i = 0; (r == SCPE_OK) && (i < TAPE_RA_RECORDS); i++) { /* short records stay buffered */
+    memset (buf, 'A' + i, sizeof (buf));
+    if (sim_tape_wrrecf (uptr, buf, sizeof (buf)) != MTSE_OK)
+        r = sim_messagef (SCPE_IERR, "%s: record write failed\n", format);
+    }
+had_async = ctx->asynch_io;
+if (!had_async) {
+    pthread_mutex_init (&ctx->ra_lock, NULL);
+    ctx->asynch_io = 1;                             /* read ahead without an I/O thread */
+    }
+uptr->pos = 0;                                      /* back to BOT without touching the stream */
+for (i = 0; (r == SCPE_OK) && (i < TAPE_RA_RECORDS); i++) {
+    if (ctx->ra_count == 0)
+        _tape_ra_fill (uptr);
+    else
+        ++hits;
+    st = sim_tape_rdrecf (uptr, buf, &bc, sizeof (buf));
+    for (j = 0; (st == MTSE_OK) && (j < bc) && (buf[j] == 'A' + i); j++)
+        ;
+    if ((st != MTSE_OK) || (bc != sizeof (buf)) || (j != bc))
+        r = sim_messagef (SCPE_IERR, "%s: record %u written before reading ahead read back wrong: status %d, length %u\n", format, i, st, bc);
+    }
+if ((r == SCPE_OK) && (hits != TAPE_RA_RECORDS - 1))  /* every read after the first finds the ring filled */
+    r = sim_messagef (SCPE_IERR, "%s: only %u of %u written records were satisfied by reading ahead\n", format, hits, TAPE_RA_RECORDS - 1);
+if ((r == SCPE_OK) && (ctx->index_count != TAPE_RA_RECORDS)) /* writing truncated the index */
+    r = sim_messagef (SCPE_IERR, "%s: %u of %u records read ahead were indexed\n", format, ctx->index_count, TAPE_RA_RECORDS);
+_tape_ra_free (ctx);
+if (!had_async) {
+    ctx->asynch_io = 0;
+    pthread_mutex_destroy (&ctx->ra_lock);
+    }
+sim_tape_detach (uptr);
+(void)remove (name);
+sim_switches = 0;
+return r;
+}
+#endif
+
 static t_stat sim_tape_test_remove_tape_files (UNIT *uptr, const char *filename)
 {
 char name[256];
 
 sprintf (name, "%s.simh", filename);
 (void)remove (name);
+sprintf (name, "%s.simh.idx", filename);
+(void)remove (name);
 sprintf (name, "%s.e11", filename);
 (void)remove (name);
+sprintf (name, "%s.e11.idx", filename);
+(void)remove (name);
 sprintf (name, "%s.tpc", filename);
 (void)remove (name);
 sprintf (name, "%s.p7b", filename);
 (void)remove (name);
 sprintf (name, "%s.aws", filename);
 (void)remove (name);
+sprintf (name, "%s.aws.idx", filename);
+(void)remove (name);
 sprintf (name, "%s.tar", filename);
 (void)remove (name);
 sprintf (name, "%s.2.tar", filename);
@@ -3839,6 +4765,20 @@ SIM_TEST(sim_tape_test_process_tape_file (dptr->units, "TapeTestFile1", "e11"));
 sim_switches = saved_switches;
 SIM_TEST(sim_tape_test_process_tape_file (dptr->units, "TapeTestFile1", "simh"));
 
+#if defined (SIM_ASYNCH_IO)
+SIM_TEST(sim_tape_test_readahead (dptr->units, "TapeTestFile1", "simh"));
+
+SIM_TEST(sim_tape_test_readahead (dptr->units, "TapeTestFile1", "p7b"));
+
+SIM_TEST(sim_tape_test_readahead_written (dptr->units, "TapeTestFile1", "simh"));
+#endif
+
+SIM_TEST(sim_tape_test_index (dptr->units, "TapeTestFile1", "simh"));
+
+SIM_TEST(sim_tape_test_index (dptr->units, "TapeTestFile1", "e11"));
+
+SIM_TEST(sim_tape_test_index (dptr->units, "TapeTestFile1", "aws"));
+
 SIM_TEST(sim_tape_test_remove_tape_files (dptr->units, "TapeTestFile1"));
 
 return SCPE_OK;
@@ -348,6 +348,14 @@
 #include <ctype.h>
 #include <math.h>
 
+#if defined(__linux) && !defined(DONT_USE_EPOLL)
+#include <errno.h>
+#include <sys/epoll.h>
+#if defined(EPOLLET)
+#define TMXR_USE_EPOLL 1
+#endif
+#endif
+
 /* Telnet protocol constants - negatives are for init'ing signed char data */
 
 /* Commands */
@@ -453,6 +461,151 @@ static u_char mantra[] = {                  /* Telnet Option Negotiation Mantra
 
 static void tmxr_add_to_open_list (TMXR* mux);
 
+/* Receive readiness tracking.
+
+   Without help, tmxr_poll_rx visits every line of a mux on every poll, so
+   its cost grows with the number of attached but idle lines.  Where epoll
+   is available each mux keeps an edge triggered epoll descriptor with its
+   line sockets registered, and a ready list of the lines which may have
+   input waiting.  A line stays on the ready list until a read comes back
+   short (the socket has been drained and the next arrival will raise a new
+   edge).  A full scan is made whenever the set of connections changes
+   (tmxr_rx_untrack clears mp->rx_tracked) and it (re)registers the sockets;
+   while any line is a serial port or in loopback the full scan is used on
+   every poll since those lines can't be watched.
+*/
+
+#if defined(TMXR_USE_EPOLL)
+typedef struct tmxr_rx_poll {
+    int                 fd;                             /* epoll descriptor */
+    int32               lines;                          /* lines the lists are sized for */
+    int32               ready_count;                    /* lines on the ready list */
+    int32               *ready;                         /* lines which may have input waiting */
+    int32               *visit;                         /* ready list being serviced */
+    } TMXR_RX_POLL;
+
+#define TMXR_RX_EVENTS  64                              /* epoll events per epoll_wait */
+
+static void tmxr_rx_queue (TMXR_RX_POLL *rp, TMLN *lp, int32 ln)
+{
+if (lp->rx_ready)
+    return;
+lp->rx_ready = TRUE;
+rp->ready[rp->ready_count++] = ln;
+}
+
+/* Register the line's socket.  Returns FALSE if the line has input
+   which can't be watched (serial port or loopback) */
+
+static t_bool tmxr_rx_track (TMXR_RX_POLL *rp, TMLN *lp, int32 ln)
+{
+struct epoll_event ev;
+
+if (lp->serport || lp->loopback)
+    return FALSE;
+if ((lp->sock == 0) || (lp->rx_poll_sock == lp->sock))
+    return TRUE;
+memset (&ev, 0, sizeof (ev));
+ev.events = EPOLLIN | EPOLLET;
+ev.data.u32 = (uint32)ln;
+if ((epoll_ctl (rp->fd, EPOLL_CTL_ADD, lp->sock, &ev)) &&
+    ((errno != EEXIST) || epoll_ctl (rp->fd, EPOLL_CTL_MOD, lp->sock, &ev)))
+    return FALSE;
+lp->rx_poll_sock = lp->sock;                            /* readiness is reported once registered */
+return TRUE;
+}
+
+static void tmxr_rx_poll_free (TMXR *mp)
+{
+TMXR_RX_POLL *rp = (TMXR_RX_POLL *)mp->rx_poll;
+int32 i;
+
+if (rp == NULL)
+    return;
+for (i = 0; i < mp->lines; i++) {
+    mp->ldsc[i].rx_poll_sock = 0;
+    mp->ldsc[i].rx_ready = FALSE;
+    }
+close (rp->fd);
+free (rp->ready);
+free (rp->visit);
+free (rp);
+mp->rx_poll = NULL;
+mp->rx_tracked = FALSE;
+}
+
+/* Start a receive poll.  When the ready list is current, collect the
+   pending readiness events and hand back the lines to be visited.
+   Otherwise prepare for a full scan (*ready == NULL) which rebuilds the
+   ready list. */
+
+static TMXR_RX_POLL *tmxr_rx_poll_start (TMXR *mp, int32 **ready, int32 *count)
+{
+TMXR_RX_POLL *rp = (TMXR_RX_POLL *)mp->rx_poll;
+struct epoll_event ev[TMXR_RX_EVENTS];
+int32 *visit;
+int i, n;
+
+*ready = NULL;
+*count = mp->lines;
+if ((rp != NULL) && (rp->lines != mp->lines))           /* line count changed? */
+    tmxr_rx_poll_free (mp);
+rp = (TMXR_RX_POLL *)mp->rx_poll;
+if (rp == NULL) {
+    rp = (TMXR_RX_POLL *)calloc (1, sizeof (*rp));
+    if (rp == NULL)
+        return NULL;
+    rp->fd = epoll_create1 (EPOLL_CLOEXEC);
+    rp->lines = mp->lines;
+    rp->ready = (int32 *)calloc (mp->lines + 1, sizeof (*rp->ready));
+    rp->visit = (int32 *)calloc (mp->lines + 1, sizeof (*rp->visit));
+    if ((rp->fd < 0) || (rp->ready == NULL) || (rp->visit == NULL)) {
+        if (rp->fd >= 0)
+            close (rp->fd);
+        free (rp->ready);
+        free (rp->visit);
+        free (rp);
+        return NULL;
+        }
+    mp->rx_poll = rp;
+    mp->rx_tracked = FALSE;
+    }
+if (!mp->rx_tracked) {                                  /* full scan */
+    rp->ready_count = 0;
+    mp->rx_tracked = TRUE;                              /* until an untrackable line is seen */
+    return rp;
+    }
+do {
+    n = epoll_wait (rp->fd, ev, TMXR_RX_EVENTS, 0);
+    for (i = 0; i < n; i++)
+        if (ev[i].data.u32 < (uint32)mp->lines)
+            tmxr_rx_queue (rp, mp->ldsc + ev[i].data.u32, (int32)ev[i].data.u32);
+    } while (n == TMXR_RX_EVENTS);
+visit = rp->visit;                                      /* service the current list */
+rp->visit = rp->ready;
+rp->ready = visit;
+*ready = rp->visit;
+*count = rp->ready_count;
+rp->ready_count = 0;                                    /* while building the next one */
+return rp;
+}
+#endif /* TMXR_USE_EPOLL */
+
+/* Note a change in a line's connection state: the socket is dropped from
+   the epoll set and the next tmxr_poll_rx makes a full scan. */
+
+static void tmxr_rx_untrack (TMLN *lp)
+{
+if (lp->mp == NULL)
+    return;
+#if defined(TMXR_USE_EPOLL)
+if (lp->rx_poll_sock && lp->mp->rx_poll)
+    epoll_ctl (((TMXR_RX_POLL *)lp->mp->rx_poll)->fd, EPOLL_CTL_DEL, lp->rx_poll_sock, NULL);
+#endif
+lp->rx_poll_sock = 0;
+lp->mp->rx_tracked = FALSE;
+}
+
 /* Initialize the line state.
 
    Reset the line state to represent an idle line.  Note that we do not clear
@@ -466,6 +619,7 @@ static void tmxr_add_to_open_list (TMXR* mux);
 
 static void tmxr_init_line (TMLN *lp)
 {
+tmxr_rx_untrack (lp);                                   /* connection state changed */
 lp->tsta = 0;                                           /* init telnet state */
 lp->xmte = 1;                                           /* enable transmit */
 lp->dstb = 0;                                           /* default bin mode */
@@ -706,10 +860,18 @@ static int32 tmxr_write (TMLN *lp, int32 length)
 {
 int32 written = 0;
 int32 i = lp->txbpr;
+int32 wrap = i + length - lp->txbsz;                    /* data beyond the end of the buffer */
 
 if ((lp->txbps) && (sim_gtime () < lp->txnexttime) && (sim_is_running))
     return 0;
 
+if ((wrap > 0) &&                                       /* wrapped and not a */
+    ((lp->loopback) || (lp->serport) ||                 /* stream socket? */
+     (!lp->sock) || (lp->datagram))) {
+    length -= wrap;                                     /* write the first piece */
+    wrap = 0;
+    }
+
 if (lp->loopback)
     return loop_write (lp, &(lp->txb[i]), length);
 
@@ -718,7 +880,10 @@ if (lp->serport) {                                      /* serial port connectio
     }
 else {
     if (lp->sock) {                                     /* Telnet connection */
-        written = sim_write_sock (lp->sock, &(lp->txb[i]), length);
+        if (wrap > 0)                                   /* both pieces at once */
+            written = sim_writev_sock (lp->sock, &(lp->txb[i]), length - wrap, lp->txb, wrap);
+        else
+            written = sim_write_sock (lp->sock, &(lp->txb[i]), length);
 
         if (written == SOCKET_ERROR) {                  /* did an error occur? */
             lp->txdone = TRUE;
@@ -746,6 +911,63 @@ return written;
 }
 
 
+/* Grow the transmit buffer of an unbuffered line so that "need" more
+   characters (and the guard space) fit.  The buffered data is moved to the
+   start of the new buffer.  Returns TRUE if the characters now fit.
+*/
+
+static t_bool tmxr_grow_txb (TMLN *lp, int32 need)
+{
+int32 used = tmxr_tqln (lp);
+int32 size = lp->txbsz;
+int32 first;
+char *txb;
+
+if (lp->txbsz - used > need)                            /* fits already? */
+    return TRUE;
+if ((lp->txbfd) || (lp->serport))                       /* fixed size line? */
+    return FALSE;
+while ((size - used <= need + TMXR_GUARD) && (size < TMXR_MAXBUF_LIMIT))
+    size = size * 2;
+if (size > TMXR_MAXBUF_LIMIT)
+    size = TMXR_MAXBUF_LIMIT;
+if (size <= lp->txbsz)                                  /* at the limit? */
+    return FALSE;
+txb = (char *)malloc (size);
+if (txb == NULL)
+    return FALSE;
+first = MIN (used, lp->txbsz - lp->txbpr);
+memcpy (txb, &lp->txb[lp->txbpr], first);               /* unwrap buffered data */
+memcpy (txb + first, lp->txb, used - first);
+free (lp->txb);
+lp->txb = txb;
+lp->txbsz = size;
+lp->txbpr = 0;
+lp->txbpi = used;
+return (size - used > need);
+}
+
+/* Grow the receive buffer of a socket line whose last read filled it */
+
+static void tmxr_grow_rxb (TMLN *lp)
+{
+int32 size = lp->rxbsz * 2;
+char *rxb, *rbr;
+
+if ((size > TMXR_MAXBUF_LIMIT) || (lp->loopback))
+    return;
+rxb = (char *)realloc (lp->rxb, size);
+if (rxb == NULL)
+    return;
+lp->rxb = rxb;
+rbr = (char *)realloc (lp->rbr, size);
+if (rbr == NULL)
+    return;
+memset (rbr + lp->rxbsz, 0, size - lp->rxbsz);
+lp->rbr = rbr;
+lp->rxbsz = size;
+}
+
 /* Remove a character from the read buffer.
 
    The character at position "p" in the read buffer associated with line "lp" is
@@ -1195,6 +1417,7 @@ for (i = 0; i < mp->lines; i++) {                       /* check each line in se
                             lp->conn = TRUE;                    /* record connection */
                             lp->sock = lp->connecting;          /* it now looks normal */
                             lp->connecting = 0;
+                            tmxr_rx_untrack (lp);               /* rescan to watch it */
                             lp->ipad = (char *)realloc (lp->ipad, 1+strlen (lp->destination));
                             strcpy (lp->ipad, lp->destination);
                             lp->cnms = sim_os_msec ();
@@ -1340,6 +1563,7 @@ if (lp->serport) {
     }
 else                                                    /* Telnet connection */
     if (lp->sock) {
+        tmxr_rx_untrack (lp);                           /* stop watching it */
         sim_close_sock (lp->sock);                      /* close socket */
         free (lp->telnet_sent_opts);
         lp->telnet_sent_opts = NULL;
@@ -1688,6 +1912,7 @@ t_stat tmxr_set_line_loopback (TMLN *lp, t_bool enable_loopback)
 if (lp->loopback == (enable_loopback != FALSE))
     return SCPE_OK;                 /* Nothing to do */
 lp->loopback = (enable_loopback != FALSE);
+tmxr_rx_untrack (lp);                                   /* input source changed */
 if (lp->loopback) {
     lp->lpbsz = lp->rxbsz;
     lp->lpb = (char *)realloc(lp->lpb, lp->lpbsz);
@@ -1887,23 +2112,62 @@ return SCPE_LOST;
 
 void tmxr_poll_rx (TMXR *mp)
 {
-int32 i, nbytes, j;
+int32 i, k, count, nbytes, want, j;
+int32 *ready = NULL;
 TMLN *lp;
+#if defined(TMXR_USE_EPOLL)
+TMXR_RX_POLL *rp;
+#endif
 
 tmxr_debug_trace (mp, "tmxr_poll_rx()");
-for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
+count = mp->lines;
+#if defined(TMXR_USE_EPOLL)
+rp = tmxr_rx_poll_start (mp, &ready, &count);
+#endif
+for (k = 0; k < count; k++) {                           /* loop thru lines */
+    i = ready ? ready[k] : k;
     lp = mp->ldsc + i;                                  /* get line desc */
+#if defined(TMXR_USE_EPOLL)
+    if (rp) {
+        lp->rx_ready = FALSE;
+        if (ready == NULL) {                            /* full scan? */
+            if (!tmxr_rx_track (rp, lp, i))
+                mp->rx_tracked = FALSE;
+            }
+        else {
+            if ((lp->sock == 0) || (lp->sock != lp->rx_poll_sock))
+                continue;                               /* line closed since queued */
+            if (lp->rxbpi == lp->rxbpr)                 /* buffer consumed? */
+                lp->rxbpi = lp->rxbpr = 0;              /* reset pointers */
+            }
+        }
+#endif
     if (!(lp->sock || lp->serport || lp->loopback) || 
-        !(lp->rcve))                                    /* skip if not connected */
+        !(lp->rcve)) {                                  /* skip if not connected */
+#if defined(TMXR_USE_EPOLL)
+        if (rp && lp->rx_poll_sock)                     /* input waits for receive enable */
+            tmxr_rx_queue (rp, lp, i);
+#endif
         continue;
+        }
 
-    nbytes = 0;
+    nbytes = want = 0;
     if (lp->rxbpi == 0)                                 /* need input? */
         nbytes = tmxr_read (lp,                         /* yes, read */
-            lp->rxbsz - TMXR_GUARD);                    /* leave spc for Telnet cruft */
+            want = lp->rxbsz - TMXR_GUARD);             /* leave spc for Telnet cruft */
     else if (lp->tsta)                                  /* in Telnet seq? */
         nbytes = tmxr_read (lp,                         /* yes, read to end */
-            lp->rxbsz - lp->rxbpi);
+            want = lp->rxbsz - lp->rxbpi);
+
+#if defined(TMXR_USE_EPOLL)
+    if (rp && lp->rx_poll_sock &&                       /* watched line and */
+        ((want == 0) || (nbytes == want) ||             /* socket maybe not drained? */
+         (lp->datagram && (nbytes > 0))))
+        tmxr_rx_queue (rp, lp, i);                      /* visit it next time */
+#endif
+    if ((nbytes == want) && (lp->rxbpi == 0) &&         /* filled an empty buffer */
+        (nbytes > 0) && (lp->sock))                     /* from a socket? */
+        tmxr_grow_rxb (lp);                             /* read more next time */
 
     if (nbytes < 0) {                                   /* line error? */
         if (!lp->datagram) {                            /* ignore errors reading UDP sockets */
@@ -2117,8 +2381,8 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
             }
         }                                               /* end else nbytes */
     }                                                   /* end for lines */
-for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
-    lp = mp->ldsc + i;                                  /* get line desc */
+for (k = 0; k < count; k++) {                           /* loop thru lines */
+    lp = mp->ldsc + (ready ? ready[k] : k);             /* get line desc */
     if (lp->rxbpi == lp->rxbpr)                         /* if buf empty, */
         lp->rxbpi = lp->rxbpr = 0;                      /* reset pointers */
     }                                                   /* end for */
@@ -2217,6 +2481,96 @@ if ((lp->txbfd && !lp->notelnet) || (TXBUF_AVAIL(lp) > 1)) {/* room for char (+
 return SCPE_STALL;                                      /* char not sent */
 }
 
+/* Store a buffer of characters in line buffer
+
+   Inputs:
+        *lp     =       pointer to line descriptor
+        *buf    =       pointer to data
+        size    =       size of data
+        *psent  =       pointer to count of characters stored (may be NULL)
+   Outputs:
+        status  =       ok, connection lost, or stall
+
+   Implementation notes:
+
+    1. The effect is that of tmxr_putc_ln for each character, but the
+       transmit buffer of an unbuffered line grows (up to TMXR_MAXBUF_LIMIT)
+       to hold the whole buffer, which is copied in bulk.  This lets a
+       device hand over a complete DMA transfer or packet and have it
+       written with a single socket operation.
+    2. If the data doesn't all fit (buffered or serial lines, or beyond
+       the growth limit) the characters which do fit are stored and
+       SCPE_STALL is returned, as tmxr_putc_ln would.
+*/
+
+static void tmxr_txb_copy (TMLN *lp, const uint8 *buf, int32 len)
+{
+int32 first = MIN (len, lp->txbsz - lp->txbpi);
+
+memcpy (&lp->txb[lp->txbpi], buf, first);
+memcpy (lp->txb, buf + first, len - first);
+lp->txbpi = (lp->txbpi + len) % lp->txbsz;
+}
+
+t_stat tmxr_put_buffer_ln (TMLN *lp, const uint8 *buf, size_t size, size_t *psent)
+{
+const uint8 *iac;
+size_t i, run, need = size;
+t_stat r = SCPE_OK;
+
+if (psent)
+    *psent = 0;
+if (size == 0)
+    return SCPE_OK;
+if ((lp->conn == FALSE) &&                              /* no conn & not buffered telnet? */
+    (!lp->txbfd || lp->notelnet)) {
+    lp->txdrp += (int32)size;                           /* lost */
+    return SCPE_LOST;
+    }
+tmxr_debug_trace_line (lp, "tmxr_put_buffer_ln()");
+if (!lp->notelnet)                                      /* telnet doubles IAC chars */
+    for (iac = buf; (iac = (const uint8 *)memchr (iac, TN_IAC, size - (iac - buf))); ++iac)
+        ++need;
+if ((size > TMXR_MAXBUF_LIMIT) ||
+    (!tmxr_grow_txb (lp, (int32)need))) {               /* can't hold it all? */
+    for (i = 0; (i < size) && (SCPE_OK == (r = tmxr_putc_ln (lp, buf[i]))); i++)
+        ;                                               /* store what fits */
+    if (psent)
+        *psent = i;
+    return r;
+    }
+if ((lp->xmte == 0) &&
+    ((lp->txbps == 0) || (lp->txnexttime <= sim_gtime ())))
+    lp->xmte = 1;                                       /* enable line transmit */
+for (i = 0; i < size; i += run) {                       /* copy runs between IACs */
+    iac = lp->notelnet ? NULL : (const uint8 *)memchr (buf + i, TN_IAC, size - i);
+    run = iac ? (size_t)(iac - (buf + i)) + 1 : size - i;
+    tmxr_txb_copy (lp, buf + i, (int32)run);
+    if (iac)
+        TXBUF_CHAR (lp, TN_IAC);                        /* stuff extra IAC char */
+    }
+if (((!lp->txbfd) && 
+     (TXBUF_AVAIL (lp) <= TMXR_GUARD)) ||               /* near full? */
+    (lp->txbps))                                        /* or we're rate limiting output */
+    lp->xmte = 0;                                       /* disable line transmit */
+if (lp->txlog) {                                        /* log if available */
+    extern TMLN *sim_oline;                             /* Make sure to avoid recursion */
+    TMLN *save_oline = sim_oline;                       /* when logging to a socket */
+
+    sim_oline = NULL;                                   /* save output socket */
+    fwrite (buf, 1, size, lp->txlog);                   /* log to actual file */
+    sim_oline = save_oline;                             /* resture output socket */
+    }
+if (lp->expect.rules)
+    for (i = 0; i < size; i++)
+        sim_exp_check (&lp->expect, buf[i]);            /* process expect rules as needed */
+if (psent)
+    *psent = size;
+if (!sim_is_running)                                    /* attach message or other non simulation time message? */
+    tmxr_send_buffered_data (lp);                       /* put data on wire */
+return SCPE_OK;
+}
+
 /* Store packet in line buffer
 
    Inputs:
@@ -2241,7 +2595,7 @@ return tmxr_put_packet_ln_ex (lp, buf, size, 0);
 
 t_stat tmxr_put_packet_ln_ex (TMLN *lp, const uint8 *buf, size_t size, uint8 frame_byte)
 {
-t_stat r;
+size_t sent;
 size_t fc_size = (frame_byte ? 1 : 0);
 size_t pktlen_size = (lp->datagram ? 0 : 2);
 
@@ -2265,9 +2619,8 @@ lp->txppsize = size + pktlen_size + fc_size;
 lp->txppoffset = 0;
 tmxr_debug (TMXR_DBG_PXMT, lp, "Sending Packet", (char *)&lp->txpb[pktlen_size+fc_size], size);
 ++lp->txpcnt;
-while ((lp->txppoffset < lp->txppsize) && 
-       (SCPE_OK == (r = tmxr_putc_ln (lp, lp->txpb[lp->txppoffset]))))
-   ++lp->txppoffset;
+tmxr_put_buffer_ln (lp, lp->txpb, lp->txppsize, &sent); /* whole packet if it fits */
+lp->txppoffset = (uint32)sent;
 tmxr_send_buffered_data (lp);
 return (lp->conn || lp->loopback) ? SCPE_OK : SCPE_LOST;
 }
@@ -2320,20 +2673,20 @@ for (i = 0; i < mp->lines; i++) {                       /* loop thru lines */
 int32 tmxr_send_buffered_data (TMLN *lp)
 {
 int32 nbytes, sbytes;
-t_stat r;
 
 tmxr_debug_trace_line (lp, "tmxr_send_buffered_data()");
 nbytes = tmxr_tqln(lp);                                 /* avail bytes */
 if (nbytes) {                                           /* >0? write */
-    if (lp->txbpr < lp->txbpi)                          /* no wrap? */
-        sbytes = tmxr_write (lp, nbytes);               /* write all data */
-    else
-        sbytes = tmxr_write (lp, lp->txbsz - lp->txbpr);/* write to end buf */
+    sbytes = tmxr_write (lp, nbytes);                   /* write all data (or to end buf) */
     if (sbytes >= 0) {                                  /* ok? */
-        tmxr_debug (TMXR_DBG_XMT, lp, "Sent", &(lp->txb[lp->txbpr]), sbytes);
+        int32 first = MIN (sbytes, lp->txbsz - lp->txbpr);
+
+        tmxr_debug (TMXR_DBG_XMT, lp, "Sent", &(lp->txb[lp->txbpr]), first);
+        if (sbytes > first)                             /* gathered across the wrap? */
+            tmxr_debug (TMXR_DBG_XMT, lp, "Sent", lp->txb, sbytes - first);
         lp->txbpr = (lp->txbpr + sbytes);               /* update remove ptr */
         if (lp->txbpr >= lp->txbsz)                     /* wrap? */
-            lp->txbpr = 0;
+            lp->txbpr -= lp->txbsz;
         lp->txcnt = lp->txcnt + sbytes;                 /* update counts */
         nbytes = nbytes - sbytes;
         if ((nbytes == 0) && (lp->datagram))            /* if Empty buffer on datagram line */
@@ -2357,10 +2710,13 @@ if (nbytes) {                                           /* >0? write */
             }
         }
     }                                                   /* end if nbytes */
-while ((lp->txppoffset < lp->txppsize) &&               /* buffered packet data? */
-       (lp->txbsz > nbytes) &&                          /* and room in xmt buffer */
-       (SCPE_OK == (r = tmxr_putc_ln (lp, lp->txpb[lp->txppoffset]))))
-   ++lp->txppoffset;
+if ((lp->txppoffset < lp->txppsize) &&                  /* buffered packet data? */
+    (lp->txbsz > nbytes)) {                             /* and room in xmt buffer */
+    size_t sent;
+
+    tmxr_put_buffer_ln (lp, &lp->txpb[lp->txppoffset], lp->txppsize - lp->txppoffset, &sent);
+    lp->txppoffset += (uint32)sent;
+    }
 if ((nbytes == 0) && (tmxr_tqln(lp) > 0))
     return tmxr_send_buffered_data (lp);
 return tmxr_tqln(lp) + tmxr_tpqln(lp);
@@ -4176,6 +4532,9 @@ if (mp->ring_sock != INVALID_SOCKET) {
     mp->ring_ipad = NULL;
     mp->ring_start_time = 0;
     }
+#if defined(TMXR_USE_EPOLL)
+tmxr_rx_poll_free (mp);
+#endif
 _tmxr_remove_from_open_list (mp);
 return SCPE_OK;
 }
@@ -4667,7 +5026,7 @@ void tmxr_linemsgvf (TMLN *lp, const char *fmt, va_list arglist)
 char stackbuf[STACKBUFSIZE];
 int32 bufsize = sizeof(stackbuf);
 char *buf = stackbuf;
-int32 i, len;
+int32 i, j, len;
 
 buf[bufsize-1] = '\0';
 while (1) {                                         /* format passed string, args */
@@ -4696,15 +5055,23 @@ while (1) {                                         /* format passed string, arg
 
 /* Output the formatted data expanding newlines where they exist */
 
-for (i = 0; i < len; ++i) {
-    if (('\n' == buf[i]) && ((i == 0) || ('\r' != buf[i-1]))) {
-        while (SCPE_STALL == tmxr_putc_ln (lp, '\r'))
-            if (lp->txbsz == tmxr_send_buffered_data (lp))
+for (i = j = 0; i <= len; ++i) {
+    if ((i == len) ||
+        (('\n' == buf[i]) && ((i == 0) || ('\r' != buf[i-1])))) {
+        while (j < i) {                             /* data up to the newline */
+            size_t sent;
+
+            if (SCPE_STALL != tmxr_put_buffer_ln (lp, (const uint8 *)&buf[j], i - j, &sent))
+                sent = i - j;
+            j += (int32)sent;
+            if ((j < i) && (lp->txbsz == tmxr_send_buffered_data (lp)))
                 sim_os_ms_sleep (10);
+            }
+        if (i < len)
+            while (SCPE_STALL == tmxr_putc_ln (lp, '\r'))
+                if (lp->txbsz == tmxr_send_buffered_data (lp))
+                    sim_os_ms_sleep (10);
         }
-    while (SCPE_STALL == tmxr_putc_ln (lp, buf[i]))
-        if (lp->txbsz == tmxr_send_buffered_data (lp))
-            sim_os_ms_sleep (10);
     }
 if (buf != stackbuf)
     free (buf);
@@ -5426,3 +5793,374 @@ if ((dptr) && (dbits & dptr->dctrl)) {
         }
     }
 }
+
+/* Unit tests
+
+   The tests build a private mux whose lines are connected to local socket
+   pairs, so they don't depend on the state of the device being tested.
+   The EXPECT rule matching which lines use is checked here as well.
+   Setting SIM_TMXR_BENCHMARK=<polls> also reports the cost of a receive
+   poll with one active line as the number of idle lines grows.
+*/
+
+#if !defined(_WIN32) && !defined(VMS)
+#include <setjmp.h>
+#include <fcntl.h>
+
+static TMXR *tmxr_test_mux (DEVICE *dptr, int32 lines, SOCKET **peers)
+{
+TMXR *mp = (TMXR *)calloc (1, sizeof (*mp));
+int32 i;
+int sv[2];
+
+*peers = (SOCKET *)calloc (lines, sizeof (**peers));
+if (mp != NULL)
+    mp->ldsc = (TMLN *)calloc (lines, sizeof (*mp->ldsc));
+if ((mp == NULL) || (mp->ldsc == NULL) || (*peers == NULL)) {
+    if (mp != NULL)
+        free (mp->ldsc);
+    free (mp);
+    free (*peers);
+    return NULL;
+    }
+mp->dptr = dptr;
+mp->ring_sock = INVALID_SOCKET;
+for (i = 0; i < lines; i++) {
+    TMLN *lp = mp->ldsc + i;
+
+    if (socketpair (AF_UNIX, SOCK_STREAM, 0, sv))       /* out of descriptors? */
+        break;                                          /* test with what we have */
+    fcntl (sv[0], F_SETFL, fcntl (sv[0], F_GETFL) | O_NONBLOCK);
+    fcntl (sv[1], F_SETFL, fcntl (sv[1], F_GETFL) | O_NONBLOCK);
+    lp->mp = mp;
+    lp->sock = sv[0];
+    (*peers)[i] = sv[1];
+    lp->conn = TRUE;
+    lp->rcve = 1;
+    lp->notelnet = TRUE;
+    tmxr_init_line (lp);
+    }
+mp->lines = i;
+return mp;
+}
+
+static void tmxr_test_free (TMXR *mp, SOCKET *peers)
+{
+int32 i;
+
+#if defined(TMXR_USE_EPOLL)
+tmxr_rx_poll_free (mp);
+#endif
+for (i = 0; i < mp->lines; i++) {
+    TMLN *lp = mp->ldsc + i;
+
+    if (lp->sock)
+        close (lp->sock);
+    if (peers[i])
+        close (peers[i]);
+    free (lp->txb);
+    free (lp->rxb);
+    free (lp->rbr);
+    }
+free (mp->ldsc);
+free (mp);
+free (peers);
+}
+
+/* Return the bytes received on a line and empty its buffer */
+
+static int32 tmxr_test_take (TMLN *lp, char *buf, int32 size)
+{
+int32 n = lp->rxbpi - lp->rxbpr;
+
+if (n > size)
+    n = size;
+memcpy (buf, &lp->rxb[lp->rxbpr], n);
+lp->rxbpr = lp->rxbpi = 0;
+return n;
+}
+
+static t_stat tmxr_test_poll_rx (DEVICE *dptr)
+{
+const int32 lines = 64;
+SOCKET *peers;
+TMXR *mp = tmxr_test_mux (dptr, lines, &peers);
+char data[3 * TMXR_MAXBUF], buf[3 * TMXR_MAXBUF];
+int32 i, n, got, polls;
+t_stat r = SCPE_OK;
+
+if (mp == NULL)
+    return SCPE_MEM;
+if (mp->lines != lines) {
+    tmxr_test_free (mp, peers);
+    return sim_messagef (SCPE_IERR, "Can't create %d socket pairs\n", (int)lines);
+    }
+tmxr_poll_rx (mp);                                      /* establish the ready list */
+if (send (peers[17], "hello", 5, 0) != 5)
+    r = sim_messagef (SCPE_IERR, "send failed: %s\n", strerror (errno));
+tmxr_poll_rx (mp);
+for (i = 0; (r == SCPE_OK) && (i < lines); i++) {
+    n = tmxr_test_take (mp->ldsc + i, buf, sizeof (buf));
+    if ((i == 17) ? ((n != 5) || memcmp (buf, "hello", 5)) : (n != 0))
+        r = sim_messagef (SCPE_IERR, "Line %d received %d bytes\n", (int)i, (int)n);
+    }
+/* More input than fits in the line buffer must all arrive without
+   any further activity on the socket */
+for (i = 0; i < (int32)sizeof (data); i++)
+    data[i] = (char)(i * 7);
+if ((r == SCPE_OK) && (send (peers[40], data, sizeof (data), 0) != (ssize_t)sizeof (data)))
+    r = sim_messagef (SCPE_IERR, "send failed: %s\n", strerror (errno));
+for (got = polls = 0; (r == SCPE_OK) && (got < (int32)sizeof (data)) && (polls < 20); polls++) {
+    tmxr_poll_rx (mp);
+    n = tmxr_test_take (mp->ldsc + 40, buf, sizeof (buf));
+    if (memcmp (buf, data + got, n))
+        r = sim_messagef (SCPE_IERR, "Data mismatch after %d bytes\n", (int)got);
+    got += n;
+    }
+if ((r == SCPE_OK) && (got != (int32)sizeof (data)))
+    r = sim_messagef (SCPE_IERR, "Received %d of %d bytes in %d polls\n", (int)got, (int)sizeof (data), (int)polls);
+/* A hangup closes the line and the next connection is still seen */
+if (r == SCPE_OK) {
+    close (peers[9]);
+    peers[9] = 0;
+    tmxr_poll_rx (mp);
+    if (mp->ldsc[9].sock != 0)
+        r = sim_messagef (SCPE_IERR, "Line 9 not closed after hangup\n");
+    }
+if ((r == SCPE_OK) && (send (peers[3], "x", 1, 0) != 1))
+    r = sim_messagef (SCPE_IERR, "send failed: %s\n", strerror (errno));
+if (r == SCPE_OK) {
+    tmxr_poll_rx (mp);
+    n = tmxr_test_take (mp->ldsc + 3, buf, sizeof (buf));
+    if ((n != 1) || (buf[0] != 'x'))
+        r = sim_messagef (SCPE_IERR, "Line 3 received %d bytes after line 9 closed\n", (int)n);
+    }
+#if defined(TMXR_USE_EPOLL)
+if ((r == SCPE_OK) && !mp->rx_tracked)
+    r = sim_messagef (SCPE_IERR, "Receive ready list not in use\n");
+#endif
+tmxr_test_free (mp, peers);
+return r;
+}
+
+/* Read what has arrived at a line's peer socket */
+
+static int32 tmxr_test_drain (SOCKET peer, char *buf, int32 size)
+{
+int32 got = 0;
+ssize_t n;
+
+while ((got < size) && ((n = recv (peer, buf + got, size - got, 0)) > 0))
+    got += (int32)n;
+return got;
+}
+
+static t_stat tmxr_test_put_buffer (DEVICE *dptr)
+{
+const int32 size = 8 * TMXR_MAXBUF;
+SOCKET *peers;
+TMXR *mp = tmxr_test_mux (dptr, 3, &peers);
+char *data = (char *)malloc (size), *buf = (char *)malloc (2 * size);
+int32 i, n, iacs;
+size_t sent;
+t_stat r = SCPE_OK;
+
+if ((mp == NULL) || (data == NULL) || (buf == NULL)) {
+    if (mp)
+        tmxr_test_free (mp, peers);
+    free (data);
+    free (buf);
+    return SCPE_MEM;
+    }
+for (i = iacs = 0; i < size; i++) {
+    data[i] = (char)(i * 13);
+    if ((uint8)data[i] == TN_IAC)
+        ++iacs;
+    }
+/* A transfer larger than the default buffer is accepted whole */
+if (SCPE_OK != tmxr_put_buffer_ln (mp->ldsc, (const uint8 *)data, size, &sent))
+    r = sim_messagef (SCPE_IERR, "Bulk transfer of %d bytes stalled after %d\n", (int)size, (int)sent);
+if ((r == SCPE_OK) && (mp->ldsc[0].txbsz <= size))
+    r = sim_messagef (SCPE_IERR, "Transmit buffer did not grow (%d bytes)\n", (int)mp->ldsc[0].txbsz);
+tmxr_send_buffered_data (mp->ldsc);
+n = tmxr_test_drain (peers[0], buf, 2 * size);
+if ((r == SCPE_OK) && ((n != size) || memcmp (buf, data, size)))
+    r = sim_messagef (SCPE_IERR, "Bulk transfer received %d of %d bytes\n", (int)n, (int)size);
+/* Telnet lines double IAC characters */
+mp->ldsc[1].notelnet = FALSE;
+if ((r == SCPE_OK) && (SCPE_OK != tmxr_put_buffer_ln (mp->ldsc + 1, (const uint8 *)data, size, &sent)))
+    r = sim_messagef (SCPE_IERR, "Telnet bulk transfer stalled after %d bytes\n", (int)sent);
+tmxr_send_buffered_data (mp->ldsc + 1);
+n = tmxr_test_drain (peers[1], buf, 2 * size);
+if ((r == SCPE_OK) && (n != size + iacs))
+    r = sim_messagef (SCPE_IERR, "Telnet bulk transfer received %d of %d bytes\n", (int)n, (int)(size + iacs));
+for (i = n = 0; (r == SCPE_OK) && (i < size); i++, n++) {
+    if ((buf[n] != data[i]) ||
+        (((uint8)data[i] == TN_IAC) && ((uint8)buf[++n] != TN_IAC)))
+        r = sim_messagef (SCPE_IERR, "Telnet data mismatch at offset %d\n", (int)i);
+    }
+/* Data which wraps around the end of the buffer goes out in one write */
+mp->ldsc[2].txbpr = mp->ldsc[2].txbpi = TMXR_MAXBUF - 40;
+if ((r == SCPE_OK) && (SCPE_OK != tmxr_put_buffer_ln (mp->ldsc + 2, (const uint8 *)data, 100, &sent)))
+    r = sim_messagef (SCPE_IERR, "Wrapped transfer stalled\n");
+n = (int32)recv (peers[2], buf, 2 * size, 0);
+if ((r == SCPE_OK) && ((n != 100) || memcmp (buf, data, 100) || tmxr_tqln (mp->ldsc + 2)))
+    r = sim_messagef (SCPE_IERR, "Wrapped transfer received %d bytes in one read, %d left\n", (int)n, (int)tmxr_tqln (mp->ldsc + 2));
+/* A line receiving a stream grows its receive buffer */
+if ((r == SCPE_OK) && (send (peers[0], data, size, 0) != size))
+    r = sim_messagef (SCPE_IERR, "send failed: %s\n", strerror (errno));
+for (i = n = 0; (r == SCPE_OK) && (n < size) && (i < 20); i++) {
+    tmxr_poll_rx (mp);
+    n += tmxr_test_take (mp->ldsc, buf + n, size - n);
+    }
+if ((r == SCPE_OK) && ((n != size) || memcmp (buf, data, size)))
+    r = sim_messagef (SCPE_IERR, "Received %d of %d bytes\n", (int)n, (int)size);
+if ((r == SCPE_OK) && (mp->ldsc[0].rxbsz <= TMXR_MAXBUF))
+    r = sim_messagef (SCPE_IERR, "Receive buffer did not grow\n");
+tmxr_test_free (mp, peers);
+free (data);
+free (buf);
+return r;
+}
+
+/* Feed output through the expect rules and check that only the last 
+   character matched, and which rule it matched ("" for none).  The rules 
+   have repeat counts, so a match doesn't schedule a simulator stop. */
+
+static t_stat tmxr_test_expect_feed (EXPECT *exp, const char *data, size_t size, const char *pattern)
+{
+size_t i;
+
+for (i = 0; i < size; i++) {
+    setenv ("_EXPECT_MATCH_PATTERN", "", 1);
+    sim_exp_check (exp, (uint8)data[i]);
+    if ((i < size - 1) && (*getenv ("_EXPECT_MATCH_PATTERN")))
+        return sim_messagef (SCPE_IERR, "Expect rule %s matched early at offset %d of '%s'\n", getenv ("_EXPECT_MATCH_PATTERN"), (int)i, data);
+    }
+if (strcmp (getenv ("_EXPECT_MATCH_PATTERN"), pattern))
+    return sim_messagef (SCPE_IERR, "Expect output '%s' matched '%s' instead of '%s'\n", data, getenv ("_EXPECT_MATCH_PATTERN"), pattern);
+return SCPE_OK;
+}
+
+static t_stat tmxr_test_expect (DEVICE *dptr)
+{
+EXPECT exp;
+char data[64];
+int32 i;
+t_stat r = SCPE_OK;
+
+memset (&exp, 0, sizeof (exp));
+exp.dptr = dptr;
+sim_exp_set (&exp, "\"login:\"", 1000, 0, 0, NULL);
+sim_exp_set (&exp, "\"ogin\"", 1000, 0, 0, NULL);
+sim_exp_set (&exp, "\"Password:\"", 1000, 0, 0, NULL);
+sim_exp_set (&exp, "\"word:\"", 1000, 0, 0, NULL);
+if (r == SCPE_OK)                                       /* shorter rule completes first */
+    r = tmxr_test_expect_feed (&exp, "Welcome\r\nlogin", 14, "\"ogin\"");
+if (r == SCPE_OK)                                       /* matched data isn't seen again */
+    r = tmxr_test_expect_feed (&exp, ":", 1, "");
+if (r == SCPE_OK)                                       /* lower numbered rule wins */
+    r = tmxr_test_expect_feed (&exp, "Password:", 9, "\"Password:\"");
+if (r == SCPE_OK)
+    r = tmxr_test_expect_feed (&exp, "Keyword:", 8, "\"word:\"");
+for (i = 0; (r == SCPE_OK) && (i < 24); i++) {          /* matches which straddle the buffer wrap */
+    memset (data, 'x', i);
+    memcpy (&data[i], "\0Password:", 10);
+    r = tmxr_test_expect_feed (&exp, data, i + 10, "\"Password:\"");
+    }
+#if defined(USE_REGEX)
+sim_exp_set (&exp, "\"([0-9]+) blocks\"", 1000, 0, EXP_TYP_REGEX, NULL);
+sim_exp_set (&exp, "\"(ERR|WARN)[0-9]\"", 1000, 0, EXP_TYP_REGEX, NULL);
+sim_exp_set (&exp, "\"done\"", 1000, 0, EXP_TYP_REGEX | EXP_TYP_REGEX_I, NULL);
+if (r == SCPE_OK)                                       /* NULs are invisible to RegEx rules */
+    r = tmxr_test_expect_feed (&exp, "copied 12\0003 blocks", 18, "\"([0-9]+) blocks\"");
+if ((r == SCPE_OK) && strcmp (getenv ("_EXPECT_MATCH_GROUP_1"), "123"))
+    r = sim_messagef (SCPE_IERR, "Expect RegEx group 1 is '%s' instead of '123'\n", getenv ("_EXPECT_MATCH_GROUP_1"));
+if (r == SCPE_OK)
+    r = tmxr_test_expect_feed (&exp, "WARN WARN7", 10, "\"(ERR|WARN)[0-9]\"");
+if ((r == SCPE_OK) && (strcmp (getenv ("_EXPECT_MATCH_GROUP_0"), "WARN7") || strcmp (getenv ("_EXPECT_MATCH_GROUP_1"), "WARN")))
+    r = sim_messagef (SCPE_IERR, "Expect RegEx groups are '%s' and '%s' instead of 'WARN7' and 'WARN'\n", getenv ("_EXPECT_MATCH_GROUP_0"), getenv ("_EXPECT_MATCH_GROUP_1"));
+if (r == SCPE_OK)
+    r = tmxr_test_expect_feed (&exp, "Copy DONE", 9, "\"done\"");
+if (r == SCPE_OK)                                       /* literal rules still match */
+    r = tmxr_test_expect_feed (&exp, "Password:", 9, "\"Password:\"");
+if (r == SCPE_OK)
+    r = tmxr_test_expect_feed (&exp, "Volume XYZ mounted on drive 3", 29, "");
+sim_exp_set (&exp, "\"Volume [A-Z][A-Z][A-Z]\"", 1000, 0, EXP_TYP_REGEX, NULL);
+if (r == SCPE_OK)                                       /* a new rule sees output which arrived before it */
+    r = tmxr_test_expect_feed (&exp, "\r", 1, "\"Volume [A-Z][A-Z][A-Z]\"");
+if (r == SCPE_OK)                                       /* and goes on matching new output */
+    r = tmxr_test_expect_feed (&exp, "Volume PQR", 10, "\"Volume [A-Z][A-Z][A-Z]\"");
+#endif
+sim_exp_clrall (&exp);
+return r;
+}
+
+static t_stat tmxr_test_benchmark (DEVICE *dptr)
+{
+const char *count = getenv ("SIM_TMXR_BENCHMARK");
+static const int32 sizes[] = {16, 256, 4096};
+SOCKET *peers;
+TMXR *mp;
+char buf[TMXR_MAXBUF];
+uint32 polls, n, start, ms[2];
+int32 s, pass;
+
+if (count == NULL)
+    return SCPE_OK;
+polls = (uint32)strtoul (count, NULL, 10);
+if (polls == 0)
+    polls = 100000;
+sim_printf ("Receive poll cost with one active line (%s):\n",
+#if defined(TMXR_USE_EPOLL)
+            "epoll ready list");
+#else
+            "full scan only");
+#endif
+for (s = 0; s < (int32)(sizeof (sizes) / sizeof (sizes[0])); s++) {
+    mp = tmxr_test_mux (dptr, sizes[s], &peers);
+    if (mp == NULL)
+        return SCPE_MEM;
+    for (pass = 0; pass < 2; pass++) {                  /* ready list, then full scan */
+        tmxr_poll_rx (mp);
+        start = sim_os_msec ();
+        for (n = 0; n < polls; n++) {
+            if (send (peers[0], "x", 1, 0) != 1)
+                break;
+            if (pass)
+                mp->rx_tracked = FALSE;
+            tmxr_poll_rx (mp);
+            tmxr_test_take (mp->ldsc, buf, sizeof (buf));
+            }
+        ms[pass] = sim_os_msec () - start;
+        }
+    sim_printf ("  %5d lines: %8.0f ns/poll ready list, %8.0f ns/poll full scan\n", (int)mp->lines,
+                (ms[0] * 1000000.0) / polls, (ms[1] * 1000000.0) / polls);
+    tmxr_test_free (mp, peers);
+    }
+return SCPE_OK;
+}
+
+t_stat sim_tmxr_test (DEVICE *dptr)
+{
+static t_bool done = FALSE;
+t_stat stat = SCPE_OK;
+SIM_TEST_INIT;
+
+if (done)                                               /* library tests once */
+    return SCPE_OK;
+done = TRUE;
+sim_printf ("Testing %s device sim_tmxr APIs\n", dptr->name);
+
+SIM_TEST(tmxr_test_poll_rx (dptr));
+SIM_TEST(tmxr_test_put_buffer (dptr));
+SIM_TEST(tmxr_test_expect (dptr));
+SIM_TEST(tmxr_test_benchmark (dptr));
+return stat;
+}
+#else
+t_stat sim_tmxr_test (DEVICE *dptr)
+{
+return SCPE_OK;
+}
+#endif
@@ -61,6 +61,7 @@ typedef struct SERPORT *SERHANDLE;
 #define TMXR_V_VALID    15
 #define TMXR_VALID      (1 << TMXR_V_VALID)
 #define TMXR_MAXBUF     256                             /* buffer size */
+#define TMXR_MAXBUF_LIMIT 65536                         /* limit for dynamically grown buffers */
 
 #define TMXR_DTR_DROP_TIME 500                          /* milliseconds to drop DTR for 'pseudo' modem control */
 #define TMXR_MODEM_RING_TIME 3                          /* seconds to wait for DTR for incoming connections */
@@ -205,6 +206,8 @@ struct tmln {
     DEVICE              *dptr;                          /* line specific device */
     EXPECT              expect;                         /* Expect rules */
     SEND                send;                           /* Send input state */
+    SOCKET              rx_poll_sock;                   /* socket registered for readiness events - private */
+    t_bool              rx_ready;                       /* on mux receive ready list - private */
     };
 
 struct tmxr {
@@ -229,6 +232,8 @@ struct tmxr {
     t_bool              port_speed_control;             /* multiplexer programmatically sets port speed */
     t_bool              packet;                         /* Lines are packet oriented */
     t_bool              datagram;                       /* Lines use datagram packet transport */
+    t_bool              rx_tracked;                     /* receive ready list covers all active lines - private */
+    void                *rx_poll;                       /* receive readiness poller - private */
     };
 
 int32 tmxr_poll_conn (TMXR *mp);
@@ -240,6 +245,7 @@ t_stat tmxr_get_packet_ln (TMLN *lp, const uint8 **pbuf, size_t *psize);
 t_stat tmxr_get_packet_ln_ex (TMLN *lp, const uint8 **pbuf, size_t *psize, uint8 frame_byte);
 void tmxr_poll_rx (TMXR *mp);
 t_stat tmxr_putc_ln (TMLN *lp, int32 chr);
+t_stat tmxr_put_buffer_ln (TMLN *lp, const uint8 *buf, size_t size, size_t *psent);
 t_stat tmxr_put_packet_ln (TMLN *lp, const uint8 *buf, size_t size);
 t_stat tmxr_put_packet_ln_ex (TMLN *lp, const uint8 *buf, size_t size, uint8 frame_byte);
 void tmxr_poll_tx (TMXR *mp);
@@ -318,6 +324,7 @@ void _tmxr_debug (uint32 dbits, TMLN *lp, const char *msg, char *buf, int bufsiz
 #define tmxr_debug_connect(mp, msg) do {if (sim_deb && (mp)->dptr && (TMXR_DBG_CON & (mp)->dptr->dctrl)) sim_debug (TMXR_DBG_CON, mp->dptr, "%s\n", (msg)); } while (0)
 #define tmxr_debug_connect_line(lp, msg) do {if (sim_deb && (lp)->mp && (lp)->mp->dptr && (TMXR_DBG_CON & (lp)->mp->dptr->dctrl)) sim_debug (TMXR_DBG_CON, (lp)->mp->dptr, "Ln%d:%s\n", (int)((lp)-(lp)->mp->ldsc), (msg)); } while (0)
 t_stat tmxr_add_debug (DEVICE *dptr);
+t_stat sim_tmxr_test (DEVICE *dptr);
 
 #if defined(SIM_ASYNCH_MUX) && !defined(SIM_ASYNCH_IO)
 #undef SIM_ASYNCH_MUX
@@ -49,6 +49,564 @@ t_stat vid_show (FILE* st, DEVICE *dptr,  UNIT* uptr, int32 val, CONST char* des
 return vid_show_video (st, uptr, val, desc);
 }
 
+/* Frame buffer expansion
+
+   Video devices keep their frame buffers in the format of the emulated
+   hardware and convert each changed scan line to the 32 bit pixels that
+   vid_draw takes.  These routines do that conversion for the common
+   formats.  Where SSE2 is available (all x86_64 hosts) the 1 bit and
+   plane select conversions produce four pixels per operation; the
+   indexed conversions are palette lookups, which don't vectorize
+   without a gather, and are simply unrolled. */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define VID_USE_SSE2    1
+#endif
+
+/* 1 bit per pixel, packed 32 pixels per longword with the leftmost pixel
+   in the least significant bit.  palette[0] is used for clear bits and
+   palette[1] for set bits. */
+
+void vid_expand_1bpp (uint32 *dst, const uint32 *src, uint32 pixels, const uint32 *palette)
+{
+uint32 bg = palette[0];
+uint32 diff = palette[0] ^ palette[1];
+uint32 bits, i = 0, j;
+#if defined(VID_USE_SSE2)
+const __m128i sel = _mm_set_epi32 (8, 4, 2, 1);
+const __m128i vbg = _mm_set1_epi32 ((int)bg);
+const __m128i vdiff = _mm_set1_epi32 ((int)diff);
+__m128i m;
+
+for (; i + 32 <= pixels; i += 32) {
+    bits = *src++;
+    for (j = 0; j < 32; j += 4, bits >>= 4) {
+        m = _mm_and_si128 (_mm_set1_epi32 ((int)(bits & 0xF)), sel);
+        m = _mm_cmpeq_epi32 (m, sel);                   /* all ones where bit set */
+        _mm_storeu_si128 ((__m128i *)&dst[i + j], _mm_xor_si128 (vbg, _mm_and_si128 (m, vdiff)));
+        }
+    }
+#else
+for (; i + 32 <= pixels; i += 32) {
+    bits = *src++;
+    for (j = 0; j < 32; j++, bits >>= 1)
+        dst[i + j] = bg ^ (diff & (0 - (bits & 1)));
+    }
+#endif
+if (i < pixels) {                                       /* partial longword */
+    bits = *src;
+    for (; i < pixels; i++, bits >>= 1)
+        dst[i] = bg ^ (diff & (0 - (bits & 1)));
+    }
+}
+
+/* 8 bits per pixel, each an index into a 256 entry palette */
+
+void vid_expand_8bpp (uint32 *dst, const uint8 *src, uint32 pixels, const uint32 *palette)
+{
+uint32 i = 0;
+
+for (; i + 4 <= pixels; i += 4) {
+    dst[i] = palette[src[i]];
+    dst[i + 1] = palette[src[i + 1]];
+    dst[i + 2] = palette[src[i + 2]];
+    dst[i + 3] = palette[src[i + 3]];
+    }
+for (; i < pixels; i++)
+    dst[i] = palette[src[i]];
+}
+
+/* One longword per pixel holding a palette index in the bits selected
+   by mask (4 or 8 bit plane frame buffers) */
+
+void vid_expand_index (uint32 *dst, const uint32 *src, uint32 pixels, uint32 mask, const uint32 *palette)
+{
+uint32 i = 0;
+
+for (; i + 4 <= pixels; i += 4) {
+    dst[i] = palette[src[i] & mask];
+    dst[i + 1] = palette[src[i + 1] & mask];
+    dst[i + 2] = palette[src[i + 2] & mask];
+    dst[i + 3] = palette[src[i + 3] & mask];
+    }
+for (; i < pixels; i++)
+    dst[i] = palette[src[i] & mask];
+}
+
+/* One longword per pixel, displaying a single plane: fg where any of the
+   bits in plane are set, otherwise bg */
+
+void vid_expand_plane (uint32 *dst, const uint32 *src, uint32 pixels, uint32 plane, uint32 fg, uint32 bg)
+{
+uint32 i = 0;
+#if defined(VID_USE_SSE2)
+const __m128i vplane = _mm_set1_epi32 ((int)plane);
+const __m128i vfg = _mm_set1_epi32 ((int)fg);
+const __m128i vdiff = _mm_set1_epi32 ((int)(fg ^ bg));
+const __m128i zero = _mm_setzero_si128 ();
+__m128i m;
+
+for (; i + 4 <= pixels; i += 4) {
+    m = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *)&src[i]), vplane);
+    m = _mm_cmpeq_epi32 (m, zero);                      /* all ones where clear */
+    _mm_storeu_si128 ((__m128i *)&dst[i], _mm_xor_si128 (vfg, _mm_and_si128 (m, vdiff)));
+    }
+#endif
+for (; i < pixels; i++)
+    dst[i] = (src[i] & plane) ? fg : bg;
+}
+
+/* Clip a vid_draw rectangle to a width by height display.  On return
+   x, y, w and h describe the visible part and *buf points at its first
+   pixel; source rows are still the original w pixels apart.  Returns
+   FALSE if nothing is visible. */
+
+static t_bool vid_clip (DEVICE *dptr, int32 width, int32 height, int32 *x, int32 *y, int32 *w, int32 *h, uint32 **buf)
+{
+int32 stride = *w;
+int32 x1 = *x + *w;
+int32 y1 = *y + *h;
+int32 x0 = (*x < 0) ? 0 : *x;
+int32 y0 = (*y < 0) ? 0 : *y;
+
+if (x1 > width)
+    x1 = width;
+if (y1 > height)
+    y1 = height;
+if ((x0 == *x) && (y0 == *y) && (x1 - x0 == *w) && (y1 - y0 == *h))
+    return (*w > 0) && (*h > 0);                        /* entirely visible or empty */
+sim_debug (SIM_VID_DBG_VIDEO, dptr, "vid_draw(%d, %d, %d, %d) clipped to %dx%d display\n", *x, *y, *w, *h, width, height);
+if ((x1 <= x0) || (y1 <= y0))
+    return FALSE;
+*buf += (y0 - *y) * stride + (x0 - *x);
+*x = x0;
+*y = y0;
+*w = x1 - x0;
+*h = y1 - y0;
+return TRUE;
+}
+
+/* Headless video
+
+   Without a window the vid_* routines keep the display image in memory.
+   SCREENSHOT saves it, and SET VIDEO STREAM writes refreshed frames to
+   a file or pipe, raw or as PNG images, at a limited rate.  This is
+   always used when the simulator is built without SDL.  When it is built
+   with SDL, SET VIDEO HEADLESS selects it and SDL is then never
+   initialized. */
+
+#if defined(HAVE_LIBPNG)
+#include <png.h>
+#endif
+#if defined(_WIN32)
+#define VID_POPEN(cmd)  _popen (cmd, "wb")
+#define VID_PCLOSE(f)   _pclose (f)
+#elif !defined(VMS)
+#define VID_POPEN(cmd)  popen (cmd, "w")
+#define VID_PCLOSE(f)   pclose (f)
+#endif
+
+#define VID_STREAM_RAW  0                               /* B, G, R, A bytes per pixel */
+#define VID_STREAM_PNG  1                               /* one PNG image per frame */
+
+#if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
+static t_bool vid_headless = FALSE;                     /* headless mode selected */
+#else
+static t_bool vid_headless = TRUE;                      /* no other choice */
+#endif
+static uint32 *vid_hl_fb = NULL;                        /* display image */
+static int32 vid_hl_width;
+static int32 vid_hl_height;
+static DEVICE *vid_hl_dev;
+static t_bool vid_hl_changed;                           /* drawn since last frame streamed */
+static FILE *vid_stream = NULL;                         /* frame stream */
+static t_bool vid_stream_pipe;                          /* stream is a pipe */
+static char vid_stream_name[CBUFSIZE];
+static int32 vid_stream_format = VID_STREAM_RAW;
+static uint32 vid_stream_rate = 10;                     /* max frames per second, 0 = every refresh */
+static uint32 vid_stream_last;                          /* sim_os_msec of last frame */
+static t_uint64 vid_stream_frames;                      /* frames written */
+
+static t_stat vid_headless_stream_close (void);
+
+static t_stat vid_headless_open (DEVICE *dptr, uint32 width, uint32 height)
+{
+if (vid_active)
+    return SCPE_OK;
+vid_hl_fb = (uint32 *)calloc ((size_t)width * height, sizeof (*vid_hl_fb));
+if (vid_hl_fb == NULL)
+    return SCPE_MEM;
+vid_hl_width = (int32)width;
+vid_hl_height = (int32)height;
+vid_hl_dev = dptr;
+vid_hl_changed = TRUE;
+vid_active = TRUE;
+sim_debug (SIM_VID_DBG_VIDEO, vid_hl_dev, "vid_open() - Headless %dx%d\n", vid_hl_width, vid_hl_height);
+return SCPE_OK;
+}
+
+static uint32 vid_headless_map_rgb (uint8 r, uint8 g, uint8 b)
+{
+return 0xFF000000 | ((uint32)r << 16) | ((uint32)g << 8) | b;
+}
+
+static void vid_headless_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf)
+{
+int32 i;
+int32 stride = w;
+
+sim_debug (SIM_VID_DBG_VIDEO, vid_hl_dev, "vid_draw(%d, %d, %d, %d)\n", x, y, w, h);
+if ((vid_hl_fb == NULL) ||
+    (!vid_clip (vid_hl_dev, vid_hl_width, vid_hl_height, &x, &y, &w, &h, &buf)))
+    return;
+for (i = 0; i < h; i++)
+    memcpy (vid_hl_fb + ((i + y) * vid_hl_width) + x, buf + stride*i, w*sizeof(*buf));
+vid_hl_changed = TRUE;
+}
+
+#if defined(HAVE_LIBPNG)
+/* Write the display image as a PNG (24 bit RGB) */
+
+static t_stat vid_headless_write_png (FILE *f, int level)
+{
+png_structp png;
+png_infop info;
+uint8 *row;
+uint32 pix;
+int32 x, y;
+
+row = (uint8 *)malloc (vid_hl_width * 3);
+png = png_create_write_struct (PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+info = png ? png_create_info_struct (png) : NULL;
+if ((row == NULL) || (info == NULL)) {
+    png_destroy_write_struct (&png, NULL);
+    free (row);
+    return SCPE_MEM;
+    }
+if (setjmp (png_jmpbuf (png))) {
+    png_destroy_write_struct (&png, &info);
+    free (row);
+    return SCPE_IOERR;
+    }
+png_init_io (png, f);
+if (level >= 0)
+    png_set_compression_level (png, level);
+png_set_IHDR (png, info, vid_hl_width, vid_hl_height, 8, PNG_COLOR_TYPE_RGB,
+              PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+png_write_info (png, info);
+for (y = 0; y < vid_hl_height; y++) {
+    for (x = 0; x < vid_hl_width; x++) {
+        pix = vid_hl_fb[y * vid_hl_width + x];
+        row[x * 3] = (uint8)(pix >> 16);
+        row[x * 3 + 1] = (uint8)(pix >> 8);
+        row[x * 3 + 2] = (uint8)pix;
+        }
+    png_write_row (png, row);
+    }
+png_write_end (png, NULL);
+png_destroy_write_struct (&png, &info);
+free (row);
+return SCPE_OK;
+}
+#endif
+
+/* Write the display image as a BMP (24 bit, bottom up) */
+
+static t_stat vid_headless_write_bmp (FILE *f)
+{
+uint32 stride = (vid_hl_width * 3 + 3) & ~3;
+uint32 size = 54 + stride * vid_hl_height;
+uint8 hdr[54];
+uint8 *row;
+uint32 pix;
+int32 x, y;
+
+memset (hdr, 0, sizeof (hdr));
+hdr[0] = 'B';
+hdr[1] = 'M';
+#define BMP_PUT32(o, v) hdr[o] = (uint8)(v); hdr[o+1] = (uint8)((v) >> 8); hdr[o+2] = (uint8)((v) >> 16); hdr[o+3] = (uint8)((v) >> 24)
+BMP_PUT32 (2, size);                                    /* file size */
+BMP_PUT32 (10, 54);                                     /* pixel data offset */
+BMP_PUT32 (14, 40);                                     /* info header size */
+BMP_PUT32 (18, (uint32)vid_hl_width);
+BMP_PUT32 (22, (uint32)vid_hl_height);
+hdr[26] = 1;                                            /* planes */
+hdr[28] = 24;                                           /* bits per pixel */
+BMP_PUT32 (34, stride * vid_hl_height);                 /* image size */
+#undef BMP_PUT32
+row = (uint8 *)calloc (stride, 1);
+if (row == NULL)
+    return SCPE_MEM;
+if (fwrite (hdr, sizeof (hdr), 1, f) != 1) {
+    free (row);
+    return SCPE_IOERR;
+    }
+for (y = vid_hl_height - 1; y >= 0; y--) {
+    for (x = 0; x < vid_hl_width; x++) {
+        pix = vid_hl_fb[y * vid_hl_width + x];
+        row[x * 3] = (uint8)pix;
+        row[x * 3 + 1] = (uint8)(pix >> 8);
+        row[x * 3 + 2] = (uint8)(pix >> 16);
+        }
+    if (fwrite (row, stride, 1, f) != 1) {
+        free (row);
+        return SCPE_IOERR;
+        }
+    }
+free (row);
+return SCPE_OK;
+}
+
+static void vid_headless_write_frame (void)
+{
+t_stat r = SCPE_OK;
+uint8 *row;
+uint32 pix;
+int32 x, y;
+
+if (vid_stream_format == VID_STREAM_PNG) {
+#if defined(HAVE_LIBPNG)
+    r = vid_headless_write_png (vid_stream, 1);         /* fast compression */
+#endif
+    }
+else {
+    if (sim_end) {                                      /* little endian? */
+        if (fwrite (vid_hl_fb, sizeof (*vid_hl_fb) * vid_hl_width, vid_hl_height, vid_stream) != (size_t)vid_hl_height)
+            r = SCPE_IOERR;
+        }
+    else {
+        row = (uint8 *)malloc (vid_hl_width * 4);
+        if (row == NULL)
+            r = SCPE_MEM;
+        for (y = 0; (y < vid_hl_height) && (r == SCPE_OK); y++) {
+            for (x = 0; x < vid_hl_width; x++) {
+                pix = vid_hl_fb[y * vid_hl_width + x];
+                row[x * 4] = (uint8)pix;
+                row[x * 4 + 1] = (uint8)(pix >> 8);
+                row[x * 4 + 2] = (uint8)(pix >> 16);
+                row[x * 4 + 3] = (uint8)(pix >> 24);
+                }
+            if (fwrite (row, vid_hl_width * 4, 1, vid_stream) != 1)
+                r = SCPE_IOERR;
+            }
+        free (row);
+        }
+    }
+if ((r == SCPE_OK) && fflush (vid_stream))
+    r = SCPE_IOERR;
+if (r != SCPE_OK) {
+    sim_printf ("Video stream %s: %s, stream closed\n", vid_stream_name, sim_error_text (r));
+    vid_headless_stream_close ();
+    return;
+    }
+sim_debug (SIM_VID_DBG_VIDEO, vid_hl_dev, "vid_refresh() - Streamed frame %" LL_FMT "u\n", vid_stream_frames);
+vid_stream_last = sim_os_msec ();
+vid_hl_changed = FALSE;
+++vid_stream_frames;
+}
+
+static void vid_headless_refresh (void)
+{
+if ((vid_stream == NULL) || (!vid_hl_changed))
+    return;
+if ((vid_stream_rate != 0) &&                           /* rate limited? */
+    ((sim_os_msec () - vid_stream_last) < (1000 / vid_stream_rate)))
+    return;                                             /* sent at next refresh or close */
+vid_headless_write_frame ();
+}
+
+static t_stat vid_headless_close (void)
+{
+if (!vid_active)
+    return SCPE_OK;
+sim_debug (SIM_VID_DBG_VIDEO, vid_hl_dev, "vid_close()\n");
+if ((vid_stream != NULL) && vid_hl_changed)             /* last frame held back? */
+    vid_headless_write_frame ();
+vid_active = FALSE;
+free (vid_hl_fb);
+vid_hl_fb = NULL;
+vid_hl_dev = NULL;
+return SCPE_OK;
+}
+
+static t_stat vid_headless_screenshot (const char *filename)
+{
+char *fullname;
+FILE *f;
+t_stat r;
+
+if (!vid_active) {
+    sim_printf ("No video display is active\n");
+    return SCPE_UDIS | SCPE_NOMESSAGE;
+    }
+fullname = (char *)malloc (strlen (filename) + 5);
+if (fullname == NULL)
+    return SCPE_MEM;
+#if defined(HAVE_LIBPNG)
+if (!match_ext (filename, "bmp"))
+    sprintf (fullname, "%s%s", filename, match_ext (filename, "png") ? "" : ".png");
+else
+    sprintf (fullname, "%s", filename);
+#else
+sprintf (fullname, "%s%s", filename, match_ext (filename, "bmp") ? "" : ".bmp");
+#endif
+f = sim_fopen (fullname, "wb");
+if (f == NULL)
+    r = SCPE_OPENERR;
+else {
+#if defined(HAVE_LIBPNG)
+    if (!match_ext (fullname, "bmp"))
+        r = vid_headless_write_png (f, -1);
+    else
+#endif
+        r = vid_headless_write_bmp (f);
+    if (fclose (f) && (r == SCPE_OK))
+        r = SCPE_IOERR;
+    }
+if (r != SCPE_OK) {
+    sim_printf ("Error saving screenshot to %s: %s\n", fullname, sim_error_text (r));
+    free (fullname);
+    return r | SCPE_NOMESSAGE;
+    }
+if (!sim_quiet)
+    sim_printf ("Screenshot saved to %s\n", fullname);
+free (fullname);
+return SCPE_OK;
+}
+
+static void vid_headless_show (FILE *st)
+{
+if (vid_active)
+    fprintf (st, "Headless video: %dx%d display%s%s\n", vid_hl_width, vid_hl_height,
+                 vid_hl_dev ? " for " : "", vid_hl_dev ? sim_dname (vid_hl_dev) : "");
+else
+    fprintf (st, "Headless video: no display active\n");
+if (vid_stream == NULL) {
+    fprintf (st, "Not streaming frames\n");
+    return;
+    }
+fprintf (st, "Streaming %s frames to %s%s", (vid_stream_format == VID_STREAM_PNG) ? "PNG" : "raw",
+             vid_stream_pipe ? "|" : "", vid_stream_name);
+if (vid_stream_rate)
+    fprintf (st, ", at most %u per second", vid_stream_rate);
+fprintf (st, ", %" LL_FMT "u frames written\n", vid_stream_frames);
+}
+
+static t_stat vid_headless_stream_close (void)
+{
+int stat = 0;
+
+if (vid_stream == NULL)
+    return SCPE_OK;
+if (vid_active && vid_hl_changed) {                     /* last frame held back? */
+    vid_hl_changed = FALSE;
+    vid_headless_write_frame ();
+    if (vid_stream == NULL)                             /* closed by write error? */
+        return SCPE_OK;
+    }
+#if defined(VID_POPEN)
+if (vid_stream_pipe)
+    stat = VID_PCLOSE (vid_stream);
+else
+#endif
+    stat = fclose (vid_stream);
+vid_stream = NULL;
+return stat ? SCPE_IOERR : SCPE_OK;
+}
+
+static t_stat vid_headless_stream_open (const char *name)
+{
+FILE *f;
+t_bool pipe = (*name == '|');
+
+if (pipe)
+    while (isspace (*++name))
+        continue;
+if (*name == 0)
+    return SCPE_2FARG;
+if (pipe) {
+#if defined(VID_POPEN)
+    f = VID_POPEN (name);
+#else
+    return sim_messagef (SCPE_NOFNC, "Video streaming to a pipe is not available on this host\n");
+#endif
+    }
+else
+    f = sim_fopen (name, "wb");
+if (f == NULL)
+    return sim_messagef (SCPE_OPENERR, "Can't open video stream %s%s: %s\n", pipe ? "|" : "", name, strerror (errno));
+vid_headless_stream_close ();
+vid_stream = f;
+vid_stream_pipe = pipe;
+strlcpy (vid_stream_name, name, sizeof (vid_stream_name));
+vid_stream_frames = 0;
+vid_stream_last = sim_os_msec () - 1000;
+vid_hl_changed = TRUE;                                  /* send the current image */
+return SCPE_OK;
+}
+
+/* SET VIDEO command */
+
+t_stat vid_set (int32 flag, CONST char *cptr)
+{
+char *cvptr, gbuf[CBUFSIZE];
+t_stat r = SCPE_OK;
+
+if ((cptr == NULL) || (*cptr == 0))
+    return SCPE_2FARG;
+while ((*cptr != 0) && (r == SCPE_OK)) {                /* do all mods */
+    if (sim_strncasecmp (cptr, "STREAM=", 7) == 0)      /* rest of line names the stream */
+        return vid_headless_stream_open (cptr + 7);
+    cptr = get_glyph_nc (cptr, gbuf, ',');              /* get modifier */
+    if ((cvptr = strchr (gbuf, '=')))                   /* = value? */
+        *cvptr++ = 0;
+    get_glyph (gbuf, gbuf, 0);                          /* modifier to UC */
+    if ((!strcmp (gbuf, "HEADLESS")) || (!strcmp (gbuf, "WINDOW"))) {
+        t_bool headless = (gbuf[0] == 'H');
+
+        if (cvptr)
+            return SCPE_ARG;
+#if !(defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL))
+        if (!headless)
+            return sim_messagef (SCPE_NOFNC, "Video windows are not available, this simulator was built without SDL\n");
+#endif
+        if ((headless != vid_headless) && vid_active)
+            return sim_messagef (SCPE_ALATT, "Video display is open, disable the video device before changing modes\n");
+        vid_headless = headless;
+        }
+    else if (!strcmp (gbuf, "FORMAT")) {
+        if ((cvptr == NULL) || (*cvptr == 0))
+            return SCPE_MISVAL;
+        get_glyph (cvptr, gbuf, 0);
+        if (!strcmp (gbuf, "RAW"))
+            vid_stream_format = VID_STREAM_RAW;
+        else if (!strcmp (gbuf, "PNG")) {
+#if defined(HAVE_LIBPNG)
+            vid_stream_format = VID_STREAM_PNG;
+#else
+            return sim_messagef (SCPE_NOFNC, "PNG support is not available, this simulator was built without libpng\n");
+#endif
+            }
+        else
+            return SCPE_ARG;
+        }
+    else if (!strcmp (gbuf, "RATE")) {
+        if ((cvptr == NULL) || (*cvptr == 0))
+            return SCPE_MISVAL;
+        vid_stream_rate = (uint32)get_uint (cvptr, 10, 1000, &r);
+        }
+    else if (!strcmp (gbuf, "NOSTREAM")) {
+        if (cvptr)
+            return SCPE_ARG;
+        r = vid_headless_stream_close ();
+        }
+    else
+        return SCPE_NOPARAM;
+    }
+return r;
+}
+
 #if defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)
 
 char vid_release_key[64] = "Ctrl-Right-Shift";
@@ -271,7 +829,7 @@ static int SDL_SavePNG_RW(SDL_Surface *surface, SDL_RWops *dst, int freedst)
 #define EVENT_CLOSE      2                              /* close event for SDL */
 #define EVENT_CURSOR     3                              /* new cursor for SDL */
 #define EVENT_WARP       4                              /* warp mouse position for SDL */
-#define EVENT_DRAW       5                              /* draw/blit region for SDL */
+#define EVENT_DRAW       5                              /* (unused) */
 #define EVENT_SHOW       6                              /* show SDL capabilities */
 #define EVENT_OPEN       7                              /* vid_open request */
 #define EVENT_EXIT       8                              /* program exit */
@@ -365,6 +923,12 @@ SDL_PixelFormat *vid_format;
 uint32 vid_windowID;
 #endif
 SDL_Thread *vid_thread_handle = NULL;                   /* event thread handle */
+#if SDL_MAJOR_VERSION != 1
+static uint32 *vid_fb = NULL;                           /* frame buffer, written by vid_draw */
+static SDL_mutex *vid_fb_lock = NULL;                   /* protects vid_fb and vid_dirty */
+static SDL_Rect vid_dirty;                              /* changed region of vid_fb (w == 0 if none) */
+static volatile t_bool vid_refresh_pending = FALSE;     /* EVENT_REDRAW queued and not yet handled */
+#endif
 SDL_Cursor *vid_cursor = NULL;                          /* current cursor */
 t_bool vid_cursor_visible = FALSE;                      /* cursor visibility state */
 KEY_EVENT_QUEUE vid_key_events;                         /* keyboard events */
@@ -511,6 +1075,8 @@ return SCPE_OK;
 
 t_stat vid_open (DEVICE *dptr, const char *title, uint32 width, uint32 height, int flags)
 {
+if (vid_headless)
+    return vid_headless_open (dptr, width, height);
 if (!vid_active) {
     int wait_count = 0;
     t_stat stat;
@@ -535,6 +1101,19 @@ if (!vid_active) {
     vid_mouse_events.count = 0;
     vid_mouse_events.sem = SDL_CreateSemaphore (1);
 
+#if SDL_MAJOR_VERSION != 1
+    vid_fb = (uint32 *)calloc ((size_t)width * height, sizeof (*vid_fb));
+    if (vid_fb == NULL) {
+        vid_active = FALSE;
+        return SCPE_MEM;
+        }
+    vid_fb_lock = SDL_CreateMutex ();
+    vid_dirty.x = vid_dirty.y = 0;                      /* first refresh loads it all */
+    vid_dirty.w = width;
+    vid_dirty.h = height;
+    vid_refresh_pending = FALSE;
+#endif
+
     vid_dev = dptr;
 
     stat = vid_create_window ();
@@ -548,6 +1127,8 @@ return SCPE_OK;
 
 t_stat vid_close (void)
 {
+if (vid_headless)
+    return vid_headless_close ();
 if (vid_active) {
     SDL_Event user_event;
     int status;
@@ -578,12 +1159,22 @@ if (vid_active) {
         SDL_DestroySemaphore(vid_key_events.sem);
         vid_key_events.sem = NULL;
         }
+#if SDL_MAJOR_VERSION != 1
+    if (vid_fb_lock) {
+        SDL_DestroyMutex (vid_fb_lock);
+        vid_fb_lock = NULL;
+        }
+    free (vid_fb);
+    vid_fb = NULL;
+#endif
     }
 return SCPE_OK;
 }
 
 t_stat vid_poll_kb (SIM_KEY_EVENT *ev)
 {
+if (vid_headless)
+    return SCPE_EOF;
 if (SDL_SemTryWait (vid_key_events.sem) == 0) {         /* get lock */
     if (vid_key_events.count > 0) {                     /* events in queue? */
         *ev = vid_key_events.events[vid_key_events.head++];
@@ -603,6 +1194,8 @@ t_stat vid_poll_mouse (SIM_MOUSE_EVENT *ev)
 t_stat stat = SCPE_EOF;
 SIM_MOUSE_EVENT *nev;
 
+if (vid_headless)
+    return SCPE_EOF;
 if (SDL_SemTryWait (vid_mouse_events.sem) == 0) {
     if (vid_mouse_events.count > 0) {
         stat = SCPE_OK;
@@ -632,6 +1225,8 @@ return stat;
 
 uint32 vid_map_rgb (uint8 r, uint8 g, uint8 b)
 {
+if (vid_headless)
+    return vid_headless_map_rgb (r, g, b);
 #if SDL_MAJOR_VERSION == 1
 return SDL_MapRGB (vid_image->format, r, g, b);
 #else
@@ -645,6 +1240,10 @@ void vid_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf)
 int32 i;
 uint32* pixels;
 
+if (vid_headless) {
+    vid_headless_draw (x, y, w, h, buf);
+    return;
+    }
 sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_draw(%d, %d, %d, %d)\n", x, y, w, h);
 
 pixels = (uint32 *)vid_image->pixels;
@@ -652,45 +1251,55 @@ pixels = (uint32 *)vid_image->pixels;
 for (i = 0; i < h; i++)
     memcpy (pixels + ((i + y) * vid_width) + x, buf + w*i, w*sizeof(*pixels));
 #else
-SDL_Event user_event;
-SDL_Rect *vid_dst;
-uint32 *vid_data;
+int32 i, x2, y2;
+int32 stride = w;
 
-sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_draw(%d, %d, %d, %d)\n", x, y, w, h);
-
-vid_dst = (SDL_Rect *)malloc (sizeof(*vid_dst));
-if (!vid_dst) {
-    sim_printf ("%s: vid_draw() memory allocation error\n", vid_dev ? sim_dname(vid_dev) : "Video Device");
+if (vid_headless) {
+    vid_headless_draw (x, y, w, h, buf);
     return;
     }
-vid_dst->x = x;
-vid_dst->y = y;
-vid_dst->w = w;
-vid_dst->h = h;
-vid_data = (uint32 *)malloc (w*h*sizeof(*buf));
-if (!vid_data) {
-    sim_printf ("%s: vid_draw() memory allocation error\n", vid_dev ? sim_dname(vid_dev) : "Video Device");
-    free (vid_dst);
+sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_draw(%d, %d, %d, %d)\n", x, y, w, h);
+
+if ((vid_fb == NULL) ||
+    (!vid_clip (vid_dev, vid_width, vid_height, &x, &y, &w, &h, &buf)))
     return;
+/* Copy into the shared frame buffer and widen the dirty region.  The
+   video thread uploads the dirty region to the texture once per refresh. */
+SDL_LockMutex (vid_fb_lock);
+for (i = 0; i < h; i++)
+    memcpy (vid_fb + ((i + y) * vid_width) + x, buf + stride*i, w*sizeof(*buf));
+if (vid_dirty.w == 0) {
+    vid_dirty.x = x;
+    vid_dirty.y = y;
+    vid_dirty.w = w;
+    vid_dirty.h = h;
     }
-memcpy (vid_data, buf, w*h*sizeof(*buf));
-user_event.type = SDL_USEREVENT;
-user_event.user.code = EVENT_DRAW;
-user_event.user.data1 = (void *)vid_dst;
-user_event.user.data2 = (void *)vid_data;
-if (SDL_PushEvent (&user_event) < 0) {
-    sim_printf ("%s: vid_draw() SDL_PushEvent error: %s\n", vid_dev ? sim_dname(vid_dev) : "Video Device", SDL_GetError());
-    free (vid_dst);
-    free (vid_data);
+else {
+    x2 = vid_dirty.x + vid_dirty.w;
+    y2 = vid_dirty.y + vid_dirty.h;
+    if (x < vid_dirty.x)
+        vid_dirty.x = x;
+    if (y < vid_dirty.y)
+        vid_dirty.y = y;
+    if (x + w > x2)
+        x2 = x + w;
+    if (y + h > y2)
+        y2 = y + h;
+    vid_dirty.w = x2 - vid_dirty.x;
+    vid_dirty.h = y2 - vid_dirty.y;
     }
+SDL_UnlockMutex (vid_fb_lock);
 #endif
 }
 
 t_stat vid_set_cursor (t_bool visible, uint32 width, uint32 height, uint8 *data, uint8 *mask, uint32 hot_x, uint32 hot_y)
 {
-SDL_Cursor *cursor = SDL_CreateCursor (data, mask, width, height, hot_x, hot_y);
+SDL_Cursor *cursor;
 SDL_Event user_event;
 
+if (vid_headless)
+    return SCPE_OK;
+cursor = SDL_CreateCursor (data, mask, width, height, hot_x, hot_y);
 sim_debug (SIM_VID_DBG_CURSOR, vid_dev, "vid_set_cursor(%s, %d, %d) Setting New Cursor\n", visible ? "visible" : "invisible", width, height);
 if (sim_deb) {
     uint32 i, j;
@@ -726,6 +1335,11 @@ void vid_set_cursor_position (int32 x, int32 y)
 int32 x_delta = vid_cursor_x - x;
 int32 y_delta = vid_cursor_y - y;
 
+if (vid_headless) {
+    vid_cursor_x = x;
+    vid_cursor_y = y;
+    return;
+    }
 if (vid_flags & SIM_VID_INPUTCAPTURED)
     return;
 
@@ -773,6 +1387,17 @@ void vid_refresh (void)
 {
 SDL_Event user_event;
 
+if (vid_headless) {
+    vid_headless_refresh ();
+    return;
+    }
+#if SDL_MAJOR_VERSION != 1
+if (vid_refresh_pending) {                              /* one already queued? */
+    sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_refresh() - Refresh Already Pending\n");
+    return;
+    }
+vid_refresh_pending = TRUE;
+#endif
 sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "vid_refresh() - Queueing Refresh Event\n");
 
 user_event.type = SDL_USEREVENT;
@@ -780,8 +1405,12 @@ user_event.user.code = EVENT_REDRAW;
 user_event.user.data1 = NULL;
 user_event.user.data2 = NULL;
 
-if (SDL_PushEvent (&user_event) < 0)
+if (SDL_PushEvent (&user_event) < 0) {
     sim_printf ("%s: vid_refresh() SDL_PushEvent error: %s\n", sim_dname(vid_dev), SDL_GetError());
+#if SDL_MAJOR_VERSION != 1
+    vid_refresh_pending = FALSE;
+#endif
+    }
 }
 
 int vid_map_key (int key)
@@ -1422,32 +2051,23 @@ SDL_WarpMouseInWindow (NULL, vid_cursor_x, vid_cursor_y);
 SDL_PumpEvents ();
 }
 
-void vid_draw_region (SDL_UserEvent *event)
-{
-SDL_Rect *vid_dst = (SDL_Rect *)event->data1;
-uint32 *buf = (uint32 *)event->data2;
-
-sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "Draw Region Event: (%d,%d,%d,%d)\n", vid_dst->x, vid_dst->x, vid_dst->w, vid_dst->h);
-
-#if SDL_MAJOR_VERSION == 1
-if (1) {
-    int32 i;
-    uint32* pixels;
-
-    pixels = (uint32 *)vid_image->pixels;
+#if SDL_MAJOR_VERSION != 1
+/* Load the region of the frame buffer changed since the last refresh
+   into the texture with a single upload */
 
-    for (i = 0; i < vid_dst->h; i++)
-        memcpy (pixels + ((i + vid_dst->y) * vid_width) + vid_dst->x, buf + vid_dst->w*i, vid_dst->w*sizeof(*pixels));
+void vid_update_texture (void)
+{
+vid_refresh_pending = FALSE;                            /* later draws need another refresh */
+SDL_LockMutex (vid_fb_lock);
+if (vid_dirty.w != 0) {
+    sim_debug (SIM_VID_DBG_VIDEO, vid_dev, "Texture Update: (%d,%d,%d,%d)\n", vid_dirty.x, vid_dirty.y, vid_dirty.w, vid_dirty.h);
+    if (SDL_UpdateTexture (vid_texture, &vid_dirty, vid_fb + (vid_dirty.y * vid_width) + vid_dirty.x, vid_width*sizeof(*vid_fb)))
+        sim_printf ("%s: vid_update_texture() - SDL_UpdateTexture error: %s\n", sim_dname(vid_dev), SDL_GetError());
+    vid_dirty.w = vid_dirty.h = 0;
     }
-#else
-if (SDL_UpdateTexture(vid_texture, vid_dst, buf, vid_dst->w*sizeof(*buf)))
-    sim_printf ("%s: vid_draw() - SDL_UpdateTexture error: %s\n", sim_dname(vid_dev), SDL_GetError());
-#endif
-
-free (vid_dst);
-free (buf);
-event->data1 = NULL;
+SDL_UnlockMutex (vid_fb_lock);
 }
+#endif
 
 int vid_video_events (void)
 {
@@ -1718,9 +2338,9 @@ while (vid_active) {
                 break;
 #endif
             case SDL_USEREVENT:
-                /* There are 6 user events generated */
-                /* EVENT_REDRAW to update the display */
-                /* EVENT_DRAW   to update a region in the display texture */
+                /* There are 5 user events generated */
+                /* EVENT_REDRAW to load changes into the display texture */
+                /*              and update the display */
                 /* EVENT_SHOW   to display the current SDL video capabilities */
                 /* EVENT_CURSOR to change the current cursor */
                 /* EVENT_WARP   to warp the cursor position */
@@ -1728,6 +2348,9 @@ while (vid_active) {
                 /*              it notice vid_active has changed */
                 while (vid_active && event.user.code) {
                     if (event.user.code == EVENT_REDRAW) {
+#if SDL_MAJOR_VERSION != 1
+                        vid_update_texture ();
+#endif
                         vid_update ();
                         event.user.code = 0;    /* Mark as done */
 #if SDL_MAJOR_VERSION == 1
@@ -1756,10 +2379,6 @@ if (0)                        while (SDL_PeepEvents (&event, 1, SDL_GETEVENT, SD
                     if (event.user.code == EVENT_CLOSE) {
                         event.user.code = 0;    /* Mark as done */
                         }
-                    if (event.user.code == EVENT_DRAW) {
-                        vid_draw_region ((SDL_UserEvent*)&event);
-                        event.user.code = 0;    /* Mark as done */
-                        }
                     if (event.user.code == EVENT_SHOW) {
                         vid_show_video_event ();
                         event.user.code = 0;    /* Mark as done */
@@ -2128,6 +2747,10 @@ t_stat vid_show_video (FILE* st, UNIT* uptr, int32 val, CONST void* desc)
 {
 SDL_Event user_event;
 
+if (vid_headless) {
+    vid_headless_show (st);
+    return SCPE_OK;
+    }
 _show_stat = -1;
 _show_st = st;
 _show_uptr = uptr;
@@ -2221,6 +2844,8 @@ t_stat vid_screenshot (const char *filename)
 {
 SDL_Event user_event;
 
+if (vid_headless)
+    return vid_headless_screenshot (filename);
 _screenshot_stat = -1;
 _screenshot_filename = filename;
 
@@ -2308,6 +2933,8 @@ void vid_beep (void)
 {
 SDL_Event user_event;
 
+if (vid_headless)
+    return;
 user_event.type = SDL_USEREVENT;
 user_event.user.code = EVENT_BEEP;
 user_event.user.data1 = NULL;
@@ -2322,16 +2949,16 @@ SDL_Delay (vid_beep_duration + 100);/* Wait for sound to finnish */
 }
 
 #else /* !(defined(USE_SIM_VIDEO) && defined(HAVE_LIBSDL)) */
-/* Non-implemented versions */
+/* Headless only versions */
 
 t_stat vid_open (DEVICE *dptr, const char *title, uint32 width, uint32 height, int flags)
 {
-return SCPE_NOFNC;
+return vid_headless_open (dptr, width, height);
 }
 
 t_stat vid_close (void)
 {
-return SCPE_OK;
+return vid_headless_close ();
 }
 
 t_stat vid_poll_kb (SIM_KEY_EVENT *ev)
@@ -2346,27 +2973,28 @@ return SCPE_EOF;
 
 uint32 vid_map_rgb (uint8 r, uint8 g, uint8 b)
 {
-return 0;
+return vid_headless_map_rgb (r, g, b);
 }
 
 void vid_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf)
 {
-return;
+vid_headless_draw (x, y, w, h, buf);
 }
 
 t_stat vid_set_cursor (t_bool visible, uint32 width, uint32 height, uint8 *data, uint8 *mask, uint32 hot_x, uint32 hot_y)
 {
-return SCPE_NOFNC;
+return SCPE_OK;
 }
 
 void vid_set_cursor_position (int32 x, int32 y)
 {
-return;
+vid_cursor_x = x;
+vid_cursor_y = y;
 }
 
 void vid_refresh (void)
 {
-return;
+vid_headless_refresh ();
 }
 
 void vid_beep (void)
@@ -2376,7 +3004,7 @@ return;
 
 const char *vid_version (void)
 {
-return "No Video Support";
+return "No Video Support (headless display only)";
 }
 
 t_stat vid_set_release_key (FILE* st, UNIT* uptr, int32 val, CONST void* desc)
@@ -2392,13 +3020,12 @@ return SCPE_OK;
 
 t_stat vid_show_video (FILE* st, UNIT* uptr, int32 val, CONST void* desc)
 {
-fprintf (st, "video support unavailable");
+vid_headless_show (st);
 return SCPE_OK;
 }
 
 t_stat vid_screenshot (const char *filename)
 {
-sim_printf ("video support unavailable\n");
-return SCPE_NOFNC|SCPE_NOMESSAGE;
+return vid_headless_screenshot (filename);
 }
 #endif /* defined(USE_SIM_VIDEO) */
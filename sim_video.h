@@ -185,6 +185,10 @@ t_stat vid_poll_kb (SIM_KEY_EVENT *ev);
 t_stat vid_poll_mouse (SIM_MOUSE_EVENT *ev);
 uint32 vid_map_rgb (uint8 r, uint8 g, uint8 b);
 void vid_draw (int32 x, int32 y, int32 w, int32 h, uint32 *buf);
+void vid_expand_1bpp (uint32 *dst, const uint32 *src, uint32 pixels, const uint32 *palette);
+void vid_expand_8bpp (uint32 *dst, const uint8 *src, uint32 pixels, const uint32 *palette);
+void vid_expand_index (uint32 *dst, const uint32 *src, uint32 pixels, uint32 mask, const uint32 *palette);
+void vid_expand_plane (uint32 *dst, const uint32 *src, uint32 pixels, uint32 plane, uint32 fg, uint32 bg);
 void vid_beep (void);
 void vid_refresh (void);
 const char *vid_version (void);
@@ -194,6 +198,7 @@ t_stat vid_set_release_key (FILE* st, UNIT* uptr, int32 val, CONST void* desc);
 t_stat vid_show_release_key (FILE* st, UNIT* uptr, int32 val, CONST void* desc);
 t_stat vid_show_video (FILE* st, UNIT* uptr, int32 val, CONST void* desc);
 t_stat vid_show (FILE* st, DEVICE *dptr,  UNIT* uptr, int32 val, CONST char* desc);
+t_stat vid_set (int32 flag, CONST char *cptr);
 t_stat vid_screenshot (const char *filename);
 
 extern t_bool vid_active;